@@ -0,0 +1,404 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Benchmark.cpp
+ */
+
+#include "Benchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <json/json.h>
+#include <libdevcore/CommonIO.h>
+#include <libdevcore/SHA3.h>
+#include <libethcore/SealEngine.h>
+#include <libethereum/ChainParams.h>
+#include <libethereum/ExtVM.h>
+#include <libethereum/LastBlockHashesFace.h>
+#include <libevm/Instruction.h>
+#include <libevm/VMFactory.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+namespace fs = boost::filesystem;
+namespace po = boost::program_options;
+
+namespace
+{
+
+// Once benchmarks run, every allocation of the process is counted so that runs can report how
+// much they allocate; the other modes only pay for checking the flag.
+atomic<bool> g_countAllocations{false};
+atomic<uint64_t> g_allocations{0};
+atomic<uint64_t> g_allocatedBytes{0};
+
+}
+
+void* operator new(size_t _size)
+{
+	if (g_countAllocations.load(memory_order_relaxed))
+	{
+		g_allocations.fetch_add(1, memory_order_relaxed);
+		g_allocatedBytes.fetch_add(_size, memory_order_relaxed);
+	}
+	if (void* p = malloc(_size ? _size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void* _p) noexcept
+{
+	free(_p);
+}
+
+namespace
+{
+
+class LastBlockHashes: public LastBlockHashesFace
+{
+public:
+	h256s precedingHashes(h256 const& /* _mostRecentHash */) const override { return h256s(256, h256()); }
+	void clear() override {}
+};
+
+/// Minimal EVM assembler for the built-in workloads; jump targets are named labels.
+class Assembly
+{
+public:
+	Assembly& operator<<(Instruction _i) { m_code.push_back(byte(_i)); return *this; }
+
+	Assembly& push(u256 const& _value)
+	{
+		bytes const v = toCompactBigEndian(_value, 1);
+		m_code.push_back(byte(Instruction::PUSH1) + byte(v.size() - 1));
+		m_code += v;
+		return *this;
+	}
+
+	Assembly& pushLabel(string const& _label)
+	{
+		m_code.push_back(byte(Instruction::PUSH2));
+		m_fixups.emplace_back(m_code.size(), _label);
+		m_code.resize(m_code.size() + 2);
+		return *this;
+	}
+
+	Assembly& label(string const& _label)
+	{
+		m_labels[_label] = m_code.size();
+		return *this << Instruction::JUMPDEST;
+	}
+
+	bytes assemble() const
+	{
+		bytes ret = m_code;
+		for (auto const& f: m_fixups)
+		{
+			size_t const target = m_labels.at(f.second);
+			ret[f.first] = byte(target >> 8);
+			ret[f.first + 1] = byte(target);
+		}
+		return ret;
+	}
+
+private:
+	bytes m_code;
+	map<string, size_t> m_labels;
+	vector<pair<size_t, string>> m_fixups;
+};
+
+struct Workload
+{
+	string name;
+	bytes code;
+	bytes data;
+	map<u256, u256> storage;
+};
+
+u256 const c_transferSelector = 0xa9059cbb;		// transfer(address,uint256)
+u256 const c_balanceOfSelector = 0x70a08231;	// balanceOf(address)
+unsigned const c_stakers = 100;
+
+/// Slot of @a _a in a mapping stored at slot @a _slot, as Solidity lays it out.
+u256 mappingSlot(Address const& _a, u256 const& _slot)
+{
+	return u256(sha3(h256(_a, h256::AlignRight).asBytes() + h256(_slot).asBytes()));
+}
+
+bytes abiCall(u256 const& _selector, vector<u256> const& _args)
+{
+	bytes ret = toCompactBigEndian(_selector, 4);
+	for (u256 const& a: _args)
+		ret += h256(a).asBytes();
+	return ret;
+}
+
+/// The transfer and balanceOf functions of an ERC-20 token, balances mapped at slot 0.
+bytes erc20Code()
+{
+	Assembly a;
+	a.push(0) << Instruction::CALLDATALOAD;
+	a.push(u256(1) << 224) << Instruction::SWAP1 << Instruction::DIV;
+	a << Instruction::DUP1;
+	a.push(c_transferSelector) << Instruction::EQ;
+	a.pushLabel("transfer") << Instruction::JUMPI;
+	a << Instruction::DUP1;
+	a.push(c_balanceOfSelector) << Instruction::EQ;
+	a.pushLabel("balanceOf") << Instruction::JUMPI;
+	a.pushLabel("revert") << Instruction::JUMP;
+
+	// transfer(to, amount): balances[caller] -= amount; balances[to] += amount; emit Transfer.
+	a.label("transfer") << Instruction::POP;
+	a << Instruction::CALLER;
+	a.push(0) << Instruction::MSTORE;
+	a.push(0);
+	a.push(32) << Instruction::MSTORE;
+	a.push(64);
+	a.push(0) << Instruction::SHA3;
+	a << Instruction::DUP1 << Instruction::SLOAD;
+	a.push(36) << Instruction::CALLDATALOAD;
+	a << Instruction::DUP1 << Instruction::DUP3 << Instruction::LT;
+	a.pushLabel("revert") << Instruction::JUMPI;
+	a << Instruction::SWAP1 << Instruction::SUB << Instruction::SWAP1 << Instruction::SSTORE;
+	a.push(4) << Instruction::CALLDATALOAD;
+	a.push(0) << Instruction::MSTORE;
+	a.push(64);
+	a.push(0) << Instruction::SHA3;
+	a << Instruction::DUP1 << Instruction::SLOAD;
+	a.push(36) << Instruction::CALLDATALOAD;
+	a << Instruction::ADD << Instruction::SWAP1 << Instruction::SSTORE;
+	a.push(36) << Instruction::CALLDATALOAD;
+	a.push(0) << Instruction::MSTORE;
+	a.push(4) << Instruction::CALLDATALOAD;
+	a << Instruction::CALLER;
+	a.push(u256(sha3("Transfer(address,address,uint256)")));
+	a.push(32);
+	a.push(0) << Instruction::LOG3;
+	a.pushLabel("returnTrue") << Instruction::JUMP;
+
+	// balanceOf(owner)
+	a.label("balanceOf") << Instruction::POP;
+	a.push(4) << Instruction::CALLDATALOAD;
+	a.push(0) << Instruction::MSTORE;
+	a.push(0);
+	a.push(32) << Instruction::MSTORE;
+	a.push(64);
+	a.push(0) << Instruction::SHA3 << Instruction::SLOAD;
+	a.push(0) << Instruction::MSTORE;
+	a.push(32);
+	a.push(0) << Instruction::RETURN;
+
+	a.label("returnTrue");
+	a.push(1);
+	a.push(0) << Instruction::MSTORE;
+	a.push(32);
+	a.push(0) << Instruction::RETURN;
+
+	a.label("revert");
+	a.push(0) << Instruction::DUP1 << Instruction::REVERT;
+	return a.assemble();
+}
+
+/// Distribution of a reward among all stakers in proportion to their stake: the total stake
+/// is at slot 0, stake i at slot 1 + i and the accumulated reward of staker i at 0x1000 + i.
+bytes stakingCode()
+{
+	Assembly a;
+	a.push(0) << Instruction::SLOAD;
+	a.push(4) << Instruction::CALLDATALOAD;
+	a.push(0);
+	a.label("loop");
+	a.push(c_stakers) << Instruction::DUP2 << Instruction::LT << Instruction::ISZERO;
+	a.pushLabel("end") << Instruction::JUMPI;
+	a << Instruction::DUP1;
+	a.push(1) << Instruction::ADD << Instruction::SLOAD;
+	a << Instruction::DUP3 << Instruction::MUL << Instruction::DUP4 << Instruction::SWAP1 << Instruction::DIV;
+	a << Instruction::DUP2;
+	a.push(0x1000) << Instruction::ADD;
+	a << Instruction::DUP1 << Instruction::SLOAD << Instruction::DUP3 << Instruction::ADD << Instruction::SWAP1 << Instruction::SSTORE;
+	a << Instruction::POP;
+	a.push(1) << Instruction::ADD;
+	a.pushLabel("loop") << Instruction::JUMP;
+	a.label("end") << Instruction::STOP;
+	return a.assemble();
+}
+
+vector<Workload> builtinWorkloads(Address const& _sender)
+{
+	vector<Workload> ret;
+	Address const recipient("0x00000000000000000000000000000000000000aa");
+	u256 const supply = u256(1000000000) * u256("1000000000000000000");
+
+	bytes const erc20 = erc20Code();
+	map<u256, u256> balances{{mappingSlot(_sender, 0), supply}, {mappingSlot(recipient, 0), 1}};
+	ret.push_back(Workload{"erc20-transfer", erc20, abiCall(c_transferSelector, {u256(u160(recipient)), 1000}), balances});
+	ret.push_back(Workload{"erc20-balanceOf", erc20, abiCall(c_balanceOfSelector, {u256(u160(_sender))}), balances});
+
+	map<u256, u256> stakes;
+	u256 total = 0;
+	for (unsigned i = 0; i < c_stakers; ++i)
+	{
+		u256 const stake = u256(i + 1) * u256("1000000000000000000");
+		stakes[1 + i] = stake;
+		stakes[0x1000 + i] = 1;
+		total += stake;
+	}
+	stakes[0] = total;
+	ret.push_back(Workload{"staking-distribute", stakingCode(), abiCall(0, {u256("5000000000000000000")}), stakes});
+	return ret;
+}
+
+/// Reads a hex bytecode file the way ethvm reads its input.
+bytes readCode(string const& _file)
+{
+	bytes const raw = contents(_file);
+	string code{reinterpret_cast<char const*>(raw.data()), raw.size()};
+	code.erase(code.find_last_not_of(" \t\n\r") + 1);
+	return fromHex(code, WhenError::Throw);
+}
+
+struct Measurement
+{
+	uint64_t iterations = 0;
+	double seconds = 0;
+	u256 gasUsed = 0;
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+	bool exception = false;
+};
+
+Measurement measure(Workload const& _w, VMKind _kind, BenchmarkOptions const& _options, SealEngineFace const& _se)
+{
+	Address const contract("0x1122334455667788991011121314151617181920");
+	State base(0);
+	{
+		Account account(0, 0);
+		account.setCode(bytes{_w.code}, 0);
+		for (auto const& s: _w.storage)
+			account.setStorage(s.first, s.second);
+		AccountMap map;
+		map[contract] = account;
+		base.populateFrom(map);
+	}
+	h256 const codeHash = sha3(_w.code);
+	LastBlockHashes lastBlockHashes;
+	EnvInfo const envInfo(_options.header, lastBlockHashes, 0, 0);
+
+	Measurement ret;
+	do
+	{
+		// Every run starts from the same state and a fresh VM, as Executive uses; preparing
+		// them is not measured.
+		State state(base);
+		VMPtr vm = VMFactory::create(_kind);
+		ExtVM ext(state, envInfo, _se, contract, _options.sender, _options.origin, 0, 0, &_w.data, &_w.code, codeHash, 0, 0, false, false);
+		u256 gas = _options.gas;
+
+		uint64_t const allocations = g_allocations;
+		uint64_t const allocatedBytes = g_allocatedBytes;
+		auto const start = chrono::steady_clock::now();
+		try
+		{
+			vm->exec(gas, ext, OnOpFunc());
+		}
+		catch (VMException const&)
+		{
+			ret.exception = true;
+		}
+		ret.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		ret.allocations += g_allocations - allocations;
+		ret.allocatedBytes += g_allocatedBytes - allocatedBytes;
+		ret.gasUsed = _options.gas - gas;
+		++ret.iterations;
+	}
+	while (ret.seconds < _options.minTime);
+	return ret;
+}
+
+}
+
+int dev::eth::runBenchmarks(BenchmarkOptions const& _options)
+{
+	g_countAllocations = true;
+	vector<pair<string, VMKind>> kinds{{"interpreter", VMKind::Interpreter}, {"legacy", VMKind::Legacy}};
+	if (!_options.evmcPath.empty())
+	{
+		try
+		{
+			// Loads the module through the same option the other tools use.
+			po::variables_map vmOptions;
+			po::store(po::command_line_parser(vector<string>{"--vm", _options.evmcPath}).options(vmProgramOptions()).run(), vmOptions);
+			po::notify(vmOptions);
+		}
+		catch (std::exception const& _e)
+		{
+			cerr << "Cannot load EVMC VM " << _options.evmcPath << ": " << _e.what() << "\n";
+			return -1;
+		}
+		kinds.emplace_back(fs::path(_options.evmcPath).stem().string(), VMKind::DLL);
+	}
+
+	vector<Workload> workloads = builtinWorkloads(_options.sender);
+	for (string const& f: _options.files)
+		try
+		{
+			workloads.push_back(Workload{fs::path(f).stem().string(), readCode(f), bytes(), {}});
+		}
+		catch (...)
+		{
+			cerr << "Cannot read bytecode from " << f << "\n";
+			return -1;
+		}
+
+	unique_ptr<SealEngineFace> se(ChainParams(genesisInfo(_options.network)).createSealEngine());
+
+	Json::Value benchmarks(Json::arrayValue);
+	for (Workload const& w: workloads)
+		for (auto const& kind: kinds)
+		{
+			Measurement const m = measure(w, kind.second, _options, *se);
+			Json::Value b;
+			b["name"] = w.name;
+			b["vm"] = kind.first;
+			b["iterations"] = Json::UInt64(m.iterations);
+			b["exception"] = m.exception;
+			b["gas_per_op"] = Json::UInt64(m.gasUsed);
+			b["ns_per_op"] = m.seconds * 1e9 / m.iterations;
+			b["gas_per_second"] = m.seconds > 0 ? double(m.gasUsed) * m.iterations / m.seconds : 0;
+			b["allocations_per_op"] = double(m.allocations) / m.iterations;
+			b["allocated_bytes_per_op"] = double(m.allocatedBytes) / m.iterations;
+			benchmarks.append(b);
+		}
+
+	Json::Value context;
+	context["version"] = dev::Version;
+	context["build_type"] = DEV_QUOTED(ETH_BUILD_TYPE);
+	context["block_number"] = Json::Int64(_options.header.number());
+	context["min_time"] = _options.minTime;
+
+	Json::Value root;
+	root["context"] = context;
+	root["benchmarks"] = benchmarks;
+	cout << (_options.styledJson ? Json::StyledWriter().write(root) : Json::FastWriter().write(root));
+	return 0;
+}
@@ -0,0 +1,53 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file Benchmark.h
+ * EVM execution microbenchmarks for ethvm.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <libdevcore/Address.h>
+#include <libethcore/BlockHeader.h>
+#include <libethashseal/GenesisInfo.h>
+
+namespace dev
+{
+namespace eth
+{
+
+struct BenchmarkOptions
+{
+	Network network = Network::MainNetworkTest;
+	BlockHeader header;				///< Block the code is executed in.
+	Address sender = Address(69);
+	Address origin = Address(69);
+	u256 gas;						///< Gas given to every run.
+	double minTime = 1;				///< Seconds to keep repeating each benchmark for; it runs at least once.
+	std::vector<std::string> files;	///< Hex bytecode files, e.g. the *.bin output of test/unittests/performance/tests.mk.
+	std::string evmcPath;			///< EVMC VM to benchmark in addition to the built-in ones; empty for none.
+	bool styledJson = true;
+};
+
+/// Run the built-in ERC-20 and staking workloads and the programs in @a _options.files on every
+/// available VM kind and print the results as JSON.
+/// @returns the process exit code.
+int runBenchmarks(BenchmarkOptions const& _options);
+
+}
+}
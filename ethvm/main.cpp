@@ -31,7 +31,9 @@
 #include <libethashseal/Ethash.h>
 //#include <libevm/VM.h>
 #include <libevm/VMFactory.h>
+#include "Benchmark.h"
 #include <boost/algorithm/string.hpp>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <ctime>
@@ -51,6 +53,7 @@ void help()
 {
 	cout
 		<< "Usage ethvm <options> [trace|stats|output|test] (<file>|-)\n"
+		<< "      ethvm <options> bench [<file> ...]\n"
 		<< "Transaction options:\n"
 		<< "    --value <n>  Transaction should transfer the <n> wei (default: 0).\n"
 		<< "    --gas <n>    Transaction should be given <n> gas (default: block gas limit).\n"
@@ -69,6 +72,10 @@ void help()
 		<< "Options for trace:\n"
 		<< "    --flat  Minimal whitespace in the JSON.\n"
 		<< "    --mnemonics  Show instruction mnemonics in the trace (non-standard).\n\n"
+		<< "Options for bench:\n"
+		<< "    --bench-time <s>  Repeat each benchmark for at least <s> seconds (default: 1).\n"
+		<< "    --evmc-vm <path>  Also benchmark the EVMC VM loaded from <path>.\n"
+		<< "    --flat  Minimal whitespace in the JSON.\n\n"
 		<< "General options:\n"
 		<< "    -V,--version  Show the version and exit.\n"
 		<< "    -h,--help  Show this help message and exit.\n";
@@ -115,7 +122,11 @@ enum class Mode
 	/// Test mode -- output information needed for test verification and
 	/// benchmarking. The execution is not introspected not to degrade
 	/// performance.
-	Test
+	Test,
+
+	/// Benchmark mode -- run built-in workloads and the given files on every VM
+	/// repeatedly and report timing and allocation statistics as JSON.
+	Benchmark
 };
 
 }
@@ -131,6 +142,9 @@ int main(int argc, char** argv)
 {
 	setDefaultOrCLocale();
 	string inputFile;
+	vector<string> benchFiles;
+	double benchTime = 1;
+	string evmcPath;
 	Mode mode = Mode::Statistics;
 
 	State state(0);
@@ -206,6 +220,26 @@ int main(int argc, char** argv)
 			mode = Mode::Trace;
 		else if (arg == "test")
 			mode = Mode::Test;
+		else if (arg == "bench")
+			mode = Mode::Benchmark;
+		else if (arg == "--bench-time" && i + 1 < argc)
+		{
+			try
+			{
+				benchTime = stod(argv[++i]);
+			}
+			catch (...)
+			{
+				benchTime = -1;
+			}
+			if (!(benchTime >= 0) || std::isinf(benchTime))
+			{
+				cerr << "Bad " << arg << " option: " << argv[i] << "\n";
+				return -1;
+			}
+		}
+		else if (arg == "--evmc-vm" && i + 1 < argc)
+			evmcPath = argv[++i];
 		else if (arg == "--input" && i + 1 < argc)
 			data = fromHex(argv[++i]);
 		else if (arg == "--code" && i + 1 < argc)
@@ -213,10 +247,29 @@ int main(int argc, char** argv)
 		else if (inputFile.empty())
 			inputFile = arg;  // Assign input file name only once.
 		else
-		{
-			cerr << "Unknown argument: " << arg << '\n';
-			return -1;
-		}
+			benchFiles.push_back(arg);
+	}
+
+	if (mode == Mode::Benchmark)
+	{
+		BenchmarkOptions options;
+		options.network = networkName;
+		options.header = blockHeader;
+		options.sender = sender;
+		options.origin = origin;
+		options.gas = gas;
+		options.minTime = benchTime;
+		if (!inputFile.empty())
+			options.files.push_back(inputFile);
+		options.files.insert(options.files.end(), benchFiles.begin(), benchFiles.end());
+		options.evmcPath = evmcPath;
+		options.styledJson = styledJson;
+		return runBenchmarks(options);
+	}
+	else if (!benchFiles.empty())
+	{
+		cerr << "Unknown argument: " << benchFiles.front() << '\n';
+		return -1;
 	}
 
 	// Read code from input file.
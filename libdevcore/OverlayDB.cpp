@@ -91,7 +91,11 @@ void OverlayDB::commit()
 bytes OverlayDB::lookupAux(h256 const& _h) const
 {
 	bytes ret = MemoryDB::lookupAux(_h);
-	if (!ret.empty() || !m_db)
+	if (!ret.empty())
+		return ret;
+	if (m_base)
+		return m_base->lookupAux(_h);
+	if (!m_db)
 		return ret;
 	std::string v;
 	bytes b = _h.asBytes();
@@ -113,6 +117,8 @@ void OverlayDB::rollback()
 std::string OverlayDB::lookup(h256 const& _h) const
 {
 	std::string ret = MemoryDB::lookup(_h);
+	if (ret.empty() && m_base)
+		return m_base->lookup(_h);
 	if (ret.empty() && m_db)
 		m_db->Get(m_readOptions, ldb::Slice((char const*)_h.data(), 32), &ret);
 	return ret;
@@ -122,6 +128,8 @@ bool OverlayDB::exists(h256 const& _h) const
 {
 	if (MemoryDB::exists(_h))
 		return true;
+	if (m_base)
+		return m_base->exists(_h);
 	std::string ret;
 	if (m_db)
 		m_db->Get(m_readOptions, ldb::Slice((char const*)_h.data(), 32), &ret);
@@ -133,6 +141,9 @@ void OverlayDB::kill(h256 const& _h)
 #if ETH_PARANOIA || 1
 	if (!MemoryDB::kill(_h))
 	{
+		// A node of the base is left there; the base is never changed through its layers.
+		if (m_base)
+			return;
 		std::string ret;
 		if (m_db)
 			m_db->Get(m_readOptions, ldb::Slice((char const*)_h.data(), 32), &ret);
@@ -32,14 +32,27 @@ namespace dev
 
 struct DBDetail: public LogChannel { static const char* name() { return "DBDetail"; } static const int verbosity = 14; };
 
+/**
+ * @brief Keeps changes in memory until they are committed to the database underneath.
+ *
+ * An overlay may instead be layered on another overlay, which it then reads through to
+ * rather than to the database. The base must not change while the layer is in use. Its
+ * changes are only ever kept in memory; commit() does nothing for a layered overlay.
+ */
 class OverlayDB: public MemoryDB
 {
 public:
 	OverlayDB(ldb::DB* _db = nullptr): m_db(_db) {}
 	~OverlayDB();
 
+	/// @returns an empty overlay that reads through to @a _base, which is not copied.
+	static OverlayDB layered(std::shared_ptr<OverlayDB const> const& _base) { OverlayDB ret; ret.m_base = _base; return ret; }
+
 	ldb::DB* db() const { return m_db.get(); }
 
+	/// @returns an overlay on the same database that holds none of the uncommitted changes of this one.
+	OverlayDB committed() const { OverlayDB ret; ret.m_db = m_db; ret.m_base = m_base; return ret; }
+
 	void commit();
 	void rollback();
 
@@ -53,6 +66,7 @@ private:
 	using MemoryDB::clear;
 
 	std::shared_ptr<ldb::DB> m_db;
+	std::shared_ptr<OverlayDB const> m_base;	///< Read when a node is not in memory, in place of m_db.
 
 	ldb::ReadOptions m_readOptions;
 	ldb::WriteOptions m_writeOptions;
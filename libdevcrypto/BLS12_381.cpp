@@ -1,6 +1,7 @@
 #include "BLS12_381.h"
 
 #include <exception>
+#include <libdevcore/Assertions.h>
 
 using namespace dev::BLS12_381;
 
@@ -83,6 +84,108 @@ namespace dev {
             G2 g; hash_to_g2(::toAS(data), g.toAS()); return g;
         }
 
+        namespace {
+            /// The pairing library reads scalars as raw limbs; find out once which end of the
+            /// byte array holds the least significant byte so that window digits match `mul`.
+            bool scalarIsBigEndian() {
+                static bool const c_bigEndian = [](){
+                    bytes one(Scalar::size, 0);
+                    one.back() = 1;
+                    return G1::getOne().mul(Scalar(one)) == G1::getOne();
+                }();
+                return c_bigEndian;
+            }
+
+            /// @returns the @a _bits-wide digit of @a _s starting at bit @a _offset.
+            unsigned scalarWindow(Scalar const& _s, unsigned _offset, unsigned _bits, bool _bigEndian) {
+                unsigned r = 0;
+                for (unsigned i = 0; i < _bits && _offset + i < Scalar::size * 8; ++i) {
+                    unsigned bit = _offset + i;
+                    unsigned byteIndex = _bigEndian ? Scalar::size - 1 - bit / 8 : bit / 8;
+                    if ((_s.data()[byteIndex] >> (bit % 8)) & 1)
+                        r |= 1u << i;
+                }
+                return r;
+            }
+
+            /// Point accumulator that avoids calling into the pairing library for additions with zero.
+            template <class Point>
+            struct Accumulator {
+                Point value;
+                bool empty = true;
+
+                void add(Point const& _p) {
+                    if (empty)
+                        value = _p;
+                    else
+                        value = value.add(_p);
+                    empty = false;
+                }
+                void add(Accumulator const& _a) { if (!_a.empty) add(_a.value); }
+                void twice() { if (!empty) value = value.add(value); }
+                Point get() const { return empty ? Point::getZero() : value; }
+            };
+
+            /// Window width minimising (bits / c) * (n + 2^c) additions.
+            unsigned pippengerWindow(size_t _n) {
+                if (_n < 8)
+                    return 2;
+                unsigned logN = 0;
+                while ((size_t(1) << (logN + 1)) <= _n)
+                    ++logN;
+                return std::min(16u, std::max(2u, logN * 69 / 100 + 2));
+            }
+
+            template <class Point>
+            Point pippenger(std::vector<Point> const& _points, std::vector<Scalar> const& _scalars) {
+                assertThrow(_points.size() == _scalars.size(), dev::Exception, "Point and scalar counts differ.");
+                if (_points.empty())
+                    return Point::getZero();
+                if (_points.size() == 1)
+                    return _points[0].mul(_scalars[0]);
+
+                bool bigEndian = scalarIsBigEndian();
+                unsigned const c = pippengerWindow(_points.size());
+                unsigned const bits = Scalar::size * 8;
+                unsigned const windows = (bits + c - 1) / c;
+
+                Accumulator<Point> result;
+                std::vector<Accumulator<Point>> buckets;
+                for (unsigned w = windows; w-- > 0;) {
+                    for (unsigned i = 0; i < c; ++i)
+                        result.twice();
+
+                    buckets.assign((size_t(1) << c) - 1, Accumulator<Point>());
+                    for (size_t i = 0; i < _points.size(); ++i)
+                        if (unsigned digit = scalarWindow(_scalars[i], w * c, c, bigEndian))
+                            buckets[digit - 1].add(_points[i]);
+
+                    // sum_j (j + 1) * bucket[j] via running sums from the top bucket down.
+                    Accumulator<Point> running;
+                    Accumulator<Point> windowSum;
+                    for (size_t j = buckets.size(); j-- > 0;) {
+                        running.add(buckets[j]);
+                        windowSum.add(running);
+                    }
+                    result.add(windowSum);
+                }
+                return result.get();
+            }
+
+            template <class Point>
+            Point sumOf(std::vector<Point> const& _points) {
+                Accumulator<Point> r;
+                for (auto const& p: _points)
+                    r.add(p);
+                return r.get();
+            }
+        }
+
+        G1 G1::multiExp(std::vector<G1> const& points, std::vector<Scalar> const& scalars) { return pippenger(points, scalars); }
+        G2 G2::multiExp(std::vector<G2> const& points, std::vector<Scalar> const& scalars) { return pippenger(points, scalars); }
+        G1 G1::sum(std::vector<G1> const& points) { return sumOf(points); }
+        G2 G2::sum(std::vector<G2> const& points) { return sumOf(points); }
+
         GT GT::fromPairing(G1 const& g1, G2 const& g2) { GT r; pairing(G1(g1).toAS(), G2(g2).toAS(), r.toAS()); return r; }
         GT GT::fromMultiPairing(G1G2s const& gs) {
             GT result = GT::getOne();
@@ -109,5 +212,38 @@ namespace dev {
             return a == b;
         }
 
+        G1 BonehLynnShacham::aggregate(std::vector<G1> const& signatures) { return G1::sum(signatures); }
+        G2 BonehLynnShacham::aggregate(std::vector<G2> const& publicKeys) { return G2::sum(publicKeys); }
+
+        bool BonehLynnShacham::aggregateVerify(std::vector<G2> const& publicKeys, std::vector<G1> const& elements, G1 const& aggregatedSignature) {
+            if (publicKeys.size() != elements.size() || publicKeys.empty())
+                return false;
+            G1G2s pairs;
+            pairs.reserve(publicKeys.size());
+            for (size_t i = 0; i < publicKeys.size(); ++i)
+                pairs.emplace_back(elements[i], publicKeys[i]);
+            return GT::fromPairing(aggregatedSignature, G2::getOne()) == GT::fromMultiPairing(pairs);
+        }
+
+        bool BonehLynnShacham::batchVerify(std::vector<G2> const& publicKeys, std::vector<G1> const& elements, std::vector<G1> const& signedElements) {
+            if (publicKeys.size() != elements.size() || publicKeys.size() != signedElements.size() || publicKeys.empty())
+                return false;
+            if (publicKeys.size() == 1)
+                return verify(publicKeys[0], elements[0], signedElements[0]);
+
+            // Random 128-bit weights stop a forged signature from cancelling out against another.
+            std::vector<Scalar> weights(publicKeys.size());
+            G1G2s pairs;
+            pairs.reserve(publicKeys.size());
+            for (size_t i = 0; i < publicKeys.size(); ++i) {
+                bytes r(Scalar::size, 0);
+                h128 low = h128::random();
+                std::copy(low.begin(), low.end(), scalarIsBigEndian() ? r.begin() + h128::size : r.begin());
+                weights[i] = Scalar(r);
+                pairs.emplace_back(elements[i], publicKeys[i].mul(weights[i]));
+            }
+            return GT::fromPairing(G1::multiExp(signedElements, weights), G2::getOne()) == GT::fromMultiPairing(pairs);
+        }
+
     }
 }
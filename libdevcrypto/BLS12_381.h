@@ -51,6 +51,10 @@ namespace dev {
             static G1 getZero();
             static G1 mapToElement(bytesConstRef data);
             static G1 publicFromPrivateKey(Scalar privateKey) { return getOne().mul(privateKey); }
+            /// Computes sum(scalars[i] * points[i]) with Pippenger's bucket method.
+            static G1 multiExp(std::vector<G1> const& points, std::vector<Scalar> const& scalars);
+            /// Computes sum(points[i]).
+            static G1 sum(std::vector<G1> const& points);
 
             G1() : H48() {}
             G1(bytesConstRef d) : H48(d) { assert(d.size() == H48::size); }
@@ -77,6 +81,10 @@ namespace dev {
             static G2 getZero();
             static G2 mapToElement(bytesConstRef data);
             static G2 publicFromPrivateKey(Scalar privateKey);
+            /// Computes sum(scalars[i] * points[i]) with Pippenger's bucket method.
+            static G2 multiExp(std::vector<G2> const& points, std::vector<Scalar> const& scalars);
+            /// Computes sum(points[i]).
+            static G2 sum(std::vector<G2> const& points);
             explicit G2(std::string const& _s, ConstructFromStringType _t = FromHex, ConstructFromHashType _ht = FailIfDifferent): H96(_s, _t, _ht) {}
 
             G2() : H96() {}
@@ -125,6 +133,15 @@ namespace dev {
             static G2 generatePublicKey(Scalar const& secret);
             static G1 sign(G1 const& element, Scalar const& secret);
             static bool verify(G2 publicKey, G1 element, G1 signedElement);
+
+            /// Aggregates signatures over any set of messages into a single signature.
+            static G1 aggregate(std::vector<G1> const& signatures);
+            /// Aggregates public keys; only meaningful for signatures over the same element.
+            static G2 aggregate(std::vector<G2> const& publicKeys);
+            /// Verifies an aggregated signature: e(sig, g2) == prod e(elements[i], publicKeys[i]).
+            static bool aggregateVerify(std::vector<G2> const& publicKeys, std::vector<G1> const& elements, G1 const& aggregatedSignature);
+            /// Verifies independent signatures at once by checking a random linear combination of them.
+            static bool batchVerify(std::vector<G2> const& publicKeys, std::vector<G1> const& elements, std::vector<G1> const& signedElements);
         };
 
     }
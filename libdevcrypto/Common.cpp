@@ -310,6 +310,33 @@ bytes to8ByteHash(bytes from) { return sha3(from).asBytes();
         return BLS12_381::BonehLynnShacham::verify(publicKey, hashToElement(publicKey, hash), signature);
     }
 
+BLS::Signature BLS::aggregate(std::vector<Signature> const& _signatures)
+{
+	return BLS12_381::BonehLynnShacham::aggregate(_signatures);
+}
+
+bool BLS::aggregateVerify(std::vector<Public> const& _publicKeys, std::vector<h256> const& _hashes, Signature const& _aggregate)
+{
+	if (_publicKeys.size() != _hashes.size())
+		return false;
+	std::vector<BLS12_381::G1> elements;
+	elements.reserve(_hashes.size());
+	for (size_t i = 0; i < _hashes.size(); ++i)
+		elements.push_back(hashToElement(_publicKeys[i], _hashes[i]));
+	return BLS12_381::BonehLynnShacham::aggregateVerify(_publicKeys, elements, _aggregate);
+}
+
+bool BLS::batchVerify(std::vector<Public> const& _publicKeys, std::vector<h256> const& _hashes, std::vector<Signature> const& _signatures)
+{
+	if (_publicKeys.size() != _hashes.size())
+		return false;
+	std::vector<BLS12_381::G1> elements;
+	elements.reserve(_hashes.size());
+	for (size_t i = 0; i < _hashes.size(); ++i)
+		elements.push_back(hashToElement(_publicKeys[i], _hashes[i]));
+	return BLS12_381::BonehLynnShacham::batchVerify(_publicKeys, elements, _signatures);
+}
+
 bytesSec dev::pbkdf2(string const& _pass, bytes const& _salt, unsigned _iterations, unsigned _dkLen)
 {
 	bytesSec ret(_dkLen);
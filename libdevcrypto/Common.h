@@ -56,6 +56,13 @@ public:
         void streamRLP(RLPStream& _s) const;
         Public publicKey;
     };
+
+    /// Aggregates signatures over any set of (public key, hash) pairs into one signature.
+    static Signature aggregate(std::vector<Signature> const& _signatures);
+    /// Verifies a signature produced by aggregate() against the signers and their hashes.
+    static bool aggregateVerify(std::vector<Public> const& _publicKeys, std::vector<h256> const& _hashes, Signature const& _aggregate);
+    /// Verifies many independent signatures with a single multi-exponentiation and multi-pairing.
+    static bool batchVerify(std::vector<Public> const& _publicKeys, std::vector<h256> const& _hashes, std::vector<Signature> const& _signatures);
 };
 
 class ECDSA {
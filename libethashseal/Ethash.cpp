@@ -124,6 +124,22 @@ void Ethash::verify(Strictness _s, BlockHeader const& _bi, BalanceRetriever bala
     }
 }
 
+bool Ethash::verifyHeaderSeal(BlockHeader const& _bi, BlockHeader const& _parent) const
+{
+	// Everything verifySeal() checks except the stake bound, which needs the minter's aged balance.
+	if (!_bi.parentHash())
+		return true;
+	if (!::verify<BLS>(publicKey(_bi), blockSignature(_bi), _bi.hash(WithoutSeal)))
+		return false;
+	if (!_parent)
+		return true;
+	const StakeKeys::Signature stakeSig = stakeSignature(_bi);
+	return _bi.number() == _parent.number() + 1 &&
+		_bi.difficulty() == calculateDifficulty(_bi, _parent) &&
+		stakeModifier(_bi) == computeChildStakeModifier(stakeModifier(_parent), publicKey(_bi), stakeSig) &&
+		verifyStakeSignature(publicKey(_bi), stakeSig, computeStakeMessage(stakeModifier(_parent), _bi.timestamp()));
+}
+
 void Ethash::verifyTransaction(ImportRequirements::value _ir, TransactionBase const& _t, BlockHeader const& _header, u256 const& _startGasUsed) const
 {
 	SealEngineFace::verifyTransaction(_ir, _t, _header, _startGasUsed);
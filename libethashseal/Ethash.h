@@ -48,6 +48,7 @@ public:
 
 	StringHashMap jsInfo(BlockHeader const& _bi) const override;
 	void verify(Strictness _s, BlockHeader const& _bi, BalanceRetriever balanceRetriever, BlockHeader const& _parent, bytesConstRef _block) const override;
+	bool verifyHeaderSeal(BlockHeader const& _bi, BlockHeader const& _parent = BlockHeader()) const override;
 	void verifyTransaction(ImportRequirements::value _ir, TransactionBase const& _t, BlockHeader const& _header, u256 const& _startGasUsed) const override;
     void populateFromParent(BlockHeader& _bi, BlockHeader const& _parent) override;
 
@@ -58,6 +58,10 @@ public:
 
 	/// Don't forget to call Super::verify when subclassing & overriding.
 	virtual void verify(Strictness _s, BlockHeader const& _bi, BalanceRetriever balanceRetriever, BlockHeader const& _parent = BlockHeader(), bytesConstRef _block = bytesConstRef()) const;
+	/// Check the parts of the seal of @a _bi that can be checked without state, e.g. on headers
+	/// downloaded ahead of their blocks. @a _parent may be null if it is not at hand.
+	/// Thread-safe; verify() must still be called on import.
+	virtual bool verifyHeaderSeal(BlockHeader const&, BlockHeader const& /* _parent */ = BlockHeader()) const { return true; }
 	/// Additional verification for transactions in blocks.
 	virtual void verifyTransaction(ImportRequirements::value _ir, TransactionBase const& _t, BlockHeader const& _header, u256 const& _startGasUsed) const;
 	/// Don't forget to call Super::populateFromParent when subclassing & overriding.
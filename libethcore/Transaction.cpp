@@ -57,6 +57,8 @@ TransactionBase::TransactionBase(bytesConstRef _rlpData, CheckTransaction _check
         s >> m_value >> m_data >> m_vrs;
         if (_checkSig >= CheckTransaction::Cheap && !m_vrs->isValid())
             BOOST_THROW_EXCEPTION(InvalidSignature());
+		// Every field was read VeryStrict, so the bytes are exactly what streamRLP() would produce.
+		m_rlp = make_shared<bytes const>(rlp.data().toBytes());
 	}
 	catch (Exception& _e)
 	{
@@ -78,7 +80,31 @@ void TransactionBase::sign(AccountKeys::Secret const& _priv)
     auto sig = dev::sign<AccountKeys::Type>(_priv, sha3(WithoutSignature));
     AccountKeys::SignatureStruct sigStruct = AccountKeys::SignatureStruct(sig, toPublic<AccountKeys::Type>(_priv));
 	if (sigStruct.isValid())
+	{
 		m_vrs = sigStruct;
+		updateRLP();
+	}
+}
+
+void TransactionBase::updateRLP()
+{
+	m_rlp.reset();
+	m_hashWith = h256();
+	if (m_vrs && m_type != NullTransaction)
+	{
+		RLPStream s;
+		streamRLP(s);
+		m_rlp = make_shared<bytes const>(s.out());
+	}
+}
+
+bytesConstRef TransactionBase::rlpRef() const
+{
+	if (m_rlp)
+		return bytesConstRef(m_rlp.get());
+	if (m_type != NullTransaction)
+		BOOST_THROW_EXCEPTION(TransactionIsUnsigned());
+	return bytesConstRef();
 }
 
 void TransactionBase::streamRLP(RLPStream& _s, IncludeSignature _sig) const
@@ -86,6 +112,12 @@ void TransactionBase::streamRLP(RLPStream& _s, IncludeSignature _sig) const
 	if (m_type == NullTransaction)
 		return;
 
+	if (_sig && m_rlp)
+	{
+		_s.appendRaw(*m_rlp);
+		return;
+	}
+
     _s.appendList((_sig ? 1 : 0) + 6);
 	_s << m_nonce << m_gasPrice << m_gas;
 	if (m_type == MessageCall)
@@ -126,14 +158,18 @@ int64_t TransactionBase::baseGasRequired(bool _contractCreation, bytesConstRef _
 
 h256 TransactionBase::sha3(IncludeSignature _sig) const
 {
-	if (_sig == WithSignature && m_hashWith)
+	if (_sig == WithSignature)
+	{
+		if (!m_hashWith)
+			m_hashWith = dev::sha3(rlpRef());
 		return m_hashWith;
+	}
 
-	RLPStream s;
-    streamRLP(s, _sig);
-
-	auto ret = dev::sha3(s.out());
-	if (_sig == WithSignature)
-		m_hashWith = ret;
-	return ret;
+	if (!m_hashWithout)
+	{
+		RLPStream s;
+		streamRLP(s, WithoutSignature);
+		m_hashWithout = dev::sha3(s.out());
+	}
+	return m_hashWithout;
 }
@@ -93,7 +93,12 @@ public:
     void streamRLP(RLPStream& _s, IncludeSignature _sig = WithSignature) const;
 
 	/// @returns the RLP serialisation of this transaction.
-	bytes rlp(IncludeSignature _sig = WithSignature) const { RLPStream s; streamRLP(s, _sig); return s.out(); }
+	bytes rlp(IncludeSignature _sig = WithSignature) const { if (_sig && m_rlp) return *m_rlp; RLPStream s; streamRLP(s, _sig); return s.out(); }
+
+	/// @returns the RLP serialisation of this transaction with signature, without copying it.
+	/// The reference stays valid as long as this transaction (or any copy of it) is neither modified nor destroyed.
+	/// @throws TransactionIsUnsigned if the signature was not initialized
+	bytesConstRef rlpRef() const;
 
 	/// @returns the SHA3 hash of the RLP serialisation of this transaction.
 	h256 sha3(IncludeSignature _sig = WithSignature) const;
@@ -124,7 +129,7 @@ public:
 	u256 nonce() const { return m_nonce; }
 
 	/// Sets the nonce to the given value. Clears any signature.
-	void setNonce(u256 const& _n) { clearSignature(); m_nonce = _n; }
+	void setNonce(u256 const& _n) { m_nonce = _n; m_hashWithout = h256(); clearSignature(); }
 
 	/// @returns true if the transaction was signed
 	bool hasSignature() const { return m_vrs.is_initialized(); }
@@ -156,7 +161,10 @@ protected:
 	};
 
 	/// Clears the signature.
-	void clearSignature() { m_vrs = AccountKeys::SignatureStruct(); }
+	void clearSignature() { m_vrs = AccountKeys::SignatureStruct(); updateRLP(); }
+
+	/// Re-encodes the cached serialisation after the signature changed.
+	void updateRLP();
 
 	Type m_type = NullTransaction;		///< Is this a contract-creation transaction or a message-call transaction?
 	u256 m_nonce;						///< The transaction-count of the sender.
@@ -167,7 +175,9 @@ protected:
 	bytes m_data;						///< The data associated with the transaction, or the initialiser if it's a creation transaction.
     boost::optional<AccountKeys::SignatureStruct> m_vrs;	///< The signature of the transaction.  Encodes the sender.
 
+	std::shared_ptr<bytes const> m_rlp;	///< RLP with signature, as received or encoded when signed; shared between copies. Null if unsigned.
 	mutable h256 m_hashWith;			///< Cached hash of transaction with signature.
+	mutable h256 m_hashWithout;			///< Cached hash of transaction without signature.
     mutable Address m_forcedSender;
 };
 
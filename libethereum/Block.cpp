@@ -36,6 +36,7 @@
 #include "Executive.h"
 #include "TransactionQueue.h"
 #include "GenesisInfo.h"
+#include "ParallelExecutor.h"
 #include "websocket-api/WebsocketEvents.h"
 
 using namespace std;
@@ -492,28 +493,52 @@ u256 Block::enact(VerifiedBlockRef const& _block, BlockChain const& _bc)
 
 	// All ok with the block generally. Play back the transactions now...
 	unsigned i = 0;
-	DEV_TIMED_ABOVE("txExec", 500)
-		for (Transaction const& tr: _block.transactions)
+	if (ParallelExecutor::applies(m_currentBlock, *m_sealEngine, _block.transactions.size()))
+	{
+		DEV_TIMED_ABOVE("txExecParallel", 500)
 		{
-			try
+			LogOverride<ExecutiveWarnChannel> o(false);
+			uncommitToSeal();
+			for (TransactionReceipt const& r: ParallelExecutor::execute(m_state, m_currentBlock, _bc.lastBlockHashes(), *m_sealEngine, _block.transactions))
 			{
-				LogOverride<ExecutiveWarnChannel> o(false);
+				Transaction const& tr = _block.transactions[i++];
+				m_transactions.push_back(tr);
+				m_receipts.push_back(r);
+				m_transactionSet.insert(tr.sha3());
+				if (m_triggerPendingEvents)
+					WebsocketAPI::WebSocketEvents::getInstance()->triggerNewPendingTransactionEvent(tr);
+
+				RLPStream receiptRLP;
+				r.streamRLP(receiptRLP);
+				receipts.push_back(receiptRLP.out());
+			}
+		}
+	}
+	else
+	{
+		DEV_TIMED_ABOVE("txExec", 500)
+			for (Transaction const& tr: _block.transactions)
+			{
+				try
+				{
+					LogOverride<ExecutiveWarnChannel> o(false);
 //				cnote << "Enacting transaction: " << tr.nonce() << tr.from() << state().transactionsFrom(tr.from()) << tr.value();
-				execute(_bc.lastBlockHashes(), tr);
+					execute(_bc.lastBlockHashes(), tr);
 //				cnote << "Now: " << tr.from() << state().transactionsFrom(tr.from());
 //				cnote << m_state;
-			}
-			catch (Exception& ex)
-			{
-				ex << errinfo_transactionIndex(i);
-				throw;
-			}
+				}
+				catch (Exception& ex)
+				{
+					ex << errinfo_transactionIndex(i);
+					throw;
+				}
 
-			RLPStream receiptRLP;
-			m_receipts.back().streamRLP(receiptRLP);
-			receipts.push_back(receiptRLP.out());
-			++i;
-		}
+				RLPStream receiptRLP;
+				m_receipts.back().streamRLP(receiptRLP);
+				receipts.push_back(receiptRLP.out());
+				++i;
+			}
+	}
 
 	h256 receiptsRoot;
 	DEV_TIMED_ABOVE(".receiptsRoot()", 500)
@@ -166,6 +166,9 @@ public:
 	/// Get the backing state object.
 	State const& state() const { return m_state; }
 
+	/// Get the state transactions are executed on, which is without the rewards once committed to seal.
+	State const& executionState() const { return m_committedToSeal ? m_precommit : m_state; }
+
 	/// Open a DB - useful for passing into the constructor & keeping for other states that are necessary.
 	OverlayDB const& db() const { return m_state.db(); }
 
@@ -188,6 +191,9 @@ public:
 	/// Get the remaining gas limit in this block.
 	u256 gasLimitRemaining() const { return m_currentBlock.gasLimit() - gasUsed(); }
 
+	/// @returns gas used by transactions thus far executed.
+	u256 gasUsed() const { return m_receipts.size() ? m_receipts.back().gasUsed() : 0; }
+
 	/// Get the list of pending transactions.
 	Transactions const& pending() const { return m_transactions; }
 
@@ -298,9 +304,6 @@ private:
 	/// Finalise the block, applying the earned rewards.
 	void applyRewards(std::vector<BlockHeader> const& _uncleBlockHeaders, u256 const& _blockReward);
 
-	/// @returns gas used by transactions thus far executed.
-	u256 gasUsed() const { return m_receipts.size() ? m_receipts.back().gasUsed() : 0; }
-
 	/// Performs irregular modifications right after initialization, e.g. to implement a hard fork.
 	void performIrregularModifications();
 
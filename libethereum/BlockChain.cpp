@@ -26,6 +26,8 @@
 #include "Block.h"
 #include "Defaults.h"
 #include "ImportPerformanceLogger.h"
+#include "StatePrefetcher.h"
+#include "StoragePrefetcher.h"
 #include <libdevcore/Common.h>
 #include <libdevcore/Assertions.h>
 #include <libdevcore/RLP.h>
@@ -52,6 +54,10 @@ namespace
 {
 
 ldb::Slice const c_sliceChainStart{"chainStart"};
+ldb::Slice const c_logIndexFromKey{"logIndexFrom"};
+
+/// How many blocks backfillLogIndex() writes at once.
+unsigned const c_logIndexBackfillBatch = 1000;
 
 }
 
@@ -311,6 +317,19 @@ unsigned BlockChain::open(fs::path const& _path, WithExisting _we)
 	m_lastBlockHash = l.empty() ? m_genesisHash : *(h256*)l.data();
 	m_lastBlockNumber = number(m_lastBlockHash);
 
+	std::string indexed;
+	m_extrasDB->Get(m_readOptions, c_logIndexFromKey, &indexed);
+	if (indexed.empty())
+	{
+		// A new database is indexed from the genesis on; the blocks of one from before there
+		// was a log index only once they are backfilled.
+		ldb::WriteBatch batch;
+		noteLogIndexFrom(batch, l.empty() ? 0 : m_lastBlockNumber + 1);
+		m_extrasDB->Write(m_writeOptions, &batch);
+	}
+	else
+		m_logIndexFrom = RLP(indexed).toInt<unsigned>();
+
 	ctrace << "Opened blockchain DB. Latest: " << currentHash() << (lastMinor == c_minorProtocolVersion ? "(rebuild not needed)" : "*** REBUILD NEEDED ***");
 	return lastMinor;
 }
@@ -331,6 +350,8 @@ void BlockChain::reopen(ChainParams const& _p, WithExisting _we, ProgressCallbac
 void BlockChain::close()
 {
 	ctrace << "Closing blockchain DB";
+	DEV_GUARDED(x_prefetcher)
+		m_prefetcher.reset();
 	// Not thread safe...
 	delete m_extrasDB;
 	delete m_blocksDB;
@@ -393,6 +414,9 @@ void BlockChain::rebuild(fs::path const& _path, std::function<void(unsigned, uns
 	m_details[m_lastBlockHash].totalDifficulty = s.info().difficulty();
 
 	m_extrasDB->Put(m_writeOptions, toSlice(m_lastBlockHash, ExtraDetails), (ldb::Slice)dev::ref(m_details[m_lastBlockHash].rlp()));
+	ldb::WriteBatch indexBatch;
+	noteLogIndexFrom(indexBatch, 0);
+	m_extrasDB->Write(m_writeOptions, &indexBatch);
 
 	h256 lastHash = m_lastBlockHash;
 	Timer t;
@@ -453,6 +477,18 @@ tuple<ImportRoute, bool, unsigned> BlockChain::sync(BlockQueue& _bq, OverlayDB c
 	VerifiedBlocks blocks;
 	_bq.drain(blocks, _max);
 
+	// Start loading the accounts of all drained blocks while the first ones are executed. A state
+	// held only in memory has nothing to load from disk.
+	if (!blocks.empty() && _stateDB.db())
+		DEV_GUARDED(x_prefetcher)
+		{
+			if (!m_prefetcher || m_prefetcher->db() != _stateDB.db())
+				m_prefetcher.reset(new StatePrefetcher(_stateDB));
+			h256 const root = info().stateRoot();
+			for (VerifiedBlock const& block: blocks)
+				m_prefetcher->prefetch(block.verified, root);
+		}
+
 	h256s fresh;
 	h256s dead;
 	h256s badBlocks;
@@ -507,6 +543,11 @@ tuple<ImportRoute, bool, unsigned> BlockChain::sync(BlockQueue& _bq, OverlayDB c
 			}
 		} while (false);
 	}
+	if (count && StoragePrefetcher::instance().enabled())
+	{
+		StoragePrefetchStats const s = StoragePrefetcher::instance().stats();
+		clog(StoragePrefetchChannel) << "Storage prefetch: hit rate" << s.hitRate() << "over" << s.reads << "reads," << s.predictedCalls << "of" << s.calls << "calls predicted," << s.prefetched << "slots prefetched," << s.dropped << "dropped";
+	}
 	return make_tuple(ImportRoute{dead, fresh, goodTransactions}, _bq.doneDrain(badBlocks), count);
 }
 
@@ -863,6 +904,9 @@ ImportRoute BlockChain::insertBlockAndExtras(VerifiedBlockRef const& _block, byt
 					extrasBatch.Put(toSlice(sha3(blockRLP[1][ta.index].data()), ExtraTransactionAddress), (ldb::Slice)dev::ref(ta.rlp()));
 			}
 
+			// Note whose logs are where.
+			LogIndex::write(extrasBatch, (unsigned)tbi.number(), tbi.hash(), *i == _block.info.hash() ? BlockReceipts(RLP(_receipts)).receipts : receipts(*i).receipts);
+
 			// Update database with them.
 			ReadGuard l1(x_blocksBlooms);
 			for (auto const& h: alteredBlooms)
@@ -1068,6 +1112,46 @@ void BlockChain::rescue(OverlayDB const& _db)
 	rewind(l);
 }
 
+void BlockChain::noteLogIndexFrom(ldb::WriteBatch& o_batch, unsigned _number)
+{
+	o_batch.Put(c_logIndexFromKey, (ldb::Slice)dev::ref(rlp(_number)));
+	m_logIndexFrom = _number;
+}
+
+void BlockChain::withLogIndex(LogFilter const& _filter, unsigned _earliest, unsigned _latest, LogIndex::OnCandidate const& _f) const
+{
+	LogIndex::forEachCandidate(m_extrasDB, _filter, _earliest, _latest, [&](unsigned _n) { return numberHash(_n); }, _f);
+}
+
+void BlockChain::backfillLogIndex(ProgressCallback const& _progress)
+{
+	unsigned const from = m_logIndexFrom;
+	ldb::WriteBatch batch;
+	for (unsigned n = from; n > 0; --n)
+	{
+		unsigned const number = n - 1;
+		h256 const hash = numberHash(number);
+		LogIndex::write(batch, number, hash, receipts(hash).receipts);
+		if (number % c_logIndexBackfillBatch)
+			continue;
+
+		// The index is complete from here on once the batch is written, so move the mark with it.
+		ldb::WriteBatch done;
+		swap(batch, done);
+		done.Put(c_logIndexFromKey, (ldb::Slice)dev::ref(rlp(number)));
+		ldb::Status o = m_extrasDB->Write(m_writeOptions, &done);
+		if (!o.ok())
+		{
+			cwarn << "Error writing the log index to extras database: " << o.ToString();
+			return;
+		}
+		m_logIndexFrom = number;
+		garbageCollect();
+		if (_progress)
+			_progress(from - number, from);
+	}
+}
+
 void BlockChain::rewind(unsigned _newHead)
 {
 	DEV_WRITE_GUARDED(x_lastBlockHash)
@@ -26,6 +26,7 @@
 #include "BlockQueue.h"
 #include "ChainParams.h"
 #include "LastBlockHashesFace.h"
+#include "LogIndex.h"
 #include "State.h"
 #include "Transaction.h"
 #include "VerifiedBlock.h"
@@ -36,6 +37,7 @@
 #include <libethcore/BlockHeader.h>
 #include <libethcore/Common.h>
 #include <libethcore/SealEngine.h>
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <unordered_map>
@@ -63,6 +65,7 @@ static const h256s NullH256s;
 class State;
 class Block;
 class ImportPerformanceLogger;
+class StatePrefetcher;
 
 DEV_SIMPLE_EXCEPTION(AlreadyHaveBlock);
 DEV_SIMPLE_EXCEPTION(FutureTime);
@@ -91,7 +94,8 @@ enum {
 	ExtraTransactionAddress,
 	ExtraLogBlooms,
 	ExtraReceipts,
-	ExtraBlocksBlooms
+	ExtraBlocksBlooms,
+	ExtraLogIndex
 };
 
 using ProgressCallback = std::function<void(unsigned, unsigned)>;
@@ -246,6 +250,19 @@ public:
 	/// Will call _progress with the progress in this operation first param done, second total.
 	void rebuild(boost::filesystem::path const& _path, ProgressCallback const& _progress = std::function<void(unsigned, unsigned)>());
 
+	/// @returns the lowest block number from which on the log index covers the canonical chain.
+	/// Blocks below it were imported before there was a log index and need backfillLogIndex().
+	unsigned logIndexFrom() const { return m_logIndexFrom; }
+
+	/// Calls @a _f, in block order, for each canonical block from @a _earliest to @a _latest that
+	/// the log index has logs of the addresses and topics of @a _filter for. @a _earliest must
+	/// not be below logIndexFrom() and @a _filter must not be a range filter.
+	void withLogIndex(LogFilter const& _filter, unsigned _earliest, unsigned _latest, LogIndex::OnCandidate const& _f) const;
+
+	/// Adds the blocks below logIndexFrom() to the log index, latest first.
+	/// Will call _progress with the progress in this operation first param done, second total.
+	void backfillLogIndex(ProgressCallback const& _progress = ProgressCallback());
+
 	/// Alter the head of the chain to some prior block along it.
 	void rewind(unsigned _newHead);
 
@@ -411,6 +428,10 @@ private:
 	h256 m_lastBlockHash;
 	unsigned m_lastBlockNumber = 0;
 
+	/// The canonical blocks from this number on are in the log index.
+	std::atomic<unsigned> m_logIndexFrom{0};
+	void noteLogIndexFrom(ldb::WriteBatch& o_batch, unsigned _number);
+
 	ldb::ReadOptions m_readOptions;
 	ldb::WriteOptions m_writeOptions;
 
@@ -426,6 +447,10 @@ private:
 
 	boost::filesystem::path m_dbPath;
 
+	/// Loads the state of drained blocks while earlier ones execute; remade only when sync() is given another state database.
+	Mutex x_prefetcher;
+	std::unique_ptr<StatePrefetcher> m_prefetcher;
+
 	friend std::ostream& operator<<(std::ostream& _out, BlockChain const& _bc);
 };
 
@@ -21,16 +21,23 @@
 
 #include "BlockChainSync.h"
 
+#include <atomic>
 #include <chrono>
+#include <future>
+#include <thread>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <libdevcore/Common.h>
 #include <libdevcore/TrieHash.h>
 #include <libp2p/Host.h>
 #include <libp2p/Session.h>
 #include <libethcore/Exceptions.h>
 #include "BlockChain.h"
+#include "BlockChainImporter.h"
 #include "BlockQueue.h"
 #include "EthereumPeer.h"
 #include "EthereumHost.h"
+#include "StateDownloader.h"
 #include "websocket-api/WebsocketEvents.h"
 
 using namespace std;
@@ -40,7 +47,10 @@ using namespace p2p;
 
 unsigned const c_maxPeerUknownNewBlocks = 1024; /// Max number of unknown new blocks peer can give us
 unsigned const c_maxRequestHeaders = 1024;
-unsigned const c_maxRequestBodies = 1024;
+unsigned const c_maxRequestBodies = c_maxBlocksAsk;	///< Peers send no more than c_maxBlocks anyway; smaller asks spread bodies over more peers
+unsigned const c_minParallelSealChecks = 16;	///< Smaller header batches are checked on the calling thread
+unsigned const c_pivotDistance = 64;		///< Blocks between the fast sync pivot and the head, so that it is unlikely to be reorganised away
+unsigned const c_pivotWindow = 256;			///< Blocks inserted up to the pivot: the look-back of aged stake balances and BLOCKHASH
 
 
 std::ostream& dev::eth::operator<<(std::ostream& _out, SyncStatus const& _sync)
@@ -55,6 +65,13 @@ std::ostream& dev::eth::operator<<(std::ostream& _out, SyncStatus const& _sync)
 namespace  // Helper functions.
 {
 
+/// Threads the seals of large header batches are checked on, shared by all syncs.
+boost::asio::thread_pool& sealCheckPool()
+{
+	static boost::asio::thread_pool s_pool(std::max(std::thread::hardware_concurrency(), 1U));
+	return s_pool;
+}
+
 template<typename T> bool haveItem(std::map<unsigned, T>& _container, unsigned _number)
 {
 	if (_container.empty())
@@ -163,7 +180,8 @@ BlockChainSync::BlockChainSync(EthereumHost& _host):
 	m_chainStartBlock(_host.chain().chainStartBlockNumber()),
 	m_startingBlock(_host.chain().number()),
 	m_lastImportedBlock(m_startingBlock),
-	m_lastImportedBlockHash(_host.chain().currentHash())
+	m_lastImportedBlockHash(_host.chain().currentHash()),
+	m_compactBlocks(_host.tq())
 {
 	m_bqRoomAvailable = host().bq().onRoomAvailable([this]()
 	{
@@ -213,7 +231,7 @@ void BlockChainSync::onPeerStatus(std::shared_ptr<EthereumPeer> _peer)
 		return; // Expired
 	if (_peer->m_genesisHash != host().chain().genesisHash())
 		_peer->disable("Invalid genesis hash");
-	else if (_peer->m_protocolVersion != host().protocolVersion() && _peer->m_protocolVersion != EthereumHost::c_oldProtocolVersion)
+	else if (_peer->m_protocolVersion != host().protocolVersion() && _peer->m_protocolVersion != EthereumHost::c_legacyTransactionsProtocolVersion && _peer->m_protocolVersion != EthereumHost::c_oldProtocolVersion)
 		_peer->disable("Invalid protocol version.");
 	else if (_peer->m_networkId != host().networkId())
 		_peer->disable("Invalid network identifier.");
@@ -238,6 +256,12 @@ void BlockChainSync::syncPeer(std::shared_ptr<EthereumPeer> _peer, bool _force)
 	if (m_state == SyncState::Waiting)
 		return;
 
+	if (m_state == SyncState::State)
+	{
+		requestState(_peer);
+		return;
+	}
+
 	u256 td = host().chain().details().totalDifficulty;
 	if (host().bq().isActive())
 		td += host().bq().difficulty();
@@ -249,7 +273,13 @@ void BlockChainSync::syncPeer(std::shared_ptr<EthereumPeer> _peer, bool _force)
 		// start sync
 		m_syncingTotalDifficulty = _peer->m_totalDifficulty;
 		if (m_state == SyncState::Idle || m_state == SyncState::NotSynced)
-			m_state = SyncState::Blocks;
+		{
+			// Fast sync only makes sense from genesis, and needs GetNodeData from the peer.
+			bool const fastSync = host().fastSyncImporter() && host().chain().number() == 0 && _peer->m_protocolVersion != EthereumHost::c_oldProtocolVersion;
+			m_state = fastSync ? SyncState::State : SyncState::Blocks;
+			if (fastSync)
+				m_pivotPeer = _peer;
+		}
 		_peer->requestBlockHeaders(_peer->m_latestHash, 1, 0, false);
 		_peer->m_requireTransactions = true;
 
@@ -268,11 +298,19 @@ void BlockChainSync::syncPeer(std::shared_ptr<EthereumPeer> _peer, bool _force)
 
 void BlockChainSync::continueSync()
 {
-	host().foreachPeer([this](std::shared_ptr<EthereumPeer> _p)
+	std::vector<std::shared_ptr<EthereumPeer>> peers;
+	host().foreachPeer([&](std::shared_ptr<EthereumPeer> _p)
 	{
-		syncPeer(_p, false);
+		peers.push_back(_p);
 		return true;
 	});
+	// Fastest first, so that the ranges needed soonest go to the peers likely to deliver them soonest.
+	std::stable_sort(peers.begin(), peers.end(), [](std::shared_ptr<EthereumPeer> const& _a, std::shared_ptr<EthereumPeer> const& _b)
+	{
+		return _a->throughput().bandwidth() > _b->throughput().bandwidth();
+	});
+	for (auto const& p: peers)
+		syncPeer(p, false);
 }
 
 void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
@@ -289,9 +327,10 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 	h256s neededBodies;
 	vector<unsigned> neededNumbers;
 	unsigned index = 0;
+	unsigned const maxBodies = _peer->throughput().capacity(Asking::BlockBodies, c_maxRequestBodies);
 	if (m_haveCommonHeader && !m_headers.empty() && m_headers.begin()->first == m_lastImportedBlock + 1)
 	{
-		while (header != m_headers.end() && neededBodies.size() < c_maxRequestBodies && index < header->second.size())
+		while (header != m_headers.end() && neededBodies.size() < maxBodies && index < header->second.size())
 		{
 			unsigned block = header->first + index;
 			if (m_downloadingBodies.count(block) == 0 && !haveItem(m_bodies, block))
@@ -327,6 +366,8 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 			if (start <= m_chainStartBlock + 1)
 				m_haveCommonHeader = true; //reached chain start
 		}
+		if (m_haveCommonHeader && requestSkeleton(_peer))
+			return;
 		if (m_haveCommonHeader)
 		{
 			start = m_lastImportedBlock + 1;
@@ -340,7 +381,7 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 
 			while (count == 0 && next != m_headers.end())
 			{
-				count = std::min(c_maxRequestHeaders, next->first - start);
+				count = std::min(_peer->throughput().capacity(Asking::BlockHeaders, c_maxRequestHeaders), next->first - start);
 				while(count > 0 && m_downloadingHeaders.count(start) != 0)
 				{
 					start++;
@@ -372,8 +413,32 @@ void BlockChainSync::requestBlocks(std::shared_ptr<EthereumPeer> _peer)
 	}
 }
 
+bool BlockChainSync::requestSkeleton(std::shared_ptr<EthereumPeer> _peer)
+{
+	// Only a peer on the best chain we know of gets to lay out the skeleton; the gaps between its
+	// headers are then fetched from everyone and checked against it when they are merged.
+	if (_peer->m_totalDifficulty < m_syncingTotalDifficulty)
+		return false;
+	std::vector<unsigned> const headers = m_skeleton.request(m_lastImportedBlock, m_highestBlock);
+	if (headers.empty())
+		return false;
+
+	for (unsigned block: headers)
+		m_downloadingHeaders.insert(block);
+	m_skeletonPeer = _peer;
+	m_headerSyncPeers[_peer] = headers;
+	clog(NetAllDetail) << "Requesting skeleton of" << headers.size() << "headers from" << headers.front();
+	_peer->requestBlockHeaders(headers.front(), headers.size(), HeaderSkeleton::c_step - 1, false);
+	return true;
+}
+
 void BlockChainSync::clearPeerDownload(std::shared_ptr<EthereumPeer> _peer)
 {
+	if (m_skeletonPeer.lock() == _peer)
+	{
+		m_skeleton.cancel();
+		m_skeletonPeer.reset();
+	}
 	auto syncPeer = m_headerSyncPeers.find(_peer);
 	if (syncPeer != m_headerSyncPeers.end())
 	{
@@ -388,10 +453,13 @@ void BlockChainSync::clearPeerDownload(std::shared_ptr<EthereumPeer> _peer)
 			m_downloadingBodies.erase(block);
 		m_bodySyncPeers.erase(syncPeer);
 	}
+	releaseStateRequest(takeStateRequest(_peer));
 }
 
 void BlockChainSync::clearPeerDownload()
 {
+	if (m_skeletonPeer.expired())
+		m_skeleton.cancel();
 	for (auto s = m_headerSyncPeers.begin(); s != m_headerSyncPeers.end();)
 	{
 		if (s->first.expired())
@@ -414,6 +482,16 @@ void BlockChainSync::clearPeerDownload()
 		else
 			++s;
 	}
+	for (auto s = m_stateSyncPeers.begin(); s != m_stateSyncPeers.end();)
+	{
+		if (s->first.expired())
+		{
+			releaseStateRequest(s->second);
+			m_stateSyncPeers.erase(s++);
+		}
+		else
+			++s;
+	}
 }
 
 void BlockChainSync::logNewBlock(h256 const& _h)
@@ -421,12 +499,83 @@ void BlockChainSync::logNewBlock(h256 const& _h)
 	m_knownNewHashes.erase(_h);
 }
 
+bool BlockChainSync::verifyHeaderSeals(RLP const& _r) const
+{
+	return verifyHeaderSeals(*host().chain().sealEngine(), _r);
+}
+
+bool BlockChainSync::verifyHeaderSeals(SealEngineFace const& _sealEngine, RLP const& _r)
+{
+	size_t const itemCount = _r.itemCount();
+	std::atomic<size_t> next{0};
+	std::atomic<bool> valid{true};
+	auto verify = [&]()
+	{
+		try
+		{
+			for (size_t i = next++; i < itemCount && valid; i = next++)
+			{
+				BlockHeader info(_r[i].data(), HeaderData);
+				// Headers of a batch are usually consecutive, so the parent is often at hand.
+				BlockHeader parent;
+				if (i > 0)
+				{
+					BlockHeader previous(_r[i - 1].data(), HeaderData);
+					if (previous.hash() == info.parentHash())
+						parent = previous;
+				}
+				if (!_sealEngine.verifyHeaderSeal(info, parent))
+				{
+					clog(NetImpolite) << "Invalid seal on header" << info.number() << info.hash();
+					valid = false;
+				}
+			}
+		}
+		catch (Exception const& _e)
+		{
+			clog(NetImpolite) << "Malformed block header:" << _e.what();
+			valid = false;
+		}
+	};
+
+	unsigned const threads = itemCount < c_minParallelSealChecks ? 1 : std::min<unsigned>(std::max(std::thread::hardware_concurrency(), 1U), itemCount / c_minParallelSealChecks + 1);
+	std::vector<std::future<void>> helpers;
+	for (unsigned t = 1; t < threads; ++t)
+	{
+		auto task = std::make_shared<std::packaged_task<void()>>(verify);
+		helpers.push_back(task->get_future());
+		boost::asio::post(sealCheckPool(), [task]() { (*task)(); });
+	}
+	verify();
+	// The helpers refer to this frame, so all of them must be done before anything is passed on.
+	for (auto& h: helpers)
+		h.wait();
+	for (auto& h: helpers)
+		h.get();
+	return valid;
+}
+
+void BlockChainSync::onPeerInvalidHeaders(std::shared_ptr<EthereumPeer> _peer)
+{
+	RecursiveGuard l(x_sync);
+	clearPeerDownload(_peer);
+	_peer->disable("Invalid block header seal.");
+	continueSync();
+}
+
 void BlockChainSync::onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
 {
 	RecursiveGuard l(x_sync);
 	DEV_INVARIANT_CHECK;
 	size_t itemCount = _r.itemCount();
 	clog(NetMessageSummary) << "BlocksHeaders (" << dec << itemCount << "entries)" << (itemCount ? "" : ": NoMoreHeaders");
+	if (m_state == SyncState::State)
+	{
+		onPeerPivotHeaders(_peer, _r);
+		return;
+	}
+	// Taken before clearPeerDownload() forgets the request; the skeleton only grows by what is merged.
+	std::vector<unsigned> const skeleton = m_skeletonPeer.lock() == _peer ? m_skeleton.requested() : std::vector<unsigned>();
 	clearPeerDownload(_peer);
 	if (m_state != SyncState::Blocks && m_state != SyncState::Waiting)
 	{
@@ -525,6 +674,7 @@ void BlockChainSync::onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP
 				m_headerIdToNumber[headerId] = blockNumber;
 		}
 	}
+	m_skeleton.accept(skeleton, [&](unsigned _block) { return _block <= m_lastImportedBlock || haveItem(m_headers, _block); });
 	collectBlocks();
 	continueSync();
 }
@@ -535,6 +685,11 @@ void BlockChainSync::onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP
 	DEV_INVARIANT_CHECK;
 	size_t itemCount = _r.itemCount();
 	clog(NetMessageSummary) << "BlocksBodies (" << dec << itemCount << "entries)" << (itemCount ? "" : ": NoMoreBodies");
+	if (m_state == SyncState::State)
+	{
+		onPeerPivotBodies(_peer, _r);
+		return;
+	}
 	clearPeerDownload(_peer);
 	if (m_state != SyncState::Blocks && m_state != SyncState::Waiting) {
 		clog(NetMessageSummary) << "Ignoring unexpected blocks";
@@ -770,6 +925,14 @@ void BlockChainSync::resetSync()
 	m_bodySyncPeers.clear();
 	m_headerIdToNumber.clear();
 	m_syncingTotalDifficulty = 0;
+	m_skeleton.reset();
+	m_skeletonPeer.reset();
+	m_pivotPeer.reset();
+	m_pivot = PivotWindow();
+	m_stateDownloader.reset();
+	m_downloadingPivotBodies.clear();
+	m_downloadingPivotReceipts.clear();
+	m_stateSyncPeers.clear();
 	m_state = SyncState::NotSynced;
 }
 
@@ -853,6 +1016,405 @@ void BlockChainSync::onPeerNewHashes(std::shared_ptr<EthereumPeer> _peer, std::v
 	}
 }
 
+void BlockChainSync::onPeerCompactBlock(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	RecursiveGuard l(x_sync);
+	DEV_INVARIANT_CHECK;
+
+	BlockHeader info(_r[0].data(), HeaderData);
+	auto h = info.hash();
+	DEV_GUARDED(_peer->x_knownBlocks)
+		_peer->m_knownBlocks.insert(h);
+	if (host().chain().isKnown(h) || host().bq().blockStatus(h) != QueueStatus::Unknown)
+		return;
+	if (static_cast<unsigned>(info.number()) > m_lastImportedBlock + 1)
+	{
+		clog(NetAllDetail) << "Received unknown new compact block";
+		syncPeer(_peer, true);
+		return;
+	}
+
+	vector<unsigned> const missing = m_compactBlocks.assemble(info, _r);
+	clog(NetMessageSummary) << "NewCompactBlock" << h << "(" << dec << _r[1].itemCount() << "transactions," << missing.size() << "missing)";
+	if (missing.empty())
+		importCompactBlock(_peer, h);
+	else
+		_peer->requestBlockTransactions(h, missing);
+}
+
+void BlockChainSync::onPeerBlockTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	RecursiveGuard l(x_sync);
+	DEV_INVARIANT_CHECK;
+
+	auto h = _r[0].toHash<h256>();
+	switch (m_compactBlocks.supply(h, _r[1]))
+	{
+	case CompactBlockStatus::Complete:
+		importCompactBlock(_peer, h);
+		break;
+	case CompactBlockStatus::Invalid:
+		_peer->disable("Block transactions do not match the header.");
+		break;
+	case CompactBlockStatus::Unknown:
+		clog(NetImpolite) << "Peer giving us transactions of a block we are not assembling.";
+		break;
+	}
+}
+
+void BlockChainSync::importCompactBlock(std::shared_ptr<EthereumPeer> _peer, h256 const& _h)
+{
+	bytes const block = m_compactBlocks.take(_h);
+	if (!block.empty())
+		onPeerNewBlock(_peer, RLP(block));
+}
+
+void BlockChainSync::requestState(std::shared_ptr<EthereumPeer> _peer)
+{
+	clearPeerDownload(_peer);
+	if (m_pivot.headers.empty())
+	{
+		// The pivot comes from the best chain we know of; nothing else can be asked for before it.
+		if (m_pivotPeer.expired() && _peer->m_totalDifficulty >= m_syncingTotalDifficulty)
+		{
+			m_pivotPeer = _peer;
+			m_pivot.head = BlockHeader();
+			_peer->requestBlockHeaders(_peer->m_latestHash, 1, 0, false);
+		}
+		return;
+	}
+
+	auto missing = [&](std::vector<bytes> const& _have, h256Hash& _downloading, Asking _asking)
+	{
+		unsigned const max = _peer->throughput().capacity(_asking, c_maxBlocksAsk);
+		h256s ret;
+		for (unsigned i = 0; i < m_pivot.headers.size() && ret.size() < max; ++i)
+			if (_have[i].empty() && _downloading.insert(m_pivot.headers[i].hash()).second)
+				ret.push_back(m_pivot.headers[i].hash());
+		return ret;
+	};
+
+	h256s hashes = missing(m_pivot.bodies, m_downloadingPivotBodies, Asking::BlockBodies);
+	if (!hashes.empty())
+	{
+		m_stateSyncPeers[_peer] = make_pair(Asking::BlockBodies, hashes);
+		_peer->requestBlockBodies(hashes);
+		return;
+	}
+	// Receipts and node data are not part of eth/62.
+	if (_peer->m_protocolVersion == EthereumHost::c_oldProtocolVersion)
+		return;
+	hashes = missing(m_pivot.receipts, m_downloadingPivotReceipts, Asking::Receipts);
+	if (!hashes.empty())
+	{
+		m_stateSyncPeers[_peer] = make_pair(Asking::Receipts, hashes);
+		_peer->requestReceipts(hashes);
+		return;
+	}
+	hashes = m_stateDownloader->request(_peer->throughput().capacity(Asking::NodeData, c_maxNodes));
+	if (!hashes.empty())
+	{
+		m_stateSyncPeers[_peer] = make_pair(Asking::NodeData, hashes);
+		_peer->requestNodeData(hashes);
+	}
+}
+
+void BlockChainSync::onPeerPivotHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	if (m_pivotPeer.lock() != _peer || !m_pivot.headers.empty())
+	{
+		clog(NetAllDetail) << "Ignoring headers while downloading state";
+		return;
+	}
+
+	size_t const itemCount = _r.itemCount();
+	if (!m_pivot.head)
+	{
+		// The peer's head: check the chain up to it from genesis, the window is chosen from its end.
+		if (itemCount != 1)
+		{
+			m_pivotPeer.reset();
+			continueSync();
+			return;
+		}
+		BlockHeader const head(_r[0].data(), HeaderData);
+		unsigned const number = static_cast<unsigned>(head.number());
+		if (head.hash() != _peer->m_latestHash)
+		{
+			m_pivotPeer.reset();
+			continueSync();
+		}
+		else if (number < c_pivotDistance + c_pivotWindow)
+		{
+			clog(NetNote) << "Chain too short for fast sync, downloading blocks";
+			m_pivotPeer.reset();
+			m_state = SyncState::Blocks;
+			onPeerBlockHeaders(_peer, _r);
+		}
+		else
+		{
+			m_pivot.head = head;
+			// Headers verified for an earlier pivot peer are kept if they are still below this head.
+			if (m_pivot.verified.empty() || m_pivot.verified.back().number() >= head.number())
+			{
+				m_pivot.verified.assign(1, host().chain().genesis());
+				m_pivot.verifiedDifficulties.assign(1, host().chain().details(host().chain().genesisHash()).totalDifficulty);
+			}
+			requestPivotHeaders(_peer);
+		}
+		return;
+	}
+
+	// The next headers towards the head. Their seals were checked against each other before
+	// they got here; the first one still needs checking against the last one verified.
+	SealEngineFace const& sealEngine = *host().chain().sealEngine();
+	bool linked = itemCount > 0;
+	try
+	{
+		for (unsigned i = 0; linked && i < itemCount && m_pivot.verified.back().number() < m_pivot.head.number(); ++i)
+		{
+			BlockHeader const h(_r[i].data(), HeaderData);
+			BlockHeader const& parent = m_pivot.verified.back();
+			linked = h.number() == parent.number() + 1 && h.parentHash() == parent.hash();
+			if (!linked)
+				break;
+			if (i == 0 && !sealEngine.verifyHeaderSeal(h, parent))
+			{
+				// What was verified before still leads back to genesis; another peer can carry on from it.
+				_peer->disable("Invalid seal on a fast sync header.");
+				m_pivotPeer.reset();
+				continueSync();
+				return;
+			}
+			m_pivot.verifiedDifficulties.push_back(m_pivot.verifiedDifficulties.back() + h.difficulty());
+			m_pivot.verified.push_back(h);
+			if (m_pivot.verified.size() > c_pivotDistance + c_pivotWindow)
+			{
+				m_pivot.verified.pop_front();
+				m_pivot.verifiedDifficulties.pop_front();
+			}
+		}
+	}
+	catch (Exception const& _e)
+	{
+		clog(NetImpolite) << "Malformed fast sync header:" << _e.what();
+		linked = false;
+	}
+	BlockHeader const& last = m_pivot.verified.back();
+	if (!linked || (last.number() == m_pivot.head.number() && last.hash() != m_pivot.head.hash()))
+	{
+		// Most likely the peer has moved on to another branch since; start over.
+		clog(NetAllDetail) << "Headers for the fast sync pivot do not lead from genesis to the peer's head";
+		_peer->addRating(-1);
+		m_pivotPeer.reset();
+		m_pivot = PivotWindow();
+		continueSync();
+		return;
+	}
+	if (last.number() < m_pivot.head.number())
+	{
+		clog(NetMessageSummary) << "Fast sync headers verified up to" << last.number() << "of" << m_pivot.head.number();
+		requestPivotHeaders(_peer);
+		return;
+	}
+
+	// The pivot window is the verified headers before the last c_pivotDistance, with the total
+	// difficulties summed over them rather than the peer's claim.
+	std::deque<BlockHeader> const headers = move(m_pivot.verified);
+	std::deque<u256> const totalDifficulties = move(m_pivot.verifiedDifficulties);
+	m_pivot = PivotWindow();
+	m_stateDownloader.reset(new StateDownloader(host().db()));
+	bytes emptyBody;
+	{
+		RLPStream s(2);
+		s.appendRaw(RLPEmptyList).appendRaw(RLPEmptyList);
+		s.swapOut(emptyBody);
+	}
+	for (unsigned i = 0; i < c_pivotWindow; ++i)
+	{
+		BlockHeader const& h = headers[i];
+		m_pivot.indices[h.hash()] = i;
+		m_pivot.headers.push_back(h);
+		m_pivot.totalDifficulties.push_back(totalDifficulties[i]);
+		bool const noTransactions = h.transactionsRoot() == EmptyTrie;
+		m_pivot.bodies.push_back(noTransactions && h.sha3Uncles() == EmptyListSHA3 ? emptyBody : bytes());
+		m_pivot.receipts.push_back(noTransactions ? RLPEmptyList : bytes());
+		m_stateDownloader->addRoot(h.stateRoot());
+	}
+	m_highestBlock = max(m_highestBlock, static_cast<unsigned>(headers.back().number()));
+	clog(NetNote) << "Fast sync pivot is block" << m_pivot.headers.back().number() << m_pivot.headers.back().hash();
+	continueStateSync();
+}
+
+void BlockChainSync::requestPivotHeaders(std::shared_ptr<EthereumPeer> _peer)
+{
+	unsigned const from = static_cast<unsigned>(m_pivot.verified.back().number()) + 1;
+	unsigned const count = std::min(_peer->throughput().capacity(Asking::BlockHeaders, c_maxRequestHeaders), static_cast<unsigned>(m_pivot.head.number()) + 1 - from);
+	_peer->requestBlockHeaders(from, count, 0, false);
+}
+
+void BlockChainSync::onPeerPivotBodies(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	auto request = takeStateRequest(_peer);
+	unsigned got = 0;
+	if (request.first == Asking::BlockBodies)
+		for (auto const& body: _r)
+		{
+			auto txList = body[0];
+			h256 const transactionsRoot = trieRootOver(txList.itemCount(), [&](unsigned i){ return rlp(i); }, [&](unsigned i){ return txList[i].data().toBytes(); });
+			h256 const uncles = sha3(body[1].data());
+			for (h256 const& h: request.second)
+			{
+				unsigned const i = m_pivot.indices[h];
+				if (m_pivot.bodies[i].empty() && m_pivot.headers[i].transactionsRoot() == transactionsRoot && m_pivot.headers[i].sha3Uncles() == uncles)
+				{
+					m_pivot.bodies[i] = body.data().toBytes();
+					++got;
+					break;
+				}
+			}
+		}
+	if (!got)
+		_peer->addRating(-1);
+	releaseStateRequest(request);
+	continueStateSync();
+}
+
+void BlockChainSync::onPeerReceipts(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	RecursiveGuard l(x_sync);
+	DEV_INVARIANT_CHECK;
+	auto request = takeStateRequest(_peer);
+	if (m_state != SyncState::State || request.first != Asking::Receipts)
+	{
+		clog(NetAllDetail) << "Ignoring unexpected receipts";
+		releaseStateRequest(request);
+		return;
+	}
+
+	// Peers skip blocks they do not know, so check each list against its header.
+	unsigned got = 0;
+	for (unsigned i = 0; i < _r.itemCount() && i < request.second.size(); ++i)
+	{
+		unsigned const index = m_pivot.indices[request.second[i]];
+		if (!m_pivot.receipts[index].empty())
+			continue;
+		vector<bytesConstRef> receipts;
+		for (auto const& r: _r[i])
+			receipts.push_back(r.data());
+		if (orderedTrieRoot(receipts) == m_pivot.headers[index].receiptsRoot())
+		{
+			m_pivot.receipts[index] = _r[i].data().toBytes();
+			++got;
+		}
+	}
+	if (!got)
+		_peer->addRating(-1);
+	releaseStateRequest(request);
+	continueStateSync();
+}
+
+void BlockChainSync::onPeerNodeData(std::shared_ptr<EthereumPeer> _peer, RLP const& _r)
+{
+	RecursiveGuard l(x_sync);
+	DEV_INVARIANT_CHECK;
+	auto request = takeStateRequest(_peer);
+	if (m_state != SyncState::State || request.first != Asking::NodeData || !m_stateDownloader)
+	{
+		clog(NetAllDetail) << "Ignoring unexpected node data";
+		releaseStateRequest(request);
+		return;
+	}
+
+	unsigned const useful = m_stateDownloader->deliver(request.second, _r);
+	if (!useful)
+		_peer->addRating(-1);
+	clog(NetMessageSummary) << "NodeData:" << useful << "of" << request.second.size() << "nodes useful;" << m_stateDownloader->downloaded() << "downloaded," << m_stateDownloader->pending() << "pending";
+	continueStateSync();
+}
+
+pair<Asking, h256s> BlockChainSync::takeStateRequest(std::shared_ptr<EthereumPeer> _peer)
+{
+	pair<Asking, h256s> ret(Asking::Nothing, h256s());
+	auto it = m_stateSyncPeers.find(_peer);
+	if (it != m_stateSyncPeers.end())
+	{
+		ret = move(it->second);
+		m_stateSyncPeers.erase(it);
+	}
+	if (m_pivotPeer.lock() == _peer)
+		m_pivotPeer.reset();
+	return ret;
+}
+
+void BlockChainSync::releaseStateRequest(pair<Asking, h256s> const& _request)
+{
+	switch (_request.first)
+	{
+	case Asking::BlockBodies:
+		for (h256 const& h: _request.second)
+			m_downloadingPivotBodies.erase(h);
+		break;
+	case Asking::Receipts:
+		for (h256 const& h: _request.second)
+			m_downloadingPivotReceipts.erase(h);
+		break;
+	case Asking::NodeData:
+		if (m_stateDownloader)
+			m_stateDownloader->cancel(_request.second);
+		break;
+	default:;
+	}
+}
+
+void BlockChainSync::continueStateSync()
+{
+	auto missing = [](std::vector<bytes> const& _v) { return any_of(_v.begin(), _v.end(), [](bytes const& _b) { return _b.empty(); }); };
+	if (!m_stateDownloader || !m_stateDownloader->complete() || missing(m_pivot.bodies) || missing(m_pivot.receipts))
+	{
+		continueSync();
+		return;
+	}
+
+	BlockChainImporterFace* importer = host().fastSyncImporter();
+	if (!importer)
+	{
+		clog(NetNote) << "Fast sync was turned off; replaying the chain instead.";
+		restartSync();
+		continueSync();
+		return;
+	}
+	try
+	{
+		for (unsigned i = 0; i < m_pivot.headers.size(); ++i)
+		{
+			RLP const body(m_pivot.bodies[i]);
+			importer->importBlock(m_pivot.headers[i], host().db(), body[0], body[1], RLP(m_pivot.receipts[i]), m_pivot.totalDifficulties[i]);
+		}
+		importer->setChainStartBlockNumber(m_pivot.headers.front().number());
+	}
+	catch (Exception const& _e)
+	{
+		cwarn << "Could not insert the blocks up to the fast sync pivot:" << _e.what() << "Replaying the chain instead.";
+		host().setFastSyncImporter(nullptr);
+		restartSync();
+		continueSync();
+		return;
+	}
+
+	BlockHeader const pivot = m_pivot.headers.back();
+	clog(NetNote) << "Fast sync has the state of block" << pivot.number() << "; downloading blocks from there";
+	m_chainStartBlock = static_cast<unsigned>(m_pivot.headers.front().number());
+	m_startingBlock = m_lastImportedBlock = static_cast<unsigned>(pivot.number());
+	m_lastImportedBlockHash = pivot.hash();
+	m_haveCommonHeader = true;
+	m_pivotPeer.reset();
+	m_pivot = PivotWindow();
+	m_stateDownloader.reset();
+	m_state = SyncState::Blocks;
+	continueSync();
+}
+
 void BlockChainSync::onPeerAborting()
 {
 	RecursiveGuard l(x_sync);
@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <deque>
 #include <mutex>
 #include <unordered_map>
 
@@ -29,6 +30,8 @@
 #include <libethcore/BlockHeader.h>
 #include <libp2p/Common.h>
 #include "CommonNet.h"
+#include "CompactBlock.h"
+#include "HeaderSkeleton.h"
 
 namespace dev
 {
@@ -41,6 +44,8 @@ namespace eth
 class EthereumHost;
 class BlockQueue;
 class EthereumPeer;
+class StateDownloader;
+class SealEngineFace;
 
 /**
  * @brief Base BlockChain synchronization strategy class.
@@ -69,6 +74,18 @@ public:
 	/// Called by peer once it has new block headers during sync
 	void onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
 
+	/// Check the seals of the headers in a BlockHeaders packet, in parallel for large batches.
+	/// Needs no lock; call before onPeerBlockHeaders.
+	/// @returns false if any header is malformed or wrongly sealed.
+	bool verifyHeaderSeals(RLP const& _r) const;
+
+	/// Check the header seals of @a _r with @a _sealEngine, spread over a shared pool of threads
+	/// for large batches.
+	static bool verifyHeaderSeals(SealEngineFace const& _sealEngine, RLP const& _r);
+
+	/// Called instead of onPeerBlockHeaders when verifyHeaderSeals failed
+	void onPeerInvalidHeaders(std::shared_ptr<EthereumPeer> _peer);
+
 	/// Called by peer once it has new block bodies
 	void onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
 
@@ -77,6 +94,18 @@ public:
 
 	void onPeerNewHashes(std::shared_ptr<EthereumPeer> _peer, std::vector<std::pair<h256, u256>> const& _hashes);
 
+	/// Called by peer once it has a new block in compact form
+	void onPeerCompactBlock(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+
+	/// Called by peer once it has the state trie nodes asked for during fast sync
+	void onPeerNodeData(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+
+	/// Called by peer once it has the receipts asked for during fast sync
+	void onPeerReceipts(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+
+	/// Called by peer with the transactions missing from a compact block
+	void onPeerBlockTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+
 	/// Called by peer when it is disconnecting
 	void onPeerAborting();
 
@@ -101,10 +130,29 @@ private:
 	void resetSync();
 	void syncPeer(std::shared_ptr<EthereumPeer> _peer, bool _force);
 	void requestBlocks(std::shared_ptr<EthereumPeer> _peer);
+	/// Ask @a _peer for every HeaderSkeleton::c_step-th header past the skeleton downloaded so far.
+	/// @returns false if the skeleton does not need extending or @a _peer is not fit to provide it.
+	bool requestSkeleton(std::shared_ptr<EthereumPeer> _peer);
 	void clearPeerDownload(std::shared_ptr<EthereumPeer> _peer);
 	void clearPeerDownload();
 	void collectBlocks();
 
+	/// Import a block rebuilt from its compact form as if it had come in a NewBlock packet.
+	void importCompactBlock(std::shared_ptr<EthereumPeer> _peer, h256 const& _h);
+
+	/// Fast sync: give @a _peer the next pivot block body, receipt or state node download.
+	void requestState(std::shared_ptr<EthereumPeer> _peer);
+	void onPeerPivotHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+	/// Ask the pivot peer @a _peer for the headers after the last one verified from genesis.
+	void requestPivotHeaders(std::shared_ptr<EthereumPeer> _peer);
+	void onPeerPivotBodies(std::shared_ptr<EthereumPeer> _peer, RLP const& _r);
+	/// Forget what @a _request asked for so that it can be asked of another peer.
+	void releaseStateRequest(std::pair<Asking, h256s> const& _request);
+	/// Take the state sync request outstanding with @a _peer, if any.
+	std::pair<Asking, h256s> takeStateRequest(std::shared_ptr<EthereumPeer> _peer);
+	/// Import the pivot window and carry on with block sync once everything is downloaded.
+	void continueStateSync();
+
 private:
 	struct Header
 	{
@@ -156,6 +204,30 @@ private:
 	unsigned m_lastImportedBlock = 0; 			///< Last imported block number
 	h256 m_lastImportedBlockHash;				///< Last imported block hash
 	u256 m_syncingTotalDifficulty;				///< Highest peer difficulty
+	HeaderSkeleton m_skeleton;					///< Sparse headers ahead of the import; gaps below its top are filled from all peers
+	std::weak_ptr<EthereumPeer> m_skeletonPeer;	///< Peer asked for the outstanding skeleton request
+
+	/// Blocks up to the fast sync pivot, inserted without being executed. The window is as long as
+	/// the look-back of aged stake balances, so the blocks after the pivot find every state they need.
+	/// It is only chosen once the pivot peer's headers have been checked from genesis up to its head.
+	struct PivotWindow
+	{
+		BlockHeader head;						///< Head of the pivot peer; unset until it answered
+		std::deque<BlockHeader> verified;		///< Last headers linked and sealed back to genesis, oldest first
+		std::deque<u256> verifiedDifficulties;	///< Total difficulty of each verified header, summed from genesis
+		std::vector<BlockHeader> headers;		///< Oldest first; the last one is the pivot
+		std::vector<u256> totalDifficulties;
+		std::vector<bytes> bodies;				///< Empty until downloaded
+		std::vector<bytes> receipts;			///< Empty until downloaded
+		std::unordered_map<h256, unsigned> indices;	///< Block hash to index in the window
+	};
+	std::weak_ptr<EthereumPeer> m_pivotPeer;	///< Peer asked for the headers to choose the pivot from
+	PivotWindow m_pivot;
+	std::unique_ptr<StateDownloader> m_stateDownloader;
+	h256Hash m_downloadingPivotBodies;
+	h256Hash m_downloadingPivotReceipts;
+	std::map<std::weak_ptr<EthereumPeer>, std::pair<Asking, h256s>, std::owner_less<std::weak_ptr<EthereumPeer>>> m_stateSyncPeers;	///< Peers to the fast sync download they were given
+	CompactBlockAssembler m_compactBlocks;		///< New blocks being rebuilt from the transaction queue
 
 private:
 	static char const* const s_stateNames[static_cast<int>(SyncState::Size)];
@@ -30,6 +30,8 @@
 #include "Executive.h"
 #include "EthereumHost.h"
 #include "Block.h"
+#include "SnapshotExporter.h"
+#include "SnapshotStorage.h"
 #include "TransactionQueue.h"
 #include "websocket-api/WebsocketEvents.h"
 
@@ -87,6 +89,7 @@ Client::Client(
 
 Client::~Client()
 {
+	stopSnapshot();
 	stopWorking();
 	terminate();
 }
@@ -120,6 +123,7 @@ void Client::init(p2p::Host* _extNet, fs::path const& _dbPath, WithExisting _for
 	auto host = _extNet->registerCapability(make_shared<EthereumHost>(bc(), m_stateDB, m_tq, m_bq, _networkId));
 	m_host = host;
 
+	_extNet->addCapability(host, EthereumHost::staticName(), EthereumHost::c_legacyTransactionsProtocolVersion);
 	_extNet->addCapability(host, EthereumHost::staticName(), EthereumHost::c_oldProtocolVersion); //TODO: remove this once v61+ protocol is common
 
 
@@ -219,6 +223,7 @@ void Client::startedWorking()
 		DEV_WRITE_GUARDED(x_postSeal)
 			m_postSeal = m_preSeal;
 	}
+	dropSealSnapshots();
 }
 
 void Client::doneWorking()
@@ -234,6 +239,7 @@ void Client::doneWorking()
 		DEV_WRITE_GUARDED(x_postSeal)
 			m_postSeal = m_preSeal;
 	}
+	dropSealSnapshots();
 }
 
 void Client::reopenChain(WithExisting _we)
@@ -247,6 +253,8 @@ void Client::reopenChain(ChainParams const& _p, WithExisting _we)
 	if (wasSealing)
 		stopSealing();
 	stopWorking();
+	// The export reads the chain and the state database that are about to be replaced.
+	stopSnapshot();
 
 	m_tq.clear();
 	m_bq.clear();
@@ -272,6 +280,11 @@ void Client::reopenChain(ChainParams const& _p, WithExisting _we)
 		m_postSeal = m_preSeal;
 		m_working = Block(chainParams().accountStartNonce);
 	}
+	dropSealSnapshots();
+	// An aborted exporter aborts every later export too.
+	if (m_snapshotExporter)
+		m_snapshotExporter.reset(new SnapshotExporter(bc(), m_stateDB));
+	m_lastSnapshot = 0;
 
 	if (auto h = m_host.lock())
 		h->reset();
@@ -301,6 +314,7 @@ void Client::clearPending()
 		DEV_READ_GUARDED(x_preSeal)
 			m_postSeal = m_preSeal;
 	}
+	dropSealSnapshots();
 
 	startSealing();
 	h256Hash changeds;
@@ -435,6 +449,7 @@ void Client::syncTransactionQueue()
 	DEV_READ_GUARDED(x_working)
 		DEV_WRITE_GUARDED(x_postSeal)
 			m_postSeal = m_working;
+	dropSealSnapshots();
 
 	DEV_READ_GUARDED(x_postSeal)
 		for (size_t i = 0; i < newPendingReceipts.size(); i++)
@@ -518,6 +533,7 @@ void Client::resyncStateFromChain()
 				}
 		DEV_READ_GUARDED(x_working) DEV_WRITE_GUARDED(x_postSeal)
 			m_postSeal = m_working;
+		dropSealSnapshots();
 
 		onPostStateChanged();
 	}
@@ -527,6 +543,31 @@ void Client::resyncStateFromChain()
 	onTransactionQueueReady();
 }
 
+shared_ptr<SealSnapshot const> Client::sealSnapshot(BlockNumber _h) const
+{
+	// Taken with the block locked, so a change to it always drops the snapshot after it is kept.
+	if (_h == LatestBlock)
+	{
+		ReadGuard l(x_preSeal);
+		Guard l2(x_sealSnapshots);
+		if (!m_preSealSnapshot)
+			m_preSealSnapshot = make_shared<SealSnapshot const>(m_preSeal);
+		return m_preSealSnapshot;
+	}
+	ReadGuard l(x_postSeal);
+	Guard l2(x_sealSnapshots);
+	if (!m_postSealSnapshot)
+		m_postSealSnapshot = make_shared<SealSnapshot const>(m_postSeal);
+	return m_postSealSnapshot;
+}
+
+void Client::dropSealSnapshots()
+{
+	Guard l(x_sealSnapshots);
+	m_preSealSnapshot.reset();
+	m_postSealSnapshot.reset();
+}
+
 void Client::resetState()
 {
 	Block newPreMine(chainParams().accountStartNonce);
@@ -537,6 +578,7 @@ void Client::resetState()
 		m_working = newPreMine;
 	DEV_READ_GUARDED(x_working) DEV_WRITE_GUARDED(x_postSeal)
 		m_postSeal = m_working;
+	dropSealSnapshots();
 
 	onPostStateChanged();
 	onTransactionQueueReady();
@@ -617,6 +659,7 @@ void Client::rejigSealing()
 				m_sealingInfo = m_working.info();
                 parent = m_working.previousInfo();
 			}
+			dropSealSnapshots();
 
 			if (wouldSeal())
 			{
@@ -706,6 +749,7 @@ void Client::tick()
 		m_report.ticks++;
 		checkWatchGarbage();
 		m_bq.tick();
+		checkSnapshot();
 		m_lastTick = chrono::system_clock::now();
 		if (m_report.ticks == 15)
 			clog(ClientTrace) << activityReport();
@@ -756,6 +800,14 @@ Block Client::block(h256 const& _block) const
 	}
 }
 
+StateView Client::stateView(h256 const& _block) const
+{
+	if (!bc().isKnown(_block))
+		BOOST_THROW_EXCEPTION(BlockNotFound() << errinfo_target(_block));
+	// The state of every imported block has been committed, so none of the overlay is needed.
+	return StateView(m_stateDB.committed(), bc().info(_block).stateRoot(), chainParams().accountStartNonce);
+}
+
 Block Client::block(h256 const& _blockHash, PopulationStatistics* o_stats) const
 {
 	try
@@ -807,11 +859,73 @@ bool Client::submitSealed(bytes const& _header)
 			m_postSeal = m_working;
 		newBlock = m_working.blockData();
 	}
+	dropSealSnapshots();
 
 	// OPTIMISE: very inefficient to not utilise the existing OverlayDB in m_postSeal that contains all trie changes.
 	return m_bq.import(&newBlock, true) == ImportResult::Success;
 }
 
+void Client::setFastSync(bool _enabled)
+{
+	if (auto h = m_host.lock())
+		h->setFastSyncImporter(_enabled ? createBlockChainImporter() : nullptr);
+}
+
+void Client::setSnapshotInterval(unsigned _interval, fs::path const& _dir)
+{
+	m_snapshotInterval = _interval;
+	m_snapshotDir = _dir;
+	if (!m_snapshotExporter)
+		m_snapshotExporter.reset(new SnapshotExporter(bc(), m_stateDB));
+}
+
+void Client::checkSnapshot()
+{
+	unsigned const number = bc().number();
+	if (!m_snapshotInterval || m_snapshotting || isMajorSyncing() || number < c_snapshotConfirmations)
+		return;
+	unsigned const target = (number - c_snapshotConfirmations) / m_snapshotInterval * m_snapshotInterval;
+	if (!target || target <= m_lastSnapshot)
+		return;
+
+	if (m_snapshotThread.joinable())
+		m_snapshotThread.join();
+	m_lastSnapshot = target;
+	m_snapshotting = true;
+	h256 const hash = bc().numberHash(target);
+	fs::path const dir = m_snapshotDir;
+	m_snapshotThread = std::thread([=]()
+	{
+		setThreadName("snapshot");
+		// Write next to the last snapshot and only replace it once complete.
+		fs::path const tmp = dir.string() + ".tmp";
+		try
+		{
+			fs::remove_all(tmp);
+			m_snapshotExporter->exportSnapshot(hash, *createSnapshotWriter(tmp.string()));
+			fs::remove_all(dir);
+			fs::rename(tmp, dir);
+			clog(ClientNote) << "Wrote snapshot of block" << target << "to" << dir;
+		}
+		catch (SnapshotExportAborted const&)
+		{
+		}
+		catch (...)
+		{
+			cwarn << "Failed to write snapshot of block" << target << ":" << boost::current_exception_diagnostic_information();
+		}
+		m_snapshotting = false;
+	});
+}
+
+void Client::stopSnapshot()
+{
+	if (m_snapshotExporter)
+		m_snapshotExporter->abort();
+	if (m_snapshotThread.joinable())
+		m_snapshotThread.join();
+}
+
 void Client::rewind(unsigned _n)
 {
 	executeInMainThread([=]() {
@@ -51,6 +51,7 @@ namespace eth
 
 class Client;
 class DownloadMan;
+class SnapshotExporter;
 
 enum ClientWorkState
 {
@@ -135,7 +136,7 @@ public:
 	// Note: "mining"/"miner" is deprecated. Use "sealing"/"sealer".
 
     virtual Address author() const override { ReadGuard l(x_preSeal); return m_preSeal.author(); }
-    virtual void setAuthor(Address const& _us) override { WriteGuard l(x_preSeal); m_preSeal.setAuthor(_us); }
+    virtual void setAuthor(Address const& _us) override { DEV_WRITE_GUARDED(x_preSeal) m_preSeal.setAuthor(_us); dropSealSnapshots(); }
 
 	/// Type of sealers available for this seal engine.
 	strings sealers() const { return sealEngine()->sealers(); }
@@ -189,15 +190,26 @@ public:
 	void rewind(unsigned _n);
 	/// Rescue the chain.
 	void rescue() { bc().rescue(m_stateDB); }
+	/// Add the blocks imported before there was a log index to it.
+	void backfillLogIndex(ProgressCallback const& _progress = ProgressCallback()) { bc().backfillLogIndex(_progress); }
 
 	std::unique_ptr<StateImporterFace> createStateImporter() { return dev::eth::createStateImporter(m_stateDB); }
 	std::unique_ptr<BlockChainImporterFace> createBlockChainImporter() { return dev::eth::createBlockChainImporter(m_bc); }
 
+	/// Download the state of a recent block instead of replaying the chain when syncing from genesis.
+	void setFastSync(bool _enabled);
+
+	/// Write a snapshot into @a _dir in the background every @a _interval blocks; 0 disables.
+	/// The block exported lags the head by c_snapshotConfirmations to stay clear of reorganisations.
+	void setSnapshotInterval(unsigned _interval, boost::filesystem::path const& _dir);
+
 	/// Queues a function to be executed in the main thread (that owns the blockchain, etc).
 	void executeInMainThread(std::function<void()> const& _function);
 
 	virtual Block block(h256 const& _block) const override;
 	using ClientBase::block;
+	virtual StateView stateView(h256 const& _block) const override;
+	using ClientBase::stateView;
 
 protected:
 	/// Perform critical setup functions.
@@ -214,6 +226,11 @@ protected:
 	virtual Block postSeal() const override { ReadGuard l(x_postSeal); return m_postSeal; }
 	virtual void prepareForTransaction() override;
 
+	/// Keeps the snapshots of m_preSeal and m_postSeal until one of them changes.
+	virtual std::shared_ptr<SealSnapshot const> sealSnapshot(BlockNumber _h) const override;
+	/// Must be called after m_preSeal or m_postSeal is changed.
+	void dropSealSnapshots();
+
 	/// Collate the changed filters for the bloom filter of the given pending transaction.
 	/// Insert any filters that are activated into @a o_changed.
 	void appendFromNewPending(TransactionReceipt const& _receipt, h256Hash& io_changed, h256 _sha3);
@@ -281,6 +298,11 @@ protected:
 	/// Ticks various system-level objects.
 	void tick();
 
+	/// Starts writing a snapshot if one is due and none is being written.
+	void checkSnapshot();
+	/// Abort the snapshot being written, if any, and wait for its thread.
+	void stopSnapshot();
+
 	/// Called when we have attempted to import a bad block.
 	/// @warning May be called from any thread.
 	void onBadBlock(Exception& _ex) const;
@@ -298,6 +320,9 @@ protected:
     AccountKeys::Public m_preSealAuthorPublicKey = AccountKeys::Public();
 	mutable SharedMutex x_postSeal;			///< Lock on m_postSeal.
 	Block m_postSeal;						///< The state of the client which we're sealing (i.e. it'll have all the rewards added).
+	mutable Mutex x_sealSnapshots;			///< Lock on m_preSealSnapshot and m_postSealSnapshot.
+	mutable std::shared_ptr<SealSnapshot const> m_preSealSnapshot;	///< Of m_preSeal, once asked for.
+	mutable std::shared_ptr<SealSnapshot const> m_postSealSnapshot;	///< Of m_postSeal, once asked for.
 	mutable SharedMutex x_working;			///< Lock on m_working.
 	Block m_working;						///< The state of the client which we're sealing (i.e. it'll have all the rewards added), while we're actually working on it.
 	BlockHeader m_sealingInfo;				///< The header we're attempting to seal on (derived from m_postSeal).
@@ -333,6 +358,15 @@ protected:
 	std::atomic<bool> m_syncBlockQueue = {false};
 
 	bytes m_extraData;
+
+	std::unique_ptr<SnapshotExporter> m_snapshotExporter;
+	boost::filesystem::path m_snapshotDir;
+	unsigned m_snapshotInterval = 0;		///< Blocks between snapshots; 0 if disabled.
+	unsigned m_lastSnapshot = 0;			///< Number of the block last snapshotted.
+	std::atomic<bool> m_snapshotting = {false};
+	std::thread m_snapshotThread;
+
+	static const unsigned c_snapshotConfirmations = 100;
 };
 
 }
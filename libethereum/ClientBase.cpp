@@ -23,6 +23,10 @@
 #include <libdevcrypto/Common.h>
 #include "ClientBase.h"
 #include <algorithm>
+#include <future>
+#include <thread>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include "BlockChain.h"
 #include "Executive.h"
 #include "State.h"
@@ -37,6 +41,97 @@ const char* WorkOutChannel::name() { return EthOrange "⚒" EthNavy "◀▬"; }
 const char* WorkChannel::name() { return EthOrange "⚒" EthWhite "  "; }
 
 static const int64_t c_maxGasEstimate = 50000000;
+static const unsigned c_maxEstimateProbes = 4;		///< Most executions estimateGas runs at once.
+
+namespace
+{
+
+unsigned estimateProbes()
+{
+	return max(2u, min(thread::hardware_concurrency(), c_maxEstimateProbes));
+}
+
+/// Threads the probes of all gas estimations run on.
+boost::asio::thread_pool& estimatePool()
+{
+	static boost::asio::thread_pool s_pool(estimateProbes());
+	return s_pool;
+}
+
+}
+
+bool dev::eth::enoughGas(ExecutionResult const& _er)
+{
+	return !(_er.excepted == TransactionException::OutOfGas ||
+		_er.excepted == TransactionException::OutOfGasBase ||
+		_er.excepted == TransactionException::OutOfGasIntrinsic ||
+		_er.codeDeposit == CodeDeposit::Failed ||
+		_er.excepted == TransactionException::BadJumpDestination);
+}
+
+pair<int64_t, ExecutionResult> dev::eth::searchGas(GasProbe const& _probe, int64_t _lowerBound, int64_t _upperBound, GasEstimationCallback const& _callback)
+{
+	// With all the gas there is, the transaction shows what it consumes before refunds.
+	// It cannot do with less, and unless the 63/64 rule of calls holds some back it
+	// needs no more, so the first guesses are usually the last.
+	ExecutionResult er = _probe(_upperBound);
+	if (!enoughGas(er))
+	{
+		if (_callback)
+			_callback(GasEstimationProgress { _upperBound, _upperBound });
+		return make_pair(_upperBound, er);
+	}
+	int64_t const consumed = static_cast<int64_t>(er.gasUsed + min(er.gasRefunded, er.gasUsed));
+	vector<int64_t> candidates{consumed - 1, consumed, consumed + consumed / 63 + 1};
+
+	int64_t failing = _lowerBound - 1;	// Highest gas known to be too little.
+	int64_t enough = _upperBound;		// Lowest gas known to be enough.
+	ExecutionResult lastGood = er;
+	unsigned const probes = estimateProbes();
+	while (enough - failing > 1)
+	{
+		candidates.erase(remove_if(candidates.begin(), candidates.end(), [&](int64_t _c) { return _c <= failing || _c >= enough; }), candidates.end());
+		if (candidates.empty())
+			// Split what is left evenly among the probes.
+			for (unsigned i = 1; i <= probes; ++i)
+			{
+				int64_t const c = failing + (enough - failing) * i / (probes + 1);
+				if (c > failing && c < enough && (candidates.empty() || c != candidates.back()))
+					candidates.push_back(c);
+			}
+
+		vector<future<ExecutionResult>> running;
+		for (int64_t c: candidates)
+		{
+			auto task = make_shared<packaged_task<ExecutionResult()>>([&_probe, c]() { return _probe(c); });
+			running.push_back(task->get_future());
+			boost::asio::post(estimatePool(), [task]() { (*task)(); });
+		}
+		// All of them refer to _probe, so none may be left running when one has thrown.
+		for (auto& r: running)
+			r.wait();
+		vector<ExecutionResult> results;
+		for (auto& r: running)
+			results.push_back(r.get());
+
+		int64_t newEnough = enough;
+		for (size_t i = 0; i < candidates.size(); ++i)
+			if (enoughGas(results[i]) && candidates[i] < newEnough)
+			{
+				newEnough = candidates[i];
+				lastGood = results[i];
+			}
+		for (size_t i = 0; i < candidates.size(); ++i)
+			if (!enoughGas(results[i]) && candidates[i] < newEnough)
+				failing = max(failing, candidates[i]);
+		enough = newEnough;
+		candidates.clear();
+
+		if (_callback)
+			_callback(GasEstimationProgress { failing, enough });
+	}
+	return make_pair(enough, lastGood);
+}
 
 pair<h256, Address> ClientBase::submitTransaction(TransactionSkeleton const& _t, AccountKeys::Secret const& _secret)
 {
@@ -63,15 +158,34 @@ ExecutionResult ClientBase::call(Address const& _from, u256 _value, Address _des
 	ExecutionResult ret;
 	try
 	{
-		Block temp = block(_blockNumber);
-		u256 nonce = temp.transactionsFrom(_from); // use the current nonce as eth_call does not change and not mined
+		if (isChainState(_blockNumber))
+		{
+			// Run on the post-state of the block with the block as environment, as a block populated from the chain would.
+			h256 const hash = bc().numberHash(_blockNumber);
+			State temp = stateView(hash).state();
+			BlockHeader const header = bc().info(hash);
+			u256 nonce = temp.getNonce(_from); // use the current nonce as eth_call does not change and not mined
+			u256 gas = _gas == Invalid256 ? gasLimitRemaining() : _gas;
+			u256 gasPrice = _gasPrice == Invalid256 ? gasBidPrice() : _gasPrice;
+			Transaction t(_value, gasPrice, gas, _dest, _data, nonce);
+			t.forceSender(_from);
+			if (_ff == FudgeFactor::Lenient)
+				temp.addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
+			EnvInfo const env(header, bc().lastBlockHashes(), header.gasUsed(), bc().chainParams().chainID);
+			return temp.execute(env, *bc().sealEngine(), t, Permanence::Reverted).first;
+		}
+		// Layered on the snapshot, the call copies only the accounts it touches.
+		shared_ptr<SealSnapshot const> snapshot = sealSnapshot(_blockNumber);
+		State temp = State::layered(snapshot->state);
+		u256 nonce = temp.getNonce(_from); // use the current nonce as eth_call does not change and not mined
 		u256 gas = _gas == Invalid256 ? gasLimitRemaining() : _gas;
 		u256 gasPrice = _gasPrice == Invalid256 ? gasBidPrice() : _gasPrice;
 		Transaction t(_value, gasPrice, gas, _dest, _data, nonce);
 		t.forceSender(_from);
 		if (_ff == FudgeFactor::Lenient)
-			temp.mutableState().addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
-		ret = temp.execute(bc().lastBlockHashes(), t, Permanence::Reverted);
+			temp.addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
+		EnvInfo const env(snapshot->info, bc().lastBlockHashes(), snapshot->gasUsed, bc().chainParams().chainID);
+		ret = temp.execute(env, *bc().sealEngine(), t, Permanence::Reverted).first;
 	}
 	catch (...)
 	{
@@ -88,44 +202,40 @@ std::pair<u256, ExecutionResult> ClientBase::estimateGas(Address const& _from, u
 		if (upperBound == Invalid256 || upperBound > c_maxGasEstimate)
 			upperBound = c_maxGasEstimate;
 		int64_t lowerBound = Transaction::baseGasRequired(!_dest, &_data, EVMSchedule());
-		Block bk = block(_blockNumber);
 		u256 gasPrice = _gasPrice == Invalid256 ? gasBidPrice() : _gasPrice;
-		ExecutionResult er;
-		ExecutionResult lastGood;
-		bool good = false;
-		while (upperBound != lowerBound)
+
+		shared_ptr<State const> base;
+		BlockHeader header;
+		if (isChainState(_blockNumber))
+		{
+			h256 const hash = bc().numberHash(_blockNumber);
+			base = make_shared<State const>(stateView(hash).state());
+			header = bc().info(hash);
+		}
+		else
+		{
+			shared_ptr<SealSnapshot const> snapshot = sealSnapshot(_blockNumber);
+			base = snapshot->state;
+			header = snapshot->info;
+		}
+		u256 const nonce = State::layered(base).getNonce(_from);
+
+		// Each probe runs on a layer of its own over the base, so they can run at once.
+		auto probe = [&](int64_t _gas)
 		{
-			int64_t mid = (lowerBound + upperBound) / 2;
-			u256 n = bk.transactionsFrom(_from);
 			Transaction t;
 			if (_dest)
-				t = Transaction(_value, gasPrice, mid, _dest, _data, n);
+				t = Transaction(_value, gasPrice, _gas, _dest, _data, nonce);
 			else
-				t = Transaction(_value, gasPrice, mid, _data, n);
+				t = Transaction(_value, gasPrice, _gas, _data, nonce);
 			t.forceSender(_from);
-			EnvInfo const env(bk.info(), bc().lastBlockHashes(), 0, mid);
-			State tempState(bk.state());
+			EnvInfo const env(header, bc().lastBlockHashes(), 0, _gas, bc().chainParams().chainID);
+			State tempState = State::layered(base);
 			tempState.addBalance(_from, (u256)(t.gas() * t.gasPrice() + t.value()));
-			er = tempState.execute(env, *bc().sealEngine(), t, Permanence::Reverted).first;
-			if (er.excepted == TransactionException::OutOfGas ||
-				er.excepted == TransactionException::OutOfGasBase ||
-				er.excepted == TransactionException::OutOfGasIntrinsic ||
-				er.codeDeposit == CodeDeposit::Failed ||
-				er.excepted == TransactionException::BadJumpDestination)
-					lowerBound = lowerBound == mid ? upperBound : mid;
-			else
-			{
-				lastGood = er;
-				upperBound = upperBound == mid ? lowerBound : mid;
-				good = true;
-			}
-
-			if (_callback)
-				_callback(GasEstimationProgress { lowerBound, upperBound });
-		}
-		if (_callback)
-			_callback(GasEstimationProgress { lowerBound, upperBound });
-		return make_pair(upperBound, good ? lastGood : er);
+			return tempState.execute(env, *bc().sealEngine(), t, Permanence::Reverted).first;
+		};
+		auto const ret = searchGas(probe, lowerBound, upperBound, _callback);
+		return make_pair(u256(ret.first), ret.second);
 	}
 	catch (...)
 	{
@@ -141,36 +251,50 @@ ImportResult ClientBase::injectBlock(bytes const& _block)
 
 u256 ClientBase::balanceAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).balance(_a);
 	return block(_block).balance(_a);
 }
 
 u256 ClientBase::countAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).getNonce(_a);
 	return block(_block).transactionsFrom(_a);
 }
 
 u256 ClientBase::stateAt(Address _a, u256 _l, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).storage(_a, _l);
 	return block(_block).storage(_a, _l);
 }
 
 h256 ClientBase::stateRootAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).storageRoot(_a);
 	return block(_block).storageRoot(_a);
 }
 
 bytes ClientBase::codeAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).code(_a);
 	return block(_block).code(_a);
 }
 
 h256 ClientBase::codeHashAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).codeHash(_a);
 	return block(_block).codeHash(_a);
 }
 
 map<h256, pair<u256, u256>> ClientBase::storageAt(Address _a, BlockNumber _block) const
 {
+	if (isChainState(_block))
+		return stateView(_block).storage(_a);
 	return block(_block).storage(_a);
 }
 
@@ -206,7 +330,7 @@ LocalisedLogEntries ClientBase::logs(LogFilter const& _f) const
 			TransactionReceipt const& tr = temp.receipt(i);
 			LogEntries le = _f.matches(tr);
 			for (unsigned j = 0; j < le.size(); ++j)
-				ret.insert(ret.begin(), LocalisedLogEntry(le[j]));
+				ret.push_back(LocalisedLogEntry(le[j]));
 		}
 		begin = bc().number();
 	}
@@ -219,7 +343,7 @@ LocalisedLogEntries ClientBase::logs(LogFilter const& _f) const
 	tie(blocks, ancestor, ancestorIndex) = bc().treeRoute(_f.earliest(), _f.latest(), false);
 
 	for (size_t i = 0; i < ancestorIndex; i++)
-		prependLogsFromBlock(_f, blocks[i], BlockPolarity::Dead, ret);
+		appendLogsFromBlock(_f, blocks[i], BlockPolarity::Dead, ret);
 
 	// cause end is our earliest block, let's compare it with our ancestor
 	// if ancestor is smaller let's move our end to it
@@ -237,33 +361,59 @@ LocalisedLogEntries ClientBase::logs(LogFilter const& _f) const
 
 	// Handle blocks from main chain
 	set<unsigned> matchingBlocks;
+	unsigned indexed = begin + 1;
 	if (!_f.isRangeFilter())
-		for (auto const& i: _f.bloomPossibilities())
-			for (auto u: bc().withBlockBloom(i, end, begin))
-				matchingBlocks.insert(u);
+	{
+		// The log index has the blocks from logIndexFrom() on; below that the blooms have to do.
+		indexed = max(end, bc().logIndexFrom());
+		if (end < indexed)
+			for (auto const& i: _f.bloomPossibilities())
+				for (auto u: bc().withBlockBloom(i, end, min(begin, indexed - 1)))
+					matchingBlocks.insert(u);
+	}
 	else
 		// if it is a range filter, we want to get all logs from all blocks in given range
 		for (unsigned i = end; i <= begin; i++)
 			matchingBlocks.insert(i);
 
 	for (auto n: matchingBlocks)
-		prependLogsFromBlock(_f, bc().numberHash(n), BlockPolarity::Live, ret);
+		appendLogsFromBlock(_f, bc().numberHash(n), BlockPolarity::Live, ret);
+
+	if (indexed <= begin)
+		bc().withLogIndex(_f, indexed, begin, [&](unsigned, h256 const& _hash, set<unsigned> const& _transactions)
+		{
+			appendLogsFromBlock(_f, _hash, BlockPolarity::Live, ret, &_transactions);
+		});
 
-	reverse(ret.begin(), ret.end());
 	return ret;
 }
 
-void ClientBase::prependLogsFromBlock(LogFilter const& _f, h256 const& _blockHash, BlockPolarity _polarity, LocalisedLogEntries& io_logs) const
+void ClientBase::appendLogsFromBlock(LogFilter const& _f, h256 const& _blockHash, BlockPolarity _polarity, LocalisedLogEntries& io_logs, set<unsigned> const* _transactions) const
 {
-	auto receipts = bc().receipts(_blockHash).receipts;
-	for (size_t i = 0; i < receipts.size(); i++)
+	auto const receipts = bc().receipts(_blockHash).receipts;
+	BlockNumber const number = bc().number(_blockHash);
+	bytes const block = bc().block(_blockHash);
+	RLP const transactions = RLP(block)[1];
+	auto append = [&](unsigned i)
 	{
-		TransactionReceipt receipt = receipts[i];
-		auto th = transaction(_blockHash, i).sha3();
-		LogEntries le = _f.matches(receipt);
+		LogEntries le = _f.matches(receipts[i]);
+		if (le.empty())
+			return;
+		// Only the transactions with matching logs are hashed.
+		h256 const th = sha3(transactions[i].data());
 		for (unsigned j = 0; j < le.size(); ++j)
-			io_logs.insert(io_logs.begin(), LocalisedLogEntry(le[j], _blockHash, (BlockNumber)bc().number(_blockHash), th, i, 0, _polarity));
+			io_logs.push_back(LocalisedLogEntry(le[j], _blockHash, number, th, i, 0, _polarity));
+	};
+
+	if (_transactions)
+	{
+		for (unsigned i: *_transactions)
+			if (i < receipts.size())
+				append(i);
 	}
+	else
+		for (unsigned i = 0; i < receipts.size(); i++)
+			append(i);
 }
 
 unsigned ClientBase::installWatch(LogFilter const& _f, Reaping _r)
@@ -517,7 +667,7 @@ BlockDetails ClientBase::pendingDetails() const
 Addresses ClientBase::addresses(BlockNumber _block) const
 {
 	Addresses ret;
-	for (auto const& i: block(_block).addresses())
+	for (auto const& i: isChainState(_block) ? stateView(_block).addresses() : block(_block).addresses())
 		ret.push_back(i.first);
 	return ret;
 }
@@ -586,7 +736,12 @@ bool ClientBase::isKnownTransaction(h256 const& _transactionHash) const
 
 bool ClientBase::isKnownTransaction(h256 const& _blockHash, unsigned _i) const
 {
-	return isKnown(_blockHash) && block(_blockHash).pending().size() > _i;
+	return isKnown(_blockHash) && transactionCount(_blockHash) > _i;
+}
+
+StateView ClientBase::stateView(BlockNumber _h) const
+{
+	return stateView(bc().numberHash(_h));
 }
 
 Block ClientBase::block(BlockNumber _h) const
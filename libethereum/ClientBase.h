@@ -28,6 +28,7 @@
 #include "TransactionQueue.h"
 #include "Block.h"
 #include "CommonNet.h"
+#include "StateView.h"
 
 namespace dev
 {
@@ -64,6 +65,28 @@ struct ClientWatch
 	mutable std::chrono::system_clock::time_point lastPoll = std::chrono::system_clock::now();
 };
 
+/// A frozen copy of the state that transactions on preSeal() or postSeal() are executed on,
+/// with the environment they are executed in. Executions layer a State of their own on it.
+struct SealSnapshot
+{
+	explicit SealSnapshot(Block const& _b): state(std::make_shared<State const>(_b.executionState())), info(_b.info()), gasUsed(_b.gasUsed()) {}
+
+	std::shared_ptr<State const> state;
+	BlockHeader info;
+	u256 gasUsed;
+};
+
+/// Runs the transaction being estimated with @a _gas and @returns the result.
+using GasProbe = std::function<ExecutionResult(int64_t _gas)>;
+
+/// @returns false if @a _er failed for want of gas.
+bool enoughGas(ExecutionResult const& _er);
+
+/// @returns the least gas from @a _lowerBound up to @a _upperBound with which @a _probe has
+/// enough gas, and the result of that probe; @a _upperBound and its result if even that is
+/// too little. Several probes run at once on a shared pool of threads.
+std::pair<int64_t, ExecutionResult> searchGas(GasProbe const& _probe, int64_t _lowerBound, int64_t _upperBound, GasEstimationCallback const& _callback = GasEstimationCallback());
+
 struct WatchChannel: public LogChannel { static const char* name(); static const int verbosity = 7; };
 #define cwatch LogOutputStream<WatchChannel, true>()
 struct WorkInChannel: public LogChannel { static const char* name(); static const int verbosity = 16; };
@@ -110,7 +133,9 @@ public:
 
 	virtual LocalisedLogEntries logs(unsigned _watchId) const override;
 	virtual LocalisedLogEntries logs(LogFilter const& _filter) const override;
-	virtual void prependLogsFromBlock(LogFilter const& _filter, h256 const& _blockHash, BlockPolarity _polarity, LocalisedLogEntries& io_logs) const;
+	/// Appends the logs of block @a _blockHash that match @a _filter to @a io_logs; only those
+	/// of @a _transactions if given.
+	virtual void appendLogsFromBlock(LogFilter const& _filter, h256 const& _blockHash, BlockPolarity _polarity, LocalisedLogEntries& io_logs, std::set<unsigned> const* _transactions = nullptr) const;
 
 	/// Install, uninstall and query watches.
 	virtual unsigned installWatch(LogFilter const& _filter, Reaping _r = Reaping::Automatic) override;
@@ -173,17 +198,28 @@ public:
 
 	Block block(BlockNumber _h) const;
 
+	/// @returns the state after block @a _h, which must be neither PendingBlock nor LatestBlock.
+	StateView stateView(BlockNumber _h) const;
+
 protected:
+	/// @returns true if the state at @a _h is that of a block in the chain rather than of preSeal() or postSeal().
+	static bool isChainState(BlockNumber _h) { return _h != PendingBlock && _h != LatestBlock; }
+
 	/// The interface that must be implemented in any class deriving this.
 	/// {
 	virtual BlockChain& bc() = 0;
 	virtual BlockChain const& bc() const = 0;
 	virtual Block block(h256 const& _h) const = 0;
+	virtual StateView stateView(h256 const& _h) const = 0;
 	virtual Block preSeal() const = 0;
 	virtual Block postSeal() const = 0;
 	virtual void prepareForTransaction() = 0;
 	/// }
 
+	/// @returns the snapshot of preSeal() for LatestBlock, otherwise of postSeal().
+	/// Taken anew each time unless overridden to keep them.
+	virtual std::shared_ptr<SealSnapshot const> sealSnapshot(BlockNumber _h) const { return std::make_shared<SealSnapshot const>(block(_h)); }
+
 	TransactionQueue m_tq;							///< Maintains a list of incoming transactions not yet in a block on the blockchain.
 
 	// filters
@@ -102,6 +102,7 @@ void ClientTest::modifyTimestamp(int64_t const& _timestamp)
 		m_working = block;
 	DEV_READ_GUARDED(x_postSeal)
 		m_postSeal = block;
+	dropSealSnapshots();
 
 	onPostStateChanged();
 }
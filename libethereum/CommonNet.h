@@ -51,6 +51,8 @@ static const unsigned c_maxPayload = 262144;	///< Maximum size of packet for us
 #endif
 static const unsigned c_maxNodes = c_maxBlocks; ///< Maximum number of nodes will ever send.
 static const unsigned c_maxReceipts = c_maxBlocks; ///< Maximum number of receipts will ever send.
+static const unsigned c_maxTransactionHashes = 4096; ///< Maximum number of transaction hashes we announce or accept in one packet.
+static const unsigned c_maxPooledTransactions = 256; ///< Maximum number of pooled transactions will ever send or ask for.
 
 class BlockChain;
 class TransactionQueue;
@@ -67,11 +69,17 @@ enum SubprotocolPacketType: byte
 	GetBlockBodiesPacket = 0x05,
 	BlockBodiesPacket = 0x06,
 	NewBlockPacket = 0x07,
+	NewPooledTransactionHashesPacket = 0x08,
+	GetPooledTransactionsPacket = 0x09,
+	PooledTransactionsPacket = 0x0a,
+	NewCompactBlockPacket = 0x0b,
+	GetBlockTransactionsPacket = 0x0c,
 
 	GetNodeDataPacket = 0x0d,
 	NodeDataPacket = 0x0e,
 	GetReceiptsPacket = 0x0f,
 	ReceiptsPacket = 0x10,
+	BlockTransactionsPacket = 0x11,	///< eth/64 and later; the packets of older versions end before this.
 
 	PacketCount
 };
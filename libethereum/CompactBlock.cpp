@@ -0,0 +1,146 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file CompactBlock.cpp
+ */
+
+#include "CompactBlock.h"
+
+#include <numeric>
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieHash.h>
+#include <libethcore/BlockHeader.h>
+#include <libp2p/Common.h>
+#include "TransactionQueue.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+ShortTransactionId dev::eth::shortTransactionId(h256 const& _txHash)
+{
+	return ShortTransactionId(_txHash.ref().cropped(0, ShortTransactionId::size));
+}
+
+void dev::eth::streamCompactBlock(RLPStream& _s, bytesConstRef _block)
+{
+	RLP block(_block);
+	RLP transactions = block[1];
+	_s.appendRaw(block[0].data());
+	_s.appendList(transactions.itemCount());
+	for (auto const& t: transactions)
+		_s << shortTransactionId(sha3(t.data()));
+	_s.appendRaw(block[2].data());
+}
+
+vector<unsigned> CompactBlockAssembler::assemble(BlockHeader const& _header, RLP const& _r)
+{
+	h256 const hash = _header.hash();
+	DEV_GUARDED(x_pending)
+		if (m_pending.count(hash))
+			return {};
+
+	RLP ids = _r[1];
+	Pending p;
+	p.header = _r[0].data().toBytes();
+	p.uncles = _r[2].data().toBytes();
+	p.totalDifficulty = _r[3].toInt<u256>();
+	p.transactionsRoot = _header.transactionsRoot();
+	p.transactions.resize(ids.itemCount());
+	p.started = chrono::steady_clock::now();
+
+	if (ids.itemCount())
+	{
+		// Blocks are built from what is current in the pools, so that is all there is to search.
+		p.transactions = m_tq.transactionsByHashPrefix(ids.toVector<ShortTransactionId>());
+		for (unsigned i = 0; i < p.transactions.size(); ++i)
+			if (p.transactions[i].empty())
+				p.missing.push_back(i);
+	}
+
+	if (p.missing.empty() && !matchesHeader(p))
+	{
+		// A short id matched the wrong transaction; fetch the real ones.
+		clog(p2p::NetMessageDetail) << "Compact block" << hash << "does not match its transactions root; asking for all transactions";
+		p.missing.resize(p.transactions.size());
+		iota(p.missing.begin(), p.missing.end(), 0);
+	}
+
+	vector<unsigned> ret = p.missing;
+	Guard l(x_pending);
+	if (m_pending.size() >= c_maxPending)
+	{
+		auto oldest = min_element(m_pending.begin(), m_pending.end(), [](pair<h256 const, Pending> const& _a, pair<h256 const, Pending> const& _b) { return _a.second.started < _b.second.started; });
+		m_pending.erase(oldest);
+	}
+	m_pending.emplace(hash, move(p));
+	return ret;
+}
+
+CompactBlockStatus CompactBlockAssembler::supply(h256 const& _hash, RLP const& _transactions)
+{
+	Guard l(x_pending);
+	auto it = m_pending.find(_hash);
+	if (it == m_pending.end())
+		return CompactBlockStatus::Unknown;
+
+	Pending& p = it->second;
+	if (_transactions.itemCount() != p.missing.size())
+	{
+		// The peer does not have the block any more; it will come in another way.
+		m_pending.erase(it);
+		return CompactBlockStatus::Unknown;
+	}
+	for (unsigned i = 0; i < p.missing.size(); ++i)
+		p.transactions[p.missing[i]] = _transactions[i].data().toBytes();
+	p.missing.clear();
+
+	if (!matchesHeader(p))
+	{
+		m_pending.erase(it);
+		return CompactBlockStatus::Invalid;
+	}
+	return CompactBlockStatus::Complete;
+}
+
+bytes CompactBlockAssembler::take(h256 const& _hash)
+{
+	Pending p;
+	{
+		Guard l(x_pending);
+		auto it = m_pending.find(_hash);
+		if (it == m_pending.end() || !it->second.missing.empty())
+			return bytes();
+		p = move(it->second);
+		m_pending.erase(it);
+	}
+
+	RLPStream block(3);
+	block.appendRaw(p.header);
+	block.appendList(p.transactions.size());
+	for (bytes const& t: p.transactions)
+		block.appendRaw(t);
+	block.appendRaw(p.uncles);
+
+	RLPStream ret(2);
+	ret.appendRaw(block.out()).append(p.totalDifficulty);
+	return ret.out();
+}
+
+bool CompactBlockAssembler::matchesHeader(Pending const& _p)
+{
+	return orderedTrieRoot(_p.transactions) == _p.transactionsRoot;
+}
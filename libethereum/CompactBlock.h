@@ -0,0 +1,106 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file CompactBlock.h
+ * Relaying new blocks as their header and short transaction ids.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <vector>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/RLP.h>
+
+namespace dev
+{
+namespace eth
+{
+
+class BlockHeader;
+class TransactionQueue;
+
+/// Identifies a transaction within a compact block: the first eight bytes of its hash.
+using ShortTransactionId = h64;
+
+ShortTransactionId shortTransactionId(h256 const& _txHash);
+
+/// Number of items streamCompactBlock() appends.
+static const unsigned c_compactBlockItems = 3;
+
+/// Append the compact form [header, [short transaction id, ...], uncles] of the block @a _block to @a _s.
+void streamCompactBlock(RLPStream& _s, bytesConstRef _block);
+
+enum class CompactBlockStatus
+{
+	Complete,		///< All transactions are there and match the header.
+	Unknown,		///< The block is not being assembled (any more).
+	Invalid			///< The transactions supplied do not match the header.
+};
+
+/**
+ * @brief Rebuilds blocks announced in compact form from the local transaction queue.
+ *
+ * Transactions the queue does not have are reported back so that the announcing peer can be
+ * asked for them; the block is complete once they are supplied. The transactions root of the
+ * header is checked before a block is handed out, so a short id colliding with the wrong
+ * transaction only costs a round trip for the whole list.
+ * @threadsafe
+ */
+class CompactBlockAssembler
+{
+public:
+	explicit CompactBlockAssembler(TransactionQueue const& _tq): m_tq(_tq) {}
+
+	/// Start assembling the block with header @a _header from the NewCompactBlock payload @a _r.
+	/// @returns the indices of the transactions still missing; empty if the block is complete or
+	/// was already being assembled.
+	std::vector<unsigned> assemble(BlockHeader const& _header, RLP const& _r);
+
+	/// Supply the transactions missing from block @a _hash, in the order assemble() reported them.
+	CompactBlockStatus supply(h256 const& _hash, RLP const& _transactions);
+
+	/// @returns the complete block @a _hash as a NewBlock payload [block, totalDifficulty] and
+	/// forgets about it; empty if the block is not complete.
+	bytes take(h256 const& _hash);
+
+private:
+	struct Pending
+	{
+		bytes header;
+		bytes uncles;
+		u256 totalDifficulty;
+		h256 transactionsRoot;
+		std::vector<bytes> transactions;	///< RLP of each transaction; empty if still missing.
+		std::vector<unsigned> missing;
+		std::chrono::steady_clock::time_point started;
+	};
+
+	static bool matchesHeader(Pending const& _p);
+
+	TransactionQueue const& m_tq;
+
+	Mutex x_pending;
+	std::map<h256, Pending> m_pending;
+
+	static const size_t c_maxPending = 16;
+};
+
+}
+}
@@ -28,10 +28,12 @@
 #include <libp2p/Session.h>
 #include <libethcore/Exceptions.h>
 #include "BlockChain.h"
+#include "BlockChainImporter.h"
 #include "TransactionQueue.h"
 #include "BlockQueue.h"
 #include "EthereumPeer.h"
 #include "BlockChainSync.h"
+#include "CompactBlock.h"
 
 using namespace std;
 using namespace dev;
@@ -39,7 +41,9 @@ using namespace dev::eth;
 using namespace p2p;
 
 unsigned const EthereumHost::c_oldProtocolVersion = 62; //TODO: remove this once v63+ is common
+unsigned const EthereumHost::c_legacyTransactionsProtocolVersion = 63;
 static unsigned const c_maxSendTransactions = 256;
+static chrono::seconds const c_transactionRequestTimeout = chrono::seconds(5);	///< Until then, announced transactions are not asked for from another peer.
 
 char const* const EthereumHost::s_stateNames[static_cast<int>(SyncState::Size)] = {"NotSynced", "Idle", "Waiting", "Blocks", "State"};
 
@@ -51,6 +55,12 @@ const char* EthereumHostTrace::name() { return EthPurple "⧫" EthGray " "; }
 
 namespace
 {
+/// All versions of the protocol we talk, newest first.
+vector<unsigned> supportedProtocolVersions()
+{
+	return {eth::c_protocolVersion, EthereumHost::c_legacyTransactionsProtocolVersion, EthereumHost::c_oldProtocolVersion};
+}
+
 class EthereumPeerObserver: public EthereumPeerObserverFace
 {
 public:
@@ -78,6 +88,37 @@ public:
 		m_tq.enqueue(_r, _peer->id());
 	}
 
+	void onPeerTransactionHashes(std::shared_ptr<EthereumPeer> _peer, h256s const& _hashes) override
+	{
+		// Ask for every transaction only once at a time, from the first peer announcing it.
+		h256s wanted;
+		auto const now = chrono::steady_clock::now();
+		DEV_GUARDED(x_requested)
+		{
+			if (m_requested.size() > c_maxTransactionHashes)
+				for (auto i = m_requested.begin(); i != m_requested.end();)
+					if (now - i->second > c_transactionRequestTimeout)
+						i = m_requested.erase(i);
+					else
+						++i;
+
+			for (auto const& h: _hashes)
+			{
+				if (m_tq.isKnown(h))
+					continue;
+				auto r = m_requested.find(h);
+				if (r != m_requested.end() && now - r->second <= c_transactionRequestTimeout)
+					continue;
+				m_requested[h] = now;
+				wanted.push_back(h);
+			}
+		}
+		clog(EthereumHostTrace) << "Transaction hashes (" << dec << _hashes.size() << "entries," << wanted.size() << "unknown)";
+
+		for (size_t i = 0; i < wanted.size(); i += c_maxPooledTransactions)
+			_peer->requestPooledTransactions(h256s(wanted.begin() + i, wanted.begin() + min<size_t>(wanted.size(), i + c_maxPooledTransactions)));
+	}
+
 	void onPeerAborting() override
 	{
 		RecursiveGuard l(m_syncMutex);
@@ -93,9 +134,16 @@ public:
 
 	void onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _headers) override
 	{
+		// Seal checks are the expensive part and need no sync state, so they run before locking.
+		bool const sealsValid = m_sync.verifyHeaderSeals(_headers);
 		RecursiveGuard l(m_syncMutex);
 		try
 		{
+			if (!sealsValid)
+			{
+				m_sync.onPeerInvalidHeaders(_peer);
+				return;
+			}
 			m_sync.onPeerBlockHeaders(_peer, _headers);
 		}
 		catch (FailedInvariant const&)
@@ -151,28 +199,77 @@ public:
 		}
 	}
 
-	void onPeerNodeData(std::shared_ptr<EthereumPeer> /* _peer */, RLP const& _r) override
+	void onPeerNodeData(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
 	{
-		unsigned itemCount = _r.itemCount();
-		clog(EthereumHostTrace) << "Node Data (" << dec << itemCount << "entries)";
+		RecursiveGuard l(m_syncMutex);
+		try
+		{
+			m_sync.onPeerNodeData(_peer, _r);
+		}
+		catch (FailedInvariant const&)
+		{
+			clog(NetWarn) << "Failed invariant during sync, restarting sync";
+			m_sync.restartSync();
+		}
 	}
 
-	void onPeerReceipts(std::shared_ptr<EthereumPeer> /* _peer */, RLP const& _r) override
+	void onPeerReceipts(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
 	{
-		unsigned itemCount = _r.itemCount();
-		clog(EthereumHostTrace) << "Receipts (" << dec << itemCount << "entries)";
+		RecursiveGuard l(m_syncMutex);
+		try
+		{
+			m_sync.onPeerReceipts(_peer, _r);
+		}
+		catch (FailedInvariant const&)
+		{
+			clog(NetWarn) << "Failed invariant during sync, restarting sync";
+			m_sync.restartSync();
+		}
+	}
+
+	void onPeerCompactBlock(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
+	{
+		RecursiveGuard l(m_syncMutex);
+		try
+		{
+			m_sync.onPeerCompactBlock(_peer, _r);
+		}
+		catch (FailedInvariant const&)
+		{
+			// "fix" for https://github.com/ethereum/webthree-umbrella/issues/300
+			clog(NetWarn) << "Failed invariant during sync, restarting sync";
+			m_sync.restartSync();
+		}
+	}
+
+	void onPeerBlockTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) override
+	{
+		RecursiveGuard l(m_syncMutex);
+		try
+		{
+			m_sync.onPeerBlockTransactions(_peer, _r);
+		}
+		catch (FailedInvariant const&)
+		{
+			// "fix" for https://github.com/ethereum/webthree-umbrella/issues/300
+			clog(NetWarn) << "Failed invariant during sync, restarting sync";
+			m_sync.restartSync();
+		}
 	}
 
 private:
 	BlockChainSync& m_sync;
 	RecursiveMutex& m_syncMutex;
 	TransactionQueue& m_tq;
+
+	Mutex x_requested;
+	unordered_map<h256, chrono::steady_clock::time_point> m_requested;	///< Transactions asked for and when.
 };
 
 class EthereumHostData: public EthereumHostDataFace
 {
 public:
-	EthereumHostData(BlockChain const& _chain, OverlayDB const& _db): m_chain(_chain), m_db(_db) {}
+	EthereumHostData(BlockChain const& _chain, OverlayDB const& _db, TransactionQueue const& _tq): m_chain(_chain), m_db(_db), m_tq(_tq) {}
 
 	pair<bytes, unsigned> blockHeaders(RLP const& _blockId, unsigned _maxHeaders, u256 _skip, bool _reverse) const override
 	{
@@ -367,9 +464,57 @@ public:
 		return make_pair(rlp, n);
 	}
 
+	pair<bytes, unsigned> pooledTransactions(RLP const& _txHashes) const override
+	{
+		unsigned const count = static_cast<unsigned>(_txHashes.itemCount());
+
+		h256s hashes;
+		auto numItemsToSend = std::min(count, c_maxPooledTransactions);
+		for (unsigned i = 0; i < numItemsToSend; ++i)
+			hashes.push_back(_txHashes[i].toHash<h256>());
+
+		bytes rlp;
+		unsigned n = 0;
+		for (Transaction const& t: m_tq.transactions(hashes))
+		{
+			if (rlp.size() >= c_maxPayload)
+				break;
+			bytesConstRef r = t.rlpRef();
+			rlp.insert(rlp.end(), r.begin(), r.end());
+			++n;
+		}
+		clog(NetMessageSummary) << n << " pooled transactions known and returned;" << (numItemsToSend - n) << " unknown;" << (count > c_maxPooledTransactions ? count - c_maxPooledTransactions : 0) << " ignored";
+
+		return make_pair(rlp, n);
+	}
+
+	pair<bytes, unsigned> blockTransactions(h256 const& _blockHash, RLP const& _indices) const override
+	{
+		// All or nothing: the peer cannot rebuild the block from part of what it asked for.
+		if (!m_chain.isKnown(_blockHash))
+			return make_pair(bytes(), 0);
+
+		bytes const block = m_chain.block(_blockHash);
+		RLP transactions = RLP(block)[1];
+		bytes rlp;
+		unsigned n = 0;
+		for (auto const& i: _indices)
+		{
+			unsigned const index = i.toInt<unsigned>();
+			if (index >= transactions.itemCount())
+				return make_pair(bytes(), 0);
+			rlp += transactions[index].data();
+			++n;
+		}
+		clog(NetMessageSummary) << n << " block transactions returned";
+
+		return make_pair(rlp, n);
+	}
+
 private:
 	BlockChain const& m_chain;
 	OverlayDB const& m_db;
+	TransactionQueue const& m_tq;
 };
 
 }
@@ -382,7 +527,7 @@ EthereumHost::EthereumHost(BlockChain const& _ch, OverlayDB const& _db, Transact
 	m_tq		(_tq),
 	m_bq		(_bq),
 	m_networkId	(_networkId),
-	m_hostData(make_shared<EthereumHostData>(m_chain, m_db))
+	m_hostData(make_shared<EthereumHostData>(m_chain, m_db, m_tq))
 {
 	// TODO: Composition would be better. Left like that to avoid initialization
 	//       issues as BlockChainSync accesses other EthereumHost members.
@@ -477,20 +622,38 @@ void EthereumHost::maintainTransactions()
 		for (auto const& t: ts)
 			m_transactionsSent.insert(t.sha3());
 	}
+	// Peers speaking the newer protocol only get the hashes and fetch what they lack.
 	foreachPeer([&](shared_ptr<EthereumPeer> _p)
 	{
+		bool const announce = _p->announcesTransactions();
 		bytes b;
+		h256s hashes;
 		unsigned n = 0;
 		for (auto const& i: peerTransactions[_p])
 		{
 			_p->m_knownTransactions.insert(ts[i].sha3());
-			b += ts[i].rlp();
+			if (announce)
+				hashes.push_back(ts[i].sha3());
+			else
+			{
+				bytesConstRef r = ts[i].rlpRef();
+				b.insert(b.end(), r.begin(), r.end());
+			}
 			++n;
 		}
 
 		_p->clearKnownTransactions();
 
-		if (n || _p->m_requireTransactions)
+		if (announce && n)
+		{
+			RLPStream s;
+			_p->prep(s, NewPooledTransactionHashesPacket, n);
+			for (auto const& h: hashes)
+				s << h;
+			_p->sealAndSend(s);
+			clog(EthereumHostTrace) << "Announced" << n << "transactions to " << _p->session()->info().clientVersion;
+		}
+		else if (!announce && (n || _p->m_requireTransactions))
 		{
 			RLPStream ts;
 			_p->prep(ts, TransactionsPacket, n).appendRaw(b, n);
@@ -505,20 +668,17 @@ void EthereumHost::maintainTransactions()
 void EthereumHost::foreachPeer(std::function<bool(std::shared_ptr<EthereumPeer>)> const& _f) const
 {
 	//order peers by protocol, rating, connection age
-	auto sessions = peerSessions();
 	auto sessionLess = [](std::pair<std::shared_ptr<SessionFace>, std::shared_ptr<Peer>> const& _left, std::pair<std::shared_ptr<SessionFace>, std::shared_ptr<Peer>> const& _right)
 		{ return _left.first->rating() == _right.first->rating() ? _left.first->connectionTime() < _right.first->connectionTime() : _left.first->rating() > _right.first->rating(); };
 
-	std::sort(sessions.begin(), sessions.end(), sessionLess);
-	for (auto s: sessions)
-		if (!_f(capabilityFromSession<EthereumPeer>(*s.first)))
-			return;
-
-	sessions = peerSessions(c_oldProtocolVersion); //TODO: remove once v61+ is common
-	std::sort(sessions.begin(), sessions.end(), sessionLess);
-	for (auto s: sessions)
-		if (!_f(capabilityFromSession<EthereumPeer>(*s.first, c_oldProtocolVersion)))
-			return;
+	for (unsigned version: supportedProtocolVersions())
+	{
+		auto sessions = peerSessions(version);
+		std::sort(sessions.begin(), sessions.end(), sessionLess);
+		for (auto s: sessions)
+			if (!_f(capabilityFromSession<EthereumPeer>(*s.first, version)))
+				return;
+	}
 }
 
 tuple<vector<shared_ptr<EthereumPeer>>, vector<shared_ptr<EthereumPeer>>, vector<shared_ptr<SessionFace>>> EthereumHost::randomSelection(unsigned _percent, std::function<bool(EthereumPeer*)> const& _allow)
@@ -564,7 +724,37 @@ void EthereumHost::maintainBlocks(h256 const& _currentHash)
 
 			h256s blocks = get<0>(m_chain.treeRoute(m_latestBlockSent, _currentHash, false, false, true));
 
+			// A compact block is hardly bigger than a list of hashes, so every peer that can
+			// rebuild blocks from its transaction queue gets one.
+			vector<bytes> compact;
+			foreachPeer([&](shared_ptr<EthereumPeer> _p)
+			{
+				if (!_p->relaysCompactBlocks())
+					return true;
+				Guard l(_p->x_knownBlocks);
+				if (_p->m_knownBlocks.count(_currentHash))
+					return true;
+				if (compact.empty())
+					for (auto const& b: blocks)
+					{
+						bytes const block = m_chain.block(b);
+						RLPStream s;
+						streamCompactBlock(s, &block);
+						compact.push_back(s.out());
+					}
+				for (size_t i = 0; i < blocks.size(); ++i)
+				{
+					RLPStream ts;
+					_p->prep(ts, NewCompactBlockPacket, c_compactBlockItems + 1).appendRaw(compact[i], c_compactBlockItems).append(m_chain.details(blocks[i]).totalDifficulty);
+					_p->sealAndSend(ts);
+				}
+				_p->m_knownBlocks.clear();
+				return true;
+			});
+
 			auto s = randomSelection(25, [&](EthereumPeer* p){
+				if (p->relaysCompactBlocks())
+					return false;
 				DEV_GUARDED(p->x_knownBlocks)
 					return !p->m_knownBlocks.count(_currentHash);
 				return false;
@@ -604,6 +794,12 @@ bool EthereumHost::isSyncing() const
 	return m_sync->isSyncing();
 }
 
+void EthereumHost::setFastSyncImporter(std::unique_ptr<BlockChainImporterFace> _importer)
+{
+	RecursiveGuard l(x_sync);
+	m_fastSyncImporter = move(_importer);
+}
+
 SyncStatus EthereumHost::status() const
 {
 	RecursiveGuard l(x_sync);
@@ -616,9 +812,10 @@ void EthereumHost::onTransactionImported(ImportResult _ir, h256 const& _h, p2p::
 	if (!session)
 		return;
 
-	std::shared_ptr<EthereumPeer> peer = capabilityFromSession<EthereumPeer>(*session);
-	if (!peer)
-		peer = capabilityFromSession<EthereumPeer>(*session, c_oldProtocolVersion);
+	std::shared_ptr<EthereumPeer> peer;
+	for (unsigned version: supportedProtocolVersions())
+		if ((peer = capabilityFromSession<EthereumPeer>(*session, version)))
+			break;
 	if (!peer)
 		return;
 
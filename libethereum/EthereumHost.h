@@ -50,6 +50,7 @@ namespace eth
 class TransactionQueue;
 class BlockQueue;
 class BlockChainSync;
+class BlockChainImporterFace;
 
 struct EthereumHostTrace: public LogChannel { static const char* name(); static const int verbosity = 6; };
 
@@ -86,14 +87,25 @@ public:
 	OverlayDB const& db() const { return m_db; }
 	BlockQueue& bq() { return m_bq; }
 	BlockQueue const& bq() const { return m_bq; }
+	TransactionQueue const& tq() const { return m_tq; }
 	SyncStatus status() const;
+
+	/// Sync a chain that is still at genesis by downloading the state of a recent block rather than
+	/// replaying every block; @a _importer inserts the blocks downloaded without executing them.
+	/// Null turns fast sync off. Set this before peers connect.
+	void setFastSyncImporter(std::unique_ptr<BlockChainImporterFace> _importer);
+	BlockChainImporterFace* fastSyncImporter() const { return m_fastSyncImporter.get(); }
+
 	h256 latestBlockSent() { return m_latestBlockSent; }
 	static char const* stateName(SyncState _s) { return s_stateNames[static_cast<int>(_s)]; }
 
 	static unsigned const c_oldProtocolVersion;
+	static unsigned const c_legacyTransactionsProtocolVersion;	///< Newest version sending transactions in full rather than announcing their hashes.
 	void foreachPeer(std::function<bool(std::shared_ptr<EthereumPeer>)> const& _f) const;
 
 protected:
+	using p2p::HostCapability<EthereumPeer>::messageCount;
+	unsigned messageCount(u256 const& _version) const override { return EthereumPeer::messageCount(_version); }
 	std::shared_ptr<p2p::Capability> newPeerCapability(std::shared_ptr<p2p::SessionFace> const& _s, unsigned _idOffset, p2p::CapDesc const& _cap, uint16_t _capID) override;
 
 private:
@@ -136,6 +148,7 @@ private:
 	mutable Mutex x_transactions;
 	std::unique_ptr<BlockChainSync> m_sync;
 	std::atomic<time_t> m_lastTick = { 0 };
+	std::unique_ptr<BlockChainImporterFace> m_fastSyncImporter;
 
 	std::shared_ptr<EthereumHostDataFace> m_hostData;
 	std::shared_ptr<EthereumPeerObserverFace> m_peerObserver;
@@ -27,6 +27,7 @@
 #include <libp2p/Session.h>
 #include <libp2p/Host.h>
 #include "EthereumHost.h"
+#include "CompactBlock.h"
 
 using namespace std;
 using namespace dev;
@@ -129,9 +130,8 @@ void EthereumPeer::requestStatus(u256 _hostNetworkId, u256 _chainTotalDifficulty
 	setAsking(Asking::State);
 	m_requireTransactions = true;
 	RLPStream s;
-	bool latest = m_peerCapabilityVersion == m_hostProtocolVersion;
 	prep(s, StatusPacket, 5)
-					<< (latest ? m_hostProtocolVersion : EthereumHost::c_oldProtocolVersion)
+					<< static_cast<unsigned>(m_peerCapabilityVersion)
 					<< _hostNetworkId
 					<< _chainTotalDifficulty
 					<< _chainCurrentHash
@@ -183,6 +183,43 @@ void EthereumPeer::requestReceipts(h256s const& _blocks)
 	requestByHashes(_blocks, Asking::Receipts, GetReceiptsPacket);
 }
 
+void EthereumPeer::requestPooledTransactions(h256s const& _hashes)
+{
+	// Not part of the sync conversation, so this leaves m_asking alone.
+	if (_hashes.empty())
+		return;
+	RLPStream s;
+	prep(s, GetPooledTransactionsPacket, _hashes.size());
+	for (auto const& i: _hashes)
+		s << i;
+	sealAndSend(s);
+}
+
+void EthereumPeer::requestBlockTransactions(h256 const& _block, std::vector<unsigned> const& _indices)
+{
+	RLPStream s;
+	prep(s, GetBlockTransactionsPacket, 2) << _block;
+	s.appendList(_indices.size());
+	for (auto i: _indices)
+		s << i;
+	sealAndSend(s);
+}
+
+unsigned EthereumPeer::messageCount(u256 const& _version)
+{
+	return _version > EthereumHost::c_legacyTransactionsProtocolVersion ? PacketCount : BlockTransactionsPacket;
+}
+
+bool EthereumPeer::announcesTransactions() const
+{
+	return m_peerCapabilityVersion > EthereumHost::c_legacyTransactionsProtocolVersion;
+}
+
+bool EthereumPeer::relaysCompactBlocks() const
+{
+	return m_peerCapabilityVersion > EthereumHost::c_legacyTransactionsProtocolVersion;
+}
+
 void EthereumPeer::requestByHashes(h256s const& _hashes, Asking _asking, SubprotocolPacketType _packetType)
 {
 	if (m_asking != Asking::Nothing)
@@ -206,6 +243,8 @@ void EthereumPeer::setAsking(Asking _a)
 {
 	m_asking = _a;
 	m_lastAsk = std::chrono::system_clock::to_time_t(chrono::system_clock::now());
+	if (_a != Asking::Nothing)
+		m_throughput.requested(_a);
 
 	auto s = session();
 	if (s)
@@ -224,6 +263,16 @@ void EthereumPeer::tick()
 		s->disconnect(PingTimeout);
 }
 
+void EthereumPeer::noteAnswer(RLP const& _r)
+{
+	m_throughput.delivered(static_cast<unsigned>(_r.itemCount()), _r.data().size());
+	if (auto s = session())
+	{
+		s->addNote("latency", toString(m_throughput.latency().count()) + "ms");
+		s->addNote("bandwidth", toString(static_cast<uint64_t>(m_throughput.bandwidth())) + "B/s");
+	}
+}
+
 bool EthereumPeer::isConversing() const
 {
 	return m_asking != Asking::Nothing;
@@ -263,6 +312,85 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 		m_observer->onPeerTransactions(dynamic_pointer_cast<EthereumPeer>(dynamic_pointer_cast<EthereumPeer>(shared_from_this())), _r);
 		break;
 	}
+	case NewPooledTransactionHashesPacket:
+	{
+		unsigned itemCount = _r.itemCount();
+		clog(NetMessageSummary) << "NewPooledTransactionHashes (" << dec << itemCount << "entries)";
+
+		if (itemCount > c_maxTransactionHashes)
+		{
+			disable("Too many transaction hashes");
+			break;
+		}
+
+		h256s hashes = _r.toVector<h256>();
+		DEV_GUARDED(x_knownTransactions)
+			m_knownTransactions.insert(hashes.begin(), hashes.end());
+
+		m_observer->onPeerTransactionHashes(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), hashes);
+		break;
+	}
+	case GetPooledTransactionsPacket:
+	{
+		unsigned count = static_cast<unsigned>(_r.itemCount());
+		if (!count)
+		{
+			clog(NetImpolite) << "Zero-entry GetPooledTransactions: Not replying.";
+			addRating(-10);
+			break;
+		}
+		clog(NetMessageSummary) << "GetPooledTransactions (" << dec << count << " entries)";
+
+		pair<bytes, unsigned> const rlpAndItemCount = m_hostData->pooledTransactions(_r);
+
+		addRating(0);
+		RLPStream s;
+		prep(s, PooledTransactionsPacket, rlpAndItemCount.second).appendRaw(rlpAndItemCount.first, rlpAndItemCount.second);
+		sealAndSend(s);
+		break;
+	}
+	case PooledTransactionsPacket:
+	{
+		m_observer->onPeerTransactions(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
+		break;
+	}
+	case NewCompactBlockPacket:
+	{
+		if (_r.itemCount() != c_compactBlockItems + 1)
+		{
+			disable("NewCompactBlock without 4 data fields.");
+			break;
+		}
+		m_observer->onPeerCompactBlock(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
+		break;
+	}
+	case GetBlockTransactionsPacket:
+	{
+		/// Packet layout:
+		/// [ block: B_32, [ index: P, ... ] ]
+		if (!relaysCompactBlocks())
+		{
+			// The answer would be outside the message ids of the peer's version.
+			disable("GetBlockTransactions before eth/64");
+			break;
+		}
+		h256 const blockHash = _r[0].toHash<h256>();
+		clog(NetMessageSummary) << "GetBlockTransactions (" << blockHash << "," << dec << _r[1].itemCount() << " entries)";
+
+		pair<bytes, unsigned> const rlpAndItemCount = m_hostData->blockTransactions(blockHash, _r[1]);
+
+		addRating(0);
+		RLPStream s;
+		prep(s, BlockTransactionsPacket, 2) << blockHash;
+		s.appendList(rlpAndItemCount.second).appendRaw(rlpAndItemCount.first, rlpAndItemCount.second);
+		sealAndSend(s);
+		break;
+	}
+	case BlockTransactionsPacket:
+	{
+		m_observer->onPeerBlockTransactions(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
+		break;
+	}
 	case GetBlockHeadersPacket:
 	{
 		/// Packet layout:
@@ -294,6 +422,7 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			clog(NetImpolite) << "Peer giving us block headers when we didn't ask for them.";
 		else
 		{
+			noteAnswer(_r);
 			setIdle();
 			m_observer->onPeerBlockHeaders(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
 		}
@@ -325,6 +454,7 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			clog(NetImpolite) << "Peer giving us block bodies when we didn't ask for them.";
 		else
 		{
+			noteAnswer(_r);
 			setIdle();
 			m_observer->onPeerBlockBodies(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
 		}
@@ -400,6 +530,7 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			clog(NetImpolite) << "Peer giving us node data when we didn't ask for them.";
 		else
 		{
+			noteAnswer(_r);
 			setIdle();
 			m_observer->onPeerNodeData(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
 		}
@@ -411,6 +542,7 @@ bool EthereumPeer::interpret(unsigned _id, RLP const& _r)
 			clog(NetImpolite) << "Peer giving us receipts when we didn't ask for them.";
 		else
 		{
+			noteAnswer(_r);
 			setIdle();
 			m_observer->onPeerReceipts(dynamic_pointer_cast<EthereumPeer>(shared_from_this()), _r);
 		}
@@ -31,6 +31,7 @@
 #include <libethcore/Common.h>
 #include <libp2p/Capability.h>
 #include "CommonNet.h"
+#include "PeerThroughput.h"
 
 namespace dev
 {
@@ -46,6 +47,8 @@ public:
 
 	virtual void onPeerTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
 
+	virtual void onPeerTransactionHashes(std::shared_ptr<EthereumPeer> _peer, h256s const& _hashes) = 0;
+
 	virtual void onPeerBlockHeaders(std::shared_ptr<EthereumPeer> _peer, RLP const& _headers) = 0;
 
 	virtual void onPeerBlockBodies(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
@@ -58,6 +61,10 @@ public:
 
 	virtual void onPeerReceipts(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
 
+	virtual void onPeerCompactBlock(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
+
+	virtual void onPeerBlockTransactions(std::shared_ptr<EthereumPeer> _peer, RLP const& _r) = 0;
+
 	virtual void onPeerAborting() = 0;
 };
 
@@ -73,6 +80,10 @@ public:
 	virtual strings nodeData(RLP const& _dataHashes) const = 0;
 
 	virtual std::pair<bytes, unsigned> receipts(RLP const& _blockHashes) const = 0;
+
+	virtual std::pair<bytes, unsigned> pooledTransactions(RLP const& _txHashes) const = 0;
+
+	virtual std::pair<bytes, unsigned> blockTransactions(h256 const& _blockHash, RLP const& _indices) const = 0;
 };
 
 /**
@@ -100,6 +111,8 @@ public:
 
 	/// How many message types do we have?
 	static unsigned messageCount() { return PacketCount; }
+	/// How many message types does version @a _version have? Older versions end before BlockTransactionsPacket.
+	static unsigned messageCount(u256 const& _version);
 
 	void init(unsigned _hostProtocolVersion, u256 _hostNetworkId, u256 _chainTotalDifficulty, h256 _chainCurrentHash, h256 _chainGenesisHash, std::shared_ptr<EthereumHostDataFace> _hostData, std::shared_ptr<EthereumPeerObserverFace> _observer);
 
@@ -121,6 +134,18 @@ public:
 	/// Request receipts for specified blocks from peer.
 	void requestReceipts(h256s const& _blocks);
 
+	/// Request the bodies of announced transactions from peer.
+	void requestPooledTransactions(h256s const& _hashes);
+
+	/// Request transactions of a block announced in compact form from peer.
+	void requestBlockTransactions(h256 const& _block, std::vector<unsigned> const& _indices);
+
+	/// Does the peer get new transactions announced by hash rather than sent in full?
+	bool announcesTransactions() const;
+
+	/// Does the peer get new blocks in compact form rather than in full?
+	bool relaysCompactBlocks() const;
+
 	/// Check if this node is rude.
 	bool isRude() const;
 
@@ -130,6 +155,9 @@ public:
 	/// Abort the sync operation.
 	void abortSync();
 
+	/// How quickly the peer has been answering our requests.
+	PeerThroughput const& throughput() const { return m_throughput; }
+
 private:
 	using p2p::Capability::sealAndSend;
 
@@ -163,6 +191,9 @@ private:
 	/// Runs period checks to check up on the peer.
 	void tick();
 
+	/// Measure the answer @a _r to the request last sent.
+	void noteAnswer(RLP const& _r);
+
 	unsigned m_hostProtocolVersion = 0;
 
 	/// Peer's protocol version.
@@ -191,6 +222,7 @@ private:
 	h256Hash m_knownTransactions;			///< Transactions that the peer already knows of.
 	unsigned m_unknownNewBlocks = 0;		///< Number of unknown NewBlocks received from this peer
 	unsigned m_lastAskedHeaders = 0;		///< Number of hashes asked
+	PeerThroughput m_throughput;
 
 	std::shared_ptr<EthereumPeerObserverFace> m_observer;
 	std::shared_ptr<EthereumHostDataFace> m_hostData;
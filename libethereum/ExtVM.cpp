@@ -142,6 +142,8 @@ size_t ExtVM::codeSizeAt(dev::Address _a)
 
 void ExtVM::setStore(u256 _n, u256 _v)
 {
+	if (m_storageAccess)
+		m_storageAccess->noteRead(_n);
 	m_s.setStorage(myAddress, _n, _v);
 }
 
@@ -28,6 +28,7 @@
 #include <libethcore/SealEngine.h>
 #include "State.h"
 #include "Executive.h"
+#include "StoragePrefetcher.h"
 
 namespace dev
 {
@@ -57,10 +58,17 @@ public:
 		// is created only if an account has code (so exist). In case of CREATE
 		// the account must be created first.
 		assert(m_s.addressInUse(_myAddress));
+		if (!_isCreate && StoragePrefetcher::instance().enabled())
+			m_storageAccess.reset(new StorageAccessRecorder(m_s, myAddress, codeHash, data));
 	}
 
 	/// Read storage location.
-	virtual u256 store(u256 _n) override final { return m_s.storage(myAddress, _n); }
+	virtual u256 store(u256 _n) override final
+	{
+		if (m_storageAccess)
+			m_storageAccess->noteRead(_n);
+		return m_s.storage(myAddress, _n);
+	}
 
 	/// Write a value in storage.
 	virtual void setStore(u256 _n, u256 _v) override final;
@@ -116,6 +124,7 @@ private:
 	State& m_s;  ///< A reference to the base state.
 	SealEngineFace const& m_sealEngine;
 	EVMSchedule const& m_evmSchedule;
+	std::unique_ptr<StorageAccessRecorder> m_storageAccess;	///< Set while storage prefetching is enabled.
 };
 
 }
@@ -0,0 +1,54 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file HeaderSkeleton.cpp
+ */
+
+#include "HeaderSkeleton.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const unsigned HeaderSkeleton::c_step;
+const unsigned HeaderSkeleton::c_maxHeaders;
+const unsigned HeaderSkeleton::c_maxAhead;
+
+vector<unsigned> HeaderSkeleton::request(unsigned _lastImported, unsigned _highest)
+{
+	if (!m_requested.empty())
+		return {};
+	unsigned const from = max(m_top, _lastImported);
+	if (_highest <= from + c_step || from >= _lastImported + c_maxAhead)
+		return {};
+
+	unsigned const count = min(c_maxHeaders, (_highest - from) / c_step);
+	for (unsigned i = 1; i <= count; ++i)
+		m_requested.push_back(from + i * c_step);
+	return m_requested;
+}
+
+void HeaderSkeleton::accept(vector<unsigned> const& _requested, function<bool(unsigned)> const& _have)
+{
+	for (unsigned block: _requested)
+	{
+		if (!_have(block))
+			break;
+		m_top = max(m_top, block);
+	}
+}
@@ -0,0 +1,71 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file HeaderSkeleton.h
+ * Plans the sparse run of headers that block sync fills in from all peers.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief Keeps track of the header skeleton: every c_step-th header ahead of the import.
+ *
+ * One skeleton request is outstanding at a time. The skeleton only grows by the headers of
+ * an answer that were actually merged, so a request that failed, was rejected or came back
+ * short is asked again from where it stopped rather than leaving a hole below the top.
+ * Not thread-safe; BlockChainSync calls it under its lock.
+ */
+class HeaderSkeleton
+{
+public:
+	/// @returns the block numbers to ask for next, or nothing if a request is outstanding or
+	/// the skeleton reaches far enough beyond @a _lastImported towards @a _highest.
+	std::vector<unsigned> request(unsigned _lastImported, unsigned _highest);
+
+	/// @returns the block numbers of the outstanding request; empty if there is none.
+	std::vector<unsigned> const& requested() const { return m_requested; }
+
+	/// Forget the outstanding request without extending the skeleton.
+	void cancel() { m_requested.clear(); }
+
+	/// Extend the skeleton over @a _requested, as far as @a _have holds for each of them in turn.
+	void accept(std::vector<unsigned> const& _requested, std::function<bool(unsigned)> const& _have);
+
+	/// Start again from the import.
+	void reset() { m_top = 0; m_requested.clear(); }
+
+	/// @returns the highest skeleton header accepted so far.
+	unsigned top() const { return m_top; }
+
+	static const unsigned c_step = 192;			///< Distance between skeleton headers; each gap is one header request
+	static const unsigned c_maxHeaders = 128;	///< Most skeleton headers asked for at once
+	static const unsigned c_maxAhead = c_step * c_maxHeaders * 2;	///< Keeps downloaded headers within reach of the import
+
+private:
+	unsigned m_top = 0;
+	std::vector<unsigned> m_requested;
+};
+
+}
+}
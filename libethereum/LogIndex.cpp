@@ -0,0 +1,213 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file LogIndex.cpp
+ */
+
+#include "LogIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <libdevcore/RLP.h>
+#include <libdevcore/SHA3.h>
+#include "BlockChain.h"
+#include "LogFilter.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+
+using EntryKey = FixedHash<41>;
+
+/// The key of the entry of @a _term for block @a _number: the tag, the term, then the number.
+EntryKey entryKey(h256 const& _term, unsigned _number)
+{
+	EntryKey ret;
+	ret[0] = ExtraLogIndex;
+	memcpy(ret.data() + 1, _term.data(), h256::size);
+	bytesRef number(ret.data() + 1 + h256::size, 8);
+	toBigEndian(uint64_t(_number), number);
+	return ret;
+}
+
+unsigned const c_noEntry = numeric_limits<unsigned>::max();
+
+/// The entries of one term, read in block order.
+class Postings
+{
+public:
+	Postings(ldb::DB* _db, h256 const& _term, unsigned _earliest, unsigned _latest):
+		m_it(_db->NewIterator(ldb::ReadOptions())), m_term(_term), m_latest(_latest)
+	{
+		EntryKey const k = entryKey(m_term, _earliest);
+		m_it->Seek(ldb::Slice((char const*)k.data(), k.size));
+		load();
+	}
+
+	/// @returns the number of the block of the current entry; c_noEntry if there are no more.
+	unsigned number() const { return m_number; }
+
+	/// Moves on to the first entry of block @a _number or later.
+	void seek(unsigned _number)
+	{
+		if (m_number >= _number)
+			return;
+		EntryKey const k = entryKey(m_term, _number);
+		m_it->Seek(ldb::Slice((char const*)k.data(), k.size));
+		load();
+	}
+
+	/// @returns the block hash and the transactions of the current entry.
+	RLP entry() const { return RLP(bytesConstRef((byte const*)m_it->value().data(), m_it->value().size())); }
+
+private:
+	void load()
+	{
+		m_number = c_noEntry;
+		if (!m_it->Valid())
+			return;
+		ldb::Slice const k = m_it->key();
+		if (k.size() != EntryKey::size || k.data()[0] != char(ExtraLogIndex) || memcmp(k.data() + 1, m_term.data(), h256::size))
+			return;
+		uint64_t const n = fromBigEndian<uint64_t>(bytesConstRef((byte const*)k.data() + 1 + h256::size, 8));
+		if (n <= m_latest)
+			m_number = unsigned(n);
+	}
+
+	unique_ptr<ldb::Iterator> m_it;
+	h256 m_term;
+	unsigned m_latest;
+	unsigned m_number = c_noEntry;
+};
+
+}
+
+h256 LogIndex::addressTerm(Address const& _a)
+{
+	return sha3(_a.ref());
+}
+
+h256 LogIndex::topicTerm(unsigned _position, h256 const& _topic)
+{
+	FixedHash<33> k(_topic);
+	k[h256::size] = byte(_position);
+	return sha3(k.ref());
+}
+
+void LogIndex::write(ldb::WriteBatch& o_batch, unsigned _number, h256 const& _hash, TransactionReceipts const& _receipts)
+{
+	map<h256, set<unsigned>> terms;
+	for (unsigned i = 0; i < _receipts.size(); ++i)
+		for (LogEntry const& e: _receipts[i].log())
+		{
+			terms[addressTerm(e.address)].insert(i);
+			for (unsigned p = 0; p < e.topics.size() && p < 4; ++p)
+				terms[topicTerm(p, e.topics[p])].insert(i);
+		}
+
+	for (auto const& t: terms)
+	{
+		RLPStream s(2);
+		s << _hash << t.second;
+		EntryKey const k = entryKey(t.first, _number);
+		o_batch.Put(ldb::Slice((char const*)k.data(), k.size), (ldb::Slice)dev::ref(s.out()));
+	}
+}
+
+void LogIndex::forEachCandidate(ldb::DB* _db, LogFilter const& _filter, unsigned _earliest, unsigned _latest, function<h256(unsigned)> const& _hashOf, OnCandidate const& _f)
+{
+	// One group of postings for the addresses and one for each topic position the filter asks
+	// for; a log matches only if it is in at least one of the postings of each group.
+	vector<vector<Postings>> groups;
+	if (!_filter.addresses().empty())
+	{
+		groups.emplace_back();
+		for (auto const& a: _filter.addresses())
+			groups.back().emplace_back(_db, addressTerm(a), _earliest, _latest);
+	}
+	for (unsigned p = 0; p < 4; ++p)
+		if (!_filter.topics()[p].empty())
+		{
+			groups.emplace_back();
+			for (auto const& t: _filter.topics()[p])
+				groups.back().emplace_back(_db, topicTerm(p, t), _earliest, _latest);
+		}
+	if (groups.empty())
+		return;
+
+	for (unsigned next = _earliest; next <= _latest;)
+	{
+		// Skip ahead until every group has an entry for the same block.
+		unsigned number = next;
+		for (bool agreed = false; !agreed;)
+		{
+			agreed = true;
+			for (auto& g: groups)
+			{
+				unsigned first = c_noEntry;
+				for (auto& p: g)
+				{
+					p.seek(number);
+					first = min(first, p.number());
+				}
+				if (first == c_noEntry)
+					return;
+				if (first != number)
+				{
+					number = first;
+					agreed = false;
+				}
+			}
+		}
+
+		h256 const hash = _hashOf(number);
+		set<unsigned> transactions;
+		for (size_t i = 0; i < groups.size(); ++i)
+		{
+			set<unsigned> inGroup;
+			for (auto const& p: groups[i])
+				if (p.number() == number)
+				{
+					RLP const e = p.entry();
+					if (e[0].toHash<h256>() == hash)
+						for (auto t: e[1].toSet<unsigned>())
+							inGroup.insert(t);
+				}
+			if (i == 0)
+				transactions = move(inGroup);
+			else
+			{
+				set<unsigned> both;
+				set_intersection(transactions.begin(), transactions.end(), inGroup.begin(), inGroup.end(), inserter(both, both.end()));
+				transactions = move(both);
+			}
+			if (transactions.empty())
+				break;
+		}
+		if (!transactions.empty())
+			_f(number, hash, transactions);
+
+		if (number == _latest)
+			break;
+		next = number + 1;
+	}
+}
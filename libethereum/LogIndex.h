@@ -0,0 +1,72 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file LogIndex.h
+ * Index of the blocks and transactions with logs of each address and topic.
+ */
+
+#pragma once
+
+#include <functional>
+#include <set>
+#include <libdevcore/db.h>
+#include <libdevcore/Address.h>
+#include <libdevcore/FixedHash.h>
+#include "TransactionReceipt.h"
+
+namespace dev
+{
+namespace eth
+{
+
+class LogFilter;
+
+/**
+ * @brief Posting lists from the addresses and topics of logs to the blocks and transactions
+ * that have them, kept in the extras database.
+ *
+ * For every address and every topic (at its position) in the logs of a block there is one
+ * entry, keyed by the term and then the block number, so the entries of a term are in block
+ * order. A filter reads only the entries of its own terms over the range it asks for,
+ * rather than testing the blooms of the range and decoding every receipt of every block
+ * that may match.
+ *
+ * An entry names its block by hash too. When the canonical chain changes, the new blocks
+ * overwrite the entries at their numbers but the others stay; they are skipped by checking
+ * the hash against the chain.
+ */
+class LogIndex
+{
+public:
+	/// Called with the number and hash of a block and the transactions in it that may have matching logs.
+	using OnCandidate = std::function<void(unsigned _number, h256 const& _hash, std::set<unsigned> const& _transactions)>;
+
+	/// @returns the term of the logs of @a _a.
+	static h256 addressTerm(Address const& _a);
+	/// @returns the term of the logs with @a _topic as their topic number @a _position.
+	static h256 topicTerm(unsigned _position, h256 const& _topic);
+
+	/// Adds to @a o_batch the entries of block @a _number with hash @a _hash and receipts @a _receipts.
+	static void write(ldb::WriteBatch& o_batch, unsigned _number, h256 const& _hash, TransactionReceipts const& _receipts);
+
+	/// Calls @a _f, in order, for each block from @a _earliest to @a _latest with entries for all
+	/// of the address and topic positions @a _filter asks for. Entries whose hash is not
+	/// @a _hashOf the block number are ignored. @a _filter must not be a range filter.
+	static void forEachCandidate(ldb::DB* _db, LogFilter const& _filter, unsigned _earliest, unsigned _latest, std::function<h256(unsigned)> const& _hashOf, OnCandidate const& _f);
+};
+
+}
+}
@@ -0,0 +1,269 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file ParallelExecutor.cpp
+ */
+
+#include "ParallelExecutor.h"
+
+#include <condition_variable>
+#include <memory>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/optional.hpp>
+#include <libdevcore/Guards.h>
+#include <libethcore/SealEngine.h>
+#include "State.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const char* ParallelExecutorChannel::name() { return EthViolet "⚙" EthYellow " ∥"; }
+
+std::atomic<unsigned> ParallelExecutor::s_threads{0};
+std::atomic<uint64_t> ParallelExecutor::s_transactions{0};
+std::atomic<uint64_t> ParallelExecutor::s_reexecuted{0};
+
+namespace
+{
+
+/// Speculative workers, shared by all blocks. A block keeps the pool it started with, so that a
+/// larger one replacing it only stops its threads once they are done.
+Mutex x_speculationPool;
+shared_ptr<boost::asio::thread_pool> s_speculationPool;
+unsigned s_speculationPoolSize = 0;
+
+shared_ptr<boost::asio::thread_pool> speculationPool()
+{
+	Guard l(x_speculationPool);
+	return s_speculationPool;
+}
+
+/// Outcome of running one transaction against the block's base state.
+struct Speculation
+{
+	unique_ptr<State> state;
+	StateAccessLog log;
+	boost::optional<TransactionReceipt> receipt;	///< Unset if execution threw.
+	bool done = false;
+};
+
+/// Everything written by the transactions already committed in this block.
+class BlockWrites
+{
+public:
+	void add(StateAccessLog const& _log)
+	{
+		for (auto const& a: _log.accountWrites)
+			m_accounts.insert(a);
+		for (auto const& a: _log.storageResets)
+		{
+			m_accounts.insert(a);
+			m_storageTouched.insert(a);
+		}
+		for (auto const& c: _log.credits)
+			m_credited.insert(c.first);
+		for (auto const& s: _log.storageWrites)
+		{
+			m_slots.insert(s);
+			m_storageTouched.insert(s.first);
+		}
+	}
+
+	/// @returns true if a transaction with access log @a _log could have observed different
+	/// values, or would overwrite different ones, had it run after the recorded writes.
+	bool conflicts(StateAccessLog const& _log) const
+	{
+		for (auto const& a: _log.accountReads)
+			if (m_accounts.count(a) || m_credited.count(a))
+				return true;
+		// Whole accounts are merged verbatim, so nothing else may have touched them.
+		for (auto const& a: _log.accountWrites)
+			if (m_storageTouched.count(a))
+				return true;
+		for (auto const& a: _log.storageResets)
+			if (m_accounts.count(a) || m_storageTouched.count(a) || m_credited.count(a))
+				return true;
+		for (auto const& c: _log.credits)
+			if (m_accounts.count(c.first))
+				return true;
+		for (auto const& s: _log.storageReads)
+			if (m_slots.count(s) || m_accounts.count(s.first))
+				return true;
+		return false;
+	}
+
+private:
+	AddressHash m_accounts;
+	AddressHash m_credited;
+	AddressHash m_storageTouched;
+	std::set<std::pair<Address, u256>> m_slots;
+};
+
+}
+
+void ParallelExecutor::setThreads(unsigned _threads)
+{
+	if (_threads > 1)
+		DEV_GUARDED(x_speculationPool)
+			if (_threads > s_speculationPoolSize)
+			{
+				s_speculationPool = make_shared<boost::asio::thread_pool>(_threads);
+				s_speculationPoolSize = _threads;
+			}
+	s_threads = _threads;
+}
+
+bool ParallelExecutor::applies(BlockHeader const& _header, SealEngineFace const& _sealEngine, size_t _count)
+{
+	return s_threads > 1 && _count > 1 && _header.number() >= _sealEngine.chainParams().byzantiumForkBlock;
+}
+
+TransactionReceipts ParallelExecutor::execute(State& io_state, BlockHeader const& _header, LastBlockHashesFace const& _lh, SealEngineFace const& _sealEngine, Transactions const& _transactions)
+{
+	u256 const chainID = _sealEngine.chainParams().chainID;
+	bool const removeEmptyAccounts = _header.number() >= _sealEngine.chainParams().EIP158ForkBlock;
+	// One copy of the state per block; each speculation is a layer over it holding only what it touches.
+	auto const base = make_shared<State const>(io_state);
+
+	vector<Speculation> speculations(_transactions.size());
+	atomic<size_t> next{0};
+	atomic<bool> stop{false};
+	Mutex x_done;
+	condition_variable cvDone;
+
+	auto speculate = [&]()
+	{
+		for (size_t i = next++; i < _transactions.size() && !stop; i = next++)
+		{
+			Speculation& s = speculations[i];
+			try
+			{
+				s.state.reset(new State(State::layered(base)));
+				s.state->setAccessLog(&s.log);
+				EnvInfo const envInfo(_header, _lh, 0, chainID);
+				s.receipt = s.state->execute(envInfo, _sealEngine, _transactions[i], Permanence::Uncommitted).second;
+			}
+			catch (...)
+			{
+				// Serial re-execution reports the error, if it is still one by then.
+			}
+			if (s.state)
+				s.state->setAccessLog(nullptr);
+			{
+				Guard l(x_done);
+				s.done = true;
+			}
+			cvDone.notify_all();
+		}
+	};
+
+	shared_ptr<boost::asio::thread_pool> const pool = speculationPool();
+	unsigned const workers = min<size_t>(s_threads, _transactions.size());
+	unsigned running = workers;
+	for (unsigned t = 0; t < workers; ++t)
+		boost::asio::post(*pool, [&]()
+		{
+			speculate();
+			// Notified under the lock, as the waiter may return and destroy cvDone as soon as it is released.
+			Guard l(x_done);
+			--running;
+			cvDone.notify_all();
+		});
+	auto joinWorkers = [&]()
+	{
+		stop = true;
+		unique_lock<Mutex> l(x_done);
+		cvDone.wait(l, [&](){ return !running; });
+	};
+
+	TransactionReceipts receipts;
+	receipts.reserve(_transactions.size());
+	BlockWrites written;
+	u256 gasUsed = 0;
+	unsigned reexecuted = 0;
+	try
+	{
+		for (size_t i = 0; i < _transactions.size(); ++i)
+		{
+			Speculation& s = speculations[i];
+			{
+				unique_lock<Mutex> l(x_done);
+				cvDone.wait(l, [&](){ return s.done; });
+			}
+
+			bool const valid =
+				s.receipt &&
+				gasUsed + _transactions[i].gas() <= _header.gasLimit() &&
+				!written.conflicts(s.log);
+			if (valid)
+			{
+				io_state.mergeSpeculative(*s.state, s.log);
+				io_state.commit(removeEmptyAccounts ? State::CommitBehaviour::RemoveEmptyAccounts : State::CommitBehaviour::KeepEmptyAccounts);
+				written.add(s.log);
+				receipts.emplace_back(s.receipt->statusCode(), gasUsed + s.receipt->gasUsed(), s.receipt->log());
+			}
+			else
+			{
+				++reexecuted;
+				StateAccessLog log;
+				io_state.setAccessLog(&log);
+				try
+				{
+					EnvInfo const envInfo(_header, _lh, gasUsed, chainID);
+					receipts.push_back(io_state.execute(envInfo, _sealEngine, _transactions[i], Permanence::Committed).second);
+				}
+				catch (Exception& ex)
+				{
+					io_state.setAccessLog(nullptr);
+					ex << errinfo_transactionIndex(i);
+					throw;
+				}
+				catch (...)
+				{
+					io_state.setAccessLog(nullptr);
+					throw;
+				}
+				io_state.setAccessLog(nullptr);
+				written.add(log);
+			}
+			gasUsed = receipts.back().cumulativeGasUsed();
+			s = Speculation();
+		}
+	}
+	catch (...)
+	{
+		joinWorkers();
+		s_transactions += _transactions.size();
+		s_reexecuted += reexecuted;
+		throw;
+	}
+	joinWorkers();
+
+	s_transactions += _transactions.size();
+	s_reexecuted += reexecuted;
+	clog(ParallelExecutorChannel) << "Executed" << _transactions.size() << "transactions with" << workers << "threads," << reexecuted << "re-executed; overall conflict rate" << stats().conflictRate();
+	return receipts;
+}
+
+ParallelExecutionStats ParallelExecutor::stats()
+{
+	ParallelExecutionStats ret;
+	ret.transactions = s_transactions;
+	ret.reexecuted = s_reexecuted;
+	return ret;
+}
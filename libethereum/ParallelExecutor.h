@@ -0,0 +1,90 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file ParallelExecutor.h
+ * Optimistic-concurrency execution of the transactions of a block.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <libdevcore/Common.h>
+#include <libdevcore/Log.h>
+#include <libethcore/BlockHeader.h>
+#include "Transaction.h"
+#include "TransactionReceipt.h"
+
+namespace dev
+{
+namespace eth
+{
+
+class State;
+class SealEngineFace;
+class LastBlockHashesFace;
+
+struct ParallelExecutorChannel: public LogChannel { static const char* name(); static const int verbosity = 6; };
+
+/// Counters accumulated over all blocks executed in parallel since start-up.
+struct ParallelExecutionStats
+{
+	uint64_t transactions = 0;	///< Transactions executed through the parallel path.
+	uint64_t reexecuted = 0;	///< Transactions whose speculative result was discarded and which ran again serially.
+
+	/// @returns the fraction of transactions that had to be re-executed.
+	double conflictRate() const { return transactions ? double(reexecuted) / transactions : 0; }
+};
+
+/**
+ * @brief Executes the transactions of a block speculatively on several threads.
+ *
+ * Every transaction is run against a private layer over the state as it was at the start of the
+ * block while its account and storage accesses are recorded (see StateAccessLog). Results are
+ * then validated and committed in block order: a transaction whose reads overlap the writes of
+ * an earlier transaction of the block is discarded and executed again serially on the real
+ * state, so receipts and the resulting state are identical to serial execution.
+ *
+ * Disabled by default; enable with setThreads(), which starts the worker threads. They are kept for
+ * the lifetime of the process, or until more are asked for.
+ */
+class ParallelExecutor
+{
+public:
+	/// Use @a _threads speculative workers per block; 0 or 1 disables parallel execution.
+	/// Grows the pool of workers if it has fewer threads than that.
+	static void setThreads(unsigned _threads);
+	static unsigned threads() { return s_threads; }
+
+	/// @returns true if execute() may be used for @a _count transactions in a block with @a _header.
+	/// Requires receipts with status codes, since intermediate state roots are only known serially.
+	static bool applies(BlockHeader const& _header, SealEngineFace const& _sealEngine, size_t _count);
+
+	/// Execute @a _transactions on top of @a io_state, committing after each one as serial
+	/// execution with Permanence::Committed does.
+	/// @returns the receipt of each transaction. Throws exactly where serial execution would.
+	static TransactionReceipts execute(State& io_state, BlockHeader const& _header, LastBlockHashesFace const& _lh, SealEngineFace const& _sealEngine, Transactions const& _transactions);
+
+	/// @returns the counters accumulated since start-up; reported by admin_eth_parallelExecutionStats.
+	static ParallelExecutionStats stats();
+
+private:
+	static std::atomic<unsigned> s_threads;
+	static std::atomic<uint64_t> s_transactions;
+	static std::atomic<uint64_t> s_reexecuted;
+};
+
+}
+}
@@ -0,0 +1,83 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file PeerThroughput.cpp
+ */
+
+#include "PeerThroughput.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const unsigned PeerThroughput::c_targetRoundTripMs;
+const unsigned PeerThroughput::c_minRateSample;
+constexpr double PeerThroughput::c_weight;
+
+void PeerThroughput::requested(Asking _asking)
+{
+	Guard l(x_stats);
+	m_asking = _asking;
+	m_askedAt = chrono::steady_clock::now();
+}
+
+void PeerThroughput::delivered(unsigned _items, size_t _bytes)
+{
+	Guard l(x_stats);
+	if (m_asking == Asking::Nothing || m_asking == Asking::State)
+		return;
+	double const seconds = max(chrono::duration<double>(chrono::steady_clock::now() - m_askedAt).count(), 0.001);
+	m_latency = average(m_latency, seconds);
+	if (_items >= c_minRateSample)
+	{
+		m_bandwidth = average(m_bandwidth, _bytes / seconds);
+		double& rate = m_itemRates[static_cast<size_t>(m_asking)];
+		rate = average(rate, _items / seconds);
+	}
+	m_asking = Asking::Nothing;
+}
+
+unsigned PeerThroughput::capacity(Asking _asking, unsigned _max) const
+{
+	double const rate = itemsPerSecond(_asking);
+	// Until measured, ask for a share that a slow peer can still answer in time.
+	if (!rate)
+		return max(_max / 4, 1u);
+	// Never ask for fewer items than an answer needs to be measured, or a peer that was
+	// slow once would only get requests too small to ever update its rate again.
+	double const items = max<double>(rate * c_targetRoundTripMs / 1000, c_minRateSample);
+	return static_cast<unsigned>(max(1.0, min<double>(items, _max)));
+}
+
+chrono::milliseconds PeerThroughput::latency() const
+{
+	Guard l(x_stats);
+	return chrono::milliseconds(static_cast<int64_t>(m_latency * 1000));
+}
+
+double PeerThroughput::bandwidth() const
+{
+	Guard l(x_stats);
+	return m_bandwidth;
+}
+
+double PeerThroughput::itemsPerSecond(Asking _asking) const
+{
+	Guard l(x_stats);
+	return _asking == Asking::Nothing ? 0 : m_itemRates[static_cast<size_t>(_asking)];
+}
@@ -0,0 +1,79 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file PeerThroughput.h
+ * Estimates of how quickly a peer answers sync requests.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <libdevcore/Guards.h>
+#include "CommonNet.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief Measures the round-trip time, bandwidth and item rates of a peer from its answers.
+ *
+ * Each answer updates exponentially weighted averages. Item rates are kept per kind of
+ * request, as a header costs a peer far less than a body, and are only taken from answers
+ * big enough for the transfer rather than the latency to dominate. Requests are then sized
+ * to take about c_targetRoundTripMs, so fast peers get bigger ranges and slow peers smaller.
+ * @threadsafe
+ */
+class PeerThroughput
+{
+public:
+	/// Note that a request of kind @a _asking was just sent.
+	void requested(Asking _asking);
+
+	/// Note the answer to the request last sent, @a _items items in @a _bytes bytes.
+	void delivered(unsigned _items, size_t _bytes);
+
+	/// @returns the number of items of kind @a _asking to ask for in one request, between 1 and @a _max.
+	/// Once measured, this is at least c_minRateSample (if @a _max allows), so the rate keeps updating.
+	unsigned capacity(Asking _asking, unsigned _max) const;
+
+	/// Average round-trip time; zero until the first answer.
+	std::chrono::milliseconds latency() const;
+	/// Average bytes per second of answers; zero until measured.
+	double bandwidth() const;
+	/// Average items of kind @a _asking per second; zero until measured.
+	double itemsPerSecond(Asking _asking) const;
+
+	static const unsigned c_targetRoundTripMs = 1000;
+	static const unsigned c_minRateSample = 8;		///< Fewest items an answer needs to be counted for rates.
+
+private:
+	static double average(double _average, double _sample) { return _average ? _average + (_sample - _average) * c_weight : _sample; }
+
+	mutable Mutex x_stats;
+	Asking m_asking = Asking::Nothing;
+	std::chrono::steady_clock::time_point m_askedAt;
+	double m_latency = 0;			///< In seconds.
+	double m_bandwidth = 0;
+	std::array<double, static_cast<size_t>(Asking::Nothing)> m_itemRates = {};
+
+	static constexpr double c_weight = 0.25;	///< Weight of a new sample in the averages.
+};
+
+}
+}
@@ -0,0 +1,281 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SnapshotExporter.h"
+#include "BlockChain.h"
+#include "SnapshotStorage.h"
+
+#include <libdevcore/Log.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/RLP.h>
+#include <libdevcore/TrieDB.h>
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+namespace
+{
+
+struct SnapshotExportLog: public LogChannel
+{
+	static char const* name() { return "SNAP"; }
+	static int const verbosity = 9;
+	static const bool debug = false;
+};
+
+/// Collects RLP items into chunks of at most the given size.
+class ChunkBuilder
+{
+public:
+	ChunkBuilder(SnapshotWriterFace& _writer, size_t _chunkSize): m_writer(_writer), m_chunkSize(_chunkSize) {}
+
+	bool empty() const { return !m_items; }
+	bool fits(size_t _size) const { return m_data.size() + _size <= m_chunkSize; }
+
+	void add(bytesConstRef _item) { m_data.insert(m_data.end(), _item.begin(), _item.end()); ++m_items; }
+	void add(bytes const& _item) { add(&_item); }
+
+	/// Write the items collected as one chunk.
+	void flush()
+	{
+		if (!m_items)
+			return;
+		RLPStream s(m_items);
+		s.appendRaw(m_data, m_items);
+		m_hashes.push_back(m_writer.writeChunk(&s.out()));
+		m_data.clear();
+		m_items = 0;
+	}
+
+	h256s const& hashes() const { return m_hashes; }
+
+private:
+	SnapshotWriterFace& m_writer;
+	size_t const m_chunkSize;
+	bytes m_data;
+	size_t m_items = 0;
+	h256s m_hashes;
+};
+
+bytes accountEntry(h256 const& _addressHash, RLP const& _account, byte _codeFlag, bytes const& _code, bytes const& _storage, size_t _storageItems)
+{
+	RLPStream s(2);
+	s << _addressHash;
+	s.appendList(5) << _account[0].toInt<u256>() << _account[1].toInt<u256>() << static_cast<unsigned>(_codeFlag) << _code;
+	s.appendList(_storageItems);
+	if (_storageItems)
+		s.appendRaw(_storage, _storageItems);
+	return s.out();
+}
+
+}
+
+void SnapshotExporter::exportSnapshot(h256 const& _block, SnapshotWriterFace& _writer, size_t _memoryBudget) const
+{
+	(void)SnapshotExportLog::debug; // override "unused variable" error on macOS
+
+	if (!m_bc.isKnown(_block))
+		BOOST_THROW_EXCEPTION(UnknownSnapshotBlock() << errinfo_hash256(_block));
+	BlockHeader const header = m_bc.info(_block);
+	h256 const stateRoot = header.stateRoot();
+	{
+		OverlayDB db = m_stateDB.committed();
+		GenericTrieDB<OverlayDB> check(&db, stateRoot);	// throws RootNotFound
+	}
+	clog(SnapshotExportLog) << "Exporting snapshot for block " << header.number() << " block hash " << _block;
+
+	// Blocks are done first, so they can use the memory budget on their own.
+	h256s const blockChunkHashes = exportBlocks(_block, _writer);
+	clog(SnapshotExportLog) << "Block chunks written: " << blockChunkHashes.size();
+
+	// Each thread holds a chunk, its encoding and the compressed copy.
+	size_t const threads = max<size_t>(1, min<size_t>(max(thread::hardware_concurrency(), 1U), _memoryBudget / (3 * m_chunkSize)));
+	vector<h256s> rangeChunkHashes(256);
+	atomic<unsigned> nextRange = {0};
+	exception_ptr error;
+	Mutex x_error;
+
+	vector<thread> workers;
+	for (size_t i = 0; i < threads; ++i)
+		workers.emplace_back([&]()
+		{
+			setThreadName("snapshot");
+			try
+			{
+				for (unsigned r = nextRange++; r < rangeChunkHashes.size(); r = nextRange++)
+					rangeChunkHashes[r] = exportStateRange(static_cast<byte>(r), stateRoot, _writer);
+			}
+			catch (...)
+			{
+				DEV_GUARDED(x_error)
+					if (!error)
+						error = current_exception();
+				nextRange = static_cast<unsigned>(rangeChunkHashes.size());
+			}
+		});
+	for (auto& w: workers)
+		w.join();
+	if (error)
+		rethrow_exception(error);
+
+	h256s stateChunkHashes;
+	for (h256s const& r: rangeChunkHashes)
+		stateChunkHashes.insert(stateChunkHashes.end(), r.begin(), r.end());
+	clog(SnapshotExportLog) << "State chunks written: " << stateChunkHashes.size() << " using " << threads << " threads";
+
+	// For Snapshot format see https://github.com/paritytech/parity/wiki/Warp-Sync-Snapshot-Format
+	RLPStream manifest(6);
+	manifest << 2 << stateChunkHashes << blockChunkHashes << stateRoot << u256(header.number()) << _block;
+	_writer.writeManifest(&manifest.out());
+}
+
+h256s SnapshotExporter::exportStateRange(byte _first, h256 const& _root, SnapshotWriterFace& _writer) const
+{
+	OverlayDB db = m_stateDB.committed();
+	GenericTrieDB<OverlayDB> accounts(&db, _root);
+	ChunkBuilder chunk(_writer, m_chunkSize);
+	// Code is only referred to by hash once it came before in the same range, as the
+	// importer reads the ranges in order but has to know the code already.
+	unordered_set<h256> codeWritten;
+
+	h256 from;
+	from[0] = _first;
+	for (auto it = accounts.lower_bound(bytesConstRef(from.data(), h256::size)); it != accounts.end(); ++it)
+	{
+		checkAborted();
+		auto const addressAndAccount = *it;
+		if (addressAndAccount.first.size() != h256::size || addressAndAccount.first[0] != _first)
+			break;
+		h256 const addressHash(addressAndAccount.first);
+		RLP const account(addressAndAccount.second);
+
+		byte codeFlag = 0;
+		bytes code;
+		h256 const codeHash = account[3].toHash<h256>();
+		if (codeHash != EmptySHA3)
+		{
+			if (codeWritten.count(codeHash))
+			{
+				codeFlag = 2;
+				code = codeHash.asBytes();
+			}
+			else
+			{
+				codeFlag = 1;
+				code = asBytes(db.lookup(codeHash));
+				codeWritten.insert(codeHash);
+			}
+		}
+
+		bytes storage;
+		size_t storageItems = 0;
+		size_t const overhead = code.size() + 128;
+		h256 const storageRoot = account[2].toHash<h256>();
+		if (storageRoot != EmptyTrie)
+		{
+			GenericTrieDB<OverlayDB> storageTrie(&db, storageRoot);
+			for (auto const& keyAndValue: storageTrie)
+			{
+				RLPStream item(2);
+				item << keyAndValue.first << keyAndValue.second;
+				if (!chunk.fits(overhead + storage.size() + item.out().size()))
+				{
+					// Split the account; the rest goes first into the next chunk.
+					if (storageItems)
+						chunk.add(accountEntry(addressHash, account, codeFlag, code, storage, storageItems));
+					chunk.flush();
+					if (codeFlag == 1)
+					{
+						codeFlag = 2;
+						code = codeHash.asBytes();
+					}
+					storage.clear();
+					storageItems = 0;
+				}
+				storage += item.out();
+				++storageItems;
+			}
+		}
+
+		bytes const entry = accountEntry(addressHash, account, codeFlag, code, storage, storageItems);
+		if (!chunk.fits(entry.size()))
+			chunk.flush();
+		chunk.add(entry);
+	}
+	chunk.flush();
+	return chunk.hashes();
+}
+
+h256s SnapshotExporter::exportBlocks(h256 const& _block, SnapshotWriterFace& _writer) const
+{
+	// The parent of the first block goes into the chunk, so it cannot be the genesis.
+	unsigned const last = m_bc.number(_block);
+	unsigned const first = max({m_bc.chainStartBlockNumber(), last >= c_blocks ? last - c_blocks + 1 : 0, 2u});
+	if (first > last)
+		return {};
+
+	h256s hashes(last - first + 1);
+	hashes.back() = _block;
+	for (size_t i = hashes.size() - 1; i > 0; --i)
+		hashes[i - 1] = m_bc.details(hashes[i]).parent;
+
+	ChunkBuilder chunk(_writer, m_chunkSize);
+	for (h256 const& h: hashes)
+	{
+		checkAborted();
+		bytes const block = m_bc.block(h);
+		RLP const blockRLP(block);
+		RLP const header = blockRLP[0];
+
+		// Everything the importer cannot work out from the parent and the block contents.
+		RLPStream abridged(10 + header.itemCount() - BlockHeader::BasicFields);
+		for (unsigned i: {2, 3, 6, 7, 9, 10, 11, 12})
+			abridged.appendRaw(header[i].data());
+		abridged.appendRaw(blockRLP[1].data()).appendRaw(blockRLP[2].data());
+		for (unsigned i = BlockHeader::BasicFields; i < header.itemCount(); ++i)
+			abridged.appendRaw(header[i].data());
+
+		RLPStream blockAndReceipts(2);
+		blockAndReceipts.appendRaw(abridged.out()).appendRaw(m_bc.receipts(h).rlp());
+		if (!chunk.fits(blockAndReceipts.out().size()))
+			chunk.flush();
+		if (chunk.empty())
+		{
+			BlockDetails const details = m_bc.details(h);
+			chunk.add(rlp(details.number - 1));
+			chunk.add(rlp(details.parent));
+			chunk.add(rlp(details.totalDifficulty - header[7].toInt<u256>()));
+		}
+		chunk.add(blockAndReceipts.out());
+	}
+	chunk.flush();
+
+	h256s ret = chunk.hashes();
+	reverse(ret.begin(), ret.end());
+	return ret;
+}
+
+void SnapshotExporter::checkAborted() const
+{
+	if (m_aborted)
+		BOOST_THROW_EXCEPTION(SnapshotExportAborted());
+}
@@ -0,0 +1,82 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file
+ *  Class for writing snapshots that SnapshotImporter can read
+ */
+
+#pragma once
+
+#include <atomic>
+#include <libdevcore/Common.h>
+#include <libdevcore/Exceptions.h>
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+
+class OverlayDB;
+
+namespace eth
+{
+
+class BlockChain;
+class SnapshotWriterFace;
+
+DEV_SIMPLE_EXCEPTION(UnknownSnapshotBlock);
+DEV_SIMPLE_EXCEPTION(SnapshotExportAborted);
+
+/**
+ * @brief Writes the state and the most recent blocks at a given block as a Parity warp snapshot.
+ *
+ * The account trie is split into 256 ranges by the first byte of the address hash, which are
+ * walked by several threads at once; each thread reads through its own overlay of the state
+ * database. At most one chunk per thread is held in memory, so the memory budget given bounds
+ * the number of threads.
+ * @threadsafe
+ */
+class SnapshotExporter
+{
+public:
+	/// Chunks are filled to about @a _chunkSize uncompressed bytes.
+	SnapshotExporter(BlockChain const& _bc, OverlayDB const& _stateDB, size_t _chunkSize = c_chunkSize): m_bc(_bc), m_stateDB(_stateDB), m_chunkSize(_chunkSize) {}
+
+	/// Write the snapshot of block @a _block to @a _writer using at most about @a _memoryBudget bytes for chunks.
+	void exportSnapshot(h256 const& _block, SnapshotWriterFace& _writer, size_t _memoryBudget = c_defaultMemoryBudget) const;
+
+	/// Make a running or future exportSnapshot() throw SnapshotExportAborted.
+	void abort() { m_aborted = true; }
+
+	static const size_t c_chunkSize = 4 * 1024 * 1024;			///< Uncompressed size a chunk is filled to by default.
+	static const size_t c_defaultMemoryBudget = 256 * 1024 * 1024;
+	static const unsigned c_blocks = 30000;						///< Blocks written before the snapshot block.
+
+private:
+	/// @returns the chunks of the accounts whose hashes start with @a _first in the trie with root @a _root.
+	h256s exportStateRange(byte _first, h256 const& _root, SnapshotWriterFace& _writer) const;
+	/// @returns the chunks of the blocks up to @a _block, newest first.
+	h256s exportBlocks(h256 const& _block, SnapshotWriterFace& _writer) const;
+
+	void checkAborted() const;
+
+	BlockChain const& m_bc;
+	OverlayDB const& m_stateDB;
+	size_t const m_chunkSize;
+	std::atomic<bool> m_aborted = {false};
+};
+
+}
+}
@@ -235,6 +235,9 @@ void SnapshotImporter::importBlockChunks(SnapshotStorageFace const& _snapshotSto
 			header.setGasUsed(abridgedBlock[5].toInt<u256>(RLP::VeryStrict));
 			header.setTimestamp(abridgedBlock[6].toPositiveInt64(RLP::VeryStrict));
 			header.setExtraData(abridgedBlock[7].toBytes(RLP::VeryStrict));
+			// seal fields follow the uncles in the abridged block
+			for (size_t sealIndex = 10; sealIndex < abridgedBlock.itemCount(); ++sealIndex)
+				header.setSeal(sealIndex - 10, abridgedBlock[sealIndex]);
 
 			totalDifficulty += difficulty;
 			m_blockChainImporter.importBlock(header, m_stateImporter.getStateDatabase(), transactions, uncles, receipts, totalDifficulty);
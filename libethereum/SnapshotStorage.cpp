@@ -83,6 +83,50 @@ private:
 	boost::filesystem::path const m_snapshotDir;
 };
 
+class SnapshotWriter: public SnapshotWriterFace
+{
+public:
+	explicit SnapshotWriter(std::string const& _snapshotDir): m_snapshotDir(_snapshotDir)
+	{
+		boost::filesystem::create_directories(m_snapshotDir);
+	}
+
+	h256 writeChunk(bytesConstRef _chunk) override
+	{
+		if (_chunk.size() > c_maxChunkUncomressedSize)
+			BOOST_THROW_EXCEPTION(ChunkIsTooBig());
+
+		std::string chunkCompressed;
+		snappy::Compress(reinterpret_cast<char const*>(_chunk.data()), _chunk.size(), &chunkCompressed);
+
+		h256 const chunkHash = sha3(chunkCompressed);
+		try
+		{
+			dev::writeFile(m_snapshotDir / toHex(chunkHash), bytesConstRef(chunkCompressed), true);
+		}
+		catch (FileError const&)
+		{
+			BOOST_THROW_EXCEPTION(FailedToWriteChunkFile() << errinfo_hash256(chunkHash));
+		}
+		return chunkHash;
+	}
+
+	void writeManifest(bytesConstRef _manifest) override
+	{
+		try
+		{
+			dev::writeFile(m_snapshotDir / "MANIFEST", _manifest, true);
+		}
+		catch (FileError const&)
+		{
+			BOOST_THROW_EXCEPTION(FailedToWriteSnapshotManifestFile());
+		}
+	}
+
+private:
+	boost::filesystem::path const m_snapshotDir;
+};
+
 }
 
 std::unique_ptr<SnapshotStorageFace> createSnapshotStorage(std::string const& _snapshotDirPath)
@@ -90,5 +134,10 @@ std::unique_ptr<SnapshotStorageFace> createSnapshotStorage(std::string const& _s
 	return std::unique_ptr<SnapshotStorageFace>(new SnapshotStorage(_snapshotDirPath));
 }
 
+std::unique_ptr<SnapshotWriterFace> createSnapshotWriter(std::string const& _snapshotDirPath)
+{
+	return std::unique_ptr<SnapshotWriterFace>(new SnapshotWriter(_snapshotDirPath));
+}
+
 }
 }
\ No newline at end of file
@@ -35,6 +35,8 @@ DEV_SIMPLE_EXCEPTION(ChunkIsTooBig);
 DEV_SIMPLE_EXCEPTION(ChunkDataCorrupted);
 DEV_SIMPLE_EXCEPTION(FailedToGetUncompressedLength);
 DEV_SIMPLE_EXCEPTION(FailedToUncompressedSnapshotChunk);
+DEV_SIMPLE_EXCEPTION(FailedToWriteChunkFile);
+DEV_SIMPLE_EXCEPTION(FailedToWriteSnapshotManifestFile);
 
 class SnapshotStorageFace
 {
@@ -49,5 +51,21 @@ public:
 
 std::unique_ptr<SnapshotStorageFace> createSnapshotStorage(std::string const& _snapshotDirPath);
 
+/// Writing counterpart of SnapshotStorageFace.
+class SnapshotWriterFace
+{
+public:
+	virtual ~SnapshotWriterFace() = default;
+
+	/// Compress and store the chunk @a _chunk; may be called from several threads at once.
+	/// @returns the hash the chunk is listed under in the manifest.
+	virtual h256 writeChunk(bytesConstRef _chunk) = 0;
+
+	/// Store the manifest @a _manifest; called once all chunks are written.
+	virtual void writeManifest(bytesConstRef _manifest) = 0;
+};
+
+std::unique_ptr<SnapshotWriterFace> createSnapshotWriter(std::string const& _snapshotDirPath);
+
 }
 }
@@ -30,6 +30,7 @@
 #include "Block.h"
 #include "Defaults.h"
 #include "ExtVM.h"
+#include "StoragePrefetcher.h"
 #include "TransactionQueue.h"
 
 using namespace std;
@@ -59,9 +60,19 @@ State::State(State const& _s):
 	m_unchangedCacheEntries(_s.m_unchangedCacheEntries),
 	m_nonExistingAccountsCache(_s.m_nonExistingAccountsCache),
 	m_touched(_s.m_touched),
+	m_base(_s.m_base),
 	m_accountStartNonce(_s.m_accountStartNonce)
 {}
 
+State State::layered(std::shared_ptr<State const> const& _base)
+{
+	// The overlay shares ownership of the base, so the base lives as long as any layer on it.
+	State ret(_base->m_accountStartNonce, OverlayDB::layered(shared_ptr<OverlayDB const>(_base, &_base->m_db)));
+	ret.m_state.open(&ret.m_db, _base->m_state.root(), Verification::Skip);
+	ret.m_base = _base;
+	return ret;
+}
+
 OverlayDB State::openDB(fs::path const& _basePath, h256 const& _genesisHash, WithExisting _we)
 {
 	fs::path path = _basePath.empty() ? Defaults::get()->m_dbPath : _basePath;
@@ -142,6 +153,7 @@ State& State::operator=(State const& _s)
 	m_unchangedCacheEntries = _s.m_unchangedCacheEntries;
 	m_nonExistingAccountsCache = _s.m_nonExistingAccountsCache;
 	m_touched = _s.m_touched;
+	m_base = _s.m_base;
 	m_accountStartNonce = _s.m_accountStartNonce;
 	return *this;
 }
@@ -160,6 +172,25 @@ Account* State::account(Address const& _addr)
 	if (m_nonExistingAccountsCache.count(_addr))
 		return nullptr;
 
+	if (m_base)
+	{
+		// Only the const containers of the base are read, so layers may do this at once.
+		auto b = m_base->m_cache.find(_addr);
+		if (b != m_base->m_cache.end())
+		{
+			clearCacheIfTooLarge();
+			auto i = m_cache.emplace(*b);
+			if (!b->second.isDirty())
+				m_unchangedCacheEntries.push_back(_addr);
+			return &i.first->second;
+		}
+		if (m_base->m_nonExistingAccountsCache.count(_addr))
+		{
+			m_nonExistingAccountsCache.insert(_addr);
+			return nullptr;
+		}
+	}
+
 	// Populate basic info.
 	string stateBack = m_state.at(_addr);
 	if (stateBack.empty())
@@ -182,6 +213,10 @@ Account* State::account(Address const& _addr)
 
 void State::clearCacheIfTooLarge() const
 {
+	// Speculative states are short-lived; keep every entry so the merge sees all of them.
+	if (m_accessLog)
+		return;
+
 	// TODO: Find a good magic number
 	while (m_unchangedCacheEntries.size() > 1000)
 	{
@@ -201,6 +236,14 @@ void State::clearCacheIfTooLarge() const
 
 void State::commit(CommitBehaviour _commitBehaviour)
 {
+	if (m_base)
+	{
+		// Our trie is still that of the base; the changes the base has only in its cache go in too.
+		for (auto const& i: m_base->m_cache)
+			if (i.second.isDirty())
+				m_cache.emplace(i);
+		m_base.reset();
+	}
 	if (_commitBehaviour == CommitBehaviour::RemoveEmptyAccounts)
 		removeEmptyAccounts();
 	m_touched += dev::eth::commit(m_cache, m_state);
@@ -213,12 +256,18 @@ unordered_map<Address, u256> State::addresses() const
 {
 #if ETH_FATDB
 	unordered_map<Address, u256> ret;
+	if (m_base)
+		// Until we commit, our trie is that of the base and what we changed is in our cache.
+		ret = m_base->addresses();
+	else
+		for (auto const& i: m_state)
+			if (m_cache.find(i.first) == m_cache.end())
+				ret[i.first] = RLP(i.second)[1].toInt<u256>();
 	for (auto& i: m_cache)
 		if (i.second.isAlive())
 			ret[i.first] = i.second.balance();
-	for (auto const& i: m_state)
-		if (m_cache.find(i.first) == m_cache.end())
-			ret[i.first] = RLP(i.second)[1].toInt<u256>();
+		else
+			ret.erase(i.first);
 	return ret;
 #else
 	BOOST_THROW_EXCEPTION(InterfaceNotSupported("State::addresses()"));
@@ -231,16 +280,19 @@ void State::setRoot(h256 const& _r)
 	m_unchangedCacheEntries.clear();
 	m_nonExistingAccountsCache.clear();
 //	m_touched.clear();
+	m_base.reset();
 	m_state.setRoot(_r);
 }
 
 bool State::addressInUse(Address const& _id) const
 {
+	noteAccountRead(_id);
 	return !!account(_id);
 }
 
 bool State::accountNonemptyAndExisting(Address const& _address) const
 {
+	noteAccountRead(_address);
 	if (Account const* a = account(_address))
 		return !a->isEmpty();
 	else
@@ -249,6 +301,7 @@ bool State::accountNonemptyAndExisting(Address const& _address) const
 
 bool State::addressHasCode(Address const& _id) const
 {
+	noteAccountRead(_id);
 	if (auto a = account(_id))
 		return a->codeHash() != EmptySHA3;
 	else
@@ -257,6 +310,7 @@ bool State::addressHasCode(Address const& _id) const
 
 u256 State::balance(Address const& _id) const
 {
+	noteAccountRead(_id);
 	if (auto a = account(_id))
 		return a->balance();
 	else
@@ -265,6 +319,7 @@ u256 State::balance(Address const& _id) const
 
 void State::incNonce(Address const& _addr)
 {
+	noteAccountWrite(_addr);
 	if (Account* a = account(_addr))
 	{
 		auto oldNonce = a->nonce();
@@ -278,6 +333,7 @@ void State::incNonce(Address const& _addr)
 
 void State::setNonce(Address const& _addr, u256 const& _newNonce)
 {
+	noteAccountWrite(_addr);
 	if (Account* a = account(_addr))
 	{
 		auto oldNonce = a->nonce();
@@ -291,7 +347,13 @@ void State::setNonce(Address const& _addr, u256 const& _newNonce)
 
 void State::addBalance(Address const& _id, u256 const& _amount)
 {
-	if (Account* a = account(_id))
+	Account* a = account(_id);
+	// Crediting commutes with other credits. Creating a missing account and touching an empty
+	// one are redone by addBalance() when the credit is merged, so neither counts as a write.
+	if (m_accessLog)
+		m_accessLog->credits.emplace(_id, a ? a->balance() : 0);
+
+	if (a)
 	{
 		// Log empty account being touched. Empty touched accounts are cleared
 		// after the transaction, so this event must be also reverted.
@@ -308,7 +370,12 @@ void State::addBalance(Address const& _id, u256 const& _amount)
 		a->addBalance(_amount);
 	}
 	else
-		createAccount(_id, {requireAccountStartNonce(), _amount});
+	{
+		// As createAccount(), which would log the credit as a write.
+		m_cache[_id] = Account(requireAccountStartNonce(), _amount);
+		m_nonExistingAccountsCache.erase(_id);
+		m_changeLog.emplace_back(Change::Create, _id);
+	}
 
 	if (_amount)
 		m_changeLog.emplace_back(Change::Balance, _id, _amount);
@@ -319,6 +386,7 @@ void State::subBalance(Address const& _addr, u256 const& _value)
 	if (_value == 0)
 		return;
 
+	noteAccountWrite(_addr);
 	Account* a = account(_addr);
 	if (!a || a->balance() < _value)
 		// TODO: I expect this never happens.
@@ -330,6 +398,7 @@ void State::subBalance(Address const& _addr, u256 const& _value)
 
 void State::setBalance(Address const& _addr, u256 const& _value)
 {
+	noteAccountWrite(_addr);
 	Account* a = account(_addr);
 	u256 original = a ? a->balance() : 0;
 	
@@ -344,6 +413,7 @@ void State::createContract(Address const& _address)
 
 u256 State::version(Address const& _a) const
 {
+	noteAccountRead(_a);
 	Account const* a = account(_a);
 	return a ? a->version() : 0;
 }
@@ -351,6 +421,7 @@ u256 State::version(Address const& _a) const
 void State::createAccount(Address const& _address, Account const&& _account)
 {
 	assert(!addressInUse(_address) && "Account already exists");
+	noteAccountWrite(_address);
 	m_cache[_address] = std::move(_account);
 	m_nonExistingAccountsCache.erase(_address);
 	m_changeLog.emplace_back(Change::Create, _address);
@@ -358,6 +429,9 @@ void State::createAccount(Address const& _address, Account const&& _account)
 
 void State::kill(Address _addr)
 {
+	noteAccountWrite(_addr);
+	if (m_accessLog)
+		m_accessLog->storageResets.insert(_addr);
 	if (auto a = account(_addr))
 		a->kill();
 	// If the account is not in the db, nothing to kill.
@@ -365,6 +439,7 @@ void State::kill(Address _addr)
 
 u256 State::getNonce(Address const& _addr) const
 {
+	noteAccountRead(_addr);
 	if (auto a = account(_addr))
 		return a->nonce();
 	else
@@ -373,6 +448,8 @@ u256 State::getNonce(Address const& _addr) const
 
 u256 State::storage(Address const& _id, u256 const& _key) const
 {
+	if (m_accessLog)
+		m_accessLog->storageReads.emplace(_id, _key);
 	if (Account const* a = account(_id))
 	{
 		auto mit = a->storageOverlay().find(_key);
@@ -390,14 +467,33 @@ u256 State::storage(Address const& _id, u256 const& _key) const
 		return 0;
 }
 
+void State::prefetchStorage(Address const& _contract, std::vector<u256> const& _keys) const
+{
+	if (_keys.empty())
+		return;
+	Account const* a = account(_contract);
+	if (!a || a->baseRoot() == EmptyTrie)
+		return;
+	std::vector<u256> missing;
+	for (u256 const& k: _keys)
+		if (!a->storageOverlay().count(k))
+			missing.push_back(k);
+	StoragePrefetcher::instance().prefetch(m_db, a->baseRoot(), missing);
+}
+
 void State::setStorage(Address const& _contract, u256 const& _key, u256 const& _value)
 {
 	m_changeLog.emplace_back(_contract, _key, storage(_contract, _key));
+	if (m_accessLog)
+		m_accessLog->storageWrites.emplace(_contract, _key);
 	m_cache[_contract].setStorage(_key, _value);
 }
 
 void State::clearStorage(Address const& _contract)
 {
+	noteAccountWrite(_contract);
+	if (m_accessLog)
+		m_accessLog->storageResets.insert(_contract);
 	h256 const& oldHash{m_cache[_contract].baseRoot()};
 	if (oldHash == EmptyTrie)
 		return;
@@ -409,6 +505,9 @@ map<h256, pair<u256, u256>> State::storage(Address const& _id) const
 {
 	map<h256, pair<u256, u256>> ret;
 
+	noteAccountRead(_id);
+	if (m_accessLog)
+		m_accessLog->storageResets.insert(_id);
 	if (Account const* a = account(_id))
 	{
 		// Pull out all values from trie storage.
@@ -441,6 +540,9 @@ map<h256, pair<u256, u256>> State::storage(Address const& _id) const
 
 h256 State::storageRoot(Address const& _id) const
 {
+	noteAccountRead(_id);
+	if (m_accessLog)
+		m_accessLog->storageResets.insert(_id);
 	string s = m_state.at(_id);
 	if (s.size())
 	{
@@ -452,6 +554,7 @@ h256 State::storageRoot(Address const& _id) const
 
 bytes const& State::code(Address const& _addr) const
 {
+	noteAccountRead(_addr);
 	Account const* a = account(_addr);
 	if (!a || a->codeHash() == EmptySHA3)
 		return NullBytes;
@@ -472,12 +575,14 @@ void State::setCode(Address const& _address, bytes&& _code, u256 const& _version
 	// rollback assumes that overwriting of the code never happens
 	// (not allowed in contract creation logic in Executive)
 	assert(!addressHasCode(_address));
+	noteAccountWrite(_address);
     m_changeLog.emplace_back(_address, code(_address));
 	m_cache[_address].setCode(move(_code), _version);
 }
 
 h256 State::codeHash(Address const& _a) const
 {
+	noteAccountRead(_a);
 	if (Account const* a = account(_a))
 		return a->codeHash();
 	else
@@ -486,6 +591,7 @@ h256 State::codeHash(Address const& _a) const
 
 size_t State::codeSize(Address const& _a) const
 {
+	noteAccountRead(_a);
 	if (Account const* a = account(_a))
 	{
 		if (a->hasNewCode())
@@ -505,6 +611,46 @@ size_t State::codeSize(Address const& _a) const
 		return 0;
 }
 
+void State::mergeSpeculative(State const& _speculative, StateAccessLog const& _log)
+{
+	// Accounts written as a whole are taken over verbatim; the caller guarantees nothing else
+	// in the block has touched them since _speculative was copied.
+	AddressHash replaced;
+	for (AddressHash const* addresses: {&_log.accountWrites, &_log.storageResets})
+		for (Address const& a: *addresses)
+		{
+			if (!replaced.insert(a).second)
+				continue;
+			auto it = _speculative.m_cache.find(a);
+			if (it == _speculative.m_cache.end() || !it->second.isDirty())
+				continue;
+			m_cache[a] = it->second;
+			m_nonExistingAccountsCache.erase(a);
+		}
+
+	// Even a zero credit goes through addBalance(), which creates the account if it is missing
+	// and touches it if it is empty, as the credit did in _speculative. A credit rolled back
+	// there left the account missing or untouched.
+	for (auto const& credit: _log.credits)
+		if (!replaced.count(credit.first))
+		{
+			auto it = _speculative.m_cache.find(credit.first);
+			if (it != _speculative.m_cache.end() && it->second.isDirty())
+				addBalance(credit.first, it->second.balance() - credit.second);
+		}
+
+	for (auto const& slot: _log.storageWrites)
+		if (!replaced.count(slot.first))
+		{
+			auto it = _speculative.m_cache.find(slot.first);
+			if (it == _speculative.m_cache.end())
+				continue;
+			auto value = it->second.storageOverlay().find(slot.second);
+			if (value != it->second.storageOverlay().end())
+				setStorage(slot.first, slot.second, value->second);
+		}
+}
+
 size_t State::savepoint() const
 {
 	return m_changeLog.size();
@@ -618,6 +764,16 @@ bool State::executeTransaction(Executive& _e, Transaction const& _t, OnOpFunc co
         throw;
     }
 }
+void StateAccessLog::clear()
+{
+	accountReads.clear();
+	accountWrites.clear();
+	storageResets.clear();
+	credits.clear();
+	storageReads.clear();
+	storageWrites.clear();
+}
+
 std::ostream& dev::eth::operator<<(std::ostream& _out, State const& _s)
 {
 	_out << "--- " << _s.rootHash() << std::endl;
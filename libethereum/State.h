@@ -154,6 +154,21 @@ struct Change
 
 using ChangeLog = std::vector<Change>;
 
+/// Record of the accounts and storage slots a State observed and modified while the log was
+/// attached with State::setAccessLog(). Used by ParallelExecutor to detect conflicts between
+/// transactions that were executed speculatively against the same base state.
+struct StateAccessLog
+{
+	AddressHash accountReads;			///< Accounts whose existence, nonce, balance or code was observed.
+	AddressHash accountWrites;			///< Accounts created, killed or with nonce, balance or code set.
+	AddressHash storageResets;			///< Accounts whose whole storage was read or cleared.
+	std::unordered_map<Address, u256> credits;	///< Accounts only credited, with their balance before the first credit (0 if missing).
+	std::set<std::pair<Address, u256>> storageReads;
+	std::set<std::pair<Address, u256>> storageWrites;
+
+	void clear();
+};
+
 /**
  * Model of an Ethereum state, essentially a facade for the trie.
  *
@@ -199,6 +214,12 @@ public:
 	/// Copy state object.
 	State& operator=(State const& _s);
 
+	/// @returns a state that starts out as @a _base but keeps its changes to itself, without copying
+	/// @a _base. Accounts are copied from the base as they are first accessed, so executing on the
+	/// result costs in proportion to what is touched. @a _base must not change, nor be accessed
+	/// other than through layered states, while any is in use; several may then be used at once.
+	static State layered(std::shared_ptr<State const> const& _base);
+
 	/// Open a DB - useful for passing into the constructor & keeping for other states that are necessary.
 	static OverlayDB openDB(boost::filesystem::path const& _path, h256 const& _genesisHash, WithExisting _we = WithExisting::Trust);
 	OverlayDB const& db() const { return m_db; }
@@ -258,6 +279,10 @@ public:
 	/// @returns 0 if no account exists at that address.
 	u256 storage(Address const& _contract, u256 const& _memory) const;
 
+	/// Have the storage positions @a _keys of @a _contract that are not cached yet loaded from the
+	/// database in the background (see StoragePrefetcher). Not recorded as an access.
+	void prefetchStorage(Address const& _contract, std::vector<u256> const& _keys) const;
+
 	/// Set the value of a storage position of an account.
 	void setStorage(Address const& _contract, u256 const& _location, u256 const& _value);
 
@@ -333,6 +358,14 @@ public:
 	/// Get contract account's version.
 	/// @returns 0 if no account exists at that address.
 	u256 version(Address const& _a) const;
+
+	/// Record all subsequent account and storage accesses into @a _log; nullptr stops recording.
+	void setAccessLog(StateAccessLog* _log) { m_accessLog = _log; }
+
+	/// Apply the writes recorded in @a _log, as performed by @a _speculative, to this state.
+	/// @a _speculative must have been copied or layered from the state this one had before any transaction
+	/// conflicting with @a _log was applied.
+	void mergeSpeculative(State const& _speculative, StateAccessLog const& _log);
 	
 private:
 	/// Turns all "touched" empty accounts into non-alive accounts.
@@ -355,15 +388,21 @@ private:
     /// exception occurred.
     bool executeTransaction(Executive& _e, Transaction const& _t, OnOpFunc const& _onOp);
 
+	void noteAccountRead(Address const& _a) const { if (m_accessLog) m_accessLog->accountReads.insert(_a); }
+	void noteAccountWrite(Address const& _a) const { if (m_accessLog) { m_accessLog->accountReads.insert(_a); m_accessLog->accountWrites.insert(_a); } }
+
     OverlayDB m_db;								///< Our overlay for the state tree.
 	SecureTrieDB<Address, OverlayDB> m_state;	///< Our state tree, as an OverlayDB DB.
 	mutable std::unordered_map<Address, Account> m_cache;	///< Our address cache. This stores the states of each address that has (or at least might have) been changed.
 	mutable std::vector<Address> m_unchangedCacheEntries;	///< Tracks entries in m_cache that can potentially be purged if it grows too large.
 	mutable std::set<Address> m_nonExistingAccountsCache;	///< Tracks addresses that are known to not exist.
 	AddressHash m_touched;						///< Tracks all addresses touched so far.
+	std::shared_ptr<State const> m_base;		///< What we were layered on, until our first commit or setRoot().
 
 	u256 m_accountStartNonce;
 
+	StateAccessLog* m_accessLog = nullptr;		///< Where accesses are recorded, if anywhere. Not copied.
+
 	friend std::ostream& operator<<(std::ostream& _out, State const& _s);
 	ChangeLog m_changeLog;
 };
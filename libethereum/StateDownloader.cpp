@@ -0,0 +1,163 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StateDownloader.cpp
+ */
+
+#include "StateDownloader.h"
+
+#include <libdevcore/SHA3.h>
+#include <libdevcore/TrieCommon.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+void StateDownloader::addRoot(h256 const& _root)
+{
+	schedule(_root, NodeKind::Account, nullptr);
+}
+
+h256s StateDownloader::request(unsigned _max)
+{
+	h256s ret;
+	while (ret.size() < _max && !m_queue.empty())
+	{
+		h256 const h = m_queue.back();
+		m_queue.pop_back();
+		if (m_requests.count(h) && m_inFlight.insert(h).second)
+			ret.push_back(h);
+	}
+	return ret;
+}
+
+unsigned StateDownloader::deliver(h256s const& _requested, RLP const& _nodes)
+{
+	unsigned useful = 0;
+	for (auto const& item: _nodes)
+	{
+		bytes node = item.toBytes();
+		h256 const h = sha3(node);
+		if (!m_inFlight.erase(h))
+			continue;
+		auto it = m_requests.find(h);
+		if (it == m_requests.end())
+			continue;
+
+		// References into the map stay valid while scheduling the children inserts into it.
+		Request& r = it->second;
+		r.data = move(node);
+		++useful;
+		if (r.kind != NodeKind::Code)
+			scheduleChildren(h, r.kind, RLP(r.data), r);
+		if (!r.missingChildren)
+			store(h);
+	}
+	cancel(_requested);
+	return useful;
+}
+
+void StateDownloader::cancel(h256s const& _requested)
+{
+	for (h256 const& h: _requested)
+		if (m_inFlight.erase(h))
+			m_queue.push_back(h);
+}
+
+bool StateDownloader::schedule(h256 const& _hash, NodeKind _kind, h256 const* _parent)
+{
+	if ((_kind == NodeKind::Code && _hash == EmptySHA3) || (_kind != NodeKind::Code && _hash == EmptyTrie))
+		return false;
+
+	auto it = m_requests.find(_hash);
+	if (it == m_requests.end())
+	{
+		if (m_db.exists(_hash))
+			return false;
+		it = m_requests.emplace(_hash, Request{_kind, bytes(), 0, h256s()}).first;
+		m_queue.push_back(_hash);
+	}
+	if (_parent)
+		it->second.parents.push_back(*_parent);
+	return true;
+}
+
+void StateDownloader::scheduleChildren(h256 const& _hash, NodeKind _kind, RLP const& _node, Request& _request)
+{
+	auto child = [&](RLP const& _child)
+	{
+		if (_child.isList())
+			// Nodes shorter than a hash are embedded in their parent.
+			scheduleChildren(_hash, _kind, _child, _request);
+		else if (_child.isData() && _child.size() == h256::size && schedule(_child.toHash<h256>(), _kind, &_hash))
+			++_request.missingChildren;
+	};
+	auto value = [&](RLP const& _value)
+	{
+		if (_kind != NodeKind::Account)
+			return;
+		RLP account(_value.payload());
+		if (account.isList() && account.itemCount() == 4)
+		{
+			if (schedule(account[2].toHash<h256>(), NodeKind::Storage, &_hash))
+				++_request.missingChildren;
+			if (schedule(account[3].toHash<h256>(), NodeKind::Code, &_hash))
+				++_request.missingChildren;
+		}
+	};
+
+	if (_node.isList() && _node.itemCount() == 17)
+	{
+		for (unsigned i = 0; i < 16; ++i)
+			if (!_node[i].isEmpty())
+				child(_node[i]);
+		if (!_node[16].isEmpty())
+			value(_node[16]);
+	}
+	else if (_node.isList() && _node.itemCount() == 2)
+	{
+		if (isLeaf(_node))
+			value(_node[1]);
+		else
+			child(_node[1]);
+	}
+}
+
+void StateDownloader::store(h256 const& _hash)
+{
+	h256s ready{_hash};
+	while (!ready.empty())
+	{
+		h256 const h = ready.back();
+		ready.pop_back();
+		auto it = m_requests.find(h);
+		if (it == m_requests.end())
+			continue;
+		m_db.insert(h, &it->second.data);
+		++m_downloaded;
+		++m_uncommitted;
+		h256s const parents = move(it->second.parents);
+		m_requests.erase(it);
+		for (h256 const& p: parents)
+		{
+			auto parent = m_requests.find(p);
+			if (parent != m_requests.end() && !--parent->second.missingChildren)
+				ready.push_back(p);
+		}
+	}
+	if (m_uncommitted >= c_commitInterval || m_requests.empty())
+		commit();
+}
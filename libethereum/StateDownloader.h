@@ -0,0 +1,114 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StateDownloader.h
+ * Scheduling of state trie node downloads for fast sync.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/RLP.h>
+
+namespace dev
+{
+namespace eth
+{
+
+/**
+ * @brief Works out which state trie nodes to ask peers for and writes the answers to the state database.
+ *
+ * Starting from one or more state roots, every node that is not in the database yet is
+ * requested by hash. Each node delivered is checked against its hash and decoded for the hashes
+ * it refers to: child nodes, and for account leaves the storage root and code. A node is only
+ * written to the database once everything below it is there, so a node found in the database
+ * stands for a complete subtrie. That makes downloads resumable after a restart and lets several
+ * roots of neighbouring blocks share all the nodes they have in common.
+ *
+ * Nodes are handed out deepest first, which keeps the nodes waiting for their children few.
+ * Not thread-safe; BlockChainSync calls it under its own lock.
+ */
+class StateDownloader
+{
+public:
+	explicit StateDownloader(OverlayDB const& _db): m_db(_db.committed()) {}
+
+	/// Schedule the download of the state trie with root @a _root.
+	void addRoot(h256 const& _root);
+
+	/// @returns up to @a _max node hashes to ask one peer for, now marked as in flight.
+	h256s request(unsigned _max);
+
+	/// Take the NodeData payload @a _nodes returned for the request @a _requested.
+	/// Requested nodes that are missing from the answer are scheduled again.
+	/// @returns the number of useful nodes the answer contained.
+	unsigned deliver(h256s const& _requested, RLP const& _nodes);
+
+	/// Schedule the nodes of request @a _requested again, e.g. because the peer went away.
+	void cancel(h256s const& _requested);
+
+	/// @returns true once every scheduled trie is in the database.
+	bool complete() const { return m_requests.empty(); }
+
+	/// Write the complete subtries collected so far to disk.
+	void commit() { m_db.commit(); m_uncommitted = 0; }
+
+	/// Nodes written to the database so far.
+	unsigned downloaded() const { return m_downloaded; }
+	/// Nodes known to be missing that have not been delivered yet.
+	unsigned pending() const { return static_cast<unsigned>(m_requests.size()); }
+
+private:
+	enum class NodeKind
+	{
+		Account,	///< Node of the account trie.
+		Storage,	///< Node of a storage trie.
+		Code		///< Contract code.
+	};
+
+	struct Request
+	{
+		NodeKind kind;
+		bytes data;					///< Node itself once delivered; empty until then.
+		unsigned missingChildren = 0;
+		h256s parents;				///< Delivered nodes waiting for this one.
+	};
+
+	/// Schedule @a _hash of kind @a _kind on behalf of the delivered node @a _parent, if any.
+	/// @returns true if the parent has to wait for it.
+	bool schedule(h256 const& _hash, NodeKind _kind, h256 const* _parent);
+	/// Schedule the hashes referred to by the node @a _node of kind @a _kind, which has hash @a _hash.
+	void scheduleChildren(h256 const& _hash, NodeKind _kind, RLP const& _node, Request& _request);
+	/// Write @a _hash and every parent it completes to the database.
+	void store(h256 const& _hash);
+
+	OverlayDB m_db;
+	std::unordered_map<h256, Request> m_requests;	///< Nodes not in the database yet.
+	std::vector<h256> m_queue;						///< Missing nodes not asked for; the back is deepest.
+	std::unordered_set<h256> m_inFlight;
+	unsigned m_downloaded = 0;
+	unsigned m_uncommitted = 0;
+
+	static const unsigned c_commitInterval = 16384;	///< Nodes stored between writes to disk.
+};
+
+}
+}
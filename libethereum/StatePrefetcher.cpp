@@ -0,0 +1,121 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StatePrefetcher.cpp
+ */
+
+#include "StatePrefetcher.h"
+
+#include <libdevcore/TrieDB.h>
+#include "CodeSizeCache.h"
+#include "State.h"
+#include "Transaction.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const char* StatePrefetchChannel::name() { return EthViolet "⚙" EthBlue " ⇣"; }
+
+StatePrefetcher::StatePrefetcher(OverlayDB const& _db, unsigned _threads):
+	m_db(_db)
+{
+	for (unsigned i = 0; i < _threads; ++i)
+		m_workers.emplace_back([this](){ setThreadName("prefetch"); work(); });
+}
+
+StatePrefetcher::~StatePrefetcher()
+{
+	DEV_GUARDED(x_queue)
+		m_stop = true;
+	m_moreToDo.notify_all();
+	for (auto& w: m_workers)
+		w.join();
+}
+
+void StatePrefetcher::prefetch(VerifiedBlockRef const& _block, h256 const& _root)
+{
+	Addresses accounts;
+	accounts.reserve(_block.transactions.size() * 2 + 1);
+	accounts.push_back(_block.info.author());
+	for (Transaction const& t: _block.transactions)
+	{
+		if (!t.hasSignature() || t.hasZeroSignature())
+			continue;
+		accounts.push_back(t.sender());
+		if (!t.isCreation())
+			accounts.push_back(t.receiveAddress());
+	}
+	prefetch(accounts, _root);
+}
+
+void StatePrefetcher::prefetch(Addresses const& _accounts, h256 const& _root)
+{
+	if (_accounts.empty() || m_workers.empty())
+		return;
+	// Split the work so that every thread has something to load in parallel.
+	size_t const perJob = (_accounts.size() + m_workers.size() - 1) / m_workers.size();
+	DEV_GUARDED(x_queue)
+		for (size_t i = 0; i < _accounts.size(); i += perJob)
+			m_queue.push_back(Job{_root, Addresses(_accounts.begin() + i, _accounts.begin() + min(_accounts.size(), i + perJob))});
+	m_moreToDo.notify_all();
+}
+
+void StatePrefetcher::work()
+{
+	// Each thread reads through its own overlay; only the underlying database is shared.
+	OverlayDB db;
+	DEV_GUARDED(x_queue)
+		db = m_db;
+
+	while (true)
+	{
+		Job job;
+		{
+			unique_lock<Mutex> l(x_queue);
+			m_moreToDo.wait(l, [&](){ return m_stop || !m_queue.empty(); });
+			if (m_stop)
+				return;
+			job = move(m_queue.front());
+			m_queue.pop_front();
+		}
+		load(db, job);
+	}
+}
+
+void StatePrefetcher::load(OverlayDB const& _db, Job const& _job)
+{
+	try
+	{
+		SecureTrieDB<Address, OverlayDB> state(const_cast<OverlayDB*>(&_db), _job.root);		// promise we won't alter the overlay! :)
+		for (Address const& a: _job.accounts)
+		{
+			string const account = state.at(a);
+			if (account.empty())
+				continue;
+			++m_accountsLoaded;
+
+			h256 const codeHash = RLP(account)[3].toHash<h256>();
+			if (codeHash != EmptySHA3 && !CodeSizeCache::instance().contains(codeHash))
+				CodeSizeCache::instance().store(codeHash, _db.lookup(codeHash).size());
+		}
+	}
+	catch (std::exception const& _e)
+	{
+		// The root may be gone already (e.g. after a reorganisation); execution will load it anyway.
+		clog(StatePrefetchChannel) << "Prefetch from" << _job.root << "failed:" << _e.what();
+	}
+}
@@ -0,0 +1,95 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StatePrefetcher.h
+ * Background loading of the state a block is about to touch.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <libdevcore/Common.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/Log.h>
+#include <libdevcore/OverlayDB.h>
+#include "VerifiedBlock.h"
+
+namespace dev
+{
+namespace eth
+{
+
+struct StatePrefetchChannel: public LogChannel { static const char* name(); static const int verbosity = 9; };
+
+/**
+ * @brief Warms the state database ahead of block execution.
+ *
+ * Once a block is verified its senders, recipients and author are known. The prefetcher walks
+ * their account trie paths and loads their contract code on its own I/O threads, so that by the
+ * time Block::enact asks State for them the nodes are in the database's block cache (and the
+ * code size in CodeSizeCache) instead of on disk.
+ *
+ * Everything is best-effort: the state read may be slightly older than the one the block is
+ * executed on, and failures are ignored. Pending work is dropped on destruction.
+ *
+ * BlockChain keeps one for as long as the state database it reads is the one synced into.
+ */
+class StatePrefetcher
+{
+public:
+	explicit StatePrefetcher(OverlayDB const& _db, unsigned _threads = c_defaultThreads);
+	~StatePrefetcher();
+
+	/// Queue the accounts touched by @a _block for loading from the state with root @a _root.
+	void prefetch(VerifiedBlockRef const& _block, h256 const& _root);
+
+	/// Queue @a _accounts for loading from the state with root @a _root.
+	void prefetch(Addresses const& _accounts, h256 const& _root);
+
+	/// @returns the database the state is loaded from.
+	ldb::DB* db() const { return m_db.db(); }
+
+	/// @returns the number of accounts found so far.
+	unsigned accountsLoaded() const { return m_accountsLoaded; }
+
+	static const unsigned c_defaultThreads = 2;
+
+private:
+	struct Job
+	{
+		h256 root;
+		Addresses accounts;
+	};
+
+	void work();
+	void load(OverlayDB const& _db, Job const& _job);
+
+	OverlayDB m_db;
+	std::vector<std::thread> m_workers;
+
+	Mutex x_queue;
+	std::condition_variable m_moreToDo;
+	std::deque<Job> m_queue;
+	bool m_stop = false;
+
+	std::atomic<unsigned> m_accountsLoaded{0};
+};
+
+}
+}
@@ -0,0 +1,123 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StateView.cpp
+ */
+
+#include "StateView.h"
+#include "State.h"
+
+#include <libdevcore/RLP.h>
+#include <libdevcore/TrieDB.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+StateView::StateView(OverlayDB const& _db, h256 const& _root, u256 const& _accountStartNonce):
+	m_db(_db),
+	m_root(_root),
+	m_accountStartNonce(_accountStartNonce)
+{
+	if (m_root != EmptyTrie)
+		SecureTrieDB<Address, OverlayDB> check(&m_db, m_root);	// throws RootNotFound
+}
+
+string StateView::account(Address const& _a) const
+{
+	if (m_root == EmptyTrie)
+		return string();
+	// The lookups only read, so the view may be shared between threads.
+	SecureTrieDB<Address, OverlayDB> accounts(const_cast<OverlayDB*>(&m_db), m_root, Verification::Skip);
+	return accounts.at(_a);
+}
+
+u256 StateView::balance(Address const& _a) const
+{
+	string const a = account(_a);
+	return a.empty() ? 0 : RLP(a)[1].toInt<u256>();
+}
+
+u256 StateView::getNonce(Address const& _a) const
+{
+	string const a = account(_a);
+	return a.empty() ? m_accountStartNonce : RLP(a)[0].toInt<u256>();
+}
+
+u256 StateView::storage(Address const& _a, u256 const& _key) const
+{
+	h256 const root = storageRoot(_a);
+	if (root == EmptyTrie)
+		return 0;
+	SecureTrieDB<h256, OverlayDB> storage(const_cast<OverlayDB*>(&m_db), root, Verification::Skip);
+	string const payload = storage.at(_key);
+	return payload.size() ? RLP(payload).toInt<u256>() : 0;
+}
+
+map<h256, pair<u256, u256>> StateView::storage(Address const& _a) const
+{
+	map<h256, pair<u256, u256>> ret;
+	h256 const root = storageRoot(_a);
+	if (root == EmptyTrie)
+		return ret;
+	SecureTrieDB<h256, OverlayDB> storage(const_cast<OverlayDB*>(&m_db), root, Verification::Skip);
+	for (auto it = storage.hashedBegin(); it != storage.hashedEnd(); ++it)
+	{
+		h256 const hashedKey((*it).first);
+		ret[hashedKey] = make_pair(u256(h256(it.key())), RLP((*it).second).toInt<u256>());
+	}
+	return ret;
+}
+
+h256 StateView::storageRoot(Address const& _a) const
+{
+	string const a = account(_a);
+	return a.empty() ? EmptyTrie : RLP(a)[2].toHash<h256>();
+}
+
+bytes StateView::code(Address const& _a) const
+{
+	h256 const hash = codeHash(_a);
+	return hash == EmptySHA3 ? bytes() : asBytes(m_db.lookup(hash));
+}
+
+h256 StateView::codeHash(Address const& _a) const
+{
+	string const a = account(_a);
+	return a.empty() ? EmptySHA3 : RLP(a)[3].toHash<h256>();
+}
+
+unordered_map<Address, u256> StateView::addresses() const
+{
+#if ETH_FATDB
+	unordered_map<Address, u256> ret;
+	if (m_root == EmptyTrie)
+		return ret;
+	SecureTrieDB<Address, OverlayDB> accounts(const_cast<OverlayDB*>(&m_db), m_root, Verification::Skip);
+	for (auto const& i: accounts)
+		ret[i.first] = RLP(i.second)[1].toInt<u256>();
+	return ret;
+#else
+	BOOST_THROW_EXCEPTION(InterfaceNotSupported("StateView::addresses()"));
+#endif
+}
+
+State StateView::state() const
+{
+	State ret(m_accountStartNonce, m_db, m_root == EmptyTrie ? BaseState::Empty : BaseState::PreExisting);
+	ret.setRoot(m_root);
+	return ret;
+}
@@ -0,0 +1,93 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StateView.h
+ * Read-only access to the state under a given root.
+ */
+
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libdevcore/OverlayDB.h>
+
+namespace dev
+{
+namespace eth
+{
+
+class State;
+
+/**
+ * @brief An immutable view of the accounts in the state trie with a given root.
+ *
+ * Unlike State, nothing is cached and nothing can be changed, so opening one costs no
+ * more than finding the root node and every query is a few trie lookups. This is what
+ * historical queries use instead of re-executing the block whose post-state they read.
+ * @threadsafe
+ */
+class StateView
+{
+public:
+	/// Open the state with root @a _root in @a _db. Throws RootNotFound if @a _db does not have it.
+	StateView(OverlayDB const& _db, h256 const& _root, u256 const& _accountStartNonce);
+
+	h256 const& root() const { return m_root; }
+
+	/// @returns true if the account @a _a exists.
+	bool addressInUse(Address const& _a) const { return !account(_a).empty(); }
+
+	/// @returns the balance of @a _a; 0 if the account does not exist.
+	u256 balance(Address const& _a) const;
+
+	/// @returns the nonce of @a _a; the account start nonce if the account does not exist.
+	u256 getNonce(Address const& _a) const;
+
+	/// @returns the value of storage slot @a _key of @a _a.
+	u256 storage(Address const& _a, u256 const& _key) const;
+
+	/// @returns all the storage of @a _a, keyed by the hash of the slot.
+	std::map<h256, std::pair<u256, u256>> storage(Address const& _a) const;
+
+	/// @returns the root of the storage trie of @a _a; EmptyTrie if the account does not exist.
+	h256 storageRoot(Address const& _a) const;
+
+	/// @returns the code of @a _a; empty if none.
+	bytes code(Address const& _a) const;
+
+	/// @returns the hash of the code of @a _a; EmptySHA3 if none.
+	h256 codeHash(Address const& _a) const;
+
+	/// @returns the balances of all accounts. Only supported when built with ETH_FATDB.
+	std::unordered_map<Address, u256> addresses() const;
+
+	/// @returns a State at the same root that transactions may be executed against.
+	State state() const;
+
+private:
+	/// @returns the RLP of account @a _a; empty if it does not exist.
+	std::string account(Address const& _a) const;
+
+	OverlayDB m_db;					///< Has no changes of its own; only read from.
+	h256 m_root;
+	u256 m_accountStartNonce;
+};
+
+}
+}
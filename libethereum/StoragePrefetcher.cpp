@@ -0,0 +1,191 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StoragePrefetcher.cpp
+ */
+
+#include "StoragePrefetcher.h"
+
+#include <algorithm>
+#include <set>
+#include <libdevcore/TrieDB.h>
+#include "State.h"
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+
+const char* StoragePrefetchChannel::name() { return EthViolet "⚙" EthBlue " ⇣s"; }
+
+const unsigned StoragePrefetcher::c_maxSlots;
+const size_t StoragePrefetcher::c_maxKeys;
+
+StoragePrefetcher::~StoragePrefetcher()
+{
+	DEV_GUARDED(x_queue)
+		m_stop = true;
+	m_moreToDo.notify_all();
+	if (m_worker.joinable())
+		m_worker.join();
+}
+
+void StoragePrefetcher::setEnabled(bool _enabled)
+{
+	DEV_GUARDED(x_queue)
+	{
+		if (_enabled && !m_worker.joinable())
+			m_worker = thread([this](){ setThreadName("prefetch"); work(); });
+		if (!_enabled)
+			m_queue.clear();
+	}
+	m_enabled = _enabled;
+}
+
+StoragePrefetcher::Key StoragePrefetcher::keyOf(h256 const& _codeHash, bytesConstRef _data)
+{
+	// Calls without a full selector all end up in the fallback function.
+	uint32_t selector = 0;
+	if (_data.size() >= 4)
+		selector = (uint32_t(_data[0]) << 24) | (uint32_t(_data[1]) << 16) | (uint32_t(_data[2]) << 8) | _data[3];
+	return Key(_codeHash, selector);
+}
+
+vector<u256> StoragePrefetcher::predict(h256 const& _codeHash, bytesConstRef _data) const
+{
+	Guard l(x_learned);
+	auto it = m_learned.find(keyOf(_codeHash, _data));
+	return it != m_learned.end() ? it->second : vector<u256>();
+}
+
+void StoragePrefetcher::learn(h256 const& _codeHash, bytesConstRef _data, vector<u256> const& _slots, bool _predicted, unsigned _hits)
+{
+	++m_calls;
+	if (_predicted)
+		++m_predictedCalls;
+	m_reads += _slots.size();
+	m_hits += _hits;
+
+	// Remember the most recent call only: slots depending on the caller or the arguments
+	// would otherwise accumulate without ever being read again.
+	vector<u256> slots(_slots.begin(), _slots.begin() + min<size_t>(_slots.size(), c_maxSlots));
+	Key const key = keyOf(_codeHash, _data);
+	Guard l(x_learned);
+	if (slots.empty())
+	{
+		m_learned.erase(key);
+		return;
+	}
+	if (m_learned.size() >= c_maxKeys && !m_learned.count(key))
+	{
+		// Evict the entry following the new one. Code hashes are spread evenly, so this is as
+		// good as a random choice and, unlike h256::random(), safe to do from several threads.
+		auto it = m_learned.lower_bound(key);
+		if (it == m_learned.end())
+			it = m_learned.begin();
+		m_learned.erase(it);
+	}
+	m_learned[key] = move(slots);
+}
+
+void StoragePrefetcher::prefetch(OverlayDB const& _db, h256 const& _root, vector<u256> const& _slots)
+{
+	if (_slots.empty() || !m_enabled)
+		return;
+	{
+		Guard l(x_queue);
+		if (m_queue.size() >= c_maxQueued)
+		{
+			// The loader is behind; the interpreter will get there first anyway.
+			m_dropped += _slots.size();
+			return;
+		}
+		m_queue.push_back(Job{_db.committed(), _root, _slots});
+	}
+	m_prefetched += _slots.size();
+	m_moreToDo.notify_one();
+}
+
+void StoragePrefetcher::work()
+{
+	while (true)
+	{
+		Job job;
+		{
+			unique_lock<Mutex> l(x_queue);
+			m_moreToDo.wait(l, [&](){ return m_stop || !m_queue.empty(); });
+			if (m_stop)
+				return;
+			job = move(m_queue.front());
+			m_queue.pop_front();
+		}
+		try
+		{
+			SecureTrieDB<h256, OverlayDB> storage(&job.db, job.root);
+			for (u256 const& slot: job.slots)
+				storage.at(h256(slot));
+		}
+		catch (std::exception const& _e)
+		{
+			// Nodes of the root may not be committed yet; nothing to warm up then.
+			clog(StoragePrefetchChannel) << "Storage prefetch from" << job.root << "failed:" << _e.what();
+		}
+	}
+}
+
+StoragePrefetchStats StoragePrefetcher::stats() const
+{
+	StoragePrefetchStats ret;
+	ret.calls = m_calls;
+	ret.predictedCalls = m_predictedCalls;
+	ret.reads = m_reads;
+	ret.hits = m_hits;
+	ret.prefetched = m_prefetched;
+	ret.dropped = m_dropped;
+	return ret;
+}
+
+StorageAccessRecorder::StorageAccessRecorder(State const& _s, Address const& _contract, h256 const& _codeHash, bytesConstRef _data):
+	m_codeHash(_codeHash),
+	m_selector(_data.cropped(0, 4).toBytes())
+{
+	m_predicted = StoragePrefetcher::instance().predict(_codeHash, _data);
+	m_hadPrediction = !m_predicted.empty();
+	_s.prefetchStorage(_contract, m_predicted);
+	sort(m_predicted.begin(), m_predicted.end());
+}
+
+StorageAccessRecorder::~StorageAccessRecorder()
+{
+	try
+	{
+		// Keep the order of first reads; later ones are already cached.
+		vector<u256> slots;
+		unsigned hits = 0;
+		set<u256> seen;
+		for (u256 const& s: m_reads)
+			if (seen.insert(s).second)
+			{
+				slots.push_back(s);
+				if (binary_search(m_predicted.begin(), m_predicted.end(), s))
+					++hits;
+			}
+		StoragePrefetcher::instance().learn(m_codeHash, &m_selector, slots, m_hadPrediction, hits);
+	}
+	catch (...)
+	{
+		// Learning is best-effort and must never disturb execution.
+	}
+}
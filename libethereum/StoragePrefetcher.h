@@ -0,0 +1,157 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file StoragePrefetcher.h
+ * Learned prefetching of contract storage.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
+#include <libdevcore/Common.h>
+#include <libdevcore/Address.h>
+#include <libdevcore/Guards.h>
+#include <libdevcore/Log.h>
+#include <libdevcore/OverlayDB.h>
+
+namespace dev
+{
+namespace eth
+{
+
+class State;
+
+struct StoragePrefetchChannel: public LogChannel { static const char* name(); static const int verbosity = 9; };
+
+/// Counters accumulated over all calls observed since the prefetcher was enabled.
+struct StoragePrefetchStats
+{
+	uint64_t calls = 0;			///< Calls into contract code that were observed.
+	uint64_t predictedCalls = 0;	///< Calls for which a set of slots had been learned before.
+	uint64_t reads = 0;			///< Storage slots read by the observed calls.
+	uint64_t hits = 0;			///< Reads of slots that had been predicted.
+	uint64_t prefetched = 0;		///< Slots handed to the background loader.
+	uint64_t dropped = 0;		///< Slots not prefetched because the loader was busy.
+
+	/// @returns the fraction of storage reads that had been predicted.
+	double hitRate() const { return reads ? double(hits) / reads : 0; }
+};
+
+/**
+ * @brief Learns which storage slots a contract function reads and loads them ahead of time.
+ *
+ * State::storage() resolves slots lazily, one storage trie walk per slot. Calls to the same
+ * function of the same code tend to read the same fixed slots (owner, totals, configuration),
+ * so the slots read by a call are remembered per code hash and function selector. When a call
+ * with the same key starts, the remembered slots of the called account that are not cached yet
+ * are walked on a background thread, bringing the trie nodes into the database's block cache
+ * before the interpreter asks for them.
+ *
+ * Only data already committed to the database is prefetched; results never feed back into the
+ * state, so a wrong prediction costs I/O but cannot change execution. Disabled by default.
+ */
+class StoragePrefetcher
+{
+public:
+	static StoragePrefetcher& instance() { static StoragePrefetcher s_this; return s_this; }
+
+	~StoragePrefetcher();
+
+	/// Turn learning and prefetching on or off.
+	void setEnabled(bool _enabled);
+	bool enabled() const { return m_enabled; }
+
+	/// @returns the slots remembered for calls of @a _codeHash with input @a _data.
+	std::vector<u256> predict(h256 const& _codeHash, bytesConstRef _data) const;
+
+	/// Remember that a call of @a _codeHash with input @a _data read @a _slots, of which
+	/// @a _hits had been predicted.
+	void learn(h256 const& _codeHash, bytesConstRef _data, std::vector<u256> const& _slots, bool _predicted, unsigned _hits);
+
+	/// Load @a _slots of the storage trie with root @a _root from @a _db in the background.
+	void prefetch(OverlayDB const& _db, h256 const& _root, std::vector<u256> const& _slots);
+
+	StoragePrefetchStats stats() const;
+
+	/// Most slots remembered per code hash and selector.
+	static const unsigned c_maxSlots = 64;
+	/// Most code hash and selector pairs remembered.
+	static const size_t c_maxKeys = 10000;
+
+private:
+	using Key = std::pair<h256, uint32_t>;
+
+	struct Job
+	{
+		OverlayDB db;
+		h256 root;
+		std::vector<u256> slots;
+	};
+
+	StoragePrefetcher() = default;
+
+	static Key keyOf(h256 const& _codeHash, bytesConstRef _data);
+	void work();
+
+	std::atomic<bool> m_enabled{false};
+
+	mutable Mutex x_learned;
+	std::map<Key, std::vector<u256>> m_learned;
+
+	Mutex x_queue;
+	std::condition_variable m_moreToDo;
+	std::deque<Job> m_queue;
+	std::thread m_worker;
+	bool m_stop = false;
+
+	std::atomic<uint64_t> m_calls{0};
+	std::atomic<uint64_t> m_predictedCalls{0};
+	std::atomic<uint64_t> m_reads{0};
+	std::atomic<uint64_t> m_hits{0};
+	std::atomic<uint64_t> m_prefetched{0};
+	std::atomic<uint64_t> m_dropped{0};
+
+	static const size_t c_maxQueued = 256;
+};
+
+/**
+ * @brief Watches the storage reads of one call frame on behalf of StoragePrefetcher.
+ *
+ * Construction prefetches what was learned for the frame's code and input; destruction
+ * teaches the prefetcher what the frame actually read.
+ */
+class StorageAccessRecorder
+{
+public:
+	StorageAccessRecorder(State const& _s, Address const& _contract, h256 const& _codeHash, bytesConstRef _data);
+	~StorageAccessRecorder();
+
+	void noteRead(u256 const& _slot) { m_reads.push_back(_slot); }
+
+private:
+	h256 m_codeHash;
+	bytes m_selector;
+	std::vector<u256> m_predicted;
+	bool m_hadPrediction = false;
+	std::vector<u256> m_reads;
+};
+
+}
+}
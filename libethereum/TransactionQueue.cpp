@@ -117,6 +117,43 @@ h256Hash TransactionQueue::knownTransactions() const
 	return m_known;
 }
 
+bool TransactionQueue::isKnown(h256 const& _txHash) const
+{
+	ReadGuard l(m_lock);
+	return m_known.count(_txHash) || m_dropped.count(_txHash);
+}
+
+Transactions TransactionQueue::transactions(h256s const& _txHashes) const
+{
+	ReadGuard l(m_lock);
+	Transactions ret;
+	for (h256 const& h: _txHashes)
+	{
+		auto t = m_currentByHash.find(h);
+		if (t != m_currentByHash.end())
+			ret.push_back(t->second->transaction);
+	}
+	return ret;
+}
+
+vector<bytes> TransactionQueue::transactionsByHashPrefix(vector<h64> const& _prefixes) const
+{
+	ReadGuard l(m_lock);
+	vector<bytes> ret;
+	ret.reserve(_prefixes.size());
+	for (h64 const& prefix: _prefixes)
+	{
+		h256 lowest;
+		prefix.ref().copyTo(lowest.ref());
+		auto t = m_currentByHash.lower_bound(lowest);
+		if (t != m_currentByHash.end() && h64(t->first.ref().cropped(0, h64::size)) == prefix)
+			ret.push_back(t->second->transaction.rlp());
+		else
+			ret.push_back(bytes());
+	}
+	return ret;
+}
+
 ImportResult TransactionQueue::manageImport_WITH_LOCK(h256 const& _h, Transaction const& _transaction)
 {
 	try
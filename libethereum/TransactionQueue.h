@@ -103,6 +103,21 @@ public:
 	/// @returns A hash set of all transactions in the queue
 	h256Hash knownTransactions() const;
 
+	/// Check whether a transaction needs to be fetched from the network.
+	/// @param _txHash Transaction hash
+	/// @returns true if the transaction is in the queue or has previously been dropped from it.
+	bool isKnown(h256 const& _txHash) const;
+
+	/// Get current transactions by hash.
+	/// @param _txHashes Transaction hashes
+	/// @returns those of the transactions that are in the current set, in the order asked for.
+	Transactions transactions(h256s const& _txHashes) const;
+
+	/// Get current transactions by the leading bytes of their hashes.
+	/// @param _prefixes The first eight bytes of each hash
+	/// @returns the RLP of a current transaction whose hash starts with each prefix; empty where there is none.
+	std::vector<bytes> transactionsByHashPrefix(std::vector<h64> const& _prefixes) const;
+
 	/// Get max nonce for an account
 	/// @returns Max transaction nonce for account in the queue
 	u256 maxNonce(Address const& _a) const;
@@ -201,7 +216,7 @@ private:
 	h256Hash m_dropped;															///< Transactions that have previously been dropped
 
 	PriorityQueue m_current;
-	std::unordered_map<h256, PriorityQueue::iterator> m_currentByHash;			///< Transaction hash to set ref
+	std::map<h256, PriorityQueue::iterator> m_currentByHash;					///< Transaction hash to set ref; ordered so it can be searched by hash prefix
 	std::unordered_map<Address, std::map<u256, PriorityQueue::iterator>> m_currentByAddressAndNonce; ///< Transactions grouped by account and nonce
 	FutureTransactions m_future;												/// Future transactions
 
@@ -104,6 +104,7 @@ Host::Host(string const& _clientVersion, KeyPair<ECDSA> const& _alias, NetworkPr
 	m_ifAddresses(Network::getInterfaceAddresses()),
 	m_ioService(2),
 	m_tcp4Acceptor(m_ioService),
+	m_strand(m_ioService),
 	m_alias(_alias),
 	m_lastPing(chrono::steady_clock::time_point::min())
 {
@@ -165,6 +166,9 @@ void Host::stop()
 
 void Host::doneWorking()
 {
+	m_ioWork.reset();
+	stopThreads();
+
 	// reset ioservice (cancels all timers and allows manually polling network, below)
 	m_ioService.reset();
 
@@ -333,7 +337,7 @@ void Host::startPeerSession(ECDSA::Public const& _id, RLP const& _rlp, unique_pt
 			else
 			{
 				pcap->newPeerCapability(ps, offset, i, 0);
-				offset += pcap->messageCount();
+				offset += pcap->messageCount(i.second);
 			}
 		}
 
@@ -436,7 +440,7 @@ void Host::runAcceptor()
 		m_accepting = true;
 
 		auto socket = make_shared<RLPXSocket>(m_ioService);
-		m_tcp4Acceptor.async_accept(socket->ref(), [=](boost::system::error_code ec)
+		m_tcp4Acceptor.async_accept(socket->ref(), ba::bind_executor(m_strand, [=](boost::system::error_code ec)
 		{
 			m_accepting = false;
 			if (ec || !m_run)
@@ -458,7 +462,8 @@ void Host::runAcceptor()
 			{
 				// incoming connection; we don't yet know nodeid
 				auto handshake = make_shared<RLPXHandshake>(this, socket);
-				m_connecting.push_back(handshake);
+				DEV_GUARDED(x_connecting)
+					m_connecting.push_back(handshake);
 				handshake->start();
 				success = true;
 			}
@@ -474,7 +479,7 @@ void Host::runAcceptor()
 			if (!success)
 				socket->ref().close();
 			runAcceptor();
-		});
+		}));
 	}
 }
 
@@ -548,13 +553,13 @@ void Host::requirePeer(NodeID const& _n, NodeIPEndpoint const& _endpoint)
 		m_nodeTable->addNode(node);
 		auto t = make_shared<boost::asio::deadline_timer>(m_ioService);
 		t->expires_from_now(boost::posix_time::milliseconds(600));
-		t->async_wait([this, _n](boost::system::error_code const& _ec)
+		t->async_wait(ba::bind_executor(m_strand, [this, _n](boost::system::error_code const& _ec)
 		{
 			if (!_ec)
 				if (m_nodeTable)
 					if (auto n = m_nodeTable->node(_n))
 						requirePeer(n.id, n.endpoint);
-		});
+		}));
 		DEV_GUARDED(x_timers)
 			m_timers.push_back(t);
 	}
@@ -595,7 +600,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 	bi::tcp::endpoint ep(_p->endpoint);
 	clog(NetConnect) << "Attempting connection to node" << _p->id << "@" << ep << "from" << id();
 	auto socket = make_shared<RLPXSocket>(m_ioService);
-	socket->ref().async_connect(ep, [=](boost::system::error_code const& ec)
+	socket->ref().async_connect(ep, ba::bind_executor(m_strand, [=](boost::system::error_code const& ec)
 	{
 		_p->m_lastAttempted = std::chrono::system_clock::now();
 		_p->m_failedAttempts++;
@@ -620,7 +625,7 @@ void Host::connect(std::shared_ptr<Peer> const& _p)
 		
 		Guard l(x_pendingNodeConns);
 		m_pendingPeerConns.erase(nptr);
-	});
+	}));
 }
 
 PeerSessionInfos Host::peerSessionInfo() const
@@ -653,10 +658,12 @@ void Host::run(boost::system::error_code const&)
 	if (!m_run)
 	{
 		// reset NodeTable
+		stopDiscovery();
 		m_nodeTable.reset();
 
 		// stopping io service allows running manual network operations for shutdown
 		// and also stops blocking worker thread, allowing worker thread to exit
+		m_ioWork.reset();
 		m_ioService.stop();
 
 		// resetting timer signals network that nothing else can be scheduled to run
@@ -717,7 +724,7 @@ void Host::run(boost::system::error_code const&)
 
 	auto runcb = [this](boost::system::error_code const& error) { run(error); };
 	m_timer->expires_from_now(boost::posix_time::milliseconds(c_timerInterval));
-	m_timer->async_wait(runcb);
+	m_timer->async_wait(ba::bind_executor(m_strand, runcb));
 }
 
 void Host::startedWorking()
@@ -749,19 +756,62 @@ void Host::startedWorking()
 	else
 		clog(NetP2PNote) << "p2p.start.notice id:" << id() << "TCP Listen port is invalid or unavailable.";
 
+	// Discovery gets a thread of its own, so its signature work and bursts of UDP
+	// traffic do not add latency to the sessions.
+	m_discoveryService.reset();
+	m_discoveryWork.reset(new ba::io_service::work(m_discoveryService));
 	auto nodeTable = make_shared<NodeTable>(
-		m_ioService,
+		m_discoveryService,
 		m_alias,
 		NodeIPEndpoint(bi::address::from_string(listenAddress()), listenPort(), listenPort()),
 		m_netPrefs.discovery
 	);
 	nodeTable->setEventHandler(new HostNodeTableHandler(*this));
 	m_nodeTable = nodeTable;
+	m_discoveryThread = std::thread([this](){
+		setThreadName("p2pDisc");
+		while (true)
+			try
+			{
+				m_discoveryService.run();
+				break;
+			}
+			catch (std::exception const& _e)
+			{
+				clog(NetP2PWarn) << "Exception in discovery thread:" << _e.what();
+			}
+	});
 	restoreNetwork(&m_restoreNetwork);
 
+	// The worker thread itself runs the I/O service in doWork(). The I/O threads block in it
+	// until the network stops, also while there is nothing to do yet or any more.
+	m_ioWork.reset(new ba::io_service::work(m_ioService));
+	for (unsigned i = 1; i < m_netPrefs.ioThreads; ++i)
+		m_ioThreads.emplace_back([this, i](){ setThreadName("p2p" + toString(i)); runIoService(); });
+	if (m_netPrefs.capabilityThreads)
+	{
+		m_capabilityService.reset();
+		m_capabilityWork.reset(new ba::io_service::work(m_capabilityService));
+		for (unsigned i = 0; i < m_netPrefs.capabilityThreads; ++i)
+			m_capabilityThreads.emplace_back([this](){
+				setThreadName("p2pCap");
+				while (true)
+					try
+					{
+						m_capabilityService.run();
+						break;
+					}
+					catch (std::exception const& _e)
+					{
+						clog(NetP2PWarn) << "Exception in capability handler:" << _e.what();
+					}
+			});
+	}
+
 	clog(NetP2PNote) << "p2p.started id:" << id();
 
-	run(boost::system::error_code());
+	// The scheduler runs on m_strand from the first call, as the I/O threads are already up.
+	m_strand.post([this](){ run(boost::system::error_code()); });
 }
 
 void Host::doWork()
@@ -778,6 +828,49 @@ void Host::doWork()
 	}
 }
 
+void Host::runIoService()
+{
+	// m_ioWork keeps run() from returning for want of work; it returns once run(error_code)
+	// has stopped the service after m_run was cleared.
+	while (true)
+		try
+		{
+			m_ioService.run();
+			break;
+		}
+		catch (std::exception const& _e)
+		{
+			clog(NetP2PWarn) << "Exception in Network Thread:" << _e.what();
+		}
+}
+
+void Host::stopDiscovery()
+{
+	if (!m_discoveryThread.joinable())
+		return;
+
+	// The node table's handlers run on the discovery thread, so it is destroyed there;
+	// the handlers it cancels then find it gone and the service runs out of work.
+	m_discoveryService.post([this](){ m_nodeTable.reset(); });
+	m_discoveryWork.reset();
+	m_discoveryThread.join();
+}
+
+void Host::stopThreads()
+{
+	stopDiscovery();
+
+	for (auto& t: m_ioThreads)
+		t.join();
+	m_ioThreads.clear();
+
+	// Let the handlers of packets already read run to completion.
+	m_capabilityWork.reset();
+	for (auto& t: m_capabilityThreads)
+		t.join();
+	m_capabilityThreads.clear();
+}
+
 void Host::keepAlivePeers()
 {
 	if (chrono::steady_clock::now() - c_keepAliveInterval < m_lastPing)
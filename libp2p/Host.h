@@ -278,6 +278,15 @@ private:
 	/// Run network. Not thread-safe; to be called only by worker.
 	virtual void doWork();
 
+	/// Run m_ioService on an additional I/O thread until the network stops.
+	void runIoService();
+
+	/// Join the additional I/O threads and finish the queued capability packets.
+	void stopThreads();
+
+	/// Destroy the node table on the discovery thread and join that thread once its handlers are done.
+	void stopDiscovery();
+
 	/// Shutdown network. Not thread-safe; to be called only by worker.
 	virtual void doneWorking();
 
@@ -299,7 +308,18 @@ private:
 	int m_listenPort = -1;												///< What port are we listening on. -1 means binding failed or acceptor hasn't been initialized.
 
 	ba::io_service m_ioService;											///< IOService for network stuff.
+	std::unique_ptr<ba::io_service::work> m_ioWork;						///< Keeps m_ioService running while the network is up, even with nothing to do.
+	std::vector<std::thread> m_ioThreads;								///< Threads running m_ioService in addition to the worker.
+
+	ba::io_service m_capabilityService;									///< Runs capability packet handlers if NetworkPreferences::capabilityThreads is set.
+	std::unique_ptr<ba::io_service::work> m_capabilityWork;				///< Keeps m_capabilityService running while the network is up.
+	std::vector<std::thread> m_capabilityThreads;
+
+	ba::io_service m_discoveryService;									///< Runs the node table's UDP socket and timers apart from the sessions.
+	std::unique_ptr<ba::io_service::work> m_discoveryWork;				///< Keeps m_discoveryService running while the network is up.
+	std::thread m_discoveryThread;
 	bi::tcp::acceptor m_tcp4Acceptor;										///< Listening acceptor.
+	ba::io_service::strand m_strand;										///< Serialises the acceptor, connect and scheduler handlers across the I/O threads.
 
 	std::unique_ptr<boost::asio::deadline_timer> m_timer;					///< Timer which, when network is running, calls scheduler() every c_timerInterval ms.
 	static const unsigned c_timerInterval = 100;							///< Interval which m_timer is run when network is connected.
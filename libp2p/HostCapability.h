@@ -55,6 +55,8 @@ protected:
 	virtual u256 version() const = 0;
 	CapDesc capDesc() const { return std::make_pair(name(), version()); }
 	virtual unsigned messageCount() const = 0;
+	/// @returns the number of message ids version @a _version of the capability takes; messageCount() unless overridden.
+	virtual unsigned messageCount(u256 const& /*_version*/) const { return messageCount(); }
 	virtual std::shared_ptr<Capability> newPeerCapability(std::shared_ptr<SessionFace> const& _s, unsigned _idOffset, CapDesc const& _cap, uint16_t _capID) = 0;
 
 	virtual void onStarting() {}
@@ -62,6 +62,11 @@ struct NetworkPreferences
 	bool traverseNAT = true;
 	bool discovery = true;		// Discovery is activated with network.
 	bool pin = false;			// Only accept or connect to trusted peers.
+
+	/// Threading
+
+	unsigned ioThreads = 1;				// Threads running network I/O; each session and handshake is serialised on its own strand.
+	unsigned capabilityThreads = 0;		// Threads interpreting capability packets; 0 interprets them on the I/O threads.
 };
 
 /**
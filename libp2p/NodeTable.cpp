@@ -176,11 +176,9 @@ void NodeTable::doDiscover(NodeID _node, unsigned _round, shared_ptr<set<shared_
 		{
 			auto r = nearest[i];
 			tried.push_back(r);
-			FindNode p(r->endpoint, _node);
-			p.sign(m_secret);
 			DEV_GUARDED(x_findNodeTimeout)
 				m_findNodeTimeout.push_back(make_pair(r->id, chrono::steady_clock::now()));
-			m_socketPointer->send(p);
+			send(unique_ptr<DiscoveryDatagram>(new FindNode(r->endpoint, _node)));
 		}
 	
 	if (tried.empty())
@@ -289,22 +287,40 @@ vector<shared_ptr<NodeEntry>> NodeTable::nearestNodeEntries(NodeID _target)
 	return ret;
 }
 
-void NodeTable::ping(NodeIPEndpoint _to) const
+void NodeTable::ping(NodeIPEndpoint _to)
 {
 	NodeIPEndpoint src;
 	DEV_GUARDED(x_nodes)
 		src = m_node.endpoint;
-	PingNode p(src, _to);
-	p.sign(m_secret);
-	m_socketPointer->send(p);
+	send(unique_ptr<DiscoveryDatagram>(new PingNode(src, _to)));
 }
 
-void NodeTable::ping(NodeEntry* _n) const
+void NodeTable::ping(NodeEntry* _n)
 {
 	if (_n)
 		ping(_n->endpoint);
 }
 
+void NodeTable::send(unique_ptr<DiscoveryDatagram> _packet)
+{
+	Guard l(x_sendQueue);
+	if (m_sendQueue.size() >= c_maxSendQueue)
+	{
+		clog(NodeTableTriviaSummary) << "Send queue full; dropping packet to" << _packet->endpoint();
+		return;
+	}
+	m_sendQueue.push_back(move(_packet));
+	if (m_sending)
+		return;
+	m_sending = true;
+	m_timers.schedule(0, [this](boost::system::error_code const& _ec)
+	{
+		if (_ec.value() == boost::asio::error::operation_aborted || m_timers.isStopped())
+			return;
+		doSend();
+	});
+}
+
 void NodeTable::evict(shared_ptr<NodeEntry> _leastSeen, shared_ptr<NodeEntry> _new)
 {
 	if (!m_socketPointer->isOpen())
@@ -398,6 +414,12 @@ NodeTable::NodeBucket& NodeTable::bucket_UNSAFE(NodeEntry const* _n)
 void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytesConstRef _packet)
 {
 	try {
+		// Recovering the sender is the expensive part, so a flood is cut off before it.
+		if (!m_receiveLimit.take(c_maxReceiveRate))
+		{
+			clog(NodeTableTriviaSummary) << "Receive rate exceeded; dropping packet from " << _from.address().to_string() << ":" << _from.port();
+			return;
+		}
 		unique_ptr<DiscoveryDatagram> packet = DiscoveryDatagram::interpretUDP(_from, _packet);
 		if (!packet)
 			return;
@@ -499,13 +521,7 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				vector<shared_ptr<NodeEntry>> nearest = nearestNodeEntries(in.target);
 				static unsigned const nlimit = (m_socketPointer->maxDatagramSize - 109) / 90;
 				for (unsigned offset = 0; offset < nearest.size(); offset += nlimit)
-				{
-					Neighbours out(_from, nearest, offset, nlimit);
-					out.sign(m_secret);
-					if (out.data.size() > 1280)
-						clog(NetWarn) << "Sending truncated datagram, size: " << out.data.size();
-					m_socketPointer->send(out);
-				}
+					send(unique_ptr<DiscoveryDatagram>(new Neighbours(_from, nearest, offset, nlimit)));
 				break;
 			}
 
@@ -516,10 +532,9 @@ void NodeTable::onReceived(UDPSocketFace*, bi::udp::endpoint const& _from, bytes
 				in.source.udpPort = _from.port();
 				addNode(Node(in.sourceid, in.source));
 				
-				Pong p(in.source);
-				p.echo = sha3(in.echo);
-				p.sign(m_secret);
-				m_socketPointer->send(p);
+				unique_ptr<Pong> p(new Pong(in.source));
+				p->echo = sha3(in.echo);
+				send(move(p));
 				break;
 			}
 		}
@@ -585,6 +600,56 @@ void NodeTable::doDiscovery()
 	});
 }
 
+void NodeTable::doSend()
+{
+	// Only run on the discovery thread, so signing never holds up the sessions' IO service.
+	unsigned allowed = 0;
+	while (allowed < c_sendBatch && m_sendLimit.take(c_maxSendRate))
+		++allowed;
+
+	vector<unique_ptr<DiscoveryDatagram>> batch;
+	DEV_GUARDED(x_sendQueue)
+		while (batch.size() < allowed && !m_sendQueue.empty())
+		{
+			batch.push_back(move(m_sendQueue.front()));
+			m_sendQueue.pop_front();
+		}
+	// Tokens taken but not used are given back.
+	m_sendLimit.tokens += allowed - batch.size();
+
+	for (auto& p: batch)
+	{
+		p->sign(m_secret);
+		if (p->data.size() > NodeSocket::maxDatagramSize)
+			clog(NetWarn) << "Sending truncated datagram, size: " << p->data.size();
+		m_socketPointer->send(*p);
+	}
+
+	Guard l(x_sendQueue);
+	if (m_sendQueue.empty())
+	{
+		m_sending = false;
+		return;
+	}
+	m_timers.schedule(c_sendInterval.count(), [this](boost::system::error_code const& _ec)
+	{
+		if (_ec.value() == boost::asio::error::operation_aborted || m_timers.isStopped())
+			return;
+		doSend();
+	});
+}
+
+bool NodeTable::RateLimit::take(unsigned _rate)
+{
+	auto now = chrono::steady_clock::now();
+	tokens = last == TimePoint() ? _rate : min<double>(_rate, tokens + chrono::duration<double>(now - last).count() * _rate);
+	last = now;
+	if (tokens < 1)
+		return false;
+	--tokens;
+	return true;
+}
+
 unique_ptr<DiscoveryDatagram> DiscoveryDatagram::interpretUDP(bi::udp::endpoint const& _from, bytesConstRef _packet)
 {
 	unique_ptr<DiscoveryDatagram> decoded;
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <algorithm>
+#include <deque>
 
 #include <boost/integer/static_log2.hpp>
 
@@ -90,6 +91,8 @@ protected:
 class NodeTable;
 inline std::ostream& operator<<(std::ostream& _out, NodeTable const& _nodeTable);
 
+struct DiscoveryDatagram;
+
 /**
  * NodeTable using modified kademlia for node discovery and preference.
  * Node table requires an IO service, creates a socket for incoming
@@ -104,6 +107,12 @@ inline std::ostream& operator<<(std::ostream& _out, NodeTable const& _nodeTable)
  * NodeTable accepts a port for UDP and will listen to the port on all available
  * interfaces.
  *
+ * Host gives the node table an IO service and thread of its own, so a burst of
+ * discovery traffic cannot hold up TCP sessions. Outgoing packets are queued and
+ * signed there in batches of at most c_sendBatch, no faster than c_maxSendRate
+ * packets a second; incoming packets beyond c_maxReceiveRate a second are dropped
+ * before their signatures are recovered.
+ *
  * [Optimization]
  * @todo serialize evictions per-bucket
  * @todo store evictions in map, unit-test eviction logic
@@ -196,6 +205,23 @@ private:
 	std::chrono::milliseconds const c_evictionCheckInterval = std::chrono::milliseconds(75);	///< Interval at which eviction timeouts are checked.
 	std::chrono::milliseconds const c_reqTimeout = std::chrono::milliseconds(300);						///< How long to wait for requests (evict, find iterations).
 	std::chrono::milliseconds const c_bucketRefresh = std::chrono::milliseconds(7200);							///< Refresh interval prevents bucket from becoming stale. [Kademlia]
+	std::chrono::milliseconds const c_sendInterval = std::chrono::milliseconds(10);	///< Interval at which the send queue is drained while it is rate limited.
+
+	/// Limits on signature work
+
+	static unsigned const c_maxSendRate = 2000;		///< Packets signed and sent per second.
+	static unsigned const c_sendBatch = 32;			///< Packets signed per run of doSend().
+	static unsigned const c_maxSendQueue = 512;		///< Packets queued before new ones are dropped; bounds the delay to well under c_reqTimeout.
+	static unsigned const c_maxReceiveRate = 4000;	///< Packets whose signatures are recovered per second.
+
+	/// Token bucket allowing @a _rate events a second in bursts of up to a second's worth.
+	struct RateLimit
+	{
+		bool take(unsigned _rate);
+
+		double tokens = 0;
+		TimePoint last;
+	};
 
 	struct NodeBucket
 	{
@@ -204,10 +230,13 @@ private:
 	};
 
 	/// Used to ping endpoint.
-	void ping(NodeIPEndpoint _to) const;
+	void ping(NodeIPEndpoint _to);
 
 	/// Used ping known node. Used by node table when refreshing buckets and as part of eviction process (see evict).
-	void ping(NodeEntry* _n) const;
+	void ping(NodeEntry* _n);
+
+	/// Queues @a _packet to be signed and sent on the discovery thread. Dropped if the queue is full.
+	void send(std::unique_ptr<DiscoveryDatagram> _packet);
 
 	/// Returns center node entry which describes this node and used with dist() to calculate xor metric for node table nodes.
 	NodeEntry center() const { return NodeEntry(m_node.id, m_node.publicKey(), m_node.endpoint); }
@@ -252,6 +281,9 @@ private:
 	/// Looks up a random node at @c_bucketRefresh interval.
 	void doDiscovery();
 
+	/// Signs and sends the packets the rate limit allows and reschedules itself while any remain.
+	void doSend();
+
 	std::unique_ptr<NodeTableEventHandler> m_nodeEventHandler;		///< Event handler for node events.
 
 	Node m_node;													///< This node. LOCK x_state if endpoint access or mutation is required. Do not modify id.
@@ -275,6 +307,12 @@ private:
 	std::shared_ptr<NodeSocket> m_socket;							///< Shared pointer for our UDPSocket; ASIO requires shared_ptr.
 	NodeSocket* m_socketPointer;									///< Set to m_socket.get(). Socket is created in constructor and disconnected in destructor to ensure access to pointer is safe.
 
+	Mutex x_sendQueue;
+	std::deque<std::unique_ptr<DiscoveryDatagram>> m_sendQueue;		///< Packets waiting to be signed and sent.
+	bool m_sending = false;											///< Whether doSend() is scheduled. LOCK x_sendQueue.
+	RateLimit m_sendLimit;											///< Only used by doSend().
+	RateLimit m_receiveLimit;										///< Only used by onReceived().
+
 	DeadlineOps m_timers; ///< this should be the last member - it must be destroyed first
 };
 
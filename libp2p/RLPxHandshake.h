@@ -47,7 +47,7 @@ static const unsigned c_rlpxVersion = 4;
  *
  * Thread Safety
  * Distinct Objects: Safe.
- * Shared objects: Unsafe.
+ * Shared objects: Unsafe, except for start() and cancel(). All handlers run on m_strand.
  */
 class RLPXHandshake: public std::enable_shared_from_this<RLPXHandshake>
 {
@@ -55,17 +55,17 @@ class RLPXHandshake: public std::enable_shared_from_this<RLPXHandshake>
 
 public:
 	/// Setup incoming connection.
-	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket): m_host(_host), m_originated(false), m_socket(_socket), m_idleTimer(m_socket->ref().get_executor()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
+	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket): m_host(_host), m_originated(false), m_socket(_socket), m_strand(m_socket->ref().get_executor()), m_idleTimer(m_socket->ref().get_executor()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
 	
 	/// Setup outbound connection.
-	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket, NodeID _remote): m_host(_host), m_remote(_remote), m_originated(true), m_socket(_socket), m_idleTimer(m_socket->ref().get_executor()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
+	RLPXHandshake(Host* _host, std::shared_ptr<RLPXSocket> const& _socket, NodeID _remote): m_host(_host), m_remote(_remote), m_originated(true), m_socket(_socket), m_strand(m_socket->ref().get_executor()), m_idleTimer(m_socket->ref().get_executor()) { crypto::Nonce::get().ref().copyTo(m_nonce.ref()); }
 
 	virtual ~RLPXHandshake() = default;
 
 	/// Start handshake.
-	void start() { transition(); }
+	void start();
 
-	/// Aborts the handshake.
+	/// Aborts the handshake. Safe to call from any thread; the handshake is torn down on its strand.
 	void cancel();
 
 protected:
@@ -143,6 +143,7 @@ protected:
 	std::unique_ptr<RLPXFrameCoder> m_io;
 	
 	std::shared_ptr<RLPXSocket> m_socket;		///< Socket.
+	ba::strand<bi::tcp::socket::executor_type> m_strand;	///< Serialises the timer and socket handlers of this handshake across the host's I/O threads.
 	boost::asio::deadline_timer m_idleTimer;	///< Timer which enforces c_timeout.
 };
 	
@@ -36,6 +36,8 @@ Session::Session(Host* _h, unique_ptr<RLPXFrameCoder>&& _io, std::shared_ptr<RLP
 	m_server(_h),
 	m_io(move(_io)),
 	m_socket(_s),
+	m_strand(_h->m_ioService),
+	m_capabilityStrand(_h->m_capabilityService),
 	m_peer(_n),
 	m_info(_info),
 	m_ping(chrono::steady_clock::time_point::max())
@@ -115,6 +117,28 @@ bool Session::readPacket(uint16_t _capId, PacketType _t, RLP const& _r)
 {
 	m_lastReceived = chrono::steady_clock::now();
 	clog(NetRight) << _t << _r;
+
+	if (m_server->m_netPrefs.capabilityThreads && !(_capId == 0 && _t < UserPacket))
+	{
+		// Keep decoding and queue imports off the I/O threads; the packet buffer is reused by the next read.
+		++m_pendingPackets;
+		auto self(shared_from_this());
+		bytes data = _r.data().toBytes();
+		m_capabilityStrand.post([this, self, _capId, _t, data]()
+		{
+			ThreadContext tc(info().id.abridged());
+			ThreadContext tc2(info().clientVersion);
+			if (!m_dropped)
+				interpretPacket(_capId, _t, RLP(&data));
+			packetInterpreted();
+		});
+		return true;
+	}
+	return interpretPacket(_capId, _t, _r);
+}
+
+bool Session::interpretPacket(uint16_t _capId, PacketType _t, RLP const& _r)
+{
 	try // Generic try-catch block designed to capture RLP format errors - TODO: give decent diagnostics, make a bit more specific over what is caught.
 	{
 		// v4 frame headers are useless, offset packet type used
@@ -131,7 +155,7 @@ bool Session::readPacket(uint16_t _capId, PacketType _t, RLP const& _r)
 		else
 		{
 			for (auto const& i: m_capabilities)
-				if (_t >= (int)i.second->m_idOffset && _t - i.second->m_idOffset < i.second->hostCapability()->messageCount())
+				if (_t >= (int)i.second->m_idOffset && _t - i.second->m_idOffset < i.second->hostCapability()->messageCount(i.first.second))
 					return i.second->m_enabled ? i.second->interpret(_t - i.second->m_idOffset, _r) : true;
 		}
 
@@ -226,79 +250,78 @@ void Session::send(bytes&& _msg, uint16_t _protocolID)
 		return;
 
 	bool doWrite = false;
-	if (isFramingEnabled())
+	DEV_GUARDED(x_framing)
 	{
-		DEV_GUARDED(x_framing)
+		if (isFramingEnabled())
 		{
-			doWrite = m_encFrames.empty();
 			auto f = getFraming(_protocolID);
 			if (!f)
 				return;
-
 			f->writer.enque(RLPXPacket(_protocolID, msg));
 			multiplexAll();
 		}
-
-		if (doWrite)
-			writeFrames();
-	}
-	else
-	{
-		DEV_GUARDED(x_framing)
-		{
+		else
 			m_writeQueue.push_back(std::move(_msg));
-			doWrite = (m_writeQueue.size() == 1);
-		}
+		// Whoever sets the flag starts the writes; they go on until nothing is left to send.
+		doWrite = !m_writeInFlight;
+		m_writeInFlight = true;
+	}
 
-		if (doWrite)
-			write();
+	if (doWrite)
+	{
+		auto self(shared_from_this());
+		m_strand.dispatch([this, self](){ write(); });
 	}
 }
 
 void Session::write()
 {
-	bytes const* out = nullptr;
 	DEV_GUARDED(x_framing)
+		if (!nextWriteBatch())
+			return;
+	writeBatch();
+}
+
+bool Session::nextWriteBatch()
+{
+	// Seal everything queued so far so that it goes to the socket in a single gathering write.
+	m_writing.clear();
+	size_t size = 0;
+	if (isFramingEnabled())
 	{
-		m_io->writeSingleFramePacket(&m_writeQueue[0], m_writeQueue[0]);
-		out = &m_writeQueue[0];
-	}
-	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(*out), [this, self](boost::system::error_code ec, std::size_t /*length*/)
-	{
-		ThreadContext tc(info().id.abridged());
-		ThreadContext tc2(info().clientVersion);
-		// must check queue, as write callback can occur following dropped()
-		if (ec)
+		multiplexAll();
+		while (!m_encFrames.empty() && (m_writing.empty() || size < c_maxWriteBatch))
 		{
-			clog(NetWarn) << "Error sending: " << ec.message();
-			drop(TCPError);
-			return;
+			size += m_encFrames.front().size();
+			m_writing.push_back(move(m_encFrames.front()));
+			m_encFrames.pop_front();
 		}
-
-		DEV_GUARDED(x_framing)
+	}
+	else
+		while (!m_writeQueue.empty() && (m_writing.empty() || size < c_maxWriteBatch))
 		{
+			m_writing.push_back(move(m_writeQueue.front()));
 			m_writeQueue.pop_front();
-			if (m_writeQueue.empty())
-				return;
+			m_io->writeSingleFramePacket(&m_writing.back(), m_writing.back());
+			size += m_writing.back().size();
 		}
-		write();
-	});
+	m_writeInFlight = !m_writing.empty();
+	return m_writeInFlight;
 }
 
-void Session::writeFrames()
+void Session::writeBatch()
 {
-	bytes const* out = nullptr;
+	// m_writing is only touched again by the completion handler below, so the buffers stay valid.
+	vector<ba::const_buffer> buffers;
 	DEV_GUARDED(x_framing)
 	{
-		if (m_encFrames.empty())
-			return;
-		else
-			out = &m_encFrames[0];
+		buffers.reserve(m_writing.size());
+		for (bytes const& b: m_writing)
+			buffers.push_back(ba::buffer(b));
 	}
 
 	auto self(shared_from_this());
-	ba::async_write(m_socket->ref(), ba::buffer(*out), [this, self](boost::system::error_code ec, std::size_t /*length*/)
+	ba::async_write(m_socket->ref(), buffers, ba::bind_executor(m_strand, [this, self](boost::system::error_code ec, std::size_t /*length*/)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -310,18 +333,12 @@ void Session::writeFrames()
 			return;
 		}
 
+		bool more = false;
 		DEV_GUARDED(x_framing)
-		{
-			if (!m_encFrames.empty())
-				m_encFrames.pop_front();
-
-			multiplexAll();
-			if (m_encFrames.empty())
-				return;
-		}
-
-		writeFrames();
-	});
+			more = nextWriteBatch();
+		if (more)
+			writeBatch();
+	}));
 }
 
 void Session::drop(DisconnectReason _reason)
@@ -358,7 +375,10 @@ void Session::disconnect(DisconnectReason _reason)
         prep(s, DisconnectPacket, 1) << (unsigned)(int)_reason;
 		sealAndSend(s, 0);
 	}
-	drop(_reason);
+	// Posted, not dispatched: packet handlers call this on the strand, where dispatch() would
+	// close the socket at once. Posted, it runs after the disconnect packet's write has started.
+	auto self(shared_from_this());
+	m_strand.post([this, self, _reason](){ drop(_reason); });
 }
 
 void Session::start()
@@ -379,7 +399,7 @@ void Session::doRead()
 
 	auto self(shared_from_this());
 	m_data.resize(h256::size);
-	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), [this,self](boost::system::error_code ec, std::size_t length)
+	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), ba::bind_executor(m_strand, [this,self](boost::system::error_code ec, std::size_t length)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -412,7 +432,7 @@ void Session::doRead()
 		/// read padded frame and mac
 		auto tlen = hLength + hPadding + h128::size;
 		m_data.resize(tlen);
-		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), [this, self, hLength, hProtocolId, tlen](boost::system::error_code ec, std::size_t length)
+		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), ba::bind_executor(m_strand, [this, self, hLength, hProtocolId, tlen](boost::system::error_code ec, std::size_t length)
 		{
 			ThreadContext tc(info().id.abridged());
 			ThreadContext tc2(info().clientVersion);
@@ -444,9 +464,9 @@ void Session::doRead()
 					clog(NetWarn) << "Couldn't interpret packet." << RLP(r);
 #endif
 			}
-			doRead();
-		});
-	});
+			continueReading();
+		}));
+	}));
 }
 
 bool Session::checkRead(std::size_t _expected, boost::system::error_code _ec, std::size_t _length)
@@ -483,7 +503,7 @@ void Session::doReadFrames()
 
 	auto self(shared_from_this());
 	m_data.resize(h256::size);
-	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), [this, self](boost::system::error_code ec, std::size_t length)
+	ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, h256::size), ba::bind_executor(m_strand, [this, self](boost::system::error_code ec, std::size_t length)
 	{
 		ThreadContext tc(info().id.abridged());
 		ThreadContext tc2(info().clientVersion);
@@ -515,7 +535,7 @@ void Session::doReadFrames()
 		RLPXFrameInfo header(rawHeader);
 		auto tlen = header.length + header.padding + h128::size; // padded frame and mac
 		m_data.resize(tlen);
-		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), [this, self, tlen, header](boost::system::error_code ec, std::size_t length)
+		ba::async_read(m_socket->ref(), boost::asio::buffer(m_data, tlen), ba::bind_executor(m_strand, [this, self, tlen, header](boost::system::error_code ec, std::size_t length)
 		{
 			ThreadContext tc(info().id.abridged());
 			ThreadContext tc2(info().clientVersion);
@@ -549,9 +569,34 @@ void Session::doReadFrames()
 				ok = true;
 				(void)ok;
 			}
-			doReadFrames();
-		});
-	});
+			continueReading();
+		}));
+	}));
+}
+
+void Session::continueReading()
+{
+	if (m_pendingPackets >= c_maxPendingPackets)
+	{
+		// Resumed by packetInterpreted(); whoever clears the flag first starts the read.
+		m_readSuspended = true;
+		if (m_pendingPackets >= c_maxPendingPackets || !m_readSuspended.exchange(false))
+			return;
+	}
+
+	if (isFramingEnabled())
+		doReadFrames();
+	else
+		doRead();
+}
+
+void Session::packetInterpreted()
+{
+	if (--m_pendingPackets < c_maxPendingPackets && m_readSuspended.exchange(false))
+	{
+		auto self(shared_from_this());
+		m_strand.post([this, self](){ continueReading(); });
+	}
 }
 
 std::shared_ptr<Session::Framing> Session::getFraming(uint16_t _protocolID)
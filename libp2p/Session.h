@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <mutex>
 #include <array>
 #include <deque>
@@ -140,13 +142,29 @@ private:
 	/// Check error code after reading and drop peer if error code.
 	bool checkRead(std::size_t _expected, boost::system::error_code _ec, std::size_t _length);
 
-	/// Perform a single round of the write operation. This could end up calling itself asynchronously.
+	/// Start writing what is queued; only called by whoever set m_writeInFlight.
 	void write();
-	void writeFrames();
 
-	/// Deliver RLPX packet to Session or Capability for interpretation.
+	/// Move what is queued into m_writing, clearing m_writeInFlight if there is nothing. Requires x_framing.
+	/// @returns true if there is something to write.
+	bool nextWriteBatch();
+
+	/// Write m_writing to the socket with a single gathering write, then go on with the next batch.
+	void writeBatch();
+
+	/// Deliver RLPX packet to Session or Capability for interpretation, the latter on the
+	/// capability threads if the host has any.
 	bool readPacket(uint16_t _capId, PacketType _t, RLP const& _r);
 
+	/// Interpret RLPX packet in the Session or the Capability it belongs to.
+	bool interpretPacket(uint16_t _capId, PacketType _t, RLP const& _r);
+
+	/// Start the next read unless too many packets wait for the capability threads.
+	void continueReading();
+
+	/// Called on the capability threads after a packet was interpreted.
+	void packetInterpreted();
+
 	/// Interpret an incoming Session packet.
 	bool interpret(PacketType _t, RLP const& _r);
 	
@@ -157,13 +175,21 @@ private:
 
 	std::unique_ptr<RLPXFrameCoder> m_io;	///< Transport over which packets are sent.
 	std::shared_ptr<RLPXSocket> m_socket;		///< Socket of peer's connection.
+	ba::io_service::strand m_strand;		///< Serialises the socket's completion handlers across the host's I/O threads.
+	ba::io_service::strand m_capabilityStrand;	///< Keeps the capability packets of this session in order on the capability threads.
+	std::atomic<unsigned> m_pendingPackets{0};	///< Packets read but not yet interpreted by the capability threads.
+	std::atomic<bool> m_readSuspended{false};	///< Reading waits for the capability threads to catch up.
+	static const unsigned c_maxPendingPackets = 64;
 	Mutex x_framing;						///< Mutex for the write queue.
 	std::deque<bytes> m_writeQueue;			///< The write queue.
+	std::deque<bytes> m_writing;			///< Sealed packets or frames of the write in flight.
+	bool m_writeInFlight = false;			///< A write is under way and will pick up whatever gets queued.
+	static const size_t c_maxWriteBatch = 256 * 1024;	///< Stop adding packets to a write once it is this large.
 	std::vector<byte> m_data;			    ///< Buffer for ingress packet data.
 	bytes m_incoming;						///< Read buffer for ingress bytes.
 
 	std::shared_ptr<Peer> m_peer;			///< The Peer object.
-	bool m_dropped = false;					///< If true, we've already divested ourselves of this peer. We're just waiting for the reads & writes to fail before the shared_ptr goes OOS and the destructor kicks in.
+	std::atomic<bool> m_dropped{false};		///< If true, we've already divested ourselves of this peer. We're just waiting for the reads & writes to fail before the shared_ptr goes OOS and the destructor kicks in.
 
 	mutable Mutex x_info;
 	PeerSessionInfo m_info;						///< Dynamic information about this peer.
@@ -3,6 +3,7 @@
 #include <libethcore/KeyManager.h>
 #include <libethereum/Client.h>
 #include <libethereum/Executive.h>
+#include <libethereum/ParallelExecutor.h>
 #include <libethashseal/EthashClient.h>
 #include "AdminEth.h"
 #include "SessionManager.h"
@@ -232,6 +233,18 @@ Json::Value AdminEth::admin_eth_getReceiptByHashAndIndex(string const& _blockNum
 	return toJson(rs.receipts[_txIndex]);
 }
 
+Json::Value AdminEth::admin_eth_parallelExecutionStats(string const& _session)
+{
+	RPC_ADMIN;
+	ParallelExecutionStats const stats = ParallelExecutor::stats();
+	Json::Value ret;
+	ret["threads"] = ParallelExecutor::threads();
+	ret["transactions"] = toJS(stats.transactions);
+	ret["reexecuted"] = toJS(stats.reexecuted);
+	ret["conflictRate"] = stats.conflictRate();
+	return ret;
+}
+
 bool AdminEth::miner_start(int)
 {
     std::function<std::string()> passFunction = [](){ return getPassword("Enter the passphrase for the key: "); };
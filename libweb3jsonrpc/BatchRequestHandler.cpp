@@ -0,0 +1,242 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BatchRequestHandler.cpp
+ */
+
+#include "BatchRequestHandler.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <jsonrpccpp/common/exception.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::rpc;
+
+namespace
+{
+
+unordered_set<string> const c_readOnlyMethods = {
+	"eth_protocolVersion", "eth_hashrate", "eth_coinbase", "eth_mining", "eth_gasPrice", "eth_accounts",
+	"eth_blockNumber", "eth_getBalance", "eth_getStorageAt", "eth_getStorageRoot", "eth_getTransactionCount",
+	"eth_pendingTransactions", "eth_getBlockTransactionCountByHash", "eth_getBlockTransactionCountByNumber",
+	"eth_getUncleCountByBlockHash", "eth_getUncleCountByBlockNumber", "eth_getCode", "eth_call", "eth_estimateGas",
+	"eth_getBlockByHash", "eth_getBlockByNumber", "eth_getTransactionByHash", "eth_getTransactionByBlockHashAndIndex",
+	"eth_getTransactionByBlockNumberAndIndex", "eth_getTransactionReceipt", "eth_getUncleByBlockHashAndIndex",
+	"eth_getUncleByBlockNumberAndIndex", "eth_getFilterLogs", "eth_getFilterLogsEx", "eth_getLogs", "eth_getLogsEx",
+	"eth_syncing", "eth_inspectTransaction", "txpool_content",
+	"net_version", "net_peerCount", "net_listening",
+	"web3_clientVersion", "web3_sha3",
+	"debug_traceTransaction", "debug_storageRangeAt", "debug_preimage", "debug_traceBlockByNumber",
+	"debug_traceBlockByHash", "debug_traceCall"
+};
+
+/// Threads the requests of batches are handled on, shared by all servers and only started
+/// once a batch is first handled concurrently.
+boost::asio::thread_pool& batchPool()
+{
+	static boost::asio::thread_pool s_pool(max(BatchRequestHandler::c_defaultBatchConcurrency, thread::hardware_concurrency()));
+	return s_pool;
+}
+
+/// @returns the response to a request with id @a _id whose method threw @a _e, as the
+/// protocol handler wraps it.
+string errorResponse(Json::Value const& _id, jsonrpc::JsonRpcException const& _e)
+{
+	Json::Value response;
+	response["id"] = _id;
+	response["jsonrpc"] = "2.0";
+	response["error"]["code"] = _e.GetCode();
+	response["error"]["message"] = _e.GetMessage();
+	response["error"]["data"] = _e.GetData();
+	string ret = Json::FastWriter().write(response);
+	ret.pop_back();
+	return ret;
+}
+
+/// @returns the internal error response to @a _request, which threw; empty for a notification.
+string internalError(Json::Value const& _request, string const& _what)
+{
+	if (!_request.isObject() || !_request.isMember("id"))
+		return string();
+	return errorResponse(_request["id"], jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_RPC_INTERNAL_ERROR, _what));
+}
+
+}
+
+constexpr unsigned BatchRequestHandler::c_defaultBatchConcurrency;
+
+BatchRequestHandler::BatchRequestHandler(jsonrpc::IProtocolHandler& _handler):
+	m_handler(_handler)
+{
+}
+
+bool BatchRequestHandler::isReadOnly(string const& _method)
+{
+	return c_readOnlyMethods.count(_method);
+}
+
+void BatchRequestHandler::addStreamingMethod(string const& _name, StreamingMethod const& _method)
+{
+	m_streamingMethods[_name] = _method;
+}
+
+void BatchRequestHandler::HandleRequest(string const& _request, string& o_response)
+{
+	Json::Value request;
+	if (!Json::Reader().parse(_request, request, false) || (request.isArray() && request.empty()) || (!request.isArray() && !request.isObject()))
+	{
+		m_handler.HandleRequest(_request, o_response);
+		return;
+	}
+
+	if (request.isObject())
+	{
+		handle(request, o_response);
+		if (!o_response.empty())
+			o_response += '\n';
+		return;
+	}
+
+	vector<string> responses(request.size());
+	for (unsigned i = 0; i < request.size();)
+	{
+		unsigned end = i;
+		while (end < request.size() && request[end].isObject() && request[end]["method"].isString() && isReadOnly(request[end]["method"].asString()))
+			++end;
+		if (end - i > 1)
+			handleConcurrently(request, i, end, responses);
+		else
+			handle(request[i], responses[i]);
+		i = max(end, i + 1);
+	}
+
+	// Like the protocol handler, say nothing to a batch of notifications.
+	o_response.clear();
+	for (auto const& r: responses)
+		if (!r.empty())
+		{
+			o_response += o_response.empty() ? '[' : ',';
+			o_response += r;
+		}
+	if (!o_response.empty())
+		o_response += "]\n";
+}
+
+void BatchRequestHandler::handle(Json::Value const& _request, string& o_response)
+{
+	try
+	{
+		if (stream(_request, o_response))
+			return;
+		Json::Value response;
+		m_handler.HandleJsonRequest(_request, response);
+		o_response = response.isNull() ? string() : Json::FastWriter().write(response);
+		if (!o_response.empty())
+			o_response.pop_back();
+	}
+	catch (std::exception const& _e)
+	{
+		// Methods are meant to throw JsonRpcException, which the protocol handler answers. Anything
+		// else must not end a pool thread or leave handleConcurrently() while others use its frame.
+		o_response = internalError(_request, _e.what());
+	}
+	catch (...)
+	{
+		o_response = internalError(_request, string());
+	}
+}
+
+bool BatchRequestHandler::stream(Json::Value const& _request, string& o_response)
+{
+	// Anything the protocol handler might answer with an error is left to it.
+	if (!_request.isObject() || !_request["method"].isString() || !_request["params"].isArray() || _request["jsonrpc"] != "2.0")
+		return false;
+	Json::Value const& id = _request["id"];
+	if (id.type() != Json::intValue && id.type() != Json::uintValue && id.type() != Json::stringValue)
+		return false;
+	auto method = m_streamingMethods.find(_request["method"].asString());
+	if (method == m_streamingMethods.end())
+		return false;
+
+	string result;
+	JsonWriter w(result);
+	try
+	{
+		if (!method->second(_request["params"], w))
+			return false;
+	}
+	catch (jsonrpc::JsonRpcException const& _e)
+	{
+		o_response = errorResponse(id, _e);
+		return true;
+	}
+
+	// This is the order Json::Value keeps the members of the response in.
+	o_response.clear();
+	o_response.reserve(result.size() + 64);
+	JsonWriter(o_response).beginObject().key("id").value(id).key("jsonrpc").value("2.0").key("result");
+	o_response += result;
+	o_response += '}';
+	return true;
+}
+
+void BatchRequestHandler::handleConcurrently(Json::Value const& _batch, unsigned _begin, unsigned _end, vector<string>& o_responses)
+{
+	// Shared with the helpers, as they may only get to run once this has returned. A helper
+	// touches the batch only after it counted itself in, which it cannot once all is claimed.
+	struct Claims
+	{
+		atomic<unsigned> next;
+		unsigned working = 0;
+		mutex x_working;
+		condition_variable done;
+	};
+	auto claims = make_shared<Claims>();
+	claims->next = _begin;
+	auto work = [this, &_batch, &o_responses, _end](Claims& _c)
+	{
+		for (unsigned i = _c.next++; i < _end; i = _c.next++)
+			handle(_batch[i], o_responses[i]);
+	};
+
+	// This thread works too, so the batch gets on even when the pool is busy with others.
+	unsigned const helpers = min<unsigned>(m_batchConcurrency, _end - _begin) - 1;
+	for (unsigned h = 0; h < helpers; ++h)
+		boost::asio::post(batchPool(), [claims, work, _end]()
+		{
+			{
+				lock_guard<mutex> l(claims->x_working);
+				if (claims->next >= _end)
+					return;
+				++claims->working;
+			}
+			work(*claims);
+			lock_guard<mutex> l(claims->x_working);
+			if (!--claims->working)
+				claims->done.notify_all();
+		});
+	work(*claims);
+	// Everything is claimed now; only the helpers still handling a request are waited for.
+	unique_lock<mutex> l(claims->x_working);
+	claims->done.wait(l, [&]() { return !claims->working; });
+}
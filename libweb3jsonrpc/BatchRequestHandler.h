@@ -0,0 +1,94 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file BatchRequestHandler.h
+ * Handling the requests of a JSON-RPC batch at once.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <jsonrpccpp/server/iprotocolhandler.h>
+#include "JsonWriter.h"
+
+namespace dev
+{
+namespace rpc
+{
+
+/// Writes the result of a method for the given parameters straight into the response.
+/// @returns false if the method cannot take these parameters; the protocol handler then answers.
+/// Errors are thrown as JsonRpcException, as by the other methods.
+using StreamingMethod = std::function<bool(Json::Value const& _params, JsonWriter& o_result)>;
+
+/**
+ * @brief Stands between the connectors and the protocol handler, spreads the requests of
+ * batches over a pool of threads and writes the largest responses without a Json::Value.
+ *
+ * Requests for methods that only read are handled at once, at most batchConcurrency() of one
+ * batch at a time. Any other request waits for those before it and is handled alone, so
+ * that, say, transactions sent in one batch keep their order. The responses are put back
+ * together in the order of the requests.
+ *
+ * A method added with addStreamingMethod() writes its result into the response itself when
+ * the request is well-formed; when it is not, the protocol handler answers as usual. A
+ * JsonRpcException thrown by the method is wrapped the way the protocol handler wraps it,
+ * so either way the response is byte for byte what the protocol handler would have written.
+ * A method that throws anything else gets an internal error response rather than taking the
+ * server down.
+ * @threadsafe
+ */
+class BatchRequestHandler: public jsonrpc::IClientConnectionHandler
+{
+public:
+	static constexpr unsigned c_defaultBatchConcurrency = 8;
+
+	explicit BatchRequestHandler(jsonrpc::IProtocolHandler& _handler);
+
+	void HandleRequest(std::string const& _request, std::string& o_response) override;
+
+	/// Sets how many requests of one batch may be handled at once; 1 handles them in turn.
+	/// The threads of the pool, at least c_defaultBatchConcurrency, are shared by all servers
+	/// and only started once a batch is first handled concurrently.
+	void setBatchConcurrency(unsigned _concurrency) { m_batchConcurrency = std::max(1u, _concurrency); }
+	unsigned batchConcurrency() const { return m_batchConcurrency; }
+
+	/// Has @a _method write the results of @a _name from now on. Not to be called while serving requests.
+	void addStreamingMethod(std::string const& _name, StreamingMethod const& _method);
+
+	/// @returns true if @a _method only reads, so it may be handled alongside others.
+	static bool isReadOnly(std::string const& _method);
+
+private:
+	/// Handles @a _request into @a o_response, which is left empty for notifications.
+	void handle(Json::Value const& _request, std::string& o_response);
+	/// Writes the response to @a _request with its streaming method. @returns false if there is none or it declined.
+	bool stream(Json::Value const& _request, std::string& o_response);
+	/// Handles the requests [@a _begin, @a _end) of @a _batch into @a o_responses at once.
+	void handleConcurrently(Json::Value const& _batch, unsigned _begin, unsigned _end, std::vector<std::string>& o_responses);
+
+	jsonrpc::IProtocolHandler& m_handler;
+	std::unordered_map<std::string, StreamingMethod> m_streamingMethods;
+	std::atomic<unsigned> m_batchConcurrency{c_defaultBatchConcurrency};
+};
+
+}
+}
@@ -29,6 +29,7 @@
 #include <libwebthree/WebThree.h>
 #include <libethcore/CommonJS.h>
 #include <libweb3jsonrpc/JsonHelper.h>
+#include <libweb3jsonrpc/JsonWriter.h>
 #include "Eth.h"
 #include "AccountHolder.h"
 
@@ -46,10 +47,116 @@ const unsigned dev::SensibleHttpThreads = 4;
 #endif
 const unsigned dev::SensibleHttpPort = 8545;
 
+namespace
+{
+
+template <class B>
+void writeBlock(eth::Interface& _client, B const& _block, bool _includeTransactions, JsonWriter& o_result)
+{
+	if (!_client.isKnown(_block))
+		o_result.null();
+	else if (_includeTransactions)
+		toJson(o_result, _client.blockInfo(_block), _client.blockDetails(_block), _client.uncleHashes(_block), _client.transactions(_block), _client.sealEngine());
+	else
+		toJson(o_result, _client.blockInfo(_block), _client.blockDetails(_block), _client.uncleHashes(_block), _client.transactionHashes(_block), _client.sealEngine());
+}
+
+/// @returns @a _method failing on invalid parameters the way the methods of Eth do.
+StreamingMethod invalidParamsOnThrow(StreamingMethod const& _method)
+{
+	return [_method](Json::Value const& _params, JsonWriter& o_result)
+	{
+		try
+		{
+			return _method(_params, o_result);
+		}
+		catch (...)
+		{
+			BOOST_THROW_EXCEPTION(JsonRpcException(Errors::ERROR_RPC_INVALID_PARAMS));
+		}
+	};
+}
+
+/// @returns the pending transactions by sender and nonce, as txpool_content() lays them out.
+AccountTransactions pendingByAccount(Transactions const& _pending)
+{
+	AccountTransactions ret;
+	for (auto const& t: _pending)
+		ret[t.sender()][to_string(t.nonce().convert_to<int64_t>())] = &t;
+	return ret;
+}
+
+/// @returns the queued transactions by sender and nonce, as txpool_content() lays them out.
+AccountTransactions queuedByAccount(TransactionQueue::FutureTransactions const& _queued)
+{
+	AccountTransactions ret;
+	for (auto const& queued: _queued)
+	{
+		auto& byNonce = ret[queued.first];
+		for (auto const& t: queued.second)
+			byNonce[to_string(t.second.transaction.nonce().convert_to<int64_t>())] = &t.second.transaction;
+	}
+	return ret;
+}
+
+}
+
 Eth::Eth(eth::Interface& _eth, eth::AccountHolder& _ethAccounts):
 	m_eth(_eth),
 	m_ethAccounts(_ethAccounts)
 {
+	// The largest responses are written as they are made rather than built up as Json::Value first.
+	bindStreamingMethod("eth_getBlockByHash", invalidParamsOnThrow([this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size() != 2 || !_params[0u].isString() || !_params[1u].isBool())
+			return false;
+		writeBlock(*client(), jsToFixed<32>(_params[0u].asString()), _params[1u].asBool(), o_result);
+		return true;
+	}));
+	bindStreamingMethod("eth_getBlockByNumber", invalidParamsOnThrow([this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size() != 2 || !_params[0u].isString() || !_params[1u].isBool())
+			return false;
+		writeBlock(*client(), jsToBlockNumber(_params[0u].asString()), _params[1u].asBool(), o_result);
+		return true;
+	}));
+	bindStreamingMethod("eth_getTransactionReceipt", invalidParamsOnThrow([this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size() != 1 || !_params[0u].isString())
+			return false;
+		h256 const h = jsToFixed<32>(_params[0u].asString());
+		if (client()->isKnownTransaction(h))
+			toJson(o_result, client()->localisedTransactionReceipt(h));
+		else
+			o_result.null();
+		return true;
+	}));
+	bindStreamingMethod("eth_getFilterLogs", invalidParamsOnThrow([this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size() != 1 || !_params[0u].isString())
+			return false;
+		toJson(o_result, client()->logs(jsToInt(_params[0u].asString())));
+		return true;
+	}));
+	bindStreamingMethod("eth_getLogs", invalidParamsOnThrow([this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size() != 1 || !_params[0u].isObject())
+			return false;
+		toJson(o_result, client()->logs(toLogFilter(_params[0u], *client())));
+		return true;
+	}));
+	bindStreamingMethod("txpool_content", [this](Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params.size())
+			return false;
+		Transactions const pending = client()->pending();
+		o_result.beginObject().key("pending");
+		toJson(o_result, pendingByAccount(pending));
+		o_result.key("queued");
+		toJson(o_result, queuedByAccount(client()->queued()));
+		o_result.endObject();
+		return true;
+	});
 }
 
 string Eth::eth_protocolVersion()
@@ -753,59 +860,9 @@ Json::Value Eth::eth_fetchQueuedTransactions(string const& _accountId)
 
 Json::Value Eth::txpool_content()
 {
-	//Return list of transactions from transactions pool
-	Transactions ours;
-
-	Json::Value finalJson;
-	Json::Value pendingAccounts;
-
-	// 1. collect all the accounts
-	std::map<Address, Transactions> accountTransactions;
-	for (const auto& pending :client()->pending())
-	{
-		auto iterM = accountTransactions.find(pending.sender());
-		if( iterM == accountTransactions.end())
-		{
-			accountTransactions[pending.sender()] = {};
-		}
-
-		accountTransactions[pending.sender()].push_back(pending);
-	}
-
-	// 2. iterate thru the resulting map and form the content using nonce
-	for (const auto& at : accountTransactions)
-	{
-		// 2.1 loop thru account transactions
-		Json::Value detail;
-		for (const auto& transactions : at.second)
-		{
-			auto nonce = transactions.nonce().convert_to<int64_t>();
-			std::string nonceKey = std::to_string(nonce);
-			detail[nonceKey] = toJson(transactions);
-		}
-
-		pendingAccounts["0x" + at.first.hex()] = detail;
-	}
-
-	Json::Value queuedJson;
-	Json::Value queuedAccountsJson;
-
-	// 3. Get the queued transactions
-	for (const auto& queued:client()->queued())
-	{
-		Json::Value detail;
-		for (const auto& transactions : queued.second)
-		{
-			auto nonce = transactions.second.transaction.nonce().convert_to<int64_t>();
-			std::string nonceKey = std::to_string(nonce);
-			detail[nonceKey] = toJson(transactions.second.transaction);
-		}
-
-		queuedAccountsJson["0x" + queued.first.hex()] = detail;
-	}
-
-	finalJson["pending"] = pendingAccounts;
-	finalJson["queued"] = queuedAccountsJson;
-
-	return finalJson;
+	Transactions const pending = client()->pending();
+	Json::Value ret;
+	ret["pending"] = toJson(pendingByAccount(pending));
+	ret["queued"] = toJson(queuedByAccount(client()->queued()));
+	return ret;
 }
\ No newline at end of file
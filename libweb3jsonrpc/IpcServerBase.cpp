@@ -25,7 +25,6 @@
 #include <cstdio>
 #include <string>
 #include <libdevcore/Guards.h>
-#include <libdevcore/Log.h>
 
 using namespace std;
 using namespace jsonrpc;
@@ -33,11 +32,6 @@ using namespace dev;
 
 int const c_bufferSize = 1024;
 
-struct IpcSendChannel: public LogChannel { static const char* name() { return "I>"; } static const int verbosity = 10; };
-struct IpcReceiveChannel: public LogChannel { static const char* name() { return "I<"; } static const int verbosity = 10; };
-#define cipcs dev::LogOutputStream<IpcSendChannel, true>()
-#define cipcr dev::LogOutputStream<IpcReceiveChannel, true>()
-
 template <class S> IpcServerBase<S>::IpcServerBase(string const& _path):
 	m_path(_path)
 {
@@ -71,84 +65,67 @@ template <class S> bool IpcServerBase<S>::StopListening()
 	return false;
 }
 
+void IpcRequestFramer::feed(char const* _data, size_t _size, function<void(string const&)> const& _onRequest)
+{
+	m_buffer.append(_data, _size);
+	for (; m_scanned < m_buffer.size(); ++m_scanned)
+	{
+		char const c = m_buffer[m_scanned];
+		if (m_inString)
+		{
+			if (m_escape)
+				m_escape = false;
+			else if (c == '\\')
+				m_escape = true;
+			else if (c == '\"')
+				m_inString = false;
+		}
+		else if (c == '\"')
+			m_inString = true;
+		else if (c == '{' || c == '[')
+			++m_depth;
+		else if ((c == '}' || c == ']') && m_depth > 0 && --m_depth == 0)
+		{
+			_onRequest(m_buffer.substr(m_start, m_scanned + 1 - m_start));
+			m_start = m_scanned + 1;
+		}
+	}
+	// Drop the requests handed out all at once rather than one by one.
+	m_buffer.erase(0, m_start);
+	m_scanned -= m_start;
+	m_start = 0;
+}
+
 template <class S> bool IpcServerBase<S>::SendResponse(string const& _response, void* _addInfo)
 {
-	bool fullyWritten = false;
-	bool errorOccured = false;
 	S socket = (S)(reinterpret_cast<intptr_t>(_addInfo));
-	string toSend = _response;
-	do
+	size_t written = 0;
+	while (written < _response.size())
 	{
-		size_t bytesWritten = Write(socket, toSend);
+		size_t const bytesWritten = Write(socket, _response.data() + written, _response.size() - written);
 		if (bytesWritten == 0)
-			errorOccured = true;
-		else if (bytesWritten < toSend.size())
-		{
-			int len = toSend.size() - bytesWritten;
-			toSend = toSend.substr(bytesWritten + sizeof(char), len);
-		}
-		else
-			fullyWritten = true;
-	} while (!fullyWritten && !errorOccured);
+			return false;
+		written += bytesWritten;
+	}
 	cipcs << _response;
-	return fullyWritten && !errorOccured;
+	return true;
 }
 
 template <class S> void IpcServerBase<S>::GenerateResponse(S _connection)
 {
 	char buffer[c_bufferSize];
-	string request;
-	bool escape = false;
-	bool inString = false;
-	size_t i = 0;
-	int depth = 0;
+	IpcRequestFramer framer;
 	size_t nbytes = 0;
 	do
 	{
 		nbytes = Read(_connection, buffer, c_bufferSize);
 		if (nbytes <= 0)
 			break;
-		request.append(buffer, nbytes);
-		while (i < request.size())
+		framer.feed(buffer, nbytes, [&](string const& _request)
 		{
-			char c = request[i];
-			if (c == '\"' && !inString)
-			{
-				inString = true;
-				escape = false;
-			}
-			else if (c == '\"' && inString && !escape)
-			{
-				inString = false;
-				escape = false;
-			}
-			else if (inString && c == '\\' && !escape)
-			{
-				escape = true;
-			}
-			else if (inString)
-			{
-				escape = false;
-			}
-			else if (!inString && (c == '{' || c == '['))
-			{
-				depth++;
-			}
-			else if (!inString && (c == '}' || c == ']'))
-			{
-				depth--;
-				if (depth == 0)
-				{
-					std::string r = request.substr(0, i + 1);
-					request.erase(0, i + 1);
-					cipcr << r;
-					OnRequest(r, reinterpret_cast<void*>((intptr_t)_connection));
-					i = 0;
-					continue;
-				}
-			}
-			i++;
-		}
+			cipcr << _request;
+			OnRequest(_request, reinterpret_cast<void*>((intptr_t)_connection));
+		});
 	} while (true);
 	DEV_GUARDED(x_sockets)
 		m_sockets.erase(_connection);
@@ -22,14 +22,47 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <thread>
 #include <mutex>
 #include <unordered_set>
 #include <jsonrpccpp/server/abstractserverconnector.h>
+#include <libdevcore/Log.h>
 
 namespace dev
 {
+
+struct IpcSendChannel: public LogChannel { static const char* name() { return "I>"; } static const int verbosity = 10; };
+struct IpcReceiveChannel: public LogChannel { static const char* name() { return "I<"; } static const int verbosity = 10; };
+#define cipcs dev::LogOutputStream<dev::IpcSendChannel, true>()
+#define cipcr dev::LogOutputStream<dev::IpcReceiveChannel, true>()
+
+/**
+ * @brief Splits the bytes read from an IPC connection into JSON requests.
+ *
+ * A request ends where the object or array it opened closes, outside of strings. The scan
+ * resumes where the previous read left off, so every byte is looked at once however the
+ * requests are split across reads.
+ */
+class IpcRequestFramer
+{
+public:
+	/// Append the @a _size bytes at @a _data and call @a _onRequest with each request they complete.
+	void feed(char const* _data, size_t _size, std::function<void(std::string const&)> const& _onRequest);
+
+	/// @returns the number of bytes held of a request that is not complete yet.
+	size_t pending() const { return m_buffer.size() - m_start; }
+
+private:
+	std::string m_buffer;
+	size_t m_start = 0;		///< Where the request being scanned starts in m_buffer.
+	size_t m_scanned = 0;	///< How many bytes of m_buffer have been scanned.
+	int m_depth = 0;
+	bool m_inString = false;
+	bool m_escape = false;
+};
+
 template <class S> class IpcServerBase: public jsonrpc::AbstractServerConnector
 {
 public:
@@ -41,7 +74,7 @@ public:
 protected:
 	virtual void Listen() = 0;
 	virtual void CloseConnection(S _socket) = 0;
-	virtual size_t Write(S _connection, std::string const& _data) = 0;
+	virtual size_t Write(S _connection, char const* _data, size_t _size) = 0;
 	virtual size_t Read(S _connection, void* _data, size_t _size) = 0;
 	void GenerateResponse(S _connection);
 
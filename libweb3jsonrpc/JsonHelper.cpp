@@ -21,6 +21,7 @@
  */
 
 #include "JsonHelper.h"
+#include "JsonWriter.h"
 
 #include <libethcore/SealEngine.h>
 #include <libethereum/Client.h>
@@ -335,6 +336,18 @@ Json::Value toJson(std::unordered_map<h256, dev::eth::LocalisedLogEntries> const
 	return res;
 }
 
+Json::Value toJson(AccountTransactions const& _ts)
+{
+	Json::Value res;
+	for (auto const& account: _ts)
+	{
+		Json::Value& byNonce = res["0x" + account.first.hex()];
+		for (auto const& t: account.second)
+			byNonce[t.first] = toJson(*t.second);
+	}
+	return res;
+}
+
 Json::Value toJsonByBlock(LocalisedLogEntries const& _entries)
 {
 	vector<h256> order;
@@ -357,6 +370,239 @@ Json::Value toJsonByBlock(LocalisedLogEntries const& _entries)
 	return toJson(entriesByBlock, order);
 }
 
+namespace
+{
+
+/// Writes the members of a block that toJson() would, with @a _transactions writing the value of
+/// "transactions". Json::Value sorts its members, so the seal engine's go in between ours.
+void writeBlock(JsonWriter& _w, BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, SealEngineFace* _sealer, function<void()> const& _transactions)
+{
+	if (!_bi)
+	{
+		_w.null();
+		return;
+	}
+	map<string, string> sealed;
+	if (_sealer)
+		for (auto const& i: _sealer->jsInfo(_bi))
+			sealed[i.first] = i.second;
+	auto next = sealed.begin();
+	// @returns true if the caller is to write the value of @a _key; false if there is none or it came from the seal engine.
+	auto member = [&](char const* _key, bool _present, bool _sealedWins)
+	{
+		for (; next != sealed.end() && next->first < _key; ++next)
+			_w.key(next->first.c_str()).value(next->second);
+		if (next != sealed.end() && next->first == _key)
+		{
+			if (_sealedWins)
+				_w.key(_key).value(next->second);
+			++next;
+			if (_sealedWins)
+				return false;
+		}
+		if (_present)
+			_w.key(_key);
+		return _present;
+	};
+
+	h256 hash;
+	bool const hashed = [&]() { try { hash = _bi.hash(); return true; } catch (...) { return false; } }();
+	_w.beginObject();
+	if (member("author", true, true))
+		_w.value(_bi.author());
+	if (member("difficulty", true, true))
+		_w.quantity(_bi.difficulty());
+	if (member("extraData", true, true))
+		_w.hex(&_bi.extraData());
+	if (member("gasLimit", true, true))
+		_w.quantity(_bi.gasLimit());
+	if (member("gasUsed", true, true))
+		_w.quantity(_bi.gasUsed());
+	if (member("hash", hashed, true))
+		_w.value(hash);
+	if (member("logsBloom", true, true))
+		_w.value(_bi.logBloom());
+	if (member("miner", true, true))
+		_w.value(_bi.author());
+	if (member("number", true, true))
+		_w.quantity(_bi.number());
+	if (member("parentHash", true, true))
+		_w.value(_bi.parentHash());
+	if (member("receiptsRoot", true, true))
+		_w.value(_bi.receiptsRoot());
+	if (member("sha3Uncles", true, true))
+		_w.value(_bi.sha3Uncles());
+	if (member("stateRoot", true, true))
+		_w.value(_bi.stateRoot());
+	if (member("timestamp", true, true))
+		_w.quantity(_bi.timestamp());
+	if (member("totalDifficulty", true, false))
+		_w.quantity(_bd.totalDifficulty);
+	if (member("transactions", true, false))
+		_transactions();
+	if (member("transactionsRoot", true, true))
+		_w.value(_bi.transactionsRoot());
+	if (member("uncles", true, false))
+	{
+		_w.beginArray();
+		for (h256 const& h: _us)
+			_w.value(h);
+		_w.endArray();
+	}
+	for (; next != sealed.end(); ++next)
+		_w.key(next->first.c_str()).value(next->second);
+	_w.endObject();
+}
+
+void writeLog(JsonWriter& _w, LocalisedLogEntry const& _e)
+{
+	if (_e.isSpecial)
+	{
+		_w.value(_e.special);
+		return;
+	}
+	_w.beginObject().key("address").value(_e.address);
+	if (_e.mined)
+		_w.key("blockHash").value(_e.blockHash).key("blockNumber").number(_e.blockNumber);
+	else
+		_w.key("blockHash").null().key("blockNumber").null();
+	_w.key("data").hex(&_e.data);
+	if (_e.mined)
+		_w.key("logIndex").number(_e.logIndex);
+	else
+		_w.key("logIndex").null();
+	_w.key("polarity").value(_e.polarity == BlockPolarity::Live).key("topics").beginArray();
+	for (auto const& t: _e.topics)
+		_w.value(t);
+	_w.endArray();
+	if (_e.mined)
+		_w.key("transactionHash").value(_e.transactionHash).key("transactionIndex").number(_e.transactionIndex).key("type").value("mined");
+	else
+		_w.key("transactionHash").null().key("transactionIndex").null().key("type").value("pending");
+	_w.endObject();
+}
+
+}
+
+void toJson(JsonWriter& _w, BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, Transactions const& _ts, SealEngineFace* _face)
+{
+	writeBlock(_w, _bi, _bd, _us, _face, [&]()
+	{
+		h256 const blockHash = _bi.hash();
+		auto const blockNumber = static_cast<BlockNumber>(_bi.number());
+		_w.beginArray();
+		for (unsigned i = 0; i < _ts.size(); ++i)
+		{
+			Transaction const& t = _ts[i];
+			if (!t)
+			{
+				_w.null();
+				continue;
+			}
+			_w.beginObject()
+				.key("blockHash").value(blockHash)
+				.key("blockNumber").quantity(blockNumber)
+				.key("from").value(t.sender())
+				.key("gas").quantity(t.gas())
+				.key("gasPrice").quantity(t.gasPrice())
+				.key("hash").value(t.sha3())
+				.key("input").hex(&t.data())
+				.key("nonce").quantity(t.nonce())
+				.key("to");
+			if (t.isCreation())
+				_w.null();
+			else
+				_w.value(t.receiveAddress());
+			_w.key("transactionIndex").quantity(i)
+				.key("value").quantity(t.value())
+				.endObject();
+		}
+		_w.endArray();
+	});
+}
+
+void toJson(JsonWriter& _w, BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, TransactionHashes const& _ts, SealEngineFace* _face)
+{
+	writeBlock(_w, _bi, _bd, _us, _face, [&]()
+	{
+		_w.beginArray();
+		for (h256 const& t: _ts)
+			_w.value(t);
+		_w.endArray();
+	});
+}
+
+void toJson(JsonWriter& _w, Transaction const& _t)
+{
+	_w.beginObject()
+		.key("blockHash").value("0x0000000000000000000000000000000000000000000000000000000000000000")
+		.key("blockNumber").null()
+		.key("data").hex(&_t.data(), 32)
+		.key("from").value(_t.from())
+		.key("gas").quantity(_t.gas())
+		.key("gasPrice").quantity(_t.gasPrice())
+		.key("hash").value(_t.sha3(WithSignature))
+		.key("input").hex(&_t.data())
+		.key("nonce").quantity(_t.nonce())
+		.key("senderPublic").value(toJS(_t.signature().publicKey))
+		.key("sighash").value(_t.sha3(WithoutSignature))
+		.key("to");
+	if (_t.isCreation())
+		_w.null();
+	else
+		_w.value(_t.to());
+	_w.key("transactionIndex").null()
+		.key("value").quantity(_t.value())
+		.endObject();
+}
+
+void toJson(JsonWriter& _w, LocalisedTransactionReceipt const& _t)
+{
+	_w.beginObject()
+		.key("blockHash").value(_t.blockHash())
+		.key("blockNumber").number(_t.blockNumber())
+		.key("contractAddress").value(_t.contractAddress())
+		.key("cumulativeGasUsed").quantity(_t.gasUsed())
+		.key("gasUsed").quantity(_t.gasUsed())
+		.key("logs");
+	toJson(_w, _t.localisedLogs());
+	_w.key("transactionHash").value(_t.hash())
+		.key("transactionIndex").number(_t.transactionIndex())
+		.endObject();
+}
+
+void toJson(JsonWriter& _w, LocalisedLogEntries const& _es)
+{
+	_w.beginArray();
+	for (auto const& e: _es)
+		writeLog(_w, e);
+	_w.endArray();
+}
+
+void toJson(JsonWriter& _w, AccountTransactions const& _ts)
+{
+	if (_ts.empty())
+	{
+		_w.null();
+		return;
+	}
+	_w.beginObject();
+	for (auto const& account: _ts)
+	{
+		_w.key(("0x" + account.first.hex()).c_str());
+		if (account.second.empty())
+		{
+			_w.null();
+			continue;
+		}
+		_w.beginObject();
+		for (auto const& t: account.second)
+			toJson(_w.key(t.first.c_str()), *t.second);
+		_w.endObject();
+	}
+	_w.endObject();
+}
+
 TransactionSkeleton toTransactionSkeleton(Json::Value const& _json)
 {
 	TransactionSkeleton ret;
@@ -30,6 +30,8 @@
 namespace dev
 {
 
+class JsonWriter;
+
 Json::Value toJson(std::map<h256, std::pair<u256, u256>> const& _storage);
 Json::Value toJson(std::unordered_map<u256, u256> const& _storage);
 Json::Value toJson(Address const& _address);
@@ -52,6 +54,8 @@ class Interface;
 using Transactions = std::vector<Transaction>;
 using UncleHashes = h256s;
 using TransactionHashes = h256s;
+/// Transactions by sender and then by decimal nonce, as txpool_content lays them out.
+using AccountTransactions = std::map<Address, std::map<std::string, Transaction const*>>;
 
 Json::Value toJson(BlockHeader const& _bi, SealEngineFace* _face = nullptr);
 //TODO: wrap these params into one structure eg. "LocalisedTransaction"
@@ -67,6 +71,16 @@ Json::Value toJson(LocalisedLogEntry const& _e);
 Json::Value toJson(LogEntry const& _e);
 Json::Value toJson(std::unordered_map<h256, LocalisedLogEntries> const& _entriesByBlock);
 Json::Value toJsonByBlock(LocalisedLogEntries const& _entries);
+Json::Value toJson(AccountTransactions const& _ts);
+
+// These write what toJson() of the same arguments would give, straight into @a _w.
+void toJson(JsonWriter& _w, BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, Transactions const& _ts, SealEngineFace* _face = nullptr);
+void toJson(JsonWriter& _w, BlockHeader const& _bi, BlockDetails const& _bd, UncleHashes const& _us, TransactionHashes const& _ts, SealEngineFace* _face = nullptr);
+void toJson(JsonWriter& _w, Transaction const& _t);
+void toJson(JsonWriter& _w, LocalisedTransactionReceipt const& _t);
+void toJson(JsonWriter& _w, LocalisedLogEntries const& _es);
+void toJson(JsonWriter& _w, AccountTransactions const& _ts);
+
 TransactionSkeleton toTransactionSkeleton(Json::Value const& _json);
 LogFilter toLogFilter(Json::Value const& _json);
 LogFilter toLogFilter(Json::Value const& _json, Interface const& _client);	// commented to avoid warning. Uncomment once in use @ PoC-7.
@@ -0,0 +1,140 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonWriter.cpp
+ */
+
+#include "JsonWriter.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+char const c_hexDigits[] = "0123456789abcdef";
+}
+
+void JsonWriter::separate()
+{
+	if (m_afterKey)
+		m_afterKey = false;
+	else if (!m_started.empty())
+	{
+		if (m_started.back())
+			m_out += ',';
+		m_started.back() = true;
+	}
+}
+
+JsonWriter& JsonWriter::open(char _c)
+{
+	separate();
+	m_out += _c;
+	m_started.push_back(false);
+	return *this;
+}
+
+JsonWriter& JsonWriter::close(char _c)
+{
+	m_out += _c;
+	m_started.pop_back();
+	return *this;
+}
+
+JsonWriter& JsonWriter::key(char const* _key)
+{
+	separate();
+	m_out += '"';
+	m_out += _key;
+	m_out += "\":";
+	m_afterKey = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::literal(char const* _s)
+{
+	separate();
+	m_out += _s;
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(char const* _s)
+{
+	// Anything that needs escaping is left to jsoncpp, so that it is escaped the same way.
+	for (char const* c = _s; *c; ++c)
+		if (*c < 0x20 || *c > 0x7e || *c == '"' || *c == '\\' || *c == '/')
+			return literal(Json::valueToQuotedString(_s).c_str());
+	separate();
+	m_out += '"';
+	m_out += _s;
+	m_out += '"';
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(Json::Value const& _v)
+{
+	string const s = Json::FastWriter().write(_v);
+	separate();
+	m_out.append(s, 0, s.size() - 1);
+	return *this;
+}
+
+JsonWriter& JsonWriter::hex(bytesConstRef _data, size_t _padding)
+{
+	separate();
+	size_t const start = m_out.size();
+	m_out.resize(start + 4 + 2 * max(_data.size(), _padding), '0');
+	char* o = &m_out[start];
+	*o++ = '"';
+	*o++ = '0';
+	*o++ = 'x';
+	for (byte b: _data)
+	{
+		*o++ = c_hexDigits[b >> 4];
+		*o++ = c_hexDigits[b & 0xf];
+	}
+	m_out.back() = '"';
+	return *this;
+}
+
+JsonWriter& JsonWriter::quantity(uint64_t _n)
+{
+	char digits[16];
+	char* d = end(digits);
+	do
+		*--d = c_hexDigits[_n & 0xf];
+	while (_n >>= 4);
+	separate();
+	m_out += "\"0x";
+	m_out.append(d, end(digits));
+	m_out += '"';
+	return *this;
+}
+
+JsonWriter& JsonWriter::quantity(u256 const& _n)
+{
+	if (_n <= numeric_limits<uint64_t>::max())
+		return quantity(static_cast<uint64_t>(_n));
+	h256 const big(_n);
+	string const h = toHex(big.ref());
+	separate();
+	m_out += "\"0x";
+	m_out.append(h, h.find_first_not_of('0'), string::npos);
+	m_out += '"';
+	return *this;
+}
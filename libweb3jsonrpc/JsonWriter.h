@@ -0,0 +1,80 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @file JsonWriter.h
+ * Writing JSON straight into a string.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <json/json.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+
+/**
+ * @brief Appends compact JSON to a string as it is written, without building a Json::Value.
+ *
+ * The output is what Json::FastWriter makes of the same value without its trailing newline,
+ * provided that the keys of every object are written in the order Json::Value keeps them:
+ * sorted byte by byte. Hashes and quantities are written in hex the way toJS() writes them.
+ */
+class JsonWriter
+{
+public:
+	explicit JsonWriter(std::string& o_out): m_out(o_out) {}
+
+	JsonWriter& beginObject() { return open('{'); }
+	JsonWriter& endObject() { return close('}'); }
+	JsonWriter& beginArray() { return open('['); }
+	JsonWriter& endArray() { return close(']'); }
+
+	/// Writes the key of the next member of an object; @a _key must not need escaping.
+	JsonWriter& key(char const* _key);
+
+	JsonWriter& null() { return literal("null"); }
+	JsonWriter& value(bool _b) { return literal(_b ? "true" : "false"); }
+	JsonWriter& value(char const* _s);
+	JsonWriter& value(std::string const& _s) { return value(_s.c_str()); }
+	/// Writes any value, as Json::FastWriter would.
+	JsonWriter& value(Json::Value const& _v);
+	/// Writes a decimal number, as Json::Value(_n) would.
+	JsonWriter& number(int64_t _n) { return literal(std::to_string(_n).c_str()); }
+
+	/// Writes "0x" followed by the hex of @a _data padded with zero bytes up to @a _padding.
+	JsonWriter& hex(bytesConstRef _data, size_t _padding = 0);
+	template <unsigned N> JsonWriter& value(FixedHash<N> const& _h) { return hex(_h.ref()); }
+	/// Writes "0x" followed by the hex of @a _n without leading zeros.
+	JsonWriter& quantity(uint64_t _n);
+	JsonWriter& quantity(u256 const& _n);
+
+private:
+	JsonWriter& open(char _c);
+	JsonWriter& close(char _c);
+	JsonWriter& literal(char const* _s);
+	/// Writes the comma that goes before any element of an array or object but the first.
+	void separate();
+
+	std::string& m_out;
+	std::vector<bool> m_started;	///< For each open array or object, whether it has an element yet.
+	bool m_afterKey = false;
+};
+
+}
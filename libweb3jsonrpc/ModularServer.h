@@ -31,6 +31,7 @@
 #include <jsonrpccpp/server/iprocedureinvokationhandler.h>
 #include <jsonrpccpp/server/abstractserverconnector.h>
 #include <jsonrpccpp/server/requesthandlerfactory.h>
+#include "BatchRequestHandler.h"
 
 template <class I> using AbstractMethodPointer = void(I::*)(Json::Value const& _parameter, Json::Value& _result);
 template <class I> using AbstractNotificationPointer = void(I::*)(Json::Value const& _parameter);
@@ -46,22 +47,28 @@ public:
 	using NotificationBinding = std::tuple<jsonrpc::Procedure, AbstractNotificationPointer<I>>;
 	using Methods = std::vector<MethodBinding>;
 	using Notifications = std::vector<NotificationBinding>;
+	using StreamingMethods = std::vector<std::pair<std::string, dev::rpc::StreamingMethod>>;
 	struct RPCModule { std::string name; std::string version; };
 	using RPCModules = std::vector<RPCModule>;
 
 	virtual ~ServerInterface() {}
 	Methods const& methods() const { return m_methods; }
 	Notifications const& notifications() const { return m_notifications; }
+	/// @returns the methods whose results are also written without building a Json::Value.
+	StreamingMethods const& streamingMethods() const { return m_streamingMethods; }
 	/// @returns which interfaces (eth, admin, db, ...) this class implements in which version.
 	virtual RPCModules implementedModules() const = 0;
 
 protected:
 	void bindAndAddMethod(jsonrpc::Procedure const& _proc, MethodPointer _pointer) { m_methods.emplace_back(_proc, _pointer); }
 	void bindAndAddNotification(jsonrpc::Procedure const& _proc, NotificationPointer _pointer) { m_notifications.emplace_back(_proc, _pointer); }
+	/// Has @a _method write the results of the already bound method @a _name when it can.
+	void bindStreamingMethod(std::string const& _name, dev::rpc::StreamingMethod const& _method) { m_streamingMethods.emplace_back(_name, _method); }
 
 private:
 	Methods m_methods;
 	Notifications m_notifications;
+	StreamingMethods m_streamingMethods;
 };
 
 template <class... Is>
@@ -69,7 +76,8 @@ class ModularServer: public jsonrpc::IProcedureInvokationHandler
 {
 public:
 	ModularServer()
-	: m_handler(jsonrpc::RequestHandlerFactory::createProtocolHandler(jsonrpc::JSONRPC_SERVER_V2, *this))
+	: m_handler(jsonrpc::RequestHandlerFactory::createProtocolHandler(jsonrpc::JSONRPC_SERVER_V2, *this)),
+	  m_batchHandler(new dev::rpc::BatchRequestHandler(*m_handler))
 	{
 		m_handler->AddProcedure(jsonrpc::Procedure("rpc_modules", jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT, NULL));
 		m_implementedModules = Json::objectValue;
@@ -110,7 +118,7 @@ public:
 	unsigned addConnector(jsonrpc::AbstractServerConnector* _connector)
 	{
 		m_connectors.emplace_back(_connector);
-		_connector->SetHandler(m_handler.get());
+		_connector->SetHandler(m_batchHandler.get());
 		return m_connectors.size() - 1;
 	}
 
@@ -119,9 +127,13 @@ public:
 		return m_connectors.at(_i).get();
 	}
 
+	/// Sets how many requests of one batch may be handled at once.
+	void setBatchConcurrency(unsigned _concurrency) { m_batchHandler->setBatchConcurrency(_concurrency); }
+
 protected:
 	std::vector<std::unique_ptr<jsonrpc::AbstractServerConnector>> m_connectors;
 	std::unique_ptr<jsonrpc::IProtocolHandler> m_handler;
+	std::unique_ptr<dev::rpc::BatchRequestHandler> m_batchHandler;	///< What the connectors hand requests to.
 	/// Mapping for implemented modules, to be filled by subclasses during construction.
 	Json::Value m_implementedModules;
 };
@@ -148,6 +160,9 @@ public:
 			m_notifications[std::get<0>(notification).GetProcedureName()] = std::get<1>(notification);
 			this->m_handler->AddProcedure(std::get<0>(notification));
 		}
+
+		for (auto const& method: m_interface->streamingMethods())
+			this->m_batchHandler->addStreamingMethod(method.first, method.second);
 		// Store module with version.
 		for (auto const& module: m_interface->implementedModules())
 			this->m_implementedModules[module.name] = module.version;
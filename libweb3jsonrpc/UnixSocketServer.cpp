@@ -22,29 +22,25 @@ along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
 #if !defined(_WIN32)
 
 #include "UnixSocketServer.h"
-#include <sys/socket.h>
-#include <fcntl.h>
+#include <array>
+#include <sys/un.h>
 #include <unistd.h>
-#include <libdevcore/Guards.h>
+#include <libdevcore/Common.h>
 #include <libdevcore/FileSystem.h>
 #include <boost/filesystem/path.hpp>
 
-// "Mac OS X does not support the flag MSG_NOSIGNAL but we have an equivalent."
-// See http://lists.apple.com/archives/macnetworkprog/2002/Dec/msg00091.html
-#if defined(__APPLE__)
-	#if !defined(MSG_NOSIGNAL)
-		#define MSG_NOSIGNAL SO_NOSIGPIPE
-	#endif
-#endif
-
 using namespace std;
 using namespace jsonrpc;
 using namespace dev;
+namespace ba = boost::asio;
 namespace fs = boost::filesystem;
 
 namespace
 {
 size_t const c_socketPathMaxLength = sizeof(sockaddr_un::sun_path) / sizeof(sockaddr_un::sun_path[0]);
+size_t const c_readBufferSize = 16 * 1024;
+chrono::milliseconds const c_minAcceptBackoff{10};		///< First wait after accepting failed.
+chrono::milliseconds const c_maxAcceptBackoff{1000};	///< Longest wait while accepting keeps failing.
 
 fs::path getIpcPathOrDataDir()
 {
@@ -56,8 +52,21 @@ fs::path getIpcPathOrDataDir()
 }
 }
 
+struct UnixDomainSocketServer::Connection
+{
+	explicit Connection(ba::io_service& _ioService): socket(_ioService), strand(_ioService) {}
+
+	ba::local::stream_protocol::socket socket;
+	ba::io_service::strand strand;		///< Keeps the reads, the writes and the closing of the socket apart.
+	std::array<char, c_readBufferSize> buffer;
+	IpcRequestFramer framer;
+	std::string responses;				///< Answers to the requests of the last read, written together.
+};
+
 UnixDomainSocketServer::UnixDomainSocketServer(string const& _appId):
-	IpcServerBase((getIpcPathOrDataDir() / fs::path(_appId + ".ipc")).string().substr(0, c_socketPathMaxLength))
+	m_path((getIpcPathOrDataDir() / fs::path(_appId + ".ipc")).string().substr(0, c_socketPathMaxLength)),
+	m_strand(m_ioService),
+	m_retry(m_ioService)
 {
 }
 
@@ -68,82 +77,190 @@ UnixDomainSocketServer::~UnixDomainSocketServer()
 
 bool UnixDomainSocketServer::StartListening()
 {
-	if (!m_running)
-	{
-		if (access(m_path.c_str(), F_OK) != -1)
-			unlink(m_path.c_str());
+	if (m_running)
+		return false;
 
-		if (access(m_path.c_str(), F_OK) != -1)
-			return false;
+	if (access(m_path.c_str(), F_OK) != -1)
+		unlink(m_path.c_str());
 
-		m_socket = socket(PF_UNIX, SOCK_STREAM, 0);
-		memset(&(m_address), 0, sizeof(sockaddr_un));
-		m_address.sun_family = AF_UNIX;
-#ifdef __APPLE__
-		m_address.sun_len = m_path.size() + 1;
-#endif
-		strncpy(m_address.sun_path, m_path.c_str(), c_socketPathMaxLength);
-		::bind(m_socket, reinterpret_cast<sockaddr*>(&m_address), sizeof(sockaddr_un));
-		listen(m_socket, 128);
+	if (access(m_path.c_str(), F_OK) != -1)
+		return false;
+
+	boost::system::error_code ec;
+	ba::local::stream_protocol::endpoint const endpoint(m_path);
+	m_ioService.reset();
+	m_acceptor.reset(new ba::local::stream_protocol::acceptor(m_ioService));
+	m_acceptor->open(endpoint.protocol(), ec);
+	if (!ec)
+		m_acceptor->bind(endpoint, ec);
+	if (!ec)
+		m_acceptor->listen(128, ec);
+	if (ec)
+	{
+		cwarn << "Cannot listen on" << m_path << ":" << ec.message();
+		m_acceptor.reset();
+		return false;
 	}
-	return IpcServerBase::StartListening();
+
+	m_running = true;
+	m_backoff = chrono::milliseconds(0);
+	m_requests.reset(new ba::thread_pool(c_requestThreads));
+	m_work.reset(new ba::io_service::work(m_ioService));
+	m_strand.post([this]() { accept(); });
+	unsigned const workers = max(2u, min(thread::hardware_concurrency(), c_maxWorkers));
+	for (unsigned i = 0; i < workers; ++i)
+		m_workers.emplace_back([this]()
+		{
+			setThreadName("ipc");
+			while (true)
+				try
+				{
+					m_ioService.run();
+					break;
+				}
+				catch (std::exception const& _e)
+				{
+					cwarn << "Exception serving IPC:" << _e.what();
+				}
+		});
+	return true;
 }
 
 bool UnixDomainSocketServer::StopListening()
 {
-	shutdown(m_socket, SHUT_RDWR);
-	close(m_socket);
-	m_socket = -1;
-	if (IpcServerBase::StopListening())
+	DEV_GUARDED(x_connections)
 	{
-		unlink(m_path.c_str());
-		return true;
+		if (!m_running)
+			return false;
+		m_running = false;
+
+		// Closing cancels what is outstanding; once the handlers have run, the workers return.
+		m_strand.post([this]() { boost::system::error_code ec; m_acceptor->close(ec); m_retry.cancel(ec); });
+		for (auto const& c: m_connections)
+		{
+			shared_ptr<Connection> connection = c.second;
+			connection->strand.post([connection]() { boost::system::error_code ec; connection->socket.close(ec); });
+		}
 	}
-	return false;
+	// Requests being handled still hand their responses back to the event loop, so they finish first.
+	m_requests->join();
+	m_requests.reset();
+	m_work.reset();
+	for (auto& w: m_workers)
+		w.join();
+	m_workers.clear();
+	DEV_GUARDED(x_connections)
+		m_connections.clear();
+	m_acceptor.reset();
+	unlink(m_path.c_str());
+	return true;
 }
 
-void UnixDomainSocketServer::Listen()
+void UnixDomainSocketServer::accept()
 {
-	socklen_t addressLen = sizeof(m_address);
-	while (m_running)
+	auto connection = make_shared<Connection>(m_ioService);
+	m_acceptor->async_accept(connection->socket, m_strand.wrap([this, connection](boost::system::error_code const& _ec)
 	{
-		int connection = accept(m_socket, (sockaddr*) &(m_address), &addressLen);
-		if (connection > 0)
-		{
-			DEV_GUARDED(x_sockets)
-				m_sockets.insert(connection);
+		onAccept(_ec, connection);
+	}));
+}
 
-			// Handle the request in a new detached thread.
-			std::thread{[this, connection]
+void UnixDomainSocketServer::onAccept(boost::system::error_code const& _ec, shared_ptr<Connection> const& _c)
+{
+	if (_ec == ba::error::operation_aborted || !m_acceptor->is_open())
+		return;
+	if (!_ec || _ec == ba::error::connection_aborted)
+	{
+		// Only the client gave up, if anything; the next one may be accepted at once.
+		if (!_ec)
+		{
+			DEV_GUARDED(x_connections)
 			{
-				GenerateResponse(connection);
-				CloseConnection(connection);
-			}}.detach();
+				if (!m_running)
+					return;
+				m_connections[_c.get()] = _c;
+			}
+			_c->strand.post([this, _c]() { read(_c); });
 		}
+		m_backoff = chrono::milliseconds(0);
+		accept();
+		return;
 	}
+
+	// Out of descriptors or memory, say: accepting again at once would only fail again.
+	m_backoff = min(max(m_backoff * 2, c_minAcceptBackoff), c_maxAcceptBackoff);
+	cwarn << "Cannot accept IPC connections:" << _ec.message() << "- retrying in" << m_backoff.count() << "ms";
+	m_retry.expires_after(m_backoff);
+	m_retry.async_wait(m_strand.wrap([this](boost::system::error_code const& _waited)
+	{
+		if (!_waited && m_acceptor->is_open())
+			accept();
+	}));
 }
 
-void UnixDomainSocketServer::CloseConnection(int _socket)
+void UnixDomainSocketServer::read(shared_ptr<Connection> const& _c)
 {
-	shutdown(_socket, SHUT_RDWR);
-	close(_socket);
+	_c->socket.async_read_some(ba::buffer(_c->buffer), _c->strand.wrap([this, _c](boost::system::error_code const& _ec, size_t _size)
+	{
+		if (_ec)
+		{
+			drop(_c.get());
+			return;
+		}
+		auto requests = make_shared<vector<string>>();
+		_c->framer.feed(_c->buffer.data(), _size, [&](string const& _request) { requests->push_back(_request); });
+		if (requests->empty())
+		{
+			read(_c);
+			return;
+		}
+		// The next read is only started once these are answered, so a connection is served in order.
+		ba::post(*m_requests, [this, _c, requests]()
+		{
+			for (string const& request: *requests)
+			{
+				cipcr << request;
+				OnRequest(request, _c.get());
+			}
+			_c->strand.post([this, _c]() { write(_c); });
+		});
+	}));
 }
 
+void UnixDomainSocketServer::write(shared_ptr<Connection> const& _c)
+{
+	if (_c->responses.empty())
+	{
+		read(_c);
+		return;
+	}
+	// Nothing is added to the responses until the next read, so they are written from where they are.
+	ba::async_write(_c->socket, ba::buffer(_c->responses), _c->strand.wrap([this, _c](boost::system::error_code const& _ec, size_t)
+	{
+		_c->responses.clear();
+		if (_ec)
+			drop(_c.get());
+		else
+			read(_c);
+	}));
+}
 
-size_t UnixDomainSocketServer::Write(int _connection, string const& _data)
+void UnixDomainSocketServer::drop(Connection* _c)
 {
-	ssize_t r = send(_connection, _data.data(), _data.size(), MSG_NOSIGNAL);
-	if (r < 0)
-		return 0;
-	return static_cast<size_t>(r);
+	boost::system::error_code ec;
+	_c->socket.close(ec);
+	DEV_GUARDED(x_connections)
+		m_connections.erase(_c);
 }
 
-size_t UnixDomainSocketServer::Read(int _connection, void* _data, size_t _size)
+bool UnixDomainSocketServer::SendResponse(string const& _response, void* _addInfo)
 {
-	ssize_t r = read(_connection, _data, _size);
-	if (r < 0)
-		return 0;
-	return static_cast<size_t>(r);
+	// Only called while the requests of one read of the connection are handled, one after the
+	// other; the responses are written once all of them are answered, in one go.
+	auto c = static_cast<Connection*>(_addInfo);
+	c->responses += _response;
+	cipcs << _response;
+	return true;
 }
 
 #endif
@@ -23,29 +23,66 @@ along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
 
 #if !defined(_WIN32)
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <thread>
-#include <sys/un.h>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio.hpp>
+#include <libdevcore/Guards.h>
 #include "IpcServerBase.h"
 
 namespace dev
 {
-class UnixDomainSocketServer: public IpcServerBase<int>
+
+/**
+ * @brief Serves JSON-RPC on a Unix domain socket from a fixed pool of threads.
+ *
+ * The connections are driven by an asio event loop that the threads of the pool run, so the
+ * number of threads does not grow with the number of clients. The requests of a connection
+ * are handled one after the other, in the order they arrive; those of different connections
+ * at once. The requests are split out of the reads as they arrive and handled on a separate
+ * pool, so slow methods do not hold up the I/O of other connections; the responses to those
+ * of one read are gathered and written together, asynchronously.
+ */
+class UnixDomainSocketServer: public jsonrpc::AbstractServerConnector
 {
 public:
 	UnixDomainSocketServer(std::string const& _appId);
 	~UnixDomainSocketServer();
 	bool StartListening() override;
 	bool StopListening() override;
+	bool SendResponse(std::string const& _response, void* _addInfo = nullptr) override;
+
+	std::string const& path() const { return m_path; }
+
+	static const unsigned c_maxWorkers = 8;	///< Most threads serving the connections.
+	static const unsigned c_requestThreads = 8;	///< Threads handling requests, which may block.
+
+private:
+	struct Connection;
+
+	void accept();
+	void onAccept(boost::system::error_code const& _ec, std::shared_ptr<Connection> const& _c);
+	void read(std::shared_ptr<Connection> const& _c);
+	void write(std::shared_ptr<Connection> const& _c);
+	void drop(Connection* _c);
+
+	std::string m_path;
+	bool m_running = false;
 
-protected:
-	void Listen() override;
-	void CloseConnection(int _socket) override;
-	size_t Write(int _connection, std::string const& _data) override;
-	size_t Read(int _connection, void* _data, size_t _size) override;
+	boost::asio::io_service m_ioService;
+	boost::asio::io_service::strand m_strand;	///< Keeps the acceptor to one thread at a time.
+	std::unique_ptr<boost::asio::io_service::work> m_work;
+	std::unique_ptr<boost::asio::local::stream_protocol::acceptor> m_acceptor;
+	boost::asio::steady_timer m_retry;			///< Delays accepting again while it keeps failing.
+	std::chrono::milliseconds m_backoff{0};
+	std::vector<std::thread> m_workers;
+	std::unique_ptr<boost::asio::thread_pool> m_requests;
 
-	sockaddr_un m_address;
-	int m_socket = 0;
+	Mutex x_connections;					///< Lock on m_connections and m_running once listening.
+	std::unordered_map<Connection*, std::shared_ptr<Connection>> m_connections;
 };
 
 } // namespace dev
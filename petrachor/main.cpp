@@ -35,6 +35,9 @@
 #include <libevm/VMFactory.h>
 #include <libethcore/KeyManager.h>
 #include <libethereum/Defaults.h>
+#include <libethereum/ParallelExecutor.h>
+#include <libethereum/StoragePrefetcher.h>
+#include <libethereum/SnapshotExporter.h>
 #include <libethereum/SnapshotImporter.h>
 #include <libethereum/SnapshotStorage.h>
 #include <libethashseal/EthashClient.h>
@@ -101,11 +104,15 @@ void help()
 		<< "    --admin-via-http  Expose admin interface via http - UNSAFE! (default: off).\n"
 		<< "    --no-ipc  Disable IPC server.\n"
 		<< "    --json-rpc-port <n>  Specify JSON-RPC server port (implies '-j', default: " << SensibleHttpPort << ").\n"
+		<< "    --json-rpc-batch-concurrency <n>  Handle up to <n> read-only requests of a batch at once (default: " << rpc::BatchRequestHandler::c_defaultBatchConcurrency << ").\n"
 		<< "    --rpccorsdomain <domain>  Domain on which to send Access-Control-Allow-Origin header.\n"
 		<< "    --admin <password>  Specify admin session key for JSON-RPC (default: auto-generated and printed at start-up).\n"
 		<< "    -K,--kill  Kill the blockchain first.\n"
 		<< "    -R,--rebuild  Rebuild the blockchain from the existing database.\n"
-		<< "    --rescue  Attempt to rescue a corrupt database.\n\n"
+		<< "    --rescue  Attempt to rescue a corrupt database.\n"
+		<< "    --backfill-log-index  Index the logs of blocks imported before there was a log index and exit.\n"
+		<< "    --parallel-exec <n>  Execute block transactions speculatively on n threads during import (default: 0, off).\n"
+		<< "    --storage-prefetch  Learn the storage slots read by contract functions and prefetch them on later calls.\n\n"
 		<< "    --import-presale <file>  Import a pre-sale key; you'll need to specify the password to this key.\n"
 		<< "    -s,--import-secret <secret>  Import a secret key into the key store.\n"
 		<< "    --master <password>  Give the master password for the key store. Use --master \"\" to show a prompt.\n"
@@ -126,6 +133,10 @@ void help()
 		<< "    --no-bootstrap  Do not connect to the default Petrachor peer servers (default only when --no-discovery is used).\n"
 		<< "    -x,--peers <number>  Attempt to connect to a given number of peers (default: 11).\n"
 		<< "    --peer-stretch <number>  Give the accepted connection multiplier (default: 7).\n"
+		<< "    --network-threads <n>  Run network I/O on n threads (default: 1).\n"
+		<< "    --capability-threads <n>  Interpret peer messages on n threads instead of the network threads (default: 0).\n"
+		<< "    --fast-sync  When starting from genesis, download the state of a recent block instead of replaying every block.\n"
+		<< "    --snapshot-interval <n>  Write a warp snapshot of the chain into the data directory every n blocks (default: 0, disabled).\n"
 
 		<< "    --public-ip <ip>  Force advertised public IP to the given IP (default: auto).\n"
 		<< "    --listen-ip <ip>(:<port>)  Listen on the given IP for incoming connections (default: 0.0.0.0).\n"
@@ -153,6 +164,8 @@ void help()
 //		<< "    --only <n>  Equivalent to --export-from n --export-to n.\n"
 //		<< "    --dont-check  Prevent checking some block aspects. Faster importing, but to apply only when the data is known to be valid.\n\n"
 //		<< "    --import-snapshot <path>  Import blockchain and state data from the Parity Warp Sync snapshot." << endl
+		<< "Snapshot export:\n"
+		<< "    --export-snapshot <path>  Write a Parity Warp Sync snapshot of the block given by --to (default: latest) to path and exit.\n\n"
 		<< "General Options:\n"
 		<< "    -d,--db-path,--datadir <path>  Load database from path (default: " << getDataDir() << ").\n"
 #if ETH_EVMJIT
@@ -256,7 +269,9 @@ enum class OperationMode
 	Node,
 	Import,
 	ImportSnapshot,
-	Export
+	ExportSnapshot,
+	Export,
+	BackfillLogIndex
 };
 
 enum class Format
@@ -343,6 +358,7 @@ int main(int argc, char** argv)
 	NodeMode nodeMode = NodeMode::Full;
 
 	int jsonRPCURL = -1;
+	unsigned jsonRPCBatchConcurrency = rpc::BatchRequestHandler::c_defaultBatchConcurrency;
 	bool adminViaHttp = false;
 	bool ipc = true;
 	std::string rpcCorsDomain = "";
@@ -368,8 +384,12 @@ int main(int argc, char** argv)
 
 	unsigned peers = 11;
 	unsigned peerStretch = 7;
+	unsigned networkThreads = 1;
+	unsigned capabilityThreads = 0;
 	std::map<NodeID, pair<NodeIPEndpoint,bool>> preferredNodes;
 	bool bootstrap = true;
+	bool fastSync = false;
+	unsigned snapshotInterval = 0;
 	bool disableDiscovery = false;
 	bool pinning = false;
 	bool enableDiscovery = false;
@@ -662,6 +682,10 @@ int main(int argc, char** argv)
 			bootstrap = true;
 		else if (arg == "--no-bootstrap")
 			bootstrap = false;
+		else if (arg == "--fast-sync")
+			fastSync = true;
+		else if (arg == "--snapshot-interval" && i + 1 < argc)
+			snapshotInterval = max(0, atoi(argv[++i]));
 		else if (arg == "--no-discovery")
 		{
 			disableDiscovery = true;
@@ -684,6 +708,8 @@ int main(int argc, char** argv)
 			adminViaHttp = true;
 		else if (arg == "--json-rpc-port" && i + 1 < argc)
 			jsonRPCURL = atoi(argv[++i]);
+		else if (arg == "--json-rpc-batch-concurrency" && i + 1 < argc)
+			jsonRPCBatchConcurrency = max(1, atoi(argv[++i]));
 		else if (arg == "--rpccorsdomain" && i + 1 < argc)
 			rpcCorsDomain = argv[++i];
 		else if (arg == "--json-admin" && i + 1 < argc)
@@ -703,6 +729,10 @@ int main(int argc, char** argv)
 			peers = atoi(argv[++i]);
 		else if (arg == "--peer-stretch" && i + 1 < argc)
 			peerStretch = atoi(argv[++i]);
+		else if (arg == "--network-threads" && i + 1 < argc)
+			networkThreads = max(1, atoi(argv[++i]));
+		else if (arg == "--capability-threads" && i + 1 < argc)
+			capabilityThreads = max(0, atoi(argv[++i]));
 		else if (arg == "--peerset" && i + 1 < argc)
 		{
 			string peerset = argv[++i];
@@ -790,6 +820,20 @@ int main(int argc, char** argv)
 			}
 		}
 #endif
+		else if (arg == "--storage-prefetch")
+			StoragePrefetcher::instance().setEnabled(true);
+		else if (arg == "--parallel-exec" && i + 1 < argc)
+			try {
+				int const threads = stoi(argv[++i]);
+				if (threads < 0)
+					throw -1;
+				ParallelExecutor::setThreads(threads);
+			}
+			catch (...)
+			{
+				cerr << "Bad " << arg << " option: " << argv[i] << "\n";
+				return -1;
+			}
 		else if (arg == "--shh")
 			useWhisper = true;
 		else if (arg == "-h" || arg == "--help")
@@ -809,6 +853,13 @@ int main(int argc, char** argv)
 			mode = OperationMode::ImportSnapshot;
 			filename = argv[++i];
 		}
+		else if (arg == "--export-snapshot" && i + 1 < argc)
+		{
+			mode = OperationMode::ExportSnapshot;
+			filename = argv[++i];
+		}
+		else if (arg == "--backfill-log-index")
+			mode = OperationMode::BackfillLogIndex;
 		else
 		{
 			cerr << "Invalid argument: " << arg << "\n";
@@ -939,6 +990,8 @@ int main(int argc, char** argv)
 	auto netPrefs = publicIP.empty() ? NetworkPreferences(listenIP, listenPort, upnp) : NetworkPreferences(publicIP, listenIP ,listenPort, upnp);
 	netPrefs.discovery = (privateChain.empty() && !disableDiscovery) || enableDiscovery;
 	netPrefs.pin = (pinning || !privateChain.empty()) && !noPinning;
+	netPrefs.ioThreads = networkThreads;
+	netPrefs.capabilityThreads = capabilityThreads;
 
 	auto nodesState = contents(getDataDir() / fs::path("network.rlp"));
 	auto caps = useWhisper ? set<string>{"eth", "shh"} : set<string>{"eth"};
@@ -967,6 +1020,10 @@ int main(int argc, char** argv)
 
 	if (!extraData.empty())
 		web3.ethereum()->setExtraData(extraData);
+	if (fastSync)
+		web3.ethereum()->setFastSync(true);
+	if (snapshotInterval && mode == OperationMode::Node)
+		web3.ethereum()->setSnapshotInterval(snapshotInterval, getDataDir() / fs::path("snapshot"));
 
 	auto toNumber = [&](string const& s) -> unsigned {
 		if (s == "latest")
@@ -1003,6 +1060,40 @@ int main(int argc, char** argv)
 		return 0;
 	}
 
+	if (mode == OperationMode::ExportSnapshot)
+	{
+		try
+		{
+			BlockChain const& bc = web3.ethereum()->blockChain();
+			SnapshotExporter exporter(bc, web3.ethereum()->stateDB());
+			auto snapshotWriter(createSnapshotWriter(filename));
+			exporter.exportSnapshot(bc.numberHash(toNumber(exportTo)), *snapshotWriter);
+		}
+		catch (...)
+		{
+			cerr << "Error during exporting the snapshot: " << boost::current_exception_diagnostic_information() << endl;
+			return -1;
+		}
+		return 0;
+	}
+
+	if (mode == OperationMode::BackfillLogIndex)
+	{
+		unsigned const from = web3.ethereum()->blockChain().logIndexFrom();
+		if (!from)
+		{
+			cout << "The log index has every block already." << endl;
+			return 0;
+		}
+		cout << "Indexing the logs of blocks 0 to " << from - 1 << "..." << endl;
+		web3.ethereum()->backfillLogIndex([](unsigned _done, unsigned _total)
+		{
+			cout << "\r" << _done << " of " << _total << " blocks indexed." << flush;
+		});
+		cout << endl;
+		return 0;
+	}
+
 	if (mode == OperationMode::Import)
 	{
 		ifstream fin(filename, std::ifstream::binary);
@@ -1220,6 +1311,7 @@ int main(int argc, char** argv)
 			auto httpConnector = new SafeHttpServer(jsonRPCURL, "", "", SensibleHttpThreads);
 			httpConnector->setAllowedOrigin(rpcCorsDomain);
 			jsonrpcHttpServer->addConnector(httpConnector);
+			jsonrpcHttpServer->setBatchConcurrency(jsonRPCBatchConcurrency);
 			jsonrpcHttpServer->StartListening();
 		}
 		if (ipc)
@@ -1235,6 +1327,7 @@ int main(int argc, char** argv)
 			));
 			auto ipcConnector = new IpcServer("geth");
 			jsonrpcIpcServer->addConnector(ipcConnector);
+			jsonrpcIpcServer->setBatchConcurrency(jsonRPCBatchConcurrency);
 			ipcConnector->StartListening();
 		}
 
@@ -22,6 +22,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <libdevcrypto/BLS12_381.h>
+#include <libdevcrypto/Common.h>
 
 using namespace std;
 using namespace dev;
@@ -104,6 +105,50 @@ BOOST_AUTO_TEST_CASE(blsTest)
     BOOST_CHECK(!incorrectSEValid);
 }
 
+BOOST_AUTO_TEST_CASE(blsMultiExp)
+{
+    vector<G1> g1s;
+    vector<G2> g2s;
+    vector<Scalar> scalars;
+    G1 expected1 = G1::getZero();
+    G2 expected2 = G2::getZero();
+    for (unsigned i = 0; i < 40; ++i)
+    {
+        Scalar point = Scalar(sha3(toBigEndian(u256(i))));
+        Scalar scalar = Scalar(sha3(toBigEndian(u256(i + 1000))));
+        g1s.push_back(G1::getOne().mul(point));
+        g2s.push_back(G2::getOne().mul(point));
+        scalars.push_back(scalar);
+        expected1 = expected1.add(g1s.back().mul(scalar));
+        expected2 = expected2.add(g2s.back().mul(scalar));
+    }
+    BOOST_CHECK(G1::multiExp(g1s, scalars) == expected1);
+    BOOST_CHECK(G2::multiExp(g2s, scalars) == expected2);
+    BOOST_CHECK(G1::multiExp({}, {}) == G1::getZero());
+}
+
+BOOST_AUTO_TEST_CASE(blsAggregate)
+{
+    vector<BLS::Public> publicKeys;
+    vector<h256> hashes;
+    vector<BLS::Signature> signatures;
+    for (unsigned i = 0; i < 8; ++i)
+    {
+        h256 secretBytes = sha3(toBigEndian(u256(i + 1)));
+        secretBytes[0] = 0; // keep it below the group order
+        Scalar secret = Scalar(secretBytes);
+        publicKeys.push_back(toPublic<BLS>(secret));
+        hashes.push_back(sha3(toBigEndian(u256(i))));
+        signatures.push_back(dev::sign<BLS>(secret, hashes.back()));
+    }
+    BOOST_CHECK(BLS::aggregateVerify(publicKeys, hashes, BLS::aggregate(signatures)));
+    BOOST_CHECK(BLS::batchVerify(publicKeys, hashes, signatures));
+
+    swap(hashes[0], hashes[1]);
+    BOOST_CHECK(!BLS::aggregateVerify(publicKeys, hashes, BLS::aggregate(signatures)));
+    BOOST_CHECK(!BLS::batchVerify(publicKeys, hashes, signatures));
+}
+
 BOOST_AUTO_TEST_CASE(ecadd)
 {
 	// "0 + 0 == 0"
@@ -0,0 +1,201 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Header skeleton planning and header seal checks of block sync.
+
+#include <set>
+#include <thread>
+#include <libethcore/SealEngine.h>
+#include <libethereum/BlockChainSync.h>
+#include <libethereum/HeaderSkeleton.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+unsigned const c_step = HeaderSkeleton::c_step;
+
+/// Accepts every seal but that of one block number, noting what it was asked.
+class PickySealEngine: public NoProof
+{
+public:
+	explicit PickySealEngine(int64_t _reject = -1): m_reject(_reject) {}
+
+	bool verifyHeaderSeal(BlockHeader const& _bi, BlockHeader const& _parent) const override
+	{
+		Guard l(x_seen);
+		m_threads.insert(this_thread::get_id());
+		++m_checked;
+		if (_bi.number() > 0 && _parent.hash() == _bi.parentHash())
+			++m_withParent;
+		return _bi.number() != m_reject;
+	}
+
+	set<thread::id> threads() const { Guard l(x_seen); return m_threads; }
+	unsigned checked() const { Guard l(x_seen); return m_checked; }
+	unsigned withParent() const { Guard l(x_seen); return m_withParent; }
+
+private:
+	int64_t m_reject;
+	mutable Mutex x_seen;
+	mutable set<thread::id> m_threads;
+	mutable unsigned m_checked = 0;
+	mutable unsigned m_withParent = 0;
+};
+
+/// @returns a BlockHeaders payload of @a _count consecutive headers.
+bytes headers(unsigned _count)
+{
+	RLPStream s(_count);
+	h256 parent(1);
+	for (unsigned i = 0; i < _count; ++i)
+	{
+		BlockHeader h;
+		h.setNumber(i + 1);
+		h.setParentHash(parent);
+		h.setGasLimit(1000000);
+		h.streamRLP(s);
+		parent = h.hash();
+	}
+	return s.out();
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(BlockChainSyncTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(skeletonLayout)
+{
+	HeaderSkeleton skeleton;
+	// Not worth it for less than a step.
+	BOOST_CHECK(skeleton.request(100, 100 + c_step).empty());
+
+	vector<unsigned> const r = skeleton.request(100, 100 + c_step * 3 + 10);
+	BOOST_CHECK((r == vector<unsigned>{100 + c_step, 100 + c_step * 2, 100 + c_step * 3}));
+	BOOST_CHECK(skeleton.requested() == r);
+	// One request at a time.
+	BOOST_CHECK(skeleton.request(100, 100 + c_step * 10).empty());
+	BOOST_CHECK_EQUAL(skeleton.top(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(skeletonAtMostMaxHeaders)
+{
+	HeaderSkeleton skeleton;
+	vector<unsigned> const r = skeleton.request(0, c_step * (HeaderSkeleton::c_maxHeaders + 5));
+	BOOST_REQUIRE_EQUAL(r.size(), HeaderSkeleton::c_maxHeaders);
+	BOOST_CHECK_EQUAL(r.back(), c_step * HeaderSkeleton::c_maxHeaders);
+}
+
+BOOST_AUTO_TEST_CASE(failedSkeletonIsAskedAgain)
+{
+	HeaderSkeleton skeleton;
+	vector<unsigned> const r = skeleton.request(0, 10000);
+	skeleton.cancel();
+	BOOST_CHECK_EQUAL(skeleton.top(), 0);
+	BOOST_CHECK(skeleton.request(0, 10000) == r);
+
+	// Answered, but nothing was merged: rejected or not had by the peer.
+	skeleton.cancel();
+	skeleton.accept(r, [](unsigned) { return false; });
+	BOOST_CHECK_EQUAL(skeleton.top(), 0);
+	BOOST_CHECK(skeleton.request(0, 10000) == r);
+}
+
+BOOST_AUTO_TEST_CASE(skeletonGrowsByWhatWasMerged)
+{
+	HeaderSkeleton skeleton;
+	vector<unsigned> const r = skeleton.request(0, c_step * 6);
+	BOOST_REQUIRE_EQUAL(r.size(), 6);
+	skeleton.cancel();
+	// Headers 3 and 5 were merged, but 4 was not: the skeleton must not skip over it.
+	skeleton.accept(r, [&](unsigned _b) { return _b != r[3]; });
+	BOOST_CHECK_EQUAL(skeleton.top(), r[2]);
+
+	vector<unsigned> const again = skeleton.request(0, c_step * 6 + 1);
+	BOOST_CHECK_EQUAL(again.front(), r[3]);
+	skeleton.cancel();
+	skeleton.accept(again, [](unsigned) { return true; });
+	BOOST_CHECK_EQUAL(skeleton.top(), again.back());
+
+	// Starts again at the import once it has overtaken the skeleton.
+	skeleton.reset();
+	BOOST_CHECK_EQUAL(skeleton.request(c_step * 2, c_step * 4).front(), c_step * 3);
+}
+
+BOOST_AUTO_TEST_CASE(skeletonStaysWithinReachOfTheImport)
+{
+	HeaderSkeleton skeleton;
+	unsigned const highest = HeaderSkeleton::c_maxAhead * 2;
+	while (true)
+	{
+		vector<unsigned> const r = skeleton.request(0, highest);
+		if (r.empty())
+			break;
+		skeleton.cancel();
+		skeleton.accept(r, [](unsigned) { return true; });
+	}
+	BOOST_CHECK(skeleton.top() >= HeaderSkeleton::c_maxAhead);
+	BOOST_CHECK(skeleton.top() < HeaderSkeleton::c_maxAhead + c_step * HeaderSkeleton::c_maxHeaders);
+	BOOST_CHECK(!skeleton.request(skeleton.top() - HeaderSkeleton::c_maxAhead + 1, highest).empty());
+}
+
+BOOST_AUTO_TEST_CASE(sealsCheckedOnce)
+{
+	for (unsigned count: {1u, 15u, 16u, 200u})
+	{
+		bytes const payload = headers(count);
+		PickySealEngine engine;
+		BOOST_CHECK(BlockChainSync::verifyHeaderSeals(engine, RLP(payload)));
+		BOOST_CHECK_EQUAL(engine.checked(), count);
+		BOOST_CHECK_EQUAL(engine.withParent(), count - 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(badSealRejectsTheBatch)
+{
+	bytes const payload = headers(500);
+	for (int64_t reject: {1, 250, 500})
+	{
+		PickySealEngine engine(reject);
+		BOOST_CHECK(!BlockChainSync::verifyHeaderSeals(engine, RLP(payload)));
+	}
+	bytes const garbage = rlpList(rlpList(1, 2, 3));
+	PickySealEngine engine;
+	BOOST_CHECK(!BlockChainSync::verifyHeaderSeals(engine, RLP(garbage)));
+}
+
+BOOST_AUTO_TEST_CASE(sealChecksReuseThreads)
+{
+	bytes const payload = headers(2000);
+	set<thread::id> seen;
+	for (unsigned i = 0; i < 10; ++i)
+	{
+		PickySealEngine engine;
+		BOOST_REQUIRE(BlockChainSync::verifyHeaderSeals(engine, RLP(payload)));
+		for (auto const& t: engine.threads())
+			seen.insert(t);
+	}
+	// The caller and at most one pool thread per core, however many batches.
+	BOOST_CHECK(seen.size() <= max(thread::hardware_concurrency(), 1u) + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Rebuilding blocks relayed in compact form.
+
+#include <libdevcore/TrieHash.h>
+#include <libethcore/BlockHeader.h>
+#include <libethereum/CompactBlock.h>
+#include <libethereum/TransactionQueue.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+class CompactBlockFixture: public TestOutputHelper
+{
+public:
+	CompactBlockFixture()
+	{
+		for (unsigned i = 0; i < 3; ++i)
+			transactions.push_back(Transaction(i, 1, 21000, Address(0x1001), bytes(), 0, AccountKeys::Pair::create().secret()));
+
+		vector<bytes> rlps;
+		for (Transaction const& t: transactions)
+			rlps.push_back(t.rlp());
+		header.setNumber(1);
+		header.setGasLimit(1000000);
+		header.setRoots(orderedTrieRoot(rlps), EmptyTrie, EmptyListSHA3, EmptyTrie);
+
+		RLPStream b(3);
+		header.streamRLP(b);
+		b.appendList(rlps.size());
+		for (bytes const& t: rlps)
+			b.appendRaw(t);
+		b.appendRaw(rlpList());
+		block = b.out();
+
+		RLPStream c(c_compactBlockItems + 1);
+		streamCompactBlock(c, &block);
+		c << totalDifficulty;
+		compact = c.out();
+	}
+
+	/// @returns the NewBlock payload the assembled block should be handed out as.
+	bytes newBlock() const
+	{
+		RLPStream ret(2);
+		ret.appendRaw(block).append(totalDifficulty);
+		return ret.out();
+	}
+
+	static bytes list(vector<Transaction> const& _transactions)
+	{
+		RLPStream ret(_transactions.size());
+		for (Transaction const& t: _transactions)
+			ret.appendRaw(t.rlp());
+		return ret.out();
+	}
+
+	TransactionQueue tq;
+	vector<Transaction> transactions;
+	BlockHeader header;
+	u256 const totalDifficulty = 1000;
+	bytes block;
+	bytes compact;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(CompactBlockTests, CompactBlockFixture)
+
+BOOST_AUTO_TEST_CASE(completeFromQueue)
+{
+	for (Transaction const& t: transactions)
+		tq.import(t);
+	CompactBlockAssembler assembler(tq);
+	BOOST_CHECK(assembler.assemble(header, RLP(compact)).empty());
+	BOOST_CHECK(assembler.take(header.hash()) == newBlock());
+	// Handed out only once.
+	BOOST_CHECK(assembler.take(header.hash()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(asksForMissingTransactions)
+{
+	tq.import(transactions[0]);
+	tq.import(transactions[2]);
+	CompactBlockAssembler assembler(tq);
+	BOOST_CHECK(assembler.assemble(header, RLP(compact)) == vector<unsigned>{1});
+	BOOST_CHECK(assembler.take(header.hash()).empty());
+	// Announced again while assembling.
+	BOOST_CHECK(assembler.assemble(header, RLP(compact)).empty());
+
+	bytes const missing = list({transactions[1]});
+	BOOST_CHECK(assembler.supply(header.hash(), RLP(missing)) == CompactBlockStatus::Complete);
+	BOOST_CHECK(assembler.take(header.hash()) == newBlock());
+}
+
+BOOST_AUTO_TEST_CASE(rejectsWrongTransactions)
+{
+	CompactBlockAssembler assembler(tq);
+	BOOST_CHECK((assembler.assemble(header, RLP(compact)) == vector<unsigned>{0, 1, 2}));
+
+	bytes const wrong = list({transactions[0], transactions[2], transactions[1]});
+	BOOST_CHECK(assembler.supply(header.hash(), RLP(wrong)) == CompactBlockStatus::Invalid);
+	bytes const right = list(transactions);
+	BOOST_CHECK(assembler.supply(header.hash(), RLP(right)) == CompactBlockStatus::Unknown);
+	BOOST_CHECK(assembler.take(header.hash()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(tooFewTransactionsForgetTheBlock)
+{
+	tq.import(transactions[1]);
+	CompactBlockAssembler assembler(tq);
+	BOOST_CHECK((assembler.assemble(header, RLP(compact)) == vector<unsigned>{0, 2}));
+	bytes const some = list({transactions[0]});
+	BOOST_CHECK(assembler.supply(header.hash(), RLP(some)) == CompactBlockStatus::Unknown);
+	BOOST_CHECK(assembler.take(header.hash()).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
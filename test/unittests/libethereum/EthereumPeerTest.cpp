@@ -87,6 +87,8 @@ public:
 
 	void onPeerTransactions(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
+	void onPeerTransactionHashes(std::shared_ptr<EthereumPeer>, h256s const&) override {}
+
 	void onPeerBlockHeaders(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
 	void onPeerBlockBodies(std::shared_ptr<EthereumPeer>, RLP const&) override {}
@@ -99,6 +101,10 @@ public:
 
 	void onPeerReceipts(std::shared_ptr<EthereumPeer>, RLP const&) override {}
 
+	void onPeerCompactBlock(std::shared_ptr<EthereumPeer>, RLP const&) override {}
+
+	void onPeerBlockTransactions(std::shared_ptr<EthereumPeer>, RLP const&) override {}
+
 	void onPeerAborting() override {}
 };
 
@@ -185,4 +191,42 @@ BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestReceipts)
 	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[2]), blockHash2);
 }
 
+BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestPooledTransactions)
+{
+	h256 txHash0("0x949d991d685738352398dff73219ab19c62c06e6f8ce899fbae755d5127ed1ef");
+	h256 txHash1("0x0e4562a10381dec21b205ed72637e6b1b523bdd0e4d4d50af5cd23dd4500a217");
+	peer.requestPooledTransactions({ txHash0, txHash1 });
+
+	uint8_t code = static_cast<uint8_t>(session->m_bytesSent[0]);
+	BOOST_REQUIRE_EQUAL(code, offset + 0x09);
+
+	bytes payloadSent(session->m_bytesSent.begin() + 1, session->m_bytesSent.end());
+	RLP rlp(payloadSent);
+	BOOST_REQUIRE_EQUAL(rlp.itemCount(), 2);
+	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[0]), txHash0);
+	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[1]), txHash1);
+}
+
+BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestBlockTransactions)
+{
+	h256 blockHash("0x949d991d685738352398dff73219ab19c62c06e6f8ce899fbae755d5127ed1ef");
+	peer.requestBlockTransactions(blockHash, { 0, 3, 7 });
+
+	uint8_t code = static_cast<uint8_t>(session->m_bytesSent[0]);
+	BOOST_REQUIRE_EQUAL(code, offset + 0x0c);
+
+	bytes payloadSent(session->m_bytesSent.begin() + 1, session->m_bytesSent.end());
+	RLP rlp(payloadSent);
+	BOOST_REQUIRE_EQUAL(rlp.itemCount(), 2);
+	BOOST_REQUIRE_EQUAL(static_cast<h256>(rlp[0]), blockHash);
+	BOOST_REQUIRE(rlp[1].toVector<unsigned>() == vector<unsigned>({ 0, 3, 7 }));
+}
+
+BOOST_AUTO_TEST_CASE(EthereumPeerSuite_requestPooledTransactionsKeepsAskNote)
+{
+	peer.requestPooledTransactions({ h256("0x949d991d685738352398dff73219ab19c62c06e6f8ce899fbae755d5127ed1ef") });
+
+	BOOST_REQUIRE(session->m_notes["ask"] == "State");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
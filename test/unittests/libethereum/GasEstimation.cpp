@@ -0,0 +1,186 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// The parallel gas search must find what a serial binary search finds.
+
+#include <libethashseal/GenesisInfo.h>
+#include <libethereum/ChainParams.h>
+#include <libethereum/ClientBase.h>
+#include <libethereum/State.h>
+#include <test/tools/libtesteth/TestHelper.h>
+#include <test/tools/libtestutils/TestLastBlockHashes.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+/// Clears storage slots 0 to 4, earning a refund for each.
+bytes const c_clearCode = fromHex("6000600055" "6000600155" "6000600255" "6000600355" "6000600455");
+/// Sets storage slot 0 of a fresh account.
+bytes const c_storeCode = fromHex("6001600055");
+/// Calls 0x0b0b with all its gas and jumps nowhere if that call failed.
+bytes const c_callCode = fromHex("60006000600060006000730000000000000000000000000000000000000b0b5af11560ff5700");
+/// Never stops.
+bytes const c_loopCode = fromHex("5b600056");
+
+class GasEstimationFixture: public TestOutputHelper
+{
+public:
+	GasEstimationFixture():
+		params(genesisInfo(eth::Network::ByzantiumTest)),
+		sealEngine(params.createSealEngine()),
+		lastHashes({})
+	{
+		header.setNumber(1);
+		header.setTimestamp(1);
+		header.setGasLimit(10000000);
+		State s(0);
+		install(s, clearer, c_clearCode);
+		for (unsigned i = 0; i < 5; ++i)
+			s.setStorage(clearer, i, 1);
+		install(s, caller, c_callCode);
+		install(s, Address(0x0b0b), c_storeCode);
+		install(s, looper, c_loopCode);
+		s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+		base = make_shared<State const>(s);
+	}
+
+	/// Runs a call to @a _dest on its own layer, as ClientBase::estimateGas() does.
+	GasProbe probe(Address const& _dest) const
+	{
+		return [this, _dest](int64_t _gas)
+		{
+			Transaction t(0, 1, _gas, _dest, bytes(), 0);
+			t.forceSender(sender);
+			EnvInfo const env(header, lastHashes, 0, _gas, params.chainID);
+			State s = State::layered(base);
+			s.addBalance(sender, t.gas() * t.gasPrice());
+			return s.execute(env, *sealEngine, t, Permanence::Reverted).first;
+		};
+	}
+
+	/// The binary search ClientBase::estimateGas() did before it probed in parallel.
+	static pair<int64_t, ExecutionResult> serialSearch(GasProbe const& _probe, int64_t _lowerBound, int64_t _upperBound)
+	{
+		ExecutionResult er;
+		ExecutionResult lastGood;
+		bool good = false;
+		while (_upperBound != _lowerBound)
+		{
+			int64_t mid = (_lowerBound + _upperBound) / 2;
+			er = _probe(mid);
+			if (!enoughGas(er))
+				_lowerBound = _lowerBound == mid ? _upperBound : mid;
+			else
+			{
+				lastGood = er;
+				_upperBound = _upperBound == mid ? _lowerBound : mid;
+				good = true;
+			}
+		}
+		return make_pair(_upperBound, good ? lastGood : er);
+	}
+
+	void checkMatchesSerial(Address const& _dest, int64_t _upperBound)
+	{
+		int64_t const lowerBound = Transaction::baseGasRequired(false, bytesConstRef(), EVMSchedule());
+		auto const expected = serialSearch(probe(_dest), lowerBound, _upperBound);
+		auto const found = searchGas(probe(_dest), lowerBound, _upperBound);
+		BOOST_CHECK_EQUAL(found.first, expected.first);
+		BOOST_REQUIRE_EQUAL(enoughGas(found.second), enoughGas(expected.second));
+		// Failed probes use all the gas they were given, which differs between the searches.
+		if (enoughGas(expected.second))
+		{
+			BOOST_CHECK_EQUAL(found.second.gasUsed, expected.second.gasUsed);
+			BOOST_CHECK_EQUAL(found.second.gasRefunded, expected.second.gasRefunded);
+		}
+	}
+
+	static void install(State& _s, Address const& _a, bytes const& _code)
+	{
+		_s.createContract(_a);
+		_s.setCode(_a, bytes(_code), 0);
+	}
+
+	ChainParams params;
+	unique_ptr<SealEngineFace> sealEngine;
+	TestLastBlockHashes lastHashes;
+	BlockHeader header;
+	shared_ptr<State const> base;
+	Address const sender{0x5e4d};
+	Address const clearer{0xc1ea};
+	Address const caller{0xca11};
+	Address const looper{0x1009};
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(GasEstimationTests, GasEstimationFixture)
+
+BOOST_AUTO_TEST_CASE(plainTransfer)
+{
+	checkMatchesSerial(Address(0x1001), 1000000);
+}
+
+BOOST_AUTO_TEST_CASE(refundHeavyCall)
+{
+	checkMatchesSerial(clearer, 1000000);
+	// The refund brings the gas used well below what the call needs.
+	auto const found = searchGas(probe(clearer), 21000, 1000000);
+	BOOST_CHECK(found.second.gasRefunded > 0);
+	BOOST_CHECK(found.first > int64_t(found.second.gasUsed));
+}
+
+BOOST_AUTO_TEST_CASE(callBoundBy63of64)
+{
+	checkMatchesSerial(caller, 1000000);
+	// The outer call keeps a 64th back, so more is needed than the inner call consumes.
+	auto const found = searchGas(probe(caller), 21000, 1000000);
+	BOOST_CHECK(enoughGas(found.second));
+	BOOST_CHECK(enoughGas(probe(caller)(found.first)));
+	BOOST_CHECK(!enoughGas(probe(caller)(found.first - 1)));
+	BOOST_CHECK(found.first > int64_t(found.second.gasUsed));
+}
+
+BOOST_AUTO_TEST_CASE(outOfGasAtUpperBound)
+{
+	checkMatchesSerial(looper, 100000);
+	vector<GasEstimationProgress> progress;
+	auto const found = searchGas(probe(looper), 21000, 100000, [&](GasEstimationProgress const& _p) { progress.push_back(_p); });
+	BOOST_CHECK_EQUAL(found.first, 100000);
+	BOOST_CHECK(!enoughGas(found.second));
+	BOOST_REQUIRE_EQUAL(progress.size(), 1);
+	BOOST_CHECK_EQUAL(progress[0].upperBound, 100000);
+}
+
+BOOST_AUTO_TEST_CASE(probeExceptionsReachTheCaller)
+{
+	GasProbe const inner = probe(clearer);
+	GasProbe const throwing = [&](int64_t _gas)
+	{
+		if (_gas < 100000)
+			BOOST_THROW_EXCEPTION(OutOfGas());
+		return inner(_gas);
+	};
+	BOOST_CHECK_THROW(searchGas(throwing, 21000, 1000000), OutOfGas);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
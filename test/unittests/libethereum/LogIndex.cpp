@@ -0,0 +1,75 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for finding the blocks and transactions with logs of given addresses and topics.
+
+#include <libdevcore/TransientDirectory.h>
+#include <libethereum/LogFilter.h>
+#include <libethereum/LogIndex.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(LogIndexTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(findsTransactionsWithMatchingLogs)
+{
+	TransientDirectory dir;
+	ldb::Options o;
+	o.create_if_missing = true;
+	ldb::DB* db = nullptr;
+	ldb::DB::Open(o, dir.path(), &db);
+	BOOST_REQUIRE(db);
+	unique_ptr<ldb::DB> holder(db);
+
+	Address const a(1);
+	Address const b(2);
+	h256 const t(3);
+	h256 const u(4);
+	auto receipt = [](LogEntries const& _logs) { return TransactionReceipt(h256(), 0, _logs); };
+	auto hashOf = [](unsigned _n) { return h256(10 + _n); };
+
+	ldb::WriteBatch batch;
+	LogIndex::write(batch, 1, hashOf(1), {receipt({LogEntry(a, h256s{t}, bytes())}), receipt({LogEntry(b, h256s{u}, bytes())})});
+	LogIndex::write(batch, 2, hashOf(2), {receipt({LogEntry(b, h256s{t}, bytes())})});
+	// A block that is no longer canonical.
+	LogIndex::write(batch, 3, h256(99), {receipt({LogEntry(a, h256s{t}, bytes())})});
+	LogIndex::write(batch, 5, hashOf(5), {receipt({}), receipt({LogEntry(a, h256s{u, t}, bytes())})});
+	db->Write(ldb::WriteOptions(), &batch);
+
+	using Candidates = vector<pair<unsigned, set<unsigned>>>;
+	auto candidates = [&](LogFilter const& _f, unsigned _earliest, unsigned _latest)
+	{
+		Candidates ret;
+		LogIndex::forEachCandidate(db, _f, _earliest, _latest, hashOf, [&](unsigned _n, h256 const&, set<unsigned> const& _t) { ret.emplace_back(_n, _t); });
+		return ret;
+	};
+
+	BOOST_CHECK(candidates(LogFilter().address(a), 0, 10) == Candidates({{1, {0}}, {5, {1}}}));
+	BOOST_CHECK(candidates(LogFilter().address(a), 2, 4) == Candidates());
+	BOOST_CHECK(candidates(LogFilter().topic(0, t), 0, 10) == Candidates({{1, {0}}, {2, {0}}}));
+	BOOST_CHECK(candidates(LogFilter().topic(1, t), 0, 10) == Candidates({{5, {1}}}));
+	BOOST_CHECK(candidates(LogFilter().address(a).address(b).topic(0, t), 0, 10) == Candidates({{1, {0}}, {2, {0}}}));
+	// In block 1, b and t are in different transactions.
+	BOOST_CHECK(candidates(LogFilter().address(b).topic(0, t), 0, 10) == Candidates({{2, {0}}}));
+	BOOST_CHECK(candidates(LogFilter().address(a).topic(0, u).topic(1, t), 0, 5) == Candidates({{5, {1}}}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,180 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Parallel execution of block transactions must match serial execution.
+
+#include <libethashseal/GenesisInfo.h>
+#include <libethereum/ChainParams.h>
+#include <libethereum/ParallelExecutor.h>
+#include <libethereum/State.h>
+#include <test/tools/libtesteth/TestHelper.h>
+#include <test/tools/libtestutils/TestLastBlockHashes.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+/// Increments storage slot 0 on every call.
+bytes const c_counterCode = fromHex("600054600101600055");
+
+class ParallelExecutorFixture: public TestOutputHelper
+{
+public:
+	ParallelExecutorFixture():
+		params(genesisInfo(eth::Network::ByzantiumTest)),
+		sealEngine(params.createSealEngine()),
+		lastHashes({})
+	{
+		header.setNumber(1);
+		header.setTimestamp(1);
+		header.setGasLimit(10000000);
+		header.setAuthor(Address(0xa11ce));
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			keys.push_back(AccountKeys::Pair::create());
+			base.addBalance(keys.back().address(), ether);
+		}
+		base.createContract(counter);
+		base.setCode(counter, bytes(c_counterCode), 0);
+		base.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	}
+
+	~ParallelExecutorFixture() { ParallelExecutor::setThreads(0); }
+
+	Transaction transfer(unsigned _from, u256 _nonce, Address const& _to) const
+	{
+		return Transaction(1000, 1, 21000, _to, bytes(), _nonce, keys[_from].secret());
+	}
+
+	Transaction count(unsigned _from, u256 _nonce) const
+	{
+		return Transaction(0, 1, 100000, counter, bytes(), _nonce, keys[_from].secret());
+	}
+
+	/// Execute @a _transactions one after the other, as Block::execute() does without parallel execution.
+	TransactionReceipts executeSerially(State& io_state, Transactions const& _transactions) const
+	{
+		TransactionReceipts receipts;
+		u256 gasUsed;
+		for (Transaction const& t: _transactions)
+		{
+			EnvInfo const envInfo(header, lastHashes, gasUsed, params.chainID);
+			receipts.push_back(io_state.execute(envInfo, *sealEngine, t, Permanence::Committed).second);
+			gasUsed = receipts.back().cumulativeGasUsed();
+		}
+		return receipts;
+	}
+
+	void checkMatchesSerial(Transactions const& _transactions)
+	{
+		checkMatchesSerial(base, _transactions);
+	}
+
+	void checkMatchesSerial(State const& _base, Transactions const& _transactions)
+	{
+		State serial(_base);
+		TransactionReceipts const expected = executeSerially(serial, _transactions);
+
+		ParallelExecutor::setThreads(4);
+		BOOST_REQUIRE(ParallelExecutor::applies(header, *sealEngine, _transactions.size()));
+		State parallel(_base);
+		TransactionReceipts const receipts = ParallelExecutor::execute(parallel, header, lastHashes, *sealEngine, _transactions);
+
+		BOOST_CHECK_EQUAL(parallel.rootHash(), serial.rootHash());
+		BOOST_REQUIRE_EQUAL(receipts.size(), expected.size());
+		for (size_t i = 0; i < receipts.size(); ++i)
+			BOOST_CHECK(receipts[i].rlp() == expected[i].rlp());
+	}
+
+	ChainParams params;
+	unique_ptr<SealEngineFace> sealEngine;
+	TestLastBlockHashes lastHashes;
+	BlockHeader header;
+	State base{0};
+	vector<AccountKeys::Pair> keys;
+	Address const counter{0xc0de};
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(ParallelExecutorTests, ParallelExecutorFixture)
+
+BOOST_AUTO_TEST_CASE(independentTransactions)
+{
+	ParallelExecutionStats const before = ParallelExecutor::stats();
+	checkMatchesSerial({
+		transfer(0, 0, Address(0x1001)),
+		transfer(1, 0, Address(0x1002)),
+		transfer(2, 0, Address(0x1003)),
+		count(3, 0)
+	});
+	ParallelExecutionStats const after = ParallelExecutor::stats();
+	BOOST_CHECK_EQUAL(after.transactions - before.transactions, 4);
+	// They share only the author, which each of them merely credits, though it does not exist
+	// until the first of them does; so do the recipients.
+	BOOST_CHECK_EQUAL(after.reexecuted - before.reexecuted, 0);
+}
+
+BOOST_AUTO_TEST_CASE(independentTransactionsFundedAuthor)
+{
+	State funded(base);
+	funded.addBalance(header.author(), ether);
+	funded.commit(State::CommitBehaviour::KeepEmptyAccounts);
+
+	ParallelExecutionStats const before = ParallelExecutor::stats();
+	checkMatchesSerial(funded, {
+		transfer(0, 0, Address(0x1001)),
+		transfer(1, 0, Address(0x1002)),
+		transfer(2, 0, Address(0x1003)),
+		count(3, 0)
+	});
+	ParallelExecutionStats const after = ParallelExecutor::stats();
+	BOOST_CHECK_EQUAL(after.transactions - before.transactions, 4);
+	BOOST_CHECK_EQUAL(after.reexecuted - before.reexecuted, 0);
+}
+
+BOOST_AUTO_TEST_CASE(conflictingTransactions)
+{
+	ParallelExecutionStats const before = ParallelExecutor::stats();
+	checkMatchesSerial({
+		transfer(0, 0, Address(0x1001)),
+		count(1, 0),
+		count(2, 0),						// reads the slot the previous one wrote
+		transfer(0, 1, Address(0x1001)),	// invalid nonce against the start of the block
+		transfer(3, 0, keys[1].address()),	// credits an account written earlier
+		count(3, 1)
+	});
+	ParallelExecutionStats const after = ParallelExecutor::stats();
+	BOOST_CHECK_EQUAL(after.transactions - before.transactions, 6);
+	BOOST_CHECK(after.reexecuted - before.reexecuted >= 3);
+	BOOST_CHECK(after.reexecuted - before.reexecuted < 6);
+}
+
+BOOST_AUTO_TEST_CASE(countsEveryCall)
+{
+	Transactions const transactions{count(0, 0), count(1, 0), count(2, 0), count(3, 0), count(0, 1)};
+	ParallelExecutor::setThreads(4);
+	State parallel(base);
+	ParallelExecutor::execute(parallel, header, lastHashes, *sealEngine, transactions);
+	BOOST_CHECK_EQUAL(parallel.storage(counter, 0), u256(transactions.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for the estimates sync requests are sized by.
+
+#include <thread>
+#include <libethereum/PeerThroughput.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(PeerThroughputTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(unmeasuredPeerGetsAShare)
+{
+	PeerThroughput t;
+	BOOST_CHECK_EQUAL(t.capacity(Asking::BlockBodies, 128), 32);
+	BOOST_CHECK_EQUAL(t.capacity(Asking::BlockBodies, 2), 1);
+	BOOST_CHECK_EQUAL(t.latency().count(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(fastPeerGetsFullRequests)
+{
+	PeerThroughput t;
+	t.requested(Asking::BlockBodies);
+	t.delivered(128, 128 * 1024);
+	BOOST_CHECK_EQUAL(t.capacity(Asking::BlockBodies, 128), 128);
+	BOOST_CHECK(t.bandwidth() > 0);
+	// Rates are kept per kind of request.
+	BOOST_CHECK_EQUAL(t.capacity(Asking::BlockHeaders, 1024), 256);
+}
+
+BOOST_AUTO_TEST_CASE(slowPeerGetsSmallRequests)
+{
+	PeerThroughput t;
+	t.requested(Asking::Receipts);
+	this_thread::sleep_for(chrono::milliseconds(500));
+	t.delivered(PeerThroughput::c_minRateSample, 1024);
+	// About 16 receipts a second, so a second's worth is well below the share of an unmeasured peer.
+	BOOST_CHECK(t.capacity(Asking::Receipts, 128) < 32);
+	BOOST_CHECK(t.latency().count() >= 500);
+}
+
+BOOST_AUTO_TEST_CASE(slowPeerRecovers)
+{
+	PeerThroughput t;
+	t.requested(Asking::BlockBodies);
+	this_thread::sleep_for(chrono::milliseconds(1100));
+	t.delivered(PeerThroughput::c_minRateSample, 1024);
+	// Under c_minRateSample bodies a second, but still asked for enough to be measured.
+	BOOST_CHECK(t.itemsPerSecond(Asking::BlockBodies) < PeerThroughput::c_minRateSample);
+	unsigned const asked = t.capacity(Asking::BlockBodies, 128);
+	BOOST_CHECK_EQUAL(asked, PeerThroughput::c_minRateSample);
+	BOOST_CHECK_EQUAL(t.capacity(Asking::BlockBodies, 4), 4);
+
+	// A prompt answer to that request moves the rate back up.
+	t.requested(Asking::BlockBodies);
+	t.delivered(asked, asked * 1024);
+	BOOST_CHECK(t.capacity(Asking::BlockBodies, 128) > asked);
+}
+
+BOOST_AUTO_TEST_CASE(smallAnswersOnlyMeasureLatency)
+{
+	PeerThroughput t;
+	t.requested(Asking::BlockHeaders);
+	t.delivered(1, 500);
+	BOOST_CHECK_EQUAL(t.itemsPerSecond(Asking::BlockHeaders), 0);
+	BOOST_CHECK_EQUAL(t.bandwidth(), 0);
+	// An answer without a request is not measured.
+	t.delivered(100, 100000);
+	BOOST_CHECK_EQUAL(t.bandwidth(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
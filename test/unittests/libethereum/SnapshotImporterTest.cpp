@@ -15,12 +15,20 @@
 	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libethereum/BlockChain.h>
+#include <libethereum/SnapshotExporter.h>
 #include <libethereum/SnapshotImporter.h>
+#include <libethereum/State.h>
 #include <libethereum/StateImporter.h>
 #include <libethereum/BlockChainImporter.h>
 #include <libethereum/SnapshotStorage.h>
+#include <test/tools/libtesteth/BlockChainHelper.h>
 #include <test/tools/libtesteth/TestHelper.h>
 
+#include <mutex>
+
 using namespace dev;
 using namespace dev::eth;
 using namespace dev::test;
@@ -50,6 +58,7 @@ namespace
 			return sha3(_code);
 		}
 		void commitStateDatabase() override { ++commitCounter; }
+		OverlayDB const& getStateDatabase() const override { return stateDatabase; }
 		h256 stateRoot() const override { return h256{}; }
 		std::string lookupCode(h256 const& _hash) const override
 		{ 
@@ -60,6 +69,7 @@ namespace
 		std::vector<ImportedAccount> importedAccounts;
 		std::vector<bytes> importedCodes;
 		int commitCounter = 0;
+		OverlayDB stateDatabase;
 	};
 
 
@@ -75,7 +85,7 @@ namespace
 	class MockBlockChainImporter: public BlockChainImporterFace
 	{
 	public:
-		void importBlock(BlockHeader const& _header, RLP _transactions, RLP _uncles, RLP _receipts, u256 const& _totalDifficulty) override
+		void importBlock(BlockHeader const& _header, OverlayDB const&, RLP _transactions, RLP _uncles, RLP _receipts, u256 const& _totalDifficulty) override
 		{
 			importedBlocks.push_back({_header, _transactions.data().toBytes(), _uncles.data().toBytes(), _receipts.data().toBytes(), _totalDifficulty});
 		}
@@ -99,6 +109,32 @@ namespace
 		std::map<h256, bytes> chunks;
 	};
 
+	/// Keeps the chunks an exporter writes, uncompressed, for an importer to read.
+	class MemorySnapshotStorage: public SnapshotStorageFace, public SnapshotWriterFace
+	{
+	public:
+		bytes readManifest() const override { return manifest; }
+		std::string readChunk(h256 const& _chunkHash) const override
+		{
+			std::lock_guard<std::mutex> l(x_chunks);
+			auto it = chunks.find(_chunkHash);
+			return it == chunks.end() ? std::string{} : std::string(it->second.begin(), it->second.end());
+		}
+
+		h256 writeChunk(bytesConstRef _chunk) override
+		{
+			h256 const hash = sha3(_chunk);
+			std::lock_guard<std::mutex> l(x_chunks);
+			chunks[hash] = _chunk.toBytes();
+			return hash;
+		}
+		void writeManifest(bytesConstRef _manifest) override { manifest = _manifest.toBytes(); }
+
+		bytes manifest;
+		mutable std::mutex x_chunks;
+		std::map<h256, bytes> chunks;
+	};
+
 	class SnapshotImporterTestFixture: public TestOutputHelper
 	{
 	public:
@@ -369,6 +405,24 @@ BOOST_AUTO_TEST_CASE(SnapshotImporterSuite_importEmptyBlock)
 	BOOST_CHECK_EQUAL(blockChainImporter.chainStartBlockNumber, parentNumber + 1);
 }
 
+BOOST_AUTO_TEST_CASE(SnapshotImporterSuite_importRestoresSealFields)
+{
+	h256 blockChunk = sha3("123");
+	snapshotStorage.manifest = createManifest(2, {}, {blockChunk}, h256{}, 0, h256{});
+
+	h256 mixHash = sha3("999");
+	Nonce nonce(012);
+	bytes block = createAbridgedBlock(Address("111"), sha3("222"), h2048(333), 444, 555, 666, 777, {8, 8, 8}, mixHash, nonce, RLPEmptyList, RLPEmptyList);
+	snapshotStorage.chunks[blockChunk] = createSingleBlockChunk(345, sha3("678"), 910, block, RLPEmptyList);
+
+	snapshotImporter.import(snapshotStorage);
+
+	BOOST_REQUIRE_EQUAL(blockChainImporter.importedBlocks.size(), 1);
+	BlockHeader const& header = blockChainImporter.importedBlocks.front().header;
+	BOOST_CHECK_EQUAL(header.seal<h256>(0), mixHash);
+	BOOST_CHECK_EQUAL(header.seal<Nonce>(1), nonce);
+}
+
 BOOST_AUTO_TEST_CASE(SnapshotImporterSuite_importBlockWithTransactions)
 {
 	h256 blockChunk = sha3("123");
@@ -391,4 +445,78 @@ BOOST_AUTO_TEST_CASE(SnapshotImporterSuite_importBlockWithTransactions)
 	BOOST_CHECK_EQUAL_COLLECTIONS(importedBlock.receipts.begin(), importedBlock.receipts.end(), receipts.begin(), receipts.end());
 }
 
+BOOST_AUTO_TEST_CASE(SnapshotImporterSuite_exportedSnapshotImports)
+{
+	// A contract with more storage than fits into one of the small chunks used below.
+	Address const contract("0x1000000000000000000000000000000000000001");
+	json_spirit::mObject storage;
+	for (unsigned i = 1; i <= 100; ++i)
+		storage[toCompactHexPrefixed(i, 1)] = toCompactHexPrefixed(u256(i) << 200, 1);
+	json_spirit::mObject contractObj;
+	contractObj["balance"] = "0";
+	contractObj["nonce"] = "0";
+	contractObj["code"] = "0x600054600101600055";
+	contractObj["storage"] = storage;
+	json_spirit::mObject senderObj;
+	senderObj["balance"] = "10000000000";
+	senderObj["nonce"] = "1";
+	senderObj["code"] = "";
+	senderObj["storage"] = json_spirit::mObject();
+	json_spirit::mObject accounts;
+	accounts["a94f5374fce5edbc8e2a8697c15331677e6ebf0b"] = senderObj;
+	accounts[contract.hex()] = contractObj;
+	TestBlock const genesis(TestBlockChain::defaultGenesisBlockJson(), accounts);
+
+	// The parent of the first exported block must not be the genesis, so blocks 2 and 3 are exported.
+	TestBlockChain source(genesis);
+	for (unsigned nonce = 1; nonce <= 3; ++nonce)
+	{
+		TestBlock block;
+		block.addTransaction(TestTransaction::defaultTransaction(nonce));
+		block.mine(source);
+		source.addBlock(block);
+	}
+	BlockChain const& sourceChain = source.interface();
+	h256 const head = sourceChain.currentHash();
+
+	MemorySnapshotStorage snapshot;
+	SnapshotExporter(sourceChain, source.testGenesis().state().db(), 2048).exportSnapshot(head, snapshot);
+
+	RLP const manifest(snapshot.manifest);
+	h256s const stateChunks = manifest[1].toVector<h256>();
+	unsigned chunksWithContract = 0;
+	for (h256 const& chunk: stateChunks)
+	{
+		std::string const data = snapshot.readChunk(chunk);
+		for (auto const& entry: RLP(data))
+			if (entry[0].toHash<h256>() == sha3(contract))
+				++chunksWithContract;
+	}
+	BOOST_REQUIRE_GT(chunksWithContract, 1);
+
+	TransientDirectory stateDir;
+	OverlayDB stateDB = State::openDB(stateDir.path(), h256{}, WithExisting::Kill);
+	TestBlockChain restored(genesis);
+	BlockChain& restoredChain = restored.interfaceUnsafe();
+	auto stateImporter = createStateImporter(stateDB);
+	auto blockChainImporter = createBlockChainImporter(restoredChain);
+	SnapshotImporter(*stateImporter, *blockChainImporter).import(snapshot);
+
+	h256 const stateRoot = sourceChain.info(head).stateRoot();
+	BOOST_CHECK_EQUAL(stateImporter->stateRoot(), stateRoot);
+	State restoredState(0, stateDB);
+	restoredState.setRoot(stateRoot);
+	BOOST_CHECK_EQUAL(restoredState.storage(contract, 100), u256(100) << 200);
+
+	for (unsigned number = 2; number <= 3; ++number)
+	{
+		h256 const hash = sourceChain.numberHash(number);
+		// The hash covers the seal fields, which the importer has to restore from the abridged block.
+		BOOST_REQUIRE(restoredChain.isKnown(hash, false));
+		BOOST_CHECK(restoredChain.headerData(hash) == sourceChain.headerData(hash));
+		BOOST_CHECK_EQUAL(RLP(restoredChain.headerData(hash)).itemCount(), RLP(sourceChain.headerData(hash)).itemCount());
+		BOOST_CHECK(restoredChain.receipts(hash).rlp() == sourceChain.receipts(hash).rlp());
+	}
+}
+
 BOOST_AUTO_TEST_SUITE_END()
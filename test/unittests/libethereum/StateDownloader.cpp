@@ -0,0 +1,131 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for downloading state tries node by node.
+
+#include <libdevcore/TransientDirectory.h>
+#include <libethereum/State.h>
+#include <libethereum/StateDownloader.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+State sourceState()
+{
+	State s(0);
+	for (unsigned i = 1; i <= 50; ++i)
+		s.addBalance(Address(i), i * 1000);
+	Address const contract(0xc0de);
+	s.createContract(contract);
+	s.setCode(contract, bytes{0x60, 0x01, 0x60, 0x00, 0x55}, 0);
+	for (unsigned i = 0; i < 40; ++i)
+		s.setStorage(contract, i, i + 1);
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	return s;
+}
+
+/// Answer requests from @a _source, leaving out every @a _skip th node if non-zero.
+bytes answer(OverlayDB const& _source, h256s const& _hashes, unsigned _skip = 0)
+{
+	vector<string> nodes;
+	for (unsigned i = 0; i < _hashes.size(); ++i)
+		if (!_skip || i % _skip)
+			nodes.push_back(_source.lookup(_hashes[i]));
+	RLPStream s(nodes.size());
+	for (auto const& n: nodes)
+		s << n;
+	return s.out();
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(StateDownloaderTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(downloadsCompleteState)
+{
+	State const source = sourceState();
+	TransientDirectory td;
+	OverlayDB db = State::openDB(td.path(), h256(), WithExisting::Kill);
+
+	StateDownloader downloader(db);
+	downloader.addRoot(source.rootHash());
+	BOOST_CHECK(!downloader.complete());
+	for (unsigned round = 0; !downloader.complete(); ++round)
+	{
+		BOOST_REQUIRE(round < 1000);
+		h256s const hashes = downloader.request(8);
+		BOOST_REQUIRE(!hashes.empty());
+		// Partial answers are made up for by later requests.
+		bytes const nodes = answer(source.db(), hashes, round % 2 ? 3 : 0);
+		downloader.deliver(hashes, RLP(nodes));
+	}
+
+	State restored(0, db);
+	restored.setRoot(source.rootHash());
+	BOOST_CHECK_EQUAL(restored.balance(Address(17)), 17000);
+	BOOST_CHECK_EQUAL(restored.storage(Address(0xc0de), 39), 40);
+	BOOST_CHECK(restored.code(Address(0xc0de)) == source.code(Address(0xc0de)));
+}
+
+BOOST_AUTO_TEST_CASE(skipsWhatIsInTheDatabase)
+{
+	State const source = sourceState();
+	TransientDirectory td;
+	OverlayDB db = State::openDB(td.path(), h256(), WithExisting::Kill);
+
+	{
+		StateDownloader first(db);
+		first.addRoot(source.rootHash());
+		while (!first.complete())
+		{
+			h256s const hashes = first.request(64);
+			bytes const nodes = answer(source.db(), hashes);
+			first.deliver(hashes, RLP(nodes));
+		}
+	}
+
+	StateDownloader second(db);
+	second.addRoot(source.rootHash());
+	BOOST_CHECK(second.complete());
+	BOOST_CHECK(second.request(64).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ignoresUnrequestedNodes)
+{
+	State const source = sourceState();
+	TransientDirectory td;
+	OverlayDB db = State::openDB(td.path(), h256(), WithExisting::Kill);
+
+	StateDownloader downloader(db);
+	downloader.addRoot(source.rootHash());
+	h256s const hashes = downloader.request(1);
+	BOOST_REQUIRE_EQUAL(hashes.size(), 1);
+
+	RLPStream junk(1);
+	junk << string("not a node");
+	BOOST_CHECK_EQUAL(downloader.deliver(hashes, RLP(junk.out())), 0);
+	// The request was not answered, so it is handed out again.
+	BOOST_CHECK(downloader.request(1) == hashes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
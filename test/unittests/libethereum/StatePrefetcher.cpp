@@ -0,0 +1,104 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for loading the state of queued blocks ahead of their execution.
+
+#include <thread>
+#include <libdevcore/TransientDirectory.h>
+#include <libethereum/BlockQueue.h>
+#include <libethereum/CodeSizeCache.h>
+#include <libethereum/State.h>
+#include <libethereum/StatePrefetcher.h>
+#include <test/tools/libtesteth/BlockChainHelper.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(StatePrefetcherTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(loadsAccountsAndCodeOfBlocks)
+{
+	TransientDirectory dir;
+	State state(0, State::openDB(dir.path(), h256{}, WithExisting::Kill), BaseState::Empty);
+	AccountKeys::Pair const sender = AccountKeys::Pair::create();
+	Address const contract(0xc0de);
+	// Code no other test has stored the size of.
+	bytes const code = h256::random().asBytes();
+	state.addBalance(sender.address(), ether);
+	state.createContract(contract);
+	state.setCode(contract, bytes(code), 0);
+	state.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	state.db().commit();
+
+	VerifiedBlockRef block;
+	block.info.setAuthor(Address(0xa11ce));
+	block.transactions.push_back(Transaction(0, 1, 100000, contract, bytes(), 0, sender.secret()));
+
+	StatePrefetcher prefetcher(state.db());
+	BOOST_CHECK(prefetcher.db() == state.db().db());
+	prefetcher.prefetch(block, state.rootHash());
+
+	h256 const codeHash = sha3(code);
+	for (unsigned i = 0; i < 1000 && (prefetcher.accountsLoaded() < 2 || !CodeSizeCache::instance().contains(codeHash)); ++i)
+		this_thread::sleep_for(chrono::milliseconds(10));
+	// The sender and the contract; the author does not exist.
+	BOOST_CHECK_EQUAL(prefetcher.accountsLoaded(), 2);
+	BOOST_REQUIRE(CodeSizeCache::instance().contains(codeHash));
+	BOOST_CHECK_EQUAL(CodeSizeCache::instance().get(codeHash), code.size());
+}
+
+BOOST_AUTO_TEST_CASE(syncImportsAsWithoutPrefetching)
+{
+	TestBlock const genesis = TestBlockChain::defaultGenesisBlock();
+	TestBlockChain mined(genesis);
+	vector<TestBlock> blocks;
+	for (unsigned nonce = 1; nonce <= 3; ++nonce)
+	{
+		TestBlock block;
+		block.addTransaction(TestTransaction::defaultTransaction(nonce));
+		block.mine(mined);
+		mined.addBlock(block);
+		blocks.push_back(block);
+	}
+
+	TestBlockChain synced(genesis);
+	BlockChain& bc = synced.interfaceUnsafe();
+	BlockQueue queue;
+	queue.setChain(bc);
+	// A sync per block, so that the later ones are prefetched by the prefetcher the first one made.
+	for (TestBlock const& block: blocks)
+	{
+		BOOST_REQUIRE(queue.import(&block.bytes(), true) == ImportResult::Success);
+		for (unsigned i = 0; i < 1000 && !queue.status().verified; ++i)
+			this_thread::sleep_for(chrono::milliseconds(10));
+		BOOST_CHECK_EQUAL(get<2>(bc.sync(queue, synced.testGenesis().state().db(), 10)), 1);
+	}
+
+	BlockChain const& expected = mined.interface();
+	BOOST_REQUIRE_EQUAL(bc.number(), expected.number());
+	for (unsigned n = 1; n <= bc.number(); ++n)
+	{
+		h256 const hash = bc.numberHash(n);
+		BOOST_CHECK_EQUAL(hash, expected.numberHash(n));
+		BOOST_CHECK(bc.receipts(hash).rlp() == expected.receipts(hash).rlp());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -54,6 +54,42 @@ BOOST_AUTO_TEST_CASE(LoadAccountCode)
 	));
 }
 
+BOOST_AUTO_TEST_CASE(LayeredStateKeepsChangesToItself)
+{
+	Address const a(1);
+	Address const b(2);
+	Address const contract(0xc0de);
+	State s(0);
+	s.addBalance(a, 100);
+	s.createContract(contract);
+	s.setStorage(contract, 1, 1);
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	s.addBalance(b, 5);		// left in the cache of the base
+	auto const base = make_shared<State const>(s);
+	h256 const baseRoot = base->rootHash();
+
+	State first = State::layered(base);
+	BOOST_CHECK_EQUAL(first.balance(a), 100);
+	BOOST_CHECK_EQUAL(first.balance(b), 5);
+	first.addBalance(a, 1);
+	first.setStorage(contract, 1, 2);
+
+	State second = State::layered(base);
+	BOOST_CHECK_EQUAL(second.balance(a), 100);
+	BOOST_CHECK_EQUAL(second.storage(contract, 1), 1);
+	BOOST_CHECK(!second.addressInUse(Address(3)));
+
+	first.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	BOOST_CHECK(first.rootHash() != baseRoot);
+	BOOST_CHECK_EQUAL(first.balance(a), 101);
+	BOOST_CHECK_EQUAL(first.balance(b), 5);
+	BOOST_CHECK_EQUAL(first.storage(contract, 1), 2);
+
+	BOOST_CHECK_EQUAL(base->rootHash(), baseRoot);
+	BOOST_CHECK_EQUAL(State::layered(base).balance(a), 100);
+	BOOST_CHECK_EQUAL(State::layered(base).storage(contract, 1), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,68 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for reading the state under a root without a Block.
+
+#include <libethereum/State.h>
+#include <libethereum/StateView.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(StateViewTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(readsAccountsUnderRoot)
+{
+	State s(0);
+	s.addBalance(Address(1), 1000);
+	Address const contract(0xc0de);
+	s.createContract(contract);
+	s.setCode(contract, bytes{0x60, 0x01, 0x60, 0x00, 0x55}, 0);
+	s.setStorage(contract, 7, 8);
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+	h256 const before = s.rootHash();
+
+	s.addBalance(Address(1), 500);
+	s.commit(State::CommitBehaviour::KeepEmptyAccounts);
+
+	StateView const view(s.db(), before, 0);
+	BOOST_CHECK_EQUAL(view.balance(Address(1)), 1000);
+	BOOST_CHECK_EQUAL(view.storage(contract, 7), 8);
+	BOOST_CHECK_EQUAL(view.storage(contract, 9), 0);
+	BOOST_CHECK(view.code(contract) == s.code(contract));
+	BOOST_CHECK_EQUAL(view.codeHash(contract), s.codeHash(contract));
+	BOOST_CHECK_EQUAL(view.storage(contract).size(), 1);
+
+	BOOST_CHECK(!view.addressInUse(Address(2)));
+	BOOST_CHECK_EQUAL(view.balance(Address(2)), 0);
+	BOOST_CHECK_EQUAL(view.storageRoot(Address(2)), EmptyTrie);
+	BOOST_CHECK_EQUAL(view.codeHash(Address(2)), EmptySHA3);
+
+	BOOST_CHECK_EQUAL(StateView(s.db(), s.rootHash(), 0).balance(Address(1)), 1500);
+	BOOST_CHECK_EQUAL(view.state().balance(Address(1)), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(unknownRootThrows)
+{
+	State s(0);
+	BOOST_CHECK_THROW(StateView(s.db(), sha3("no such root"), 0), RootNotFound);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,145 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for learning which storage slots contract calls read.
+
+#include <thread>
+#include <libethereum/StoragePrefetcher.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+
+bytes const c_transfer = fromHex("a9059cbb0000000000000000000000000000000000000000000000000000000000000001");
+bytes const c_approve = fromHex("095ea7b3");
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(StoragePrefetcherTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(learnsPerCodeAndSelector)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	h256 const code = h256::random();
+	StoragePrefetchStats const before = p.stats();
+
+	BOOST_CHECK(p.predict(code, &c_transfer).empty());
+	p.learn(code, &c_transfer, {1, 2, 3}, false, 0);
+	BOOST_CHECK((p.predict(code, &c_transfer) == vector<u256>{1, 2, 3}));
+	// Only the selector counts, not the arguments.
+	BOOST_CHECK((p.predict(code, bytesConstRef(c_transfer.data(), 4)) == vector<u256>{1, 2, 3}));
+	BOOST_CHECK(p.predict(code, &c_approve).empty());
+	BOOST_CHECK(p.predict(h256::random(), &c_transfer).empty());
+
+	// The most recent call replaces what was learned; a call reading nothing forgets it.
+	p.learn(code, &c_transfer, {4}, true, 0);
+	BOOST_CHECK((p.predict(code, &c_transfer) == vector<u256>{4}));
+	p.learn(code, &c_transfer, {}, true, 0);
+	BOOST_CHECK(p.predict(code, &c_transfer).empty());
+
+	StoragePrefetchStats const after = p.stats();
+	BOOST_CHECK_EQUAL(after.calls - before.calls, 3);
+	BOOST_CHECK_EQUAL(after.predictedCalls - before.predictedCalls, 2);
+	BOOST_CHECK_EQUAL(after.reads - before.reads, 4);
+}
+
+BOOST_AUTO_TEST_CASE(shortInputIsTheFallback)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	h256 const code = h256::random();
+	bytes const shortInput{0xa9, 0x05};
+	p.learn(code, &shortInput, {7}, false, 0);
+	BOOST_CHECK((p.predict(code, bytesConstRef()) == vector<u256>{7}));
+}
+
+BOOST_AUTO_TEST_CASE(keepsAtMostMaxSlots)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	h256 const code = h256::random();
+	vector<u256> slots;
+	for (unsigned i = 0; i < StoragePrefetcher::c_maxSlots * 2; ++i)
+		slots.push_back(i);
+	p.learn(code, &c_approve, slots, false, 0);
+	vector<u256> const predicted = p.predict(code, &c_approve);
+	BOOST_REQUIRE_EQUAL(predicted.size(), StoragePrefetcher::c_maxSlots);
+	BOOST_CHECK(equal(predicted.begin(), predicted.end(), slots.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(evictsBeyondMaxKeys)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	h256s codes;
+	for (size_t i = 0; i < StoragePrefetcher::c_maxKeys + 100; ++i)
+	{
+		codes.push_back(h256::random());
+		p.learn(codes.back(), &c_approve, {i}, false, 0);
+		// What was just learned is never the entry evicted for it.
+		BOOST_REQUIRE(!p.predict(codes.back(), &c_approve).empty());
+	}
+	size_t remembered = 0;
+	for (h256 const& c: codes)
+		if (!p.predict(c, &c_approve).empty())
+			++remembered;
+	BOOST_CHECK(remembered <= StoragePrefetcher::c_maxKeys);
+	BOOST_CHECK(remembered >= StoragePrefetcher::c_maxKeys - 100);
+}
+
+BOOST_AUTO_TEST_CASE(learnsFromSeveralThreads)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	StoragePrefetchStats const before = p.stats();
+	unsigned const perThread = StoragePrefetcher::c_maxKeys;
+	vector<thread> threads;
+	for (unsigned t = 0; t < 4; ++t)
+		threads.emplace_back([&, t]()
+		{
+			for (unsigned i = 0; i < perThread; ++i)
+			{
+				h256 const code(u256(t) << 128 | i);
+				p.learn(code, &c_transfer, {i}, false, 0);
+				p.predict(code, &c_transfer);
+			}
+		});
+	for (auto& t: threads)
+		t.join();
+	BOOST_CHECK_EQUAL(p.stats().calls - before.calls, 4 * perThread);
+	h256 const code = h256::random();
+	p.learn(code, &c_transfer, {1}, false, 0);
+	BOOST_CHECK((p.predict(code, &c_transfer) == vector<u256>{1}));
+}
+
+BOOST_AUTO_TEST_CASE(prefetchesOnlyWhenEnabled)
+{
+	StoragePrefetcher& p = StoragePrefetcher::instance();
+	OverlayDB db;
+	StoragePrefetchStats const before = p.stats();
+	p.prefetch(db, h256::random(), {1, 2});
+	BOOST_CHECK_EQUAL(p.stats().prefetched, before.prefetched);
+
+	p.setEnabled(true);
+	p.prefetch(db, h256::random(), {1, 2});
+	p.prefetch(db, h256::random(), {});
+	BOOST_CHECK_EQUAL(p.stats().prefetched - before.prefetched, 2);
+	p.setEnabled(false);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -187,4 +187,30 @@ BOOST_AUTO_TEST_CASE(CheckLowSForUnsignedTransactionThrows)
 	BOOST_REQUIRE_THROW(tx.checkLowS(), TransactionIsUnsigned);
 }
 
+BOOST_AUTO_TEST_CASE(RlpOfSignedTransactionIsSharedBetweenCopies)
+{
+	Secret sec("0x45a915e4d060149eb4365960e6a7a45f334393093061116b197e3240065ff2d8");
+	Transaction tx(0, 0, 10000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0, sec);
+	Transaction copy = tx;
+	BOOST_CHECK(copy.rlpRef().data() == tx.rlpRef().data());
+
+	Transaction decoded(tx.rlp(), CheckTransaction::Everything);
+	BOOST_CHECK(decoded.rlp() == tx.rlp());
+	BOOST_CHECK_EQUAL(decoded.sha3(), tx.sha3());
+	BOOST_CHECK_EQUAL(decoded.sha3(WithoutSignature), tx.sha3(WithoutSignature));
+}
+
+BOOST_AUTO_TEST_CASE(SetNonceUpdatesCachedRlp)
+{
+	Secret sec("0x45a915e4d060149eb4365960e6a7a45f334393093061116b197e3240065ff2d8");
+	Transaction tx(0, 0, 10000, Address("a94f5374fce5edbc8e2a8697c15331677e6ebf0b"), bytes(), 0, sec);
+	h256 const hash = tx.sha3();
+	h256 const unsignedHash = tx.sha3(WithoutSignature);
+
+	tx.setNonce(5);
+	BOOST_CHECK_EQUAL(RLP(tx.rlpRef())[0].toInt<u256>(), 5);
+	BOOST_CHECK(tx.sha3() != hash);
+	BOOST_CHECK(tx.sha3(WithoutSignature) != unsignedHash);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
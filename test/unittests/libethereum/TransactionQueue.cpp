@@ -310,4 +310,26 @@ BOOST_AUTO_TEST_CASE(tqEqueue)
 	BOOST_REQUIRE(topTr.size() == 1);
 }
 
+BOOST_AUTO_TEST_CASE(tqTransactionsByHashPrefix)
+{
+	dev::eth::TransactionQueue txq;
+	Address dest = Address("0x095e7baea6a6c7c4c2dfeb977efac326af552d87");
+	AccountKeys::Secret sec = AccountKeys::Pair::create().secret();
+	Transaction tx0(0, 10 * szabo, 25000, dest, bytes(), 0, sec);
+	Transaction tx1(0, 10 * szabo, 25000, dest, bytes(), 1, sec);
+	Transaction absent(0, 10 * szabo, 25000, dest, bytes(), 2, sec);
+	txq.import(tx0);
+	txq.import(tx1);
+
+	auto prefix = [](Transaction const& _t) { return h64(_t.sha3().ref().cropped(0, h64::size)); };
+	vector<bytes> found = txq.transactionsByHashPrefix({prefix(tx1), prefix(absent), prefix(tx0)});
+	BOOST_REQUIRE_EQUAL(found.size(), 3);
+	BOOST_CHECK(found[0] == tx1.rlp());
+	BOOST_CHECK(found[1].empty());
+	BOOST_CHECK(found[2] == tx0.rlp());
+
+	txq.drop(tx1.sha3());
+	BOOST_CHECK(txq.transactionsByHashPrefix({prefix(tx1)})[0].empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
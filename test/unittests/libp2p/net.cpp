@@ -263,6 +263,42 @@ BOOST_AUTO_TEST_CASE(neighboursPacket)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(bench_discoveryPackets, *boost::unit_test::label("bench"))
+{
+	if (!test::Options::get().all)
+	{
+		clog << "Skipping benchmark test because --all option is not specified.\n";
+		return;
+	}
+
+	// Each packet is signed by its sender and recovered by its receiver, which is
+	// what bounds the rate a node table can take part in discovery at.
+	auto k = KeyPair<ECDSA>::create();
+	bi::udp::endpoint to(bi::address::from_string("127.0.0.1"), 30300);
+	NodeIPEndpoint ep(bi::address::from_string("127.0.0.1"), 30300, 30300);
+	vector<shared_ptr<NodeEntry>> nearest;
+	for (uint16_t port = 30500; port < 30512; ++port)
+		nearest.push_back(make_shared<NodeEntry>(k.pub(), KeyPair<ECDSA>::create().pub(), NodeIPEndpoint(bi::address::from_string("200.200.200.200"), port, port)));
+
+	unsigned const n = 2000;
+	Timer timer;
+	for (unsigned i = 0; i < n; ++i)
+	{
+		unique_ptr<DiscoveryDatagram> out;
+		switch (i % 4)
+		{
+		case 0: out.reset(new PingNode(ep, ep)); break;
+		case 1: out.reset(new Pong(ep)); break;
+		case 2: out.reset(new FindNode(to, k.pub())); break;
+		default: out.reset(new Neighbours(to, nearest)); break;
+		}
+		out->sign(k.secret());
+		auto in = DiscoveryDatagram::interpretUDP(to, bytesConstRef(&out->data));
+		BOOST_REQUIRE(in && in->sourceid == k.pub());
+	}
+	std::cout << "discovery packets signed and recovered: " << static_cast<unsigned>(n / timer.elapsed()) << " per second\n";
+}
+
 BOOST_AUTO_TEST_CASE(test_findnode_neighbours)
 {
 	// Executing findNode should result in a list which is serialized
@@ -0,0 +1,203 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for handling the requests of JSON-RPC batches at once.
+
+#include <atomic>
+#include <thread>
+#include <libweb3jsonrpc/BatchRequestHandler.h>
+#include <libweb3jsonrpc/JsonWriter.h>
+#include <jsonrpccpp/common/errors.h>
+#include <jsonrpccpp/server/iprocedureinvokationhandler.h>
+#include <jsonrpccpp/server/requesthandlerfactory.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::rpc;
+using namespace dev::test;
+
+namespace
+{
+/// Answers eth_blockNumber slowly with its parameter and eth_sendRawTransaction with how
+/// many eth_blockNumber calls were still running; eth_call throws what no method should.
+class SlowMethods: public jsonrpc::IProcedureInvokationHandler
+{
+public:
+	void HandleMethodCall(jsonrpc::Procedure& _proc, Json::Value const& _input, Json::Value& _output) override
+	{
+		if (_proc.GetProcedureName() == "eth_sendRawTransaction")
+		{
+			_output = Json::Value(static_cast<unsigned>(running));
+			return;
+		}
+		if (_proc.GetProcedureName() == "eth_call")
+			throw runtime_error("boom");
+		unsigned const now = ++running;
+		for (unsigned seen = most; now > seen && !most.compare_exchange_weak(seen, now);) {}
+		this_thread::sleep_for(chrono::milliseconds(50));
+		_output = _input[0];
+		--running;
+	}
+	void HandleNotificationCall(jsonrpc::Procedure&, Json::Value const&) override {}
+
+	atomic<unsigned> running{0};
+	atomic<unsigned> most{0};
+};
+
+string request(string const& _method, unsigned _id)
+{
+	return "{\"jsonrpc\":\"2.0\",\"method\":\"" + _method + "\",\"params\":[\"" + toString(_id) + "\"],\"id\":" + toString(_id) + "}";
+}
+
+/// Answers eth_getLogs with a fixed result, or fails as Eth does if asked for "bad".
+class FixedMethods: public jsonrpc::IProcedureInvokationHandler
+{
+public:
+	void HandleMethodCall(jsonrpc::Procedure&, Json::Value const& _input, Json::Value& _output) override
+	{
+		if (_input[0u] == "bad")
+			BOOST_THROW_EXCEPTION(jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_RPC_INVALID_PARAMS));
+		_output = result();
+	}
+	void HandleNotificationCall(jsonrpc::Procedure&, Json::Value const&) override {}
+
+	static Json::Value result()
+	{
+		Json::Value ret;
+		ret["b"].append("0x01");
+		ret["b"].append(Json::Value());
+		ret["a"] = 7;
+		return ret;
+	}
+
+	/// Writes what HandleMethodCall() answers.
+	static bool stream(Json::Value const& _params, JsonWriter& o_result)
+	{
+		if (_params[0u] == "bad")
+			BOOST_THROW_EXCEPTION(jsonrpc::JsonRpcException(jsonrpc::Errors::ERROR_RPC_INVALID_PARAMS));
+		o_result.beginObject().key("a").number(7).key("b").beginArray().value("0x01").null().endArray().endObject();
+		return true;
+	}
+};
+
+template <class M>
+unique_ptr<jsonrpc::IProtocolHandler> protocolFor(M& _methods)
+{
+	unique_ptr<jsonrpc::IProtocolHandler> ret(jsonrpc::RequestHandlerFactory::createProtocolHandler(jsonrpc::JSONRPC_SERVER_V2, _methods));
+	for (char const* name: {"eth_blockNumber", "eth_sendRawTransaction", "eth_call", "eth_getLogs"})
+		ret->AddProcedure(jsonrpc::Procedure(name, jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_STRING, "param1", jsonrpc::JSON_STRING, NULL));
+	return ret;
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(BatchRequestHandlerTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(answersInOrder)
+{
+	SlowMethods methods;
+	unique_ptr<jsonrpc::IProtocolHandler> protocol = protocolFor(methods);
+	BatchRequestHandler handler(*protocol);
+	handler.setBatchConcurrency(4);
+
+	string batch = "[";
+	for (unsigned i = 0; i < 8; ++i)
+		batch += request("eth_blockNumber", i) + ",";
+	batch += request("eth_sendRawTransaction", 8) + "," + request("eth_blockNumber", 9) + "]";
+	string response;
+	handler.HandleRequest(batch, response);
+
+	Json::Value responses;
+	BOOST_REQUIRE(Json::Reader().parse(response, responses));
+	BOOST_REQUIRE_EQUAL(responses.size(), 10);
+	for (unsigned i = 0; i < 10; ++i)
+		BOOST_CHECK_EQUAL(responses[i]["id"].asUInt(), i);
+	BOOST_CHECK_EQUAL(responses[3]["result"].asString(), "3");
+	BOOST_CHECK_EQUAL(responses[8]["result"].asUInt(), 0);
+	BOOST_CHECK_LE(methods.most, 4);
+	BOOST_CHECK_GT(methods.most, 1);
+
+	handler.HandleRequest(request("eth_blockNumber", 7), response);
+	BOOST_REQUIRE(Json::Reader().parse(response, responses));
+	BOOST_CHECK_EQUAL(responses["result"].asString(), "7");
+}
+
+BOOST_AUTO_TEST_CASE(throwingMethodGetsInternalError)
+{
+	SlowMethods methods;
+	unique_ptr<jsonrpc::IProtocolHandler> protocol = protocolFor(methods);
+	BatchRequestHandler handler(*protocol);
+	for (unsigned concurrency: {1u, 4u})
+	{
+		handler.setBatchConcurrency(concurrency);
+		string batch = "[";
+		for (unsigned i = 0; i < 6; ++i)
+			batch += request(i == 2 || i == 4 ? "eth_call" : "eth_blockNumber", i) + (i < 5 ? "," : "]");
+		string response;
+		handler.HandleRequest(batch, response);
+
+		Json::Value responses;
+		BOOST_REQUIRE(Json::Reader().parse(response, responses));
+		BOOST_REQUIRE_EQUAL(responses.size(), 6);
+		for (unsigned i = 0; i < 6; ++i)
+		{
+			BOOST_CHECK_EQUAL(responses[i]["id"].asUInt(), i);
+			BOOST_CHECK_EQUAL(responses[i]["jsonrpc"].asString(), "2.0");
+			if (i == 2 || i == 4)
+				BOOST_CHECK_EQUAL(responses[i]["error"]["code"].asInt(), jsonrpc::Errors::ERROR_RPC_INTERNAL_ERROR);
+			else
+				BOOST_CHECK_EQUAL(responses[i]["result"].asString(), toString(i));
+		}
+	}
+
+	// Alone, too; a notification gets nothing back.
+	string response;
+	handler.HandleRequest(request("eth_call", 7), response);
+	Json::Value error;
+	BOOST_REQUIRE(Json::Reader().parse(response, error));
+	BOOST_CHECK_EQUAL(error["error"]["code"].asInt(), jsonrpc::Errors::ERROR_RPC_INTERNAL_ERROR);
+	BOOST_CHECK_EQUAL(error["id"].asUInt(), 7);
+	handler.HandleRequest("{\"jsonrpc\":\"2.0\",\"method\":\"eth_call\",\"params\":[\"7\"]}", response);
+	BOOST_CHECK(response.empty());
+}
+
+BOOST_AUTO_TEST_CASE(streamsWhatTheProtocolHandlerWrites)
+{
+	FixedMethods methods;
+	unique_ptr<jsonrpc::IProtocolHandler> protocol = protocolFor(methods);
+	BatchRequestHandler handler(*protocol);
+	handler.addStreamingMethod("eth_getLogs", &FixedMethods::stream);
+
+	vector<string> const requests = {
+		"{\"jsonrpc\":\"2.0\",\"method\":\"eth_getLogs\",\"params\":[\"x\"],\"id\":1}",
+		"{\"id\":\"abc\",\"params\":[\"x\"],\"method\":\"eth_getLogs\",\"jsonrpc\":\"2.0\"}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"eth_getLogs\",\"params\":[\"bad\"],\"id\":2}",
+		"{\"jsonrpc\":\"2.0\",\"method\":\"eth_getLogs\",\"params\":[\"bad\"],\"id\":\"def\"}",
+		"[{\"jsonrpc\":\"2.0\",\"method\":\"eth_getLogs\",\"params\":[\"x\"],\"id\":3},{\"jsonrpc\":\"2.0\",\"method\":\"eth_getLogs\",\"params\":[\"bad\"],\"id\":4}]"
+	};
+	for (string const& r: requests)
+	{
+		string expected;
+		protocol->HandleRequest(r, expected);
+		string response;
+		handler.HandleRequest(r, response);
+		BOOST_CHECK_EQUAL(response, expected);
+		BOOST_CHECK_EQUAL(response.back(), '\n');
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,342 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for splitting and serving requests over IPC.
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <libdevcore/FileSystem.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libweb3jsonrpc/IpcServer.h>
+#include <jsonrpccpp/server/iclientconnectionhandler.h>
+#include <test/tools/libtesteth/TestHelper.h>
+#include <test/tools/libtesteth/TestOutputHelper.h>
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace dev;
+using namespace dev::test;
+
+BOOST_FIXTURE_TEST_SUITE(IpcServerTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(framerSplitsAcrossReads)
+{
+	IpcRequestFramer framer;
+	vector<string> requests;
+	auto collect = [&](string const& _r) { requests.push_back(_r); };
+
+	string const stream = "{\"id\":1,\"params\":[\"}]\\\"{\"]}[{\"id\":2},{\"id\":3}]{\"id\":4}";
+	for (char c: stream)
+		framer.feed(&c, 1, collect);
+	BOOST_REQUIRE_EQUAL(requests.size(), 3);
+	BOOST_CHECK_EQUAL(requests[0], "{\"id\":1,\"params\":[\"}]\\\"{\"]}");
+	BOOST_CHECK_EQUAL(requests[1], "[{\"id\":2},{\"id\":3}]");
+	BOOST_CHECK_EQUAL(requests[2], "{\"id\":4}");
+	BOOST_CHECK_EQUAL(framer.pending(), 0);
+
+	framer.feed("{\"id\":", 6, collect);
+	BOOST_CHECK_EQUAL(requests.size(), 3);
+	BOOST_CHECK_EQUAL(framer.pending(), 6);
+	framer.feed("5}\n{\"id\":6}", 11, collect);
+	BOOST_REQUIRE_EQUAL(requests.size(), 5);
+	BOOST_CHECK_EQUAL(requests[3], "{\"id\":5}");
+	BOOST_CHECK_EQUAL(requests[4], "\n{\"id\":6}");
+}
+
+#if !defined(_WIN32)
+
+namespace
+{
+class SizeHandler: public jsonrpc::IClientConnectionHandler
+{
+public:
+	void HandleRequest(string const& _request, string& o_response) override { o_response = "{\"size\":" + toString(_request.size()) + "}"; }
+};
+
+class EchoHandler: public jsonrpc::IClientConnectionHandler
+{
+public:
+	void HandleRequest(string const& _request, string& o_response) override { o_response = _request; }
+};
+
+/// Echoes requests, holding those with "slow" in them until released.
+class BlockingHandler: public jsonrpc::IClientConnectionHandler
+{
+public:
+	void HandleRequest(string const& _request, string& o_response) override
+	{
+		if (_request.find("slow") != string::npos)
+		{
+			unique_lock<mutex> l(x_released);
+			++blocked;
+			m_released.wait_for(l, chrono::seconds(10), [this]() { return released; });
+		}
+		o_response = _request;
+	}
+
+	void release()
+	{
+		{
+			lock_guard<mutex> l(x_released);
+			released = true;
+		}
+		m_released.notify_all();
+	}
+
+	unsigned waiting()
+	{
+		lock_guard<mutex> l(x_released);
+		return blocked;
+	}
+
+private:
+	mutex x_released;
+	condition_variable m_released;
+	bool released = false;
+	unsigned blocked = 0;
+};
+
+/// @returns a socket connected to @a _path whose reads give up after a few seconds, or -1.
+int connectTo(string const& _path)
+{
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, _path.c_str(), sizeof(address.sun_path) - 1);
+	timeval timeout = {5, 0};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/// Write @a _data to @a _fd in pieces of @a _piece bytes.
+void writeInPieces(int _fd, string const& _data, size_t _piece)
+{
+	for (size_t written = 0; written < _data.size();)
+	{
+		ssize_t const w = write(_fd, _data.data() + written, min(_piece, _data.size() - written));
+		if (w <= 0)
+			break;
+		written += w;
+	}
+}
+
+/// @returns what can be read from @a _fd until @a _size bytes came or the read times out.
+string readUpTo(int _fd, size_t _size)
+{
+	string ret;
+	char buffer[4096];
+	while (ret.size() < _size)
+	{
+		ssize_t const r = read(_fd, buffer, min(sizeof(buffer), _size - ret.size()));
+		if (r <= 0)
+			break;
+		ret.append(buffer, r);
+	}
+	return ret;
+}
+
+string request(unsigned _id)
+{
+	return "{\"jsonrpc\":\"2.0\",\"method\":\"eth_blockNumber\",\"params\":[],\"id\":" + toString(_id) + "}";
+}
+}
+
+BOOST_AUTO_TEST_CASE(servesPipelinedRequestsInOrder)
+{
+	TransientDirectory dir;
+	setIpcPath(dir.path());
+	UnixDomainSocketServer server("test");
+	EchoHandler handler;
+	server.SetHandler(&handler);
+	BOOST_REQUIRE(server.StartListening());
+
+	// Clients that go away with a request half written, or without reading their answers.
+	int const halfWay = connectTo(server.path());
+	BOOST_REQUIRE_NE(halfWay, -1);
+	string const first = request(1);
+	writeInPieces(halfWay, first.substr(0, first.size() / 2), 5);
+	close(halfWay);
+	int const unread = connectTo(server.path());
+	BOOST_REQUIRE_NE(unread, -1);
+	string many;
+	for (unsigned i = 0; i < 1000; ++i)
+		many += request(i);
+	writeInPieces(unread, many + "{\"id\":", 4096);
+	close(unread);
+
+	// Every client pipelines its requests in pieces that do not line up with them.
+	unsigned const clients = 8;
+	unsigned const perClient = 200;
+	vector<string> expected(clients);
+	vector<string> received(clients);
+	vector<thread> threads;
+	for (unsigned c = 0; c < clients; ++c)
+	{
+		for (unsigned i = 0; i < perClient; ++i)
+			expected[c] += request(c * perClient + i);
+		threads.emplace_back([&, c]()
+		{
+			int const fd = connectTo(server.path());
+			if (fd == -1)
+				return;
+			thread writer([&]() { writeInPieces(fd, expected[c], 7 + c); });
+			received[c] = readUpTo(fd, expected[c].size());
+			writer.join();
+			close(fd);
+		});
+	}
+	for (auto& t: threads)
+		t.join();
+	for (unsigned c = 0; c < clients; ++c)
+		BOOST_CHECK_EQUAL(received[c], expected[c]);
+
+	// Still serving.
+	int const fd = connectTo(server.path());
+	BOOST_REQUIRE_NE(fd, -1);
+	writeInPieces(fd, first, first.size());
+	BOOST_CHECK_EQUAL(readUpTo(fd, first.size()), first);
+	close(fd);
+
+	BOOST_CHECK(server.StopListening());
+}
+
+BOOST_AUTO_TEST_CASE(slowRequestsDoNotHoldUpOtherConnections)
+{
+	TransientDirectory dir;
+	setIpcPath(dir.path());
+	UnixDomainSocketServer server("test");
+	BlockingHandler handler;
+	server.SetHandler(&handler);
+	BOOST_REQUIRE(server.StartListening());
+
+	// Slow requests holding all but one of the threads that handle requests.
+	string const slow = "{\"jsonrpc\":\"2.0\",\"method\":\"slow\",\"params\":[],\"id\":1}";
+	vector<int> slowClients;
+	for (unsigned i = 0; i < UnixDomainSocketServer::c_requestThreads - 1; ++i)
+	{
+		int const fd = connectTo(server.path());
+		BOOST_REQUIRE_NE(fd, -1);
+		writeInPieces(fd, slow, slow.size());
+		slowClients.push_back(fd);
+	}
+	for (unsigned i = 0; i < 1000 && handler.waiting() < slowClients.size(); ++i)
+		this_thread::sleep_for(chrono::milliseconds(10));
+	BOOST_REQUIRE_EQUAL(handler.waiting(), slowClients.size());
+
+	// Others are still read from and answered meanwhile.
+	string const fast = request(2);
+	for (unsigned i = 0; i < UnixDomainSocketServer::c_maxWorkers; ++i)
+	{
+		int const fd = connectTo(server.path());
+		BOOST_REQUIRE_NE(fd, -1);
+		writeInPieces(fd, fast, 5);
+		BOOST_CHECK_EQUAL(readUpTo(fd, fast.size()), fast);
+		close(fd);
+	}
+
+	handler.release();
+	for (int fd: slowClients)
+	{
+		BOOST_CHECK_EQUAL(readUpTo(fd, slow.size()), slow);
+		close(fd);
+	}
+	BOOST_CHECK(server.StopListening());
+}
+
+BOOST_AUTO_TEST_CASE(bench_ipcThroughput, *boost::unit_test::label("bench"))
+{
+	if (!test::Options::get().all)
+	{
+		clog << "Skipping benchmark test because --all option is not specified.\n";
+		return;
+	}
+
+	TransientDirectory dir;
+	setIpcPath(dir.path());
+	UnixDomainSocketServer server("bench");
+	SizeHandler handler;
+	server.SetHandler(&handler);
+	BOOST_REQUIRE(server.StartListening());
+
+	// Many clients, each writing its requests in pieces that do not line up with them.
+	unsigned const clients = 64;
+	unsigned const perClient = 2000;
+	string const request = "{\"jsonrpc\":\"2.0\",\"method\":\"eth_blockNumber\",\"params\":[],\"id\":1}";
+	string const response = "{\"size\":" + toString(request.size()) + "}";
+	string all;
+	for (unsigned i = 0; i < perClient; ++i)
+		all += request;
+
+	atomic<unsigned> answered{0};
+	Timer timer;
+	vector<thread> threads;
+	for (unsigned c = 0; c < clients; ++c)
+		threads.emplace_back([&]()
+		{
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			strncpy(address.sun_path, server.path().c_str(), sizeof(address.sun_path) - 1);
+			if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+				return;
+			thread writer([&]()
+			{
+				for (size_t written = 0; written < all.size();)
+				{
+					ssize_t const w = write(fd, all.data() + written, min<size_t>(777, all.size() - written));
+					if (w <= 0)
+						break;
+					written += w;
+				}
+			});
+			string received;
+			char buffer[4096];
+			while (received.size() < response.size() * perClient)
+			{
+				ssize_t const r = read(fd, buffer, sizeof(buffer));
+				if (r <= 0)
+					break;
+				received.append(buffer, r);
+			}
+			writer.join();
+			close(fd);
+			if (received.size() == response.size() * perClient)
+				answered += perClient;
+		});
+	for (auto& t: threads)
+		t.join();
+	double const elapsed = timer.elapsed();
+	server.StopListening();
+
+	BOOST_CHECK_EQUAL(answered, clients * perClient);
+	std::cout << "IPC requests answered: " << static_cast<unsigned>(answered / elapsed) << " per second\n";
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
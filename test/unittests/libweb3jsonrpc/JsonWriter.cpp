@@ -0,0 +1,225 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests that writing JSON straight into a string gives what Json::FastWriter does.
+
+#include <libdevcore/CommonJS.h>
+#include <libethcore/SealEngine.h>
+#include <libethereum/BlockDetails.h>
+#include <libethereum/Transaction.h>
+#include <libethereum/TransactionReceipt.h>
+#include <libweb3jsonrpc/JsonHelper.h>
+#include <libweb3jsonrpc/JsonWriter.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+
+namespace
+{
+string fastWrite(Json::Value const& _v)
+{
+	string ret = Json::FastWriter().write(_v);
+	ret.pop_back();
+	return ret;
+}
+
+/// Adds its own members to blocks, some of them in place of or after the ones of toJson().
+class SealFields: public NoProof
+{
+public:
+	StringHashMap jsInfo(BlockHeader const&) const override
+	{
+		return {
+			{"aaa", "before everything"},
+			{"difficulty", "0xd1ff"},
+			{"hash", "0x5ea1"},
+			{"mixHash", "0x01"},
+			{"nonce", "0x02"},
+			{"totalDifficulty", "loses"},
+			{"transactions", "loses"},
+			{"uncles", "loses"},
+			{"unclesCount", "0x3"},
+			{"zzz", "after everything"}
+		};
+	}
+};
+
+BlockHeader header()
+{
+	BlockHeader ret;
+	ret.setNumber(0x1234);
+	ret.setParentHash(h256(5));
+	ret.setRoots(h256(6), h256(7), h256(8), h256(9));
+	ret.setTimestamp(1500000000);
+	ret.setAuthor(Address(0xa));
+	ret.setDifficulty(131072);
+	ret.setGasLimit(3141592);
+	ret.setGasUsed(42000);
+	ret.setExtraData(bytes{1, 2, 3});
+	return ret;
+}
+
+Transactions transactions()
+{
+	AccountKeys::Secret const secret = AccountKeys::Pair::create().secret();
+	Transactions ret;
+	ret.push_back(Transaction(1, 2, 21000, Address(0x1001), bytes(), 0, secret));
+	ret.push_back(Transaction(u256(1) << 200, 20000000000, 100000, bytes{0x60, 0x00, 0x60, 0x00, 0xf3}, 1, secret));
+	ret.push_back(Transaction(0, 1, 50000, Address(0x1002), bytes(40, 0xab), 2, secret));
+	return ret;
+}
+
+template <class T>
+void checkBlock(BlockHeader const& _bi, T const& _ts, SealEngineFace* _sealer)
+{
+	BlockDetails const details(0x1234, 0xabcdef, h256(5), h256s());
+	UncleHashes const uncles{h256(0xc), h256(0xd)};
+	string s;
+	JsonWriter w(s);
+	toJson(w, _bi, details, uncles, _ts, _sealer);
+	BOOST_CHECK_EQUAL(s, fastWrite(toJson(_bi, details, uncles, _ts, _sealer)));
+}
+}
+
+BOOST_FIXTURE_TEST_SUITE(JsonWriterTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(writesLikeFastWriter)
+{
+	for (u256 const& n: {u256(0), u256(15), u256(256), u256(numeric_limits<uint64_t>::max()), (u256(1) << 255) + 1})
+	{
+		string s;
+		JsonWriter(s).quantity(n);
+		BOOST_CHECK_EQUAL(s, fastWrite(toJS(n)));
+	}
+
+	bytes const data{1, 2, 0xff};
+	string s;
+	JsonWriter(s).beginObject()
+		.key("data").hex(&data, 32)
+		.key("list").beginArray().value("a/b").value("\"\n").null().value(false).number(-3).endArray()
+		.key("none").beginObject().endObject()
+		.endObject();
+	Json::Value v;
+	v["data"] = toJS(data, 32);
+	v["list"].append("a/b");
+	v["list"].append("\"\n");
+	v["list"].append(Json::Value());
+	v["list"].append(false);
+	v["list"].append(-3);
+	v["none"] = Json::Value(Json::objectValue);
+	BOOST_CHECK_EQUAL(s, fastWrite(v));
+}
+
+BOOST_AUTO_TEST_CASE(writesLogsLikeToJson)
+{
+	LogEntry const log(Address(0xabc), h256s{h256(1), h256(2)}, bytes{0x60, 0x00});
+	LocalisedLogEntries logs;
+	logs.emplace_back(log, h256(3), 12, h256(4), 5, 6, BlockPolarity::Live);
+	logs.emplace_back(log);
+	logs.emplace_back(log, h256(7));
+
+	string s;
+	JsonWriter w(s);
+	toJson(w, logs);
+	BOOST_CHECK_EQUAL(s, fastWrite(toJson(logs)));
+}
+
+BOOST_AUTO_TEST_CASE(writesBlocksLikeToJson)
+{
+	SealFields sealer;
+	NoProof plain;
+	Transactions const ts = transactions();
+	TransactionHashes hashes;
+	for (auto const& t: ts)
+		hashes.push_back(t.sha3());
+
+	for (SealEngineFace* s: {static_cast<SealEngineFace*>(nullptr), static_cast<SealEngineFace*>(&plain), static_cast<SealEngineFace*>(&sealer)})
+	{
+		checkBlock(header(), ts, s);
+		checkBlock(header(), Transactions(), s);
+		checkBlock(header(), hashes, s);
+		checkBlock(header(), TransactionHashes(), s);
+		// No block at all.
+		checkBlock(BlockHeader(), ts, s);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(writesReceiptsLikeToJson)
+{
+	LogEntries const logs{
+		LogEntry(Address(0xabc), h256s{h256(1), h256(2)}, bytes{0x60, 0x00}),
+		LogEntry(Address(0xdef), h256s(), bytes())
+	};
+	for (auto const& receipt: {TransactionReceipt(h256(0x5), 21000, LogEntries()), TransactionReceipt(1, 53000, logs)})
+		for (Address const& created: {Address(), Address(0xc0de)})
+		{
+			LocalisedTransactionReceipt const r(receipt, h256(1), h256(2), 0x1234, 3, created);
+			string s;
+			JsonWriter w(s);
+			toJson(w, r);
+			BOOST_CHECK_EQUAL(s, fastWrite(toJson(r)));
+		}
+}
+
+BOOST_AUTO_TEST_CASE(writesPendingTransactionsLikeToJson)
+{
+	for (auto const& t: transactions())
+	{
+		string s;
+		JsonWriter w(s);
+		toJson(w, t);
+		BOOST_CHECK_EQUAL(s, fastWrite(toJson(t)));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(writesTxPoolLikeToJson)
+{
+	Transactions const ts = transactions();
+	Transactions more;
+	AccountKeys::Secret const secret = AccountKeys::Pair::create().secret();
+	// Nonces are keyed as text, so 10 sorts before 9.
+	for (unsigned nonce: {9, 10, 11})
+		more.push_back(Transaction(0, 1, 21000, Address(0x1001), bytes(), nonce, secret));
+
+	AccountTransactions byAccount;
+	for (auto const& t: ts)
+		byAccount[t.sender()][toString(t.nonce())] = &t;
+	for (auto const& t: more)
+		byAccount[t.sender()][toString(t.nonce())] = &t;
+	// An account whose transactions have all gone.
+	byAccount[Address(0xdead)];
+
+	for (AccountTransactions const& pool: {AccountTransactions(), byAccount})
+	{
+		string s;
+		JsonWriter w(s);
+		w.beginObject().key("pending");
+		toJson(w, pool);
+		w.key("queued");
+		toJson(w, AccountTransactions());
+		w.endObject();
+		Json::Value v;
+		v["pending"] = toJson(pool);
+		v["queued"] = toJson(AccountTransactions());
+		BOOST_CHECK_EQUAL(s, fastWrite(v));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
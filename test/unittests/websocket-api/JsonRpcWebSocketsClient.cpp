@@ -0,0 +1,106 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Tests for websocket clients going away with messages still to send.
+
+#include <future>
+#include <thread>
+#include <boost/asio/executor_work_guard.hpp>
+#include <websocket-api/JsonRpcWebSocketsClient.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::test;
+using namespace WebsocketAPI;
+
+namespace
+{
+class CountedSubscription: public Subscription
+{
+public:
+	explicit CountedSubscription(IWebsocketClient* _client): Subscription(_client, NewBlockHeaders) {}
+	void cleanUp() override { ++cleanedUp; Subscription::cleanUp(); }
+	unsigned cleanedUp = 0;
+};
+}
+
+BOOST_FIXTURE_TEST_SUITE(JsonRpcWebSocketsClientTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(closesWithWritesQueued)
+{
+	net::io_context io;
+	auto work = net::make_work_guard(io);
+	net::thread_pool requests(1);
+	tcp::acceptor acceptor(io, tcp::endpoint(net::ip::address_v4::loopback(), 0));
+	unsigned short const port = acceptor.local_endpoint().port();
+
+	// The peer does not read until the server has given up on it.
+	promise<void> handshaken;
+	promise<void> overflowed;
+	size_t received = 0;
+	thread peer([&]()
+	{
+		net::io_context peerIo;
+		BoostWebsocket ws(peerIo);
+		ws.next_layer().connect(tcp::endpoint(net::ip::address_v4::loopback(), port));
+		ws.handshake("127.0.0.1", "/");
+		handshaken.set_value();
+		overflowed.get_future().wait();
+		try
+		{
+			for (;;)
+			{
+				beast::flat_buffer b;
+				received += ws.read(b);
+			}
+		}
+		catch (...) {}
+	});
+
+	tcp::socket socket(io);
+	acceptor.accept(socket);
+	auto client = make_shared<JsonRpcWebSocketsClient>(move(socket), requests);
+	weak_ptr<JsonRpcWebSocketsClient> const watch = client;
+	client->start();
+	thread runner([&]() { io.run(); });
+	handshaken.get_future().wait();
+
+	// More than the client may have queued, so it is disconnected with a write under way.
+	string const message(64 * 1024, 'x');
+	for (size_t sent = 0; sent < 4 * JsonRpcWebSocketsClient::c_maxQueuedBytes; sent += message.size())
+		client->sendAsync(message);
+	promise<void> queued;
+	net::post(io, [&]() { queued.set_value(); });
+	queued.get_future().wait();
+	overflowed.set_value();
+	peer.join();
+	BOOST_CHECK_LT(received, 4 * JsonRpcWebSocketsClient::c_maxQueuedBytes);
+
+	// A subscription made as the client goes away is cleaned up rather than left behind.
+	auto subscription = make_shared<CountedSubscription>(client.get());
+	BOOST_CHECK(!client->cacheSubscription(subscription));
+	BOOST_CHECK_EQUAL(subscription->cleanedUp, 1);
+
+	client.reset();
+	work.reset();
+	runner.join();
+	requests.join();
+	BOOST_CHECK(watch.expired());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
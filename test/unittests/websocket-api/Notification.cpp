@@ -0,0 +1,87 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Notifications must be sent exactly as FastWriter would write the whole message.
+
+#include <websocket-api/Notification.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::test;
+using namespace WebsocketAPI;
+
+namespace
+{
+
+string message(Notification const& _n, string const& _subscriptionId)
+{
+	string ret;
+	for (auto const& b: _n.buffers(_subscriptionId))
+		ret.append(static_cast<char const*>(b.data()), b.size());
+	BOOST_CHECK_EQUAL(ret.size(), _n.size(_subscriptionId.size()));
+	return ret;
+}
+
+string fastWriter(Json::Value const& _result, string const& _subscriptionId)
+{
+	Json::Value params;
+	params["subscription"] = _subscriptionId;
+	params["result"] = _result;
+	Json::Value out;
+	out["method"] = "eth_subscription";
+	out["jsonrpc"] = "2.0";
+	out["params"] = params;
+	return Json::FastWriter().write(out);
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(NotificationTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(matchesFastWriter)
+{
+	Json::Value header;
+	header["number"] = "0x1b4";
+	header["hash"] = "0xdc0818cf78f21a8e70579cb46a43643f78291264dda342ae31049421c82d21ae";
+	header["extraData"] = "quote \" and backslash \\ and\nnewline";
+	header["logsBloom"] = Json::Value(Json::nullValue);
+	header["uncles"] = Json::Value(Json::arrayValue);
+	header["gasUsed"] = 21000;
+	header["nested"]["zeta"] = true;
+	header["nested"]["alpha"] = Json::Value(Json::arrayValue);
+	header["nested"]["alpha"].append(1);
+	header["nested"]["alpha"].append("two");
+
+	vector<Json::Value> results{
+		header,
+		Json::Value("0xd6f5b0c7b94d1a8a4e2f9f8f5d0d3c2b1a09f8e7d6c5b4a3928170f6e5d4c3b2"),
+		Json::Value(false),
+		Json::Value(Json::objectValue),
+		Json::Value(Json::nullValue)
+	};
+	string const id = "0x9cef478923ff08bf67fde6c64013158d";
+	for (Json::Value const& r: results)
+	{
+		Notification const n(r);
+		BOOST_CHECK_EQUAL(message(n, id), fastWriter(r, id));
+		// The same notification goes to every subscription.
+		BOOST_CHECK_EQUAL(message(n, "0x1"), fastWriter(r, "0x1"));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+/*
+	This file is part of cpp-ethereum.
+
+	cpp-ethereum is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	cpp-ethereum is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with cpp-ethereum.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/// @file
+/// Events reach subscribers in the order they were triggered; overflow is dropped and counted.
+
+#include <future>
+#include <libweb3jsonrpc/JsonHelper.h>
+#include <websocket-api/WebsocketEvents.h>
+#include <test/tools/libtesteth/TestHelper.h>
+
+using namespace std;
+using namespace dev;
+using namespace dev::eth;
+using namespace dev::test;
+using namespace WebsocketAPI;
+
+namespace
+{
+
+string text(Notification const& _n)
+{
+	string ret;
+	for (auto const& b: _n.buffers("0x1"))
+		ret.append(static_cast<char const*>(b.data()), b.size());
+	return ret;
+}
+
+BlockHeader header(unsigned _number)
+{
+	BlockHeader ret;
+	ret.setNumber(_number);
+	return ret;
+}
+
+/// Collects the block headers published to it.
+class Subscriber
+{
+public:
+	explicit Subscriber(WebSocketEvents& _events)
+	{
+		m_connection = _events.subscribeNewBlockHeaderEvent([this](NotificationPtr const& _n)
+		{
+			if (m_onFirst)
+			{
+				m_onFirst();
+				m_onFirst = nullptr;
+			}
+			lock_guard<mutex> l(x_received);
+			m_received.push_back(text(*_n));
+			m_changed.notify_all();
+		});
+	}
+	~Subscriber() { m_connection.disconnect(); }
+
+	/// Call @a _f from the dispatcher before the first header is recorded.
+	void onFirst(function<void()> const& _f) { m_onFirst = _f; }
+
+	/// @returns the headers received once there are @a _count of them, or after a generous timeout.
+	vector<string> waitFor(size_t _count)
+	{
+		unique_lock<mutex> l(x_received);
+		m_changed.wait_for(l, chrono::seconds(10), [&]() { return m_received.size() >= _count; });
+		return m_received;
+	}
+
+private:
+	boost::signals2::connection m_connection;
+	function<void()> m_onFirst;
+	mutex x_received;
+	condition_variable m_changed;
+	vector<string> m_received;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(WebsocketEventsTests, TestOutputHelper)
+
+BOOST_AUTO_TEST_CASE(dispatchesInOrder)
+{
+	WebSocketEvents events;
+	Subscriber s(events);
+	unsigned const count = 1000;
+	for (unsigned i = 0; i < count; ++i)
+		events.triggerNewBlockHeaderEvent(header(i));
+
+	vector<string> const received = s.waitFor(count);
+	BOOST_REQUIRE_EQUAL(received.size(), count);
+	for (unsigned i = 0; i < count; ++i)
+		BOOST_CHECK_EQUAL(received[i], text(Notification(toJson(header(i)))));
+	BOOST_CHECK_EQUAL(events.droppedEvents(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(dropsWhatDoesNotFit)
+{
+	WebSocketEvents events;
+	Subscriber s(events);
+	promise<void> entered;
+	promise<void> release;
+	shared_future<void> released = release.get_future().share();
+	s.onFirst([&]() { entered.set_value(); released.wait(); });
+
+	// Hold the dispatcher in the first event while the queue fills up.
+	events.triggerNewBlockHeaderEvent(header(0));
+	entered.get_future().wait();
+	unsigned const extra = 10;
+	unsigned const total = 1 + WebSocketEvents::c_queueCapacity + extra;
+	for (unsigned i = 1; i < total; ++i)
+		events.triggerNewBlockHeaderEvent(header(i));
+	uint64_t const dropped = events.droppedEvents();
+	BOOST_CHECK(dropped >= extra);
+	release.set_value();
+
+	// What was queued arrives in order; the last ones, which found it full, never do.
+	vector<string> const received = s.waitFor(total - dropped);
+	BOOST_REQUIRE_EQUAL(received.size(), total - dropped);
+	for (unsigned i = 0; i < received.size(); ++i)
+		BOOST_CHECK_EQUAL(received[i], text(Notification(toJson(header(i)))));
+	BOOST_CHECK_EQUAL(events.droppedEvents(), dropped);
+
+	// Once drained, the queue takes events again.
+	events.triggerNewBlockHeaderEvent(header(total));
+	BOOST_CHECK_EQUAL(s.waitFor(received.size() + 1).back(), text(Notification(toJson(header(total)))));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <string>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 
@@ -12,17 +14,19 @@ namespace WebsocketAPI {
     using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
     using BoostWebsocket = websocket::stream<tcp::socket>;
 
+    class Notification;
+
     class IWebsocketClient{
     public:
-        IWebsocketClient(BoostWebsocket& ws) : m_ws(ws){}
+        virtual ~IWebsocketClient() {}
 
-        virtual void readAsync(const std::string& jsonStr) = 0;
+        /// Queues @a jsonStr to be sent to the client and returns without waiting for it.
+        /// May be called from any thread.
         virtual void sendAsync(std::string jsonStr) = 0;
-        virtual void sendSync(const std::string& jsonStr) = 0;
 
-        virtual void close() = 0;
+        /// Queues @a notification to be sent for subscription @a subscriptionId, like sendAsync().
+        virtual void notify(std::shared_ptr<Notification const> notification, std::string subscriptionId) = 0;
 
-    protected:
-        BoostWebsocket& m_ws;
+        virtual void close() = 0;
     };
-}
\ No newline at end of file
+}
@@ -55,7 +55,7 @@ void invokeMethod(Json::Value json, IWebsocketClient* client)
 
 		Json::FastWriter fastWriter;
 		std::string output = fastWriter.write(root);
-		client->sendSync(output);
+		client->sendAsync(output);
 	}
 }
 
@@ -82,7 +82,7 @@ bool invokeWeb3JsonRpc(const std::string& name, Json::Value json, IWebsocketClie
 
 			Json::FastWriter fastWriter;
 			std::string output = fastWriter.write(root);
-			client->sendSync(output);
+			client->sendAsync(output);
 
 			return true;
 		}
@@ -104,7 +104,7 @@ void eth_subscribe(Json::Value json, IWebsocketClient* client)
 
         Json::FastWriter fastWriter;
         std::string output = fastWriter.write(root);
-        client->sendSync(output);
+        client->sendAsync(output);
 
         //cache the subscription so it wont get freed
         JsonRpcWebSocketsClient* derived = (JsonRpcWebSocketsClient*)client;
@@ -131,7 +131,7 @@ void eth_unsubscribe(Json::Value json, IWebsocketClient* client)
 
 	Json::FastWriter fastWriter;
 	std::string output = fastWriter.write(root);
-	client->sendSync(output);
+	client->sendAsync(output);
 }
 
 }}
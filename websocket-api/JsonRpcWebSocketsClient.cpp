@@ -1,60 +1,237 @@
-#include <thread>
-#include <iostream>
+#include <libdevcore/Log.h>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
 #include "JsonRpcWebSocketsClient.h"
 #include "JsonRpcHelper.h"
 #include "JsonRpcMethods.h"
 
 namespace WebsocketAPI {
-JsonRpcWebSocketsClient::JsonRpcWebSocketsClient(BoostWebsocket& ws) : IWebsocketClient(ws)
+thread_local JsonRpcWebSocketsClient* JsonRpcWebSocketsClient::s_handling = nullptr;
+thread_local JsonRpcWebSocketsClient::Handled* JsonRpcWebSocketsClient::s_handled = nullptr;
+
+JsonRpcWebSocketsClient::JsonRpcWebSocketsClient(tcp::socket&& socket, net::thread_pool& requests):
+	m_ws(std::move(socket)), m_requests(requests)
+{
+}
+
+void JsonRpcWebSocketsClient::start()
+{
+	net::dispatch(m_ws.get_executor(), [self = shared_from_this()]()
+	{
+		self->m_ws.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+		self->m_ws.set_option(websocket::stream_base::decorator(
+				[](websocket::response_type& res)
+				{
+					res.set(http::field::server, std::string(BOOST_BEAST_VERSION_STRING) + " websocket-server-async");
+				}));
+		self->m_ws.read_message_max(c_maxMessageSize);
+		self->m_ws.async_accept(beast::bind_front_handler(&JsonRpcWebSocketsClient::onAccept, self));
+	});
+}
+
+void JsonRpcWebSocketsClient::onAccept(beast::error_code ec)
+{
+	if (ec)
+	{
+		shutdown();
+		return;
+	}
+	// Anything queued while the handshake was going waited for it to finish.
+	m_accepted = true;
+	if (!m_writeQueue.empty())
+		write();
+	read();
+}
+
+void JsonRpcWebSocketsClient::read()
 {
+	m_reading = true;
+	m_ws.async_read(m_readBuffer, beast::bind_front_handler(&JsonRpcWebSocketsClient::onRead, shared_from_this()));
 }
 
-void JsonRpcWebSocketsClient::readAsync(const std::string& jsonStr)
+void JsonRpcWebSocketsClient::onRead(beast::error_code ec, std::size_t)
 {
-    std::thread{ std::bind(
-            [client = shared_from_this(), json = jsonStr]() {
-                try
-                {
-                    auto jsonObject = JsonRpcHelper::parse(json);
-                    auto base = std::static_pointer_cast<IWebsocketClient>(client);
-                    JsonRpcMethods::invokeMethod(jsonObject, base.get());
+	m_reading = false;
+	if (ec)
+	{
+		shutdown();
+		return;
+	}
+
+	std::string request = beast::buffers_to_string(m_readBuffer.data());
+	m_readBuffer.consume(m_readBuffer.size());
+	++m_inFlight;
+	net::post(m_requests, [self = shared_from_this(), request = std::move(request), sequence = m_nextRequest++]()
+	{
+		Handled handled;
+		self->handle(request, handled);
+		net::post(self->m_ws.get_executor(), [self, sequence, handled = std::move(handled)]() mutable
+		{
+			self->onHandled(sequence, std::move(handled));
+		});
+	});
+
+	if (m_inFlight < c_maxInFlight)
+		read();
+}
+
+void JsonRpcWebSocketsClient::handle(std::string const& request, Handled& o_handled)
+{
+	// What the methods send while handling it is collected, to be queued in request order.
+	s_handling = this;
+	s_handled = &o_handled;
+	try
+	{
+		auto jsonObject = JsonRpcHelper::parse(request);
+		JsonRpcMethods::invokeMethod(jsonObject, this);
+	}
+	catch (std::exception const& e)
+	{
+		cwarn << "Websocket request failed:" << e.what();
+	}
+	catch (...)
+	{
+		cwarn << "Websocket request failed.";
+	}
+	s_handling = nullptr;
+	s_handled = nullptr;
+}
 
-                } catch (...)
-                {
-                    // TODO: log error here
-                }
-            }
-    ) }.detach();
+void JsonRpcWebSocketsClient::onHandled(uint64_t sequence, Handled&& handled)
+{
+	--m_inFlight;
+	m_handledEarly.emplace(sequence, std::move(handled));
+	for (auto it = m_handledEarly.begin(); it != m_handledEarly.end() && it->first == m_nextResponse; it = m_handledEarly.erase(it), ++m_nextResponse)
+	{
+		for (std::string& response: it->second.responses)
+			queue(Outgoing{nullptr, std::move(response)});
+		// The subscriptions are announced now, so what they were notified of meanwhile follows.
+		for (std::string const& id: it->second.subscriptions)
+		{
+			{
+				std::lock_guard<std::recursive_mutex> lock(m_mutex);
+				m_unannounced.erase(id);
+			}
+			auto held = m_held.find(id);
+			if (held == m_held.end())
+				continue;
+			for (Outgoing& notification: held->second)
+				queue(std::move(notification));
+			m_held.erase(held);
+		}
+	}
+	// Reading paused when the client had too many requests going; carry on now one is done.
+	if (!m_reading && !m_closed && m_inFlight < c_maxInFlight)
+		read();
 }
 
 void JsonRpcWebSocketsClient::sendAsync(std::string jsonStr)
 {
-    std::thread{ std::bind(
-            [this, json = jsonStr]() {
-                sendSync(json);
-            }
-    ) }.detach();
+	if (s_handling == this)
+	{
+		s_handled->responses.push_back(std::move(jsonStr));
+		return;
+	}
+	net::post(m_ws.get_executor(), [self = shared_from_this(), message = Outgoing{nullptr, std::move(jsonStr)}]() mutable
+	{
+		self->queue(std::move(message));
+	});
 }
 
-void JsonRpcWebSocketsClient::sendSync(const std::string& jsonStr)
+void JsonRpcWebSocketsClient::notify(NotificationPtr notification, std::string subscriptionId)
 {
-    try
-    {
-    	std::lock_guard<std::recursive_mutex> lock(m_mutex);
-        beast::flat_buffer buffer;
-        beast::ostream(buffer) << jsonStr;
-        m_ws.write(buffer.data());
+	net::post(m_ws.get_executor(), [self = shared_from_this(), message = Outgoing{std::move(notification), std::move(subscriptionId)}]() mutable
+	{
+		{
+			std::lock_guard<std::recursive_mutex> lock(self->m_mutex);
+			if (self->m_unannounced.count(message.text))
+			{
+				if (!self->m_closed)
+					self->m_held[message.text].push_back(std::move(message));
+				return;
+			}
+		}
+		self->queue(std::move(message));
+	});
+}
 
-    } catch (std::exception& e)
-    {
-        // TODO: log error here
-        std::cout << e.what() << std::endl;
-    }
+void JsonRpcWebSocketsClient::queue(Outgoing&& message)
+{
+	if (m_closed)
+		return;
+	size_t const size = message.size();
+	if (m_queuedBytes + size > c_maxQueuedBytes)
+	{
+		cnote << "Disconnecting websocket client with" << m_queuedBytes << "bytes it has not taken yet.";
+		shutdown();
+		return;
+	}
+	m_queuedBytes += size;
+	m_writeQueue.push_back(std::move(message));
+	if (m_writeQueue.size() == 1 && m_accepted)
+		write();
 }
 
-void JsonRpcWebSocketsClient::cacheSubscription(std::shared_ptr<Subscription> sub)
+void JsonRpcWebSocketsClient::write()
 {
+	m_ws.text(true);
+	Outgoing const& message = m_writeQueue.front();
+	auto onWrite = beast::bind_front_handler(&JsonRpcWebSocketsClient::onWrite, shared_from_this());
+	if (message.notification)
+		m_ws.async_write(message.notification->buffers(message.text), std::move(onWrite));
+	else
+		m_ws.async_write(net::buffer(message.text), std::move(onWrite));
+}
+
+void JsonRpcWebSocketsClient::onWrite(beast::error_code ec, std::size_t)
+{
+	// Once closed, the message just written is left for the destructor.
+	if (m_closed)
+		return;
+	if (ec)
+	{
+		shutdown();
+		return;
+	}
+	m_queuedBytes -= m_writeQueue.front().size();
+	m_writeQueue.pop_front();
+	if (!m_writeQueue.empty())
+		write();
+}
+
+void JsonRpcWebSocketsClient::shutdown()
+{
+	if (m_closed)
+		return;
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	// The message at the front may still be being written, so its buffers have to stay.
+	if (!m_writeQueue.empty())
+		m_writeQueue.erase(m_writeQueue.begin() + 1, m_writeQueue.end());
+	m_queuedBytes = 0;
+	beast::error_code ec;
+	beast::get_lowest_layer(m_ws).close(ec);
+	close();
+}
+
+bool JsonRpcWebSocketsClient::cacheSubscription(std::shared_ptr<Subscription> sub)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
+	// The subscriptions of a closed client are already gone; this one must not outlive it either.
+	if (m_closed)
+	{
+		sub->cleanUp();
+		return false;
+	}
 	m_subscriptionMap.insert(std::make_pair(sub->getId(), sub));
+	if (s_handling == this)
+	{
+		m_unannounced.insert(sub->getId());
+		s_handled->subscriptions.push_back(sub->getId());
+	}
+	return true;
 }
 
 void JsonRpcWebSocketsClient::freeSubscription(SubscriptionMapIt iter)
@@ -66,6 +243,7 @@ void JsonRpcWebSocketsClient::freeSubscription(SubscriptionMapIt iter)
 
 bool JsonRpcWebSocketsClient::unsubscribe(const std::string& subId)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	auto iter = m_subscriptionMap.find(subId);
 	if(iter == m_subscriptionMap.end())
 		return false;
@@ -77,9 +255,11 @@ bool JsonRpcWebSocketsClient::unsubscribe(const std::string& subId)
 
 void JsonRpcWebSocketsClient::close()
 {
+	std::lock_guard<std::recursive_mutex> lock(m_mutex);
 	SubscriptionMapIt iter = m_subscriptionMap.begin();
 	while(iter != m_subscriptionMap.end()) {
-		freeSubscription(iter);
+		if (iter->second)
+			freeSubscription(iter);
 		iter++;
 	}
 
@@ -1,29 +1,102 @@
 #pragma once
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
 #include <vector>
+#include <boost/asio/thread_pool.hpp>
 #include "IWebSocketClient.h"
+#include "Notification.h"
 #include "websocket-api/subscription/Subscription.h"
 
 namespace WebsocketAPI {
 
+    /**
+     * A websocket connection, driven asynchronously on the io_context of the server.
+     *
+     * Reads, writes and closing all happen on the strand of the socket. Requests are handled on
+     * a separate pool so that a slow one does not hold up the io_context; at most c_maxInFlight
+     * of a client at once, after which reading pauses. Responses are still sent in the order the
+     * requests came in, and the notifications of a new subscription only after the response
+     * that announces it. What is sent waits in a queue that may hold up to c_maxQueuedBytes; a
+     * client that falls further behind is disconnected.
+     */
     class JsonRpcWebSocketsClient : public IWebsocketClient,
             public std::enable_shared_from_this<JsonRpcWebSocketsClient> {
 
     public:
-        JsonRpcWebSocketsClient(BoostWebsocket& ws);
+        static const size_t c_maxQueuedBytes = 4 * 1024 * 1024;	///< Most unsent data a client may have.
+        static const unsigned c_maxInFlight = 16;					///< Most requests of a client handled at once.
+        static const size_t c_maxMessageSize = 1024 * 1024;		///< Largest request accepted.
+
+        JsonRpcWebSocketsClient(tcp::socket&& socket, net::thread_pool& requests);
+
+        /// Accepts the websocket handshake and starts reading requests.
+        void start();
 
-        virtual void readAsync(const std::string& jsonStr);
         virtual void sendAsync(std::string jsonStr);
-        virtual void sendSync(const std::string& jsonStr);
+        virtual void notify(NotificationPtr notification, std::string subscriptionId);
 		virtual void close();
 
-        void cacheSubscription(std::shared_ptr<Subscription> sub);
+        /// Keeps @a sub until it is unsubscribed or the client closes.
+        /// @returns false, having cleaned @a sub up, if the client has closed already.
+        bool cacheSubscription(std::shared_ptr<Subscription> sub);
 		bool unsubscribe(const std::string& subId);
 
     private:
+		void onAccept(beast::error_code ec);
+		void read();
+		void onRead(beast::error_code ec, std::size_t);
+		/// What handling a request gave: its responses, and the subscriptions they announce.
+		struct Handled
+		{
+			std::vector<std::string> responses;
+			std::vector<std::string> subscriptions;
+		};
+
+		void handle(std::string const& request, Handled& o_handled);
+		void onHandled(uint64_t sequence, Handled&& handled);
+		/// A message waiting to be sent: either @a text, or @a notification for the subscription
+		/// with id @a text.
+		struct Outgoing
+		{
+			NotificationPtr notification;
+			std::string text;
+
+			size_t size() const { return notification ? notification->size(text.size()) : text.size(); }
+		};
+
+		void queue(Outgoing&& message);
+		void write();
+		void onWrite(beast::error_code ec, std::size_t);
+		void shutdown();
+
+		BoostWebsocket m_ws;
+		net::thread_pool& m_requests;
+		beast::flat_buffer m_readBuffer;
+		std::deque<Outgoing> m_writeQueue;
+		size_t m_queuedBytes = 0;
+		unsigned m_inFlight = 0;
+		uint64_t m_nextRequest = 0;				///< Sequence number of the next request read.
+		uint64_t m_nextResponse = 0;			///< Sequence number of the request answered next.
+		std::map<uint64_t, Handled> m_handledEarly;	///< Requests handled before an earlier one, by sequence number.
+		std::map<std::string, std::vector<Outgoing>> m_held;	///< Notifications of subscriptions not announced yet.
+		bool m_reading = false;
+		bool m_accepted = false;			///< The handshake is done, so messages may be written.
+		std::atomic<bool> m_closed{false};		///< Only set on the strand, under m_mutex.
+
 		using SubscriptionMapIt = std::map<std::string, SubscriptionPtr>::iterator ;
 		std::map<std::string, SubscriptionPtr> m_subscriptionMap;
 
+		std::set<std::string> m_unannounced;	///< Subscriptions made by requests whose responses are not queued yet.
+
 		void freeSubscription(SubscriptionMapIt it);
-		std::recursive_mutex m_mutex;
+		std::recursive_mutex m_mutex;			///< Lock on m_subscriptionMap, m_unannounced and the setting of m_closed.
+
+		/// The client and results of the request being handled on this thread, if any.
+		static thread_local JsonRpcWebSocketsClient* s_handling;
+		static thread_local Handled* s_handled;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,22 @@
+#include "Notification.h"
+
+namespace WebsocketAPI {
+
+Notification::Notification(Json::Value const& result):
+	m_tail("\"}}\n")
+{
+	Json::FastWriter fastWriter;
+	std::string out = fastWriter.write(result);
+	if (!out.empty() && out.back() == '\n')
+		out.pop_back();
+	// The same as writing {"jsonrpc", "method", "params": {"result", "subscription"}} with
+	// FastWriter, which orders the keys alphabetically and ends with a newline.
+	m_head = "{\"jsonrpc\":\"2.0\",\"method\":\"eth_subscription\",\"params\":{\"result\":" + out + ",\"subscription\":\"";
+}
+
+std::array<net::const_buffer, 3> Notification::buffers(std::string const& subscriptionId) const
+{
+	return {{net::buffer(m_head), net::buffer(subscriptionId), net::buffer(m_tail)}};
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <json/json.h>
+#include "IWebSocketClient.h"
+
+namespace WebsocketAPI {
+
+    /**
+     * An eth_subscription message, rendered once and shared by every subscription it goes to.
+     *
+     * The message is kept as the text before and after the subscription id, so sending it to
+     * a subscription only needs the id in between; nothing is copied per subscriber.
+     */
+    class Notification {
+    public:
+        explicit Notification(Json::Value const& result);
+
+        /// @returns the message for subscription @a subscriptionId, as buffers to write in turn.
+        /// They refer to this notification and @a subscriptionId, which must outlive them.
+        std::array<net::const_buffer, 3> buffers(std::string const& subscriptionId) const;
+
+        /// @returns the size of the message for a subscription id of @a idSize characters.
+        size_t size(size_t idSize) const { return m_head.size() + idSize + m_tail.size(); }
+
+    private:
+        std::string m_head;
+        std::string m_tail;
+    };
+
+    using NotificationPtr = std::shared_ptr<Notification const>;
+}
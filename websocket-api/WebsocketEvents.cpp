@@ -1,30 +1,119 @@
-
 #include "WebsocketEvents.h"
+#include "WebsocketServer.h"
+#include "libdevcore/CommonJS.h"
+#include "libdevcore/Log.h"
+#include "libweb3jsonrpc/Eth.h"
+#include "libweb3jsonrpc/JsonHelper.h"
 
 using namespace dev::eth;
 
 namespace WebsocketAPI {
-    std::shared_ptr<WebSocketEvents> WebSocketEvents::m_instance = nullptr;
+	std::shared_ptr<WebSocketEvents> WebSocketEvents::m_instance = std::make_shared<WebSocketEvents>();
+
+	constexpr size_t WebSocketEvents::c_queueCapacity;
 
     WebSocketEvents::WebSocketEvents()
     {}
 
+	WebSocketEvents::~WebSocketEvents()
+	{
+		{
+			std::lock_guard<std::mutex> l(x_wake);
+			m_running = false;
+		}
+		m_wake.notify_one();
+		if (m_dispatcher.joinable())
+			m_dispatcher.join();
+		m_queue.consume_all([](Event* _e) { delete _e; });
+	}
+
     std::shared_ptr<WebSocketEvents>& WebSocketEvents::getInstance()
     {
-        if(m_instance == nullptr)
-            m_instance = std::make_shared<WebSocketEvents>();
-
         return m_instance;
     }
 
+	void WebSocketEvents::enqueue(Event* _e)
+	{
+		std::call_once(m_started, [this]() {
+			m_dispatcher = std::thread([this]() { dev::setThreadName("wsEvents"); dispatch(); });
+		});
+		if (!m_queue.bounded_push(_e))
+		{
+			delete _e;
+			++m_dropped;
+			return;
+		}
+		// Paired with the fence in dispatch(): either the dispatcher sees this event when it checks
+		// the queue, or this sees it sleeping. Only then is the lock taken, so a dispatcher that is
+		// busy costs the producer nothing but the push.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_sleeping)
+		{
+			std::lock_guard<std::mutex> l(x_wake);
+			m_wake.notify_one();
+		}
+	}
+
+	void WebSocketEvents::dispatch()
+	{
+		uint64_t reported = 0;
+		while (m_running)
+		{
+			if (m_queue.empty())
+			{
+				std::unique_lock<std::mutex> l(x_wake);
+				m_sleeping = true;
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				m_wake.wait(l, [this]() { return !m_running || !m_queue.empty(); });
+				m_sleeping = false;
+			}
+			m_queue.consume_all([this](Event* _e) {
+				std::unique_ptr<Event> e(_e);
+				try
+				{
+					publish(*e);
+				}
+				catch (std::exception const& ex)
+				{
+					cwarn << "Cannot publish websocket event:" << ex.what();
+				}
+			});
+			uint64_t const dropped = m_dropped;
+			if (dropped != reported)
+				cwarn << "Dropped" << dropped - reported << "websocket events while the dispatcher was behind.";
+			reported = dropped;
+		}
+	}
+
+	void WebSocketEvents::publish(Event const& _e)
+	{
+		switch (_e.kind)
+		{
+		case Event::PendingTransaction:
+			m_onPendingTransactionEvent(std::make_shared<Notification const>(Json::Value(toJS(_e.transaction))));
+			break;
+		case Event::BlocksMined:
+			m_onBlocksMinedEvent();
+			break;
+		case Event::NewBlockHeader:
+			m_onNewBlockHeaderEvent(std::make_shared<Notification const>(toJson(_e.header)));
+			break;
+		case Event::SyncChange:
+			if (auto interface = getEthInterface())
+				m_onSyncChangeEvent(std::make_shared<Notification const>(interface->eth_syncing()));
+			break;
+		}
+	}
+
 	boost::signals2::connection WebSocketEvents::subscribeNewPendingTransactionEvent(OnNewPendingTransactionEvent func)
     {
         return m_onPendingTransactionEvent.connect(func);
     }
 
-    void WebSocketEvents::triggerNewPendingTransactionEvent(Transaction const _t)
+    void WebSocketEvents::triggerNewPendingTransactionEvent(Transaction const& _t)
     {
-        m_onPendingTransactionEvent(_t);
+		if (!m_onPendingTransactionEvent.empty())
+			enqueue(new Event{Event::PendingTransaction, _t.sha3(), BlockHeader()});
     }
 
 	boost::signals2::connection WebSocketEvents::subscribeBlocksMinedEvent(OnBlocksMined func)
@@ -34,7 +123,8 @@ namespace WebsocketAPI {
 
     void WebSocketEvents::triggerBlocksMinedEvent()
 	{
-		m_onBlocksMinedEvent();
+		if (!m_onBlocksMinedEvent.empty())
+			enqueue(new Event{Event::BlocksMined, dev::h256(), BlockHeader()});
 	}
 
 	boost::signals2::connection WebSocketEvents::subscribeNewBlockHeaderEvent(OnNewBlockHeader func)
@@ -42,9 +132,10 @@ namespace WebsocketAPI {
     	return m_onNewBlockHeaderEvent.connect(func);
 	}
 
-	void WebSocketEvents::triggerNewBlockHeaderEvent(BlockHeader bh)
+	void WebSocketEvents::triggerNewBlockHeaderEvent(BlockHeader const& bh)
 	{
-		m_onNewBlockHeaderEvent(bh);
+		if (!m_onNewBlockHeaderEvent.empty())
+			enqueue(new Event{Event::NewBlockHeader, dev::h256(), bh});
 	}
 
 	boost::signals2::connection WebSocketEvents::subscribeSyncChangeEvent(OnSyncChangeEvent func)
@@ -54,6 +145,7 @@ namespace WebsocketAPI {
 
 	void WebSocketEvents::triggerSyncChangeEvent()
 	{
-		m_onSyncChangeEvent();
+		if (!m_onSyncChangeEvent.empty())
+			enqueue(new Event{Event::SyncChange, dev::h256(), BlockHeader()});
 	}
-}
\ No newline at end of file
+}
@@ -1,41 +1,85 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include "boost/lockfree/queue.hpp"
 #include "boost/signals2/signal.hpp"
 #include "libethereum/Transaction.h"
 #include "libethcore/BlockHeader.h"
+#include "Notification.h"
 
 namespace WebsocketAPI
 {
 using namespace dev::eth;
-using OnNewPendingTransactionEvent = std::function<void(Transaction const _t)>;
+/// Subscribers get the notification, rendered once for all of them.
+using OnNewPendingTransactionEvent = std::function<void(NotificationPtr const& _n)>;
 using OnBlocksMined = std::function<void()>;
-using OnNewBlockHeader = std::function<void(BlockHeader bh)>;
-using OnSyncChangeEvent = std::function<void()>;
+using OnNewBlockHeader = std::function<void(NotificationPtr const& _n)>;
+using OnSyncChangeEvent = std::function<void(NotificationPtr const& _n)>;
 
+/**
+ * The events websocket subscriptions listen to.
+ *
+ * Block import, execution and sync only put the event into a fixed-size lock-free queue
+ * and return; a dispatcher thread takes it from there, builds what is sent for it once
+ * and hands it to every subscriber. Events nobody subscribes to are not queued, and
+ * events that arrive while the queue is full are dropped, and counted, rather than making
+ * the caller wait.
+ */
 class WebSocketEvents
 {
 public:
     WebSocketEvents();
+	~WebSocketEvents();
     static std::shared_ptr<WebSocketEvents>& getInstance();
 
 	boost::signals2::connection subscribeNewPendingTransactionEvent(OnNewPendingTransactionEvent func);
-    void triggerNewPendingTransactionEvent(Transaction const _t);
+    void triggerNewPendingTransactionEvent(Transaction const& _t);
 
 	boost::signals2::connection subscribeBlocksMinedEvent(OnBlocksMined func);
 	void triggerBlocksMinedEvent();
 
 	boost::signals2::connection subscribeNewBlockHeaderEvent(OnNewBlockHeader func);
-	void triggerNewBlockHeaderEvent(dev::eth::BlockHeader bh);
+	void triggerNewBlockHeaderEvent(dev::eth::BlockHeader const& bh);
 
 	boost::signals2::connection subscribeSyncChangeEvent(OnSyncChangeEvent func);
 	void triggerSyncChangeEvent();
 
+	/// @returns how many events were dropped because the queue was full.
+	uint64_t droppedEvents() const { return m_dropped; }
+
+	static constexpr size_t c_queueCapacity = 4096;
+
 private:
+	struct Event
+	{
+		enum Kind { PendingTransaction, BlocksMined, NewBlockHeader, SyncChange };
+		Kind kind;
+		dev::h256 transaction;
+		BlockHeader header;
+	};
+
+	/// Hands @a _e to the dispatcher, which takes ownership; deletes it if the queue is full.
+	void enqueue(Event* _e);
+	void dispatch();
+	void publish(Event const& _e);
+
     static std::shared_ptr<WebSocketEvents> m_instance;
-    boost::signals2::signal<void(Transaction const _t)> m_onPendingTransactionEvent;
+	boost::signals2::signal<void(NotificationPtr const&)> m_onPendingTransactionEvent;
 	boost::signals2::signal<void()> m_onBlocksMinedEvent;
-	boost::signals2::signal<void(BlockHeader h)> m_onNewBlockHeaderEvent;
-	boost::signals2::signal<void()> m_onSyncChangeEvent;
+	boost::signals2::signal<void(NotificationPtr const&)> m_onNewBlockHeaderEvent;
+	boost::signals2::signal<void(NotificationPtr const&)> m_onSyncChangeEvent;
+
+	boost::lockfree::queue<Event*, boost::lockfree::fixed_sized<true>> m_queue{c_queueCapacity};
+	std::atomic<uint64_t> m_dropped{0};
+	std::atomic<bool> m_running{true};
+	std::atomic<bool> m_sleeping{false};	///< Set by the dispatcher, under x_wake, before it waits for events.
+	std::once_flag m_started;
+	std::mutex x_wake;
+	std::condition_variable m_wake;
+	std::thread m_dispatcher;
 };
-}
\ No newline at end of file
+}
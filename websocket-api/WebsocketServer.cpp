@@ -1,7 +1,12 @@
-#include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <string>
 #include <thread>
+#include <vector>
 #include <memory.h>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <libdevcore/Log.h>
 #include "JsonRpcWebSocketsClient.h"
 #include "JsonRpcMethods.h"
 #include "WebsocketServer.h"
@@ -11,6 +16,11 @@ namespace WebsocketAPI
 
 static dev::rpc::Eth* f_ethInterface = nullptr;
 
+static const unsigned c_maxIoThreads = 4;			///< Most threads running the sockets.
+static const unsigned c_requestThreads = 8;			///< Threads handling requests, which may block.
+static const std::chrono::milliseconds c_minAcceptBackoff{10};	///< First wait after accepting failed.
+static const std::chrono::milliseconds c_maxAcceptBackoff{1000};	///< Longest wait while accepting keeps failing.
+
 void setEthInterface(dev::rpc::Eth* eth)
 {
 	f_ethInterface = eth;
@@ -21,73 +31,98 @@ dev::rpc::Eth* getEthInterface()
 	return f_ethInterface;
 }
 
+namespace
+{
+
+/// Accepts connections and hands each to a client of its own, on a strand of its own.
+class Listener: public std::enable_shared_from_this<Listener>
+{
+public:
+	Listener(net::io_context& ioc, net::thread_pool& requests): m_ioc(ioc), m_requests(requests), m_acceptor(net::make_strand(ioc)), m_retry(m_acceptor.get_executor()) {}
+
+	bool listen(tcp::endpoint const& endpoint)
+	{
+		beast::error_code ec;
+		m_acceptor.open(endpoint.protocol(), ec);
+		if (!ec)
+			m_acceptor.set_option(net::socket_base::reuse_address(true), ec);
+		if (!ec)
+			m_acceptor.bind(endpoint, ec);
+		if (!ec)
+			m_acceptor.listen(net::socket_base::max_listen_connections, ec);
+		if (ec)
+		{
+			cwarn << "Cannot serve websockets on port" << endpoint.port() << ":" << ec.message();
+			return false;
+		}
+		accept();
+		return true;
+	}
+
+private:
+	void accept()
+	{
+		m_acceptor.async_accept(net::make_strand(m_ioc), beast::bind_front_handler(&Listener::onAccept, shared_from_this()));
+	}
+
+	void onAccept(beast::error_code ec, tcp::socket socket)
+	{
+		if (ec == net::error::operation_aborted)
+			return;
+		if (!ec || ec == net::error::connection_aborted)
+		{
+			// Only the client gave up, if anything; the next one may be accepted at once.
+			if (!ec)
+				std::make_shared<JsonRpcWebSocketsClient>(std::move(socket), m_requests)->start();
+			m_backoff = std::chrono::milliseconds(0);
+			accept();
+			return;
+		}
+
+		// Out of descriptors or memory, say: accepting again at once would only fail again.
+		m_backoff = std::min(std::max(m_backoff * 2, c_minAcceptBackoff), c_maxAcceptBackoff);
+		cwarn << "Cannot accept websocket connections:" << ec.message() << "- retrying in" << m_backoff.count() << "ms";
+		m_retry.expires_after(m_backoff);
+		m_retry.async_wait([self = shared_from_this()](beast::error_code const& _ec)
+		{
+			if (!_ec)
+				self->accept();
+		});
+	}
+
+	net::io_context& m_ioc;
+	net::thread_pool& m_requests;
+	tcp::acceptor m_acceptor;
+	net::steady_timer m_retry;					///< Delays accepting again while it keeps failing.
+	std::chrono::milliseconds m_backoff{0};
+};
+
+}
+
 void connect(unsigned short port)
 {
     JsonRpcMethods::initialize();
 
+    unsigned const ioThreads = std::max(1u, std::min(std::thread::hardware_concurrency(), c_maxIoThreads));
+    net::io_context ioc{static_cast<int>(ioThreads)};
+    net::thread_pool requests(c_requestThreads);
+
     auto const address = net::ip::make_address("0.0.0.0");
-    net::io_context ioc{ 1 };
-    tcp::acceptor acceptor{ ioc, {address, port} };
-    for (;;)
-    {
-
-        tcp::socket socket{ ioc };
-
-        acceptor.accept(socket); // stops until new socket/client connections
-
-        std::thread{ std::bind(
-                [q{std::move(socket)}]() { // socket will be const - mutable should be used
-
-                    websocket::stream<tcp::socket> ws{std::move(const_cast<tcp::socket&>(q))};
-
-                    // Set a decorator to change the Server of the handshake
-                    // no need to set. It ıs not necessary
-                    ws.set_option(websocket::stream_base::decorator(
-                            [](websocket::response_type& res)
-                            {
-                                res.set(http::field::server,
-                                        std::string(BOOST_BEAST_VERSION_STRING) +
-                                        " websocket-server-sync");
-                            }));
-
-                    // Accept the websocket handshake
-                    ws.accept();
-
-                    std::shared_ptr<JsonRpcWebSocketsClient> client = std::make_shared<JsonRpcWebSocketsClient>(ws);
-
-                    while (true)
-                    {
-                        try
-                        {
-
-                            // This buffer will hold the incoming message
-                            // buffer types https://www.boost.org/doc/libs/1_75_0/libs/beast/doc/html/beast/using_io/buffer_types.html
-                            // check for the best one
-                            //beast::multi_buffer buffer;
-                            beast::flat_buffer buffer;
-
-                            // Read a message
-                            ws.read(buffer);   // synchronous hold until new data
-
-                            auto out = beast::buffers_to_string(buffer.cdata());
-                            std::cout << out << std::endl;		// for debugging on data received by websocket server
-
-                            client->readAsync(out);
-
-                        }
-                        catch (beast::system_error const& se)
-                        {
-                            if (se.code() != websocket::error::closed)
-                            {
-                                std::cerr << "Error: " << se.code().message() << std::endl;
-                                break;
-                            }
-                        }
-                    } // end of while
-                    client->close();
-                }
-        ) }.detach();
-    }
+    if (!std::make_shared<Listener>(ioc, requests)->listen(tcp::endpoint{address, port}))
+        return;
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < ioThreads; ++i)
+        threads.emplace_back([&ioc]()
+        {
+            dev::setThreadName("ws");
+            ioc.run();
+        });
+    dev::setThreadName("ws");
+    ioc.run();
+    for (auto& t: threads)
+        t.join();
+    requests.join();
 }
 
 void connectAsync(unsigned short port){
@@ -99,4 +134,4 @@ void connectAsync(unsigned short port){
 }
 
 
-}
\ No newline at end of file
+}
@@ -1,66 +1,117 @@
+#include <map>
+#include <mutex>
+#include <libdevcore/Log.h>
 #include <websocket-api/WebsocketEvents.h>
 #include "libweb3jsonrpc/Eth.h"
+#include "libweb3jsonrpc/JsonHelper.h"
 #include "LogsSubscription.h"
 #include "../WebsocketServer.h"
 
 namespace WebsocketAPI
 {
-	LogsSubscription::LogsSubscription(IWebsocketClient* client, Json::Value j)
-		: Subscription(client, Subscription::Type::Logs) {
-
-		auto interface = WebsocketAPI::getEthInterface();
-		if(interface == nullptr)
-			return;
-
-		m_filterId = interface->eth_newFilterWS(j);
-
-		m_connection = WebSocketEvents::getInstance()->subscribeBlocksMinedEvent(
-				std::bind(&LogsSubscription::onBlocksMined, this));
-	}
-
-	void LogsSubscription::onBlocksMined()
+	namespace
 	{
-		try {
-			auto interface = WebsocketAPI::getEthInterface();
-			if (interface == nullptr || m_filterId.empty())
-				return;
-
-			Json::Value jlogs = interface->eth_getFilterChanges(m_filterId);
-
-			Json::FastWriter fastWriter;
-			Json::Value root;
-			Json::Value params;
-
-			params["subscription"] = getId();
+		/// The logs subscriptions, grouped by the criteria of their filters.
+		class FilterGroups
+		{
+		public:
+			static FilterGroups& get()
+			{
+				static FilterGroups s_groups;
+				return s_groups;
+			}
 
-			root["jsonrpc"] = "2.0";
-			root["method"] = "eth_subscription";
+			/// Adds subscription @a id of @a client to the group of @a filter, installing
+			/// the filter if it is the first. @returns false if no filter could be installed.
+			bool join(dev::h256 const& criteria, Json::Value const& filter, std::string const& id, IWebsocketClient* client)
+			{
+				std::lock_guard<std::mutex> l(x_groups);
+				auto it = m_groups.find(criteria);
+				if (it == m_groups.end())
+				{
+					auto interface = WebsocketAPI::getEthInterface();
+					if (interface == nullptr)
+						return false;
+					it = m_groups.insert(std::make_pair(criteria, Group{interface->eth_newFilterWS(filter), {}})).first;
+					if (!m_connection.connected())
+						m_connection = WebSocketEvents::getInstance()->subscribeBlocksMinedEvent(
+								std::bind(&FilterGroups::onBlocksMined, this));
+				}
+				it->second.members[id] = client;
+				return true;
+			}
 
-			for (unsigned int i = 0; i < jlogs.size(); i++)
+			/// Removes subscription @a id; uninstalls the filter if it was the last of its group.
+			void leave(dev::h256 const& criteria, std::string const& id)
 			{
-				if(jlogs[i]["type"].asString() != "mined")
-					continue;
+				std::lock_guard<std::mutex> l(x_groups);
+				auto it = m_groups.find(criteria);
+				if (it == m_groups.end())
+					return;
+				it->second.members.erase(id);
+				if (!it->second.members.empty())
+					return;
+
+				if (auto interface = WebsocketAPI::getEthInterface())
+					interface->eth_uninstallFilterWS(it->second.filterId);
+				m_groups.erase(it);
+				if (m_groups.empty())
+					m_connection.disconnect();
+			}
 
-				params["result"] = jlogs[i];
-				root["params"] = params;
+		private:
+			struct Group
+			{
+				std::string filterId;
+				std::map<std::string, IWebsocketClient*> members;	///< Client of each subscription, by id.
+			};
 
-				std::string result = fastWriter.write(root);
-				getClient()->sendSync(result);
+			void onBlocksMined()
+			{
+				auto interface = WebsocketAPI::getEthInterface();
+				if (interface == nullptr)
+					return;
+
+				std::lock_guard<std::mutex> l(x_groups);
+				for (auto const& group: m_groups)
+					try
+					{
+						Json::Value jlogs = interface->eth_getFilterChanges(group.second.filterId);
+						for (unsigned int i = 0; i < jlogs.size(); i++)
+						{
+							if (jlogs[i]["type"].asString() != "mined")
+								continue;
+
+							auto notification = std::make_shared<Notification const>(jlogs[i]);
+							for (auto const& member: group.second.members)
+								member.second->notify(notification, member.first);
+						}
+					}
+					catch (std::exception const& e)
+					{
+						cwarn << "Cannot notify websocket clients of logs:" << e.what();
+					}
 			}
 
-		} catch (std::exception &e) {
-			std::cout << e.what() << std::endl;
-		}
+			std::mutex x_groups;
+			std::map<dev::h256, Group> m_groups;
+			boost::signals2::connection m_connection;
+		};
+	}
+
+	LogsSubscription::LogsSubscription(IWebsocketClient* client, Json::Value j)
+		: Subscription(client, Subscription::Type::Logs),
+		m_criteria(dev::eth::toLogFilter(j).sha3())
+	{
+		m_joined = FilterGroups::get().join(m_criteria, j, getId(), client);
 	}
 
 	void LogsSubscription::cleanUp()
 	{
 		Subscription::cleanUp();
 
-		auto interface = WebsocketAPI::getEthInterface();
-		if (interface == nullptr || m_filterId.empty())
-			return;
-
-		interface->eth_uninstallFilterWS(m_filterId);
+		if (m_joined)
+			FilterGroups::get().leave(m_criteria, getId());
+		m_joined = false;
 	}
-}
\ No newline at end of file
+}
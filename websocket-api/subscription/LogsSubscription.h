@@ -2,19 +2,22 @@
 #include <string>
 #include <json/json.h>
 
+#include "libdevcore/FixedHash.h"
 #include "websocket-api/IWebSocketClient.h"
 #include "Subscription.h"
 #include "libethereum/Transaction.h"
 
 namespace WebsocketAPI
 {
+	/// A logs subscription. Subscriptions whose filters have the same criteria share one
+	/// installed filter, which is checked once per mined block for all of them.
 	class LogsSubscription : public Subscription{
 	public:
 		LogsSubscription(IWebsocketClient* client, Json::Value);
-		void onBlocksMined();
 		virtual void cleanUp();
 
 	private:
-		std::string m_filterId;
+		dev::h256 m_criteria;	///< Hash of the filter; the same for all subscriptions in the group.
+		bool m_joined = false;
 	};
-}
\ No newline at end of file
+}
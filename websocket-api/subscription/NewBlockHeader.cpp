@@ -1,4 +1,3 @@
-#include "libweb3jsonrpc/JsonHelper.h"
 #include "NewBlockHeader.h"
 #include "../WebsocketEvents.h"
 
@@ -13,30 +12,8 @@ namespace WebsocketAPI
 				std::bind(&NewBlockHeader::onNewBlockHeader, this, std::placeholders::_1));
 	}
 
-	void NewBlockHeader::onNewBlockHeader(BlockHeader bh)
+	void NewBlockHeader::onNewBlockHeader(NotificationPtr const& _header)
 	{
-		try {
-			Json::Value root;
-			Json::Value params;
-			Json::Value result;
-
-			params["subscription"] = getId();
-
-			root["jsonrpc"] = "2.0";
-			root["method"] = "eth_subscription";
-
-			result = toJson(bh);
-			params["subscription"] = getId();
-			params["result"] = result;
-
-			root["params"] = params;
-
-			Json::FastWriter fastWriter;
-			std::string out = fastWriter.write(root);
-			getClient()->sendSync(out);
-		}
-		catch (std::exception &e) {
-			std::cout << e.what() << std::endl;
-		}
+		getClient()->notify(_header, getId());
 	}
 }
\ No newline at end of file
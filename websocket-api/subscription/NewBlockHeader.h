@@ -4,6 +4,7 @@
 #include <json/json.h>
 #include "libethcore/BlockHeader.h"
 #include "websocket-api/IWebSocketClient.h"
+#include "websocket-api/Notification.h"
 #include "Subscription.h"
 
 namespace WebsocketAPI
@@ -11,7 +12,7 @@ namespace WebsocketAPI
 	class NewBlockHeader : public Subscription{
 	public:
 		NewBlockHeader(IWebsocketClient* client);
-		void onNewBlockHeader(dev::eth::BlockHeader bh);
+		void onNewBlockHeader(NotificationPtr const& _header);
 
 	};
 }
\ No newline at end of file
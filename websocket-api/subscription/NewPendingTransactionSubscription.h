@@ -1,5 +1,6 @@
 #pragma once
 #include "websocket-api/IWebSocketClient.h"
+#include "websocket-api/Notification.h"
 #include "Subscription.h"
 #include "libethereum/Transaction.h"
 
@@ -8,6 +9,6 @@ namespace WebsocketAPI
     class NewPendingTransactionSubscription : public Subscription{
     public:
         NewPendingTransactionSubscription(IWebsocketClient* client);
-        void onPendingTransaction(dev::eth::Transaction const _t);
+        void onPendingTransaction(NotificationPtr const& _hash);
     };
 }
\ No newline at end of file
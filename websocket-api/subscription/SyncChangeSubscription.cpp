@@ -1,6 +1,5 @@
 #include "SyncChangeSubscription.h"
 #include "../WebsocketEvents.h"
-#include "../WebsocketServer.h"
 
 namespace WebsocketAPI
 {
@@ -8,33 +7,11 @@ namespace WebsocketAPI
 			: Subscription(client, Subscription::SyncChanged)
 	{
 		m_connection = WebSocketEvents::getInstance()->subscribeSyncChangeEvent(
-				std::bind(&SyncChangeSubscription::onSyncChanged, this));
+				std::bind(&SyncChangeSubscription::onSyncChanged, this, std::placeholders::_1));
 	}
 
-	void SyncChangeSubscription::onSyncChanged()
+	void SyncChangeSubscription::onSyncChanged(NotificationPtr const& _syncing)
 	{
-		try {
-			auto interface = WebsocketAPI::getEthInterface();
-			if(interface == nullptr)
-				return;
-
-			auto result = interface->eth_syncing();
-			Json::Value root;
-			Json::Value params;
-
-			root["jsonrpc"] = "2.0";
-			root["method"] = "eth_subscription";
-			params["subscription"] = getId();
-			params["result"] = result;
-
-			root["params"] = params;
-
-			Json::FastWriter fastWriter;
-			std::string out = fastWriter.write(root);
-			getClient()->sendSync(out);
-
-		} catch (std::exception &e) {
-			std::cout << e.what() << std::endl;
-		}
+		getClient()->notify(_syncing, getId());
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <json/json.h>
 #include "libethcore/BlockHeader.h"
 #include "websocket-api/IWebSocketClient.h"
+#include "websocket-api/Notification.h"
 #include "Subscription.h"
 
 namespace WebsocketAPI
@@ -11,7 +12,7 @@ namespace WebsocketAPI
 	class SyncChangeSubscription : public Subscription{
 	public:
 		SyncChangeSubscription(IWebsocketClient* client);
-		void onSyncChanged();
+		void onSyncChanged(NotificationPtr const& _syncing);
 
 	};
 }
\ No newline at end of file